@@ -0,0 +1,807 @@
+#include "Benchmarks/bench.h"
+#include "Core/Platform/filesync.h"
+#include "Core/Platform/platform.h"
+#include "Core/Container/basic.h"
+#include <EASTL/sort.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace glex;
+
+namespace
+{
+	struct Entry
+	{
+		char const* name;
+		FunctionPtr<void(BenchmarkState&)> function;
+	};
+
+	struct Options
+	{
+		Vector<String> filters;
+		uint32_t repetitions = 15;
+		double minTime = 0.02;			// Seconds per sample.
+		char const* outPath = nullptr;
+		bool list = false;
+		char const* baselinePath = nullptr;
+		char const* currentPath = nullptr;
+		double threshold = 0.05;		// Smallest relative change of the median compare reports.
+		double alpha = 0.01;
+	};
+
+	struct Result
+	{
+		String name;
+		String error;
+		uint64_t iterations = 0;
+		Vector<double> samples;			// Nanoseconds per iteration.
+		uint64_t bytes = 0;
+		uint64_t items = 0;
+		Vector<std::pair<String, double>> counters;
+	};
+
+	struct Summary
+	{
+		double median;
+		double mean;
+		double stddev;
+		double min;
+		double max;
+		double mad;						// Median absolute deviation.
+	};
+
+	// Just enough JSON to read the result files back.
+	struct JsonValue
+	{
+		enum class Type : uint8_t
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		Type type = Type::Null;
+		double number = 0.0;
+		String string;
+		Vector<JsonValue> elements;
+		Vector<String> keys;			// Objects only, keys[i] names elements[i].
+
+		JsonValue const* Find(char const* key) const
+		{
+			for (uint32_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key)
+					return &elements[i];
+			}
+			return nullptr;
+		}
+	};
+
+	class JsonParser
+	{
+	private:
+		constexpr static uint32_t k_maxDepth = 64;
+
+		char const* m_p;
+		char const* m_end;
+
+		void SkipSpace()
+		{
+			while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+				m_p++;
+		}
+
+		bool Consume(char c)
+		{
+			SkipSpace();
+			if (m_p == m_end || *m_p != c)
+				return false;
+			m_p++;
+			return true;
+		}
+
+		bool ConsumeWord(char const* word)
+		{
+			uint32_t length = strlen(word);
+			if (static_cast<uint64_t>(m_end - m_p) < length || memcmp(m_p, word, length) != 0)
+				return false;
+			m_p += length;
+			return true;
+		}
+
+		static void AppendUtf8(String& out, uint32_t code)
+		{
+			if (code < 0x80)
+				out.push_back(code);
+			else if (code < 0x800)
+			{
+				out.push_back(0xc0 | code >> 6);
+				out.push_back(0x80 | (code & 0x3f));
+			}
+			else if (code < 0x10000)
+			{
+				out.push_back(0xe0 | code >> 12);
+				out.push_back(0x80 | (code >> 6 & 0x3f));
+				out.push_back(0x80 | (code & 0x3f));
+			}
+			else
+			{
+				out.push_back(0xf0 | code >> 18);
+				out.push_back(0x80 | (code >> 12 & 0x3f));
+				out.push_back(0x80 | (code >> 6 & 0x3f));
+				out.push_back(0x80 | (code & 0x3f));
+			}
+		}
+
+		bool ParseHex(uint32_t& out)
+		{
+			if (m_end - m_p < 4)
+				return false;
+			out = 0;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				char c = *m_p++;
+				uint32_t digit;
+				if (c >= '0' && c <= '9')
+					digit = c - '0';
+				else if (c >= 'a' && c <= 'f')
+					digit = c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					digit = c - 'A' + 10;
+				else
+					return false;
+				out = out << 4 | digit;
+			}
+			return true;
+		}
+
+		bool ParseString(String& out)
+		{
+			if (!Consume('"'))
+				return false;
+			while (m_p < m_end && *m_p != '"')
+			{
+				if (*m_p != '\\')
+				{
+					out.push_back(*m_p++);
+					continue;
+				}
+				if (++m_p == m_end)
+					return false;
+				char c = *m_p++;
+				switch (c)
+				{
+					case 'b': out.push_back('\b'); break;
+					case 'f': out.push_back('\f'); break;
+					case 'n': out.push_back('\n'); break;
+					case 'r': out.push_back('\r'); break;
+					case 't': out.push_back('\t'); break;
+					case 'u':
+					{
+						uint32_t code, low;
+						if (!ParseHex(code))
+							return false;
+						if (code - 0xd800 < 0x400 && ConsumeWord("\\u") && ParseHex(low) && low - 0xdc00 < 0x400)
+							code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+						AppendUtf8(out, code);
+						break;
+					}
+					default: out.push_back(c); break;
+				}
+			}
+			return Consume('"');
+		}
+
+		bool ParseValue(JsonValue& out, uint32_t depth)
+		{
+			SkipSpace();
+			if (m_p == m_end || depth > k_maxDepth)
+				return false;
+			if (*m_p == '"')
+			{
+				out.type = JsonValue::Type::String;
+				return ParseString(out.string);
+			}
+			if (*m_p == '[' || *m_p == '{')
+			{
+				bool isObject = *m_p++ == '{';
+				out.type = isObject ? JsonValue::Type::Object : JsonValue::Type::Array;
+				if (Consume(isObject ? '}' : ']'))
+					return true;
+				do
+				{
+					if (isObject && (!ParseString(out.keys.emplace_back()) || !Consume(':')))
+						return false;
+					if (!ParseValue(out.elements.emplace_back(), depth + 1))
+						return false;
+				} while (Consume(','));
+				return Consume(isObject ? '}' : ']');
+			}
+			if (ConsumeWord("true") || ConsumeWord("false"))
+			{
+				out.type = JsonValue::Type::Bool;
+				out.number = m_p[-1] == 'e' && m_p[-2] == 'u';
+				return true;
+			}
+			if (ConsumeWord("null"))
+				return true;
+			// strtod stops at the end of the number, the text is null-terminated.
+			char* end;
+			out.number = strtod(m_p, &end);
+			if (end == m_p || end > m_end)
+				return false;
+			out.type = JsonValue::Type::Number;
+			m_p = end;
+			return true;
+		}
+
+	public:
+		JsonParser(char const* text, uint32_t length) : m_p(text), m_end(text + length) {}
+
+		bool Parse(JsonValue& out)
+		{
+			if (!ParseValue(out, 0))
+				return false;
+			SkipSpace();
+			return m_p == m_end;
+		}
+	};
+
+	Entry s_entries[Benchmark::k_maxBenchmarks];
+	uint32_t s_numEntries = 0;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Running
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+void BenchmarkState::SetCounter(char const* name, double value)
+{
+	for (uint32_t i = 0; i < m_numCounters; i++)
+	{
+		if (strcmp(m_counterNames[i], name) == 0)
+		{
+			m_counters[i] = value;
+			return;
+		}
+	}
+	if (m_numCounters == k_maxCounters)
+		return;
+	m_counterNames[m_numCounters] = name;
+	m_counters[m_numCounters++] = value;
+}
+
+bool Benchmark::Register(char const* name, FunctionPtr<void(BenchmarkState&)> function)
+{
+	if (s_numEntries == k_maxBenchmarks)
+	{
+		fprintf(stderr, "Too many benchmarks, %s is left out.\n", name);
+		return false;
+	}
+	s_entries[s_numEntries++] = { name, function };
+	return true;
+}
+
+void Benchmark::UseAddress(char const volatile*) {}
+
+uint64_t Benchmark::RunSample(uint32_t index, uint64_t iterations, BenchmarkState& state)
+{
+	state.m_iterations = iterations;
+	state.m_begin = 0;
+	state.m_end = 0;
+	s_entries[index].function(state);
+	if (state.m_error == nullptr && (state.m_begin == 0 || state.m_end == 0))
+		state.m_error = "The benchmark never finished its timed loop.";
+	if (state.m_error != nullptr)
+		return 0;
+	return Max(state.m_end - state.m_begin, static_cast<uint64_t>(1));
+}
+
+static bool Matches(char const* name, Options const& options)
+{
+	if (options.filters.empty())
+		return true;
+	for (String const& filter : options.filters)
+	{
+		if (strstr(name, filter.c_str()) != nullptr)
+			return true;
+	}
+	return false;
+}
+
+static double Median(Vector<double> values)
+{
+	if (values.empty())
+		return 0.0;
+	eastl::sort(values.begin(), values.end());
+	uint32_t middle = values.size() / 2;
+	return values.size() % 2 != 0 ? values[middle] : (values[middle - 1] + values[middle]) * 0.5;
+}
+
+static Summary Summarize(Vector<double> const& samples)
+{
+	Summary summary = {};
+	if (samples.empty())
+		return summary;
+	summary.median = Median(samples);
+	summary.min = samples[0];
+	summary.max = samples[0];
+	double sum = 0.0;
+	for (double sample : samples)
+	{
+		sum += sample;
+		summary.min = Min(summary.min, sample);
+		summary.max = Max(summary.max, sample);
+	}
+	summary.mean = sum / samples.size();
+	double squares = 0.0;
+	Vector<double> deviations;
+	deviations.reserve(samples.size());
+	for (double sample : samples)
+	{
+		squares += (sample - summary.mean) * (sample - summary.mean);
+		deviations.push_back(fabs(sample - summary.median));
+	}
+	summary.stddev = samples.size() > 1 ? sqrt(squares / (samples.size() - 1)) : 0.0;
+	summary.mad = Median(std::move(deviations));
+	return summary;
+}
+
+static void PrintThroughput(char* buffer, uint32_t size, Result const& result, double nanoseconds)
+{
+	buffer[0] = '\0';
+	if (nanoseconds <= 0.0)
+		return;
+	if (result.bytes != 0)
+		snprintf(buffer, size, "%.3f GB/s", result.bytes / nanoseconds);
+	else if (result.items != 0)
+		snprintf(buffer, size, "%.3f M/s", result.items / nanoseconds * 1e3);
+}
+
+static void PrintResult(Result const& result)
+{
+	if (!result.error.empty())
+	{
+		printf("%-48s FAILED: %s\n", result.name.c_str(), result.error.c_str());
+		return;
+	}
+	Summary summary = Summarize(result.samples);
+	char throughput[32];
+	PrintThroughput(throughput, sizeof(throughput), result, summary.median);
+	printf("%-48s %14.2f %7.1f%% %14s", result.name.c_str(), summary.median, summary.median > 0.0 ? summary.mad / summary.median * 100.0 : 0.0, throughput);
+	for (auto const& [name, value] : result.counters)
+		printf("  %s=%.4g", name.c_str(), value);
+	printf("\n");
+}
+
+// Grows the iteration count until a sample lasts the minimum time, then takes the samples at that count.
+static Result Run(uint32_t index, Options const& options, double ticksPerNanosecond)
+{
+	Result result;
+	result.name = s_entries[index].name;
+	uint64_t minTicks = static_cast<uint64_t>(options.minTime * 1e9 * ticksPerNanosecond);
+	uint64_t iterations = 1;
+	uint64_t ticks;
+	for (;;)
+	{
+		BenchmarkState state;
+		ticks = Benchmark::RunSample(index, iterations, state);
+		if (ticks == 0)
+		{
+			result.error = state.Error();
+			return result;
+		}
+		if (ticks >= minTicks || iterations >= 1ULL << 40)
+			break;
+		// Aim a bit past the minimum, but don't trust tiny samples to scale linearly.
+		double scale = Min(Max(minTicks * 1.4 / ticks, 2.0), 100.0);
+		iterations = static_cast<uint64_t>(iterations * scale);
+	}
+	result.iterations = iterations;
+	for (uint32_t i = 0; i < options.repetitions; i++)
+	{
+		BenchmarkState state;
+		ticks = Benchmark::RunSample(index, iterations, state);
+		if (ticks == 0)
+		{
+			result.error = state.Error();
+			return result;
+		}
+		result.samples.push_back(ticks / ticksPerNanosecond / iterations);
+		result.bytes = state.BytesProcessed();
+		result.items = state.ItemsProcessed();
+		result.counters.clear();
+		for (uint32_t j = 0; j < state.NumCounters(); j++)
+			result.counters.emplace_back(state.CounterName(j), state.Counter(j));
+	}
+	return result;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Result files
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+template <typename... Args>
+static void Append(String& out, char const* format, Args... args)
+{
+	char buffer[256];
+	int32_t length = snprintf(buffer, sizeof(buffer), format, args...);
+	if (length > 0)
+		out.append(buffer, Min(static_cast<uint32_t>(length), static_cast<uint32_t>(sizeof(buffer) - 1)));
+}
+
+static void AppendJsonString(String& out, char const* string)
+{
+	out.push_back('"');
+	for (char const* p = string; *p != '\0'; p++)
+	{
+		if (*p == '"' || *p == '\\')
+			out.push_back('\\');
+		if (static_cast<uint8_t>(*p) >= 0x20)
+			out.push_back(*p);
+	}
+	out.push_back('"');
+}
+
+static char const* BuildName()
+{
+#if defined(GLEX_DEBUG)
+	return "debug";
+#elif defined(GLEX_RELEASE)
+	return "release";
+#else
+	return "test";
+#endif
+}
+
+static bool WriteResults(char const* path, Vector<Result> const& results, double ticksPerNanosecond)
+{
+	String out = "{\n\t\"context\": {";
+	Append(out, "\"timestamp\": %llu, \"cpus\": %u, \"ticks_per_ns\": %.6f, \"build\": \"%s\"", static_cast<unsigned long long>(time(nullptr)), Platform::GetProcessorCount(), ticksPerNanosecond, BuildName());
+	out.append("},\n\t\"benchmarks\": [");
+	for (uint32_t i = 0; i < results.size(); i++)
+	{
+		Result const& result = results[i];
+		out.append(i == 0 ? "\n\t\t{\"name\": " : ",\n\t\t{\"name\": ");
+		AppendJsonString(out, result.name.c_str());
+		if (!result.error.empty())
+		{
+			out.append(", \"error\": ");
+			AppendJsonString(out, result.error.c_str());
+			out.append("}");
+			continue;
+		}
+		Summary summary = Summarize(result.samples);
+		Append(out, ", \"iterations\": %llu, \"median_ns\": %.4f, \"mean_ns\": %.4f, \"stddev_ns\": %.4f, \"min_ns\": %.4f, \"max_ns\": %.4f",
+			static_cast<unsigned long long>(result.iterations), summary.median, summary.mean, summary.stddev, summary.min, summary.max);
+		if (result.bytes != 0)
+			Append(out, ", \"bytes_per_iteration\": %llu", static_cast<unsigned long long>(result.bytes));
+		if (result.items != 0)
+			Append(out, ", \"items_per_iteration\": %llu", static_cast<unsigned long long>(result.items));
+		if (!result.counters.empty())
+		{
+			out.append(", \"counters\": {");
+			for (uint32_t j = 0; j < result.counters.size(); j++)
+			{
+				if (j != 0)
+					out.append(", ");
+				AppendJsonString(out, result.counters[j].first.c_str());
+				Append(out, ": %.6g", result.counters[j].second);
+			}
+			out.append("}");
+		}
+		out.append(", \"samples_ns\": [");
+		for (uint32_t j = 0; j < result.samples.size(); j++)
+			Append(out, j == 0 ? "%.4f" : ", %.4f", result.samples[j]);
+		out.append("]}");
+	}
+	out.append("\n\t]\n}\n");
+	FileSync file(path, FileAccess::Write, FileOpen::CreateOrOverwrite);
+	return file != nullptr && file.Write(out.data(), out.size()) == out.size();
+}
+
+static bool ReadResults(char const* path, JsonValue& context, Vector<Result>& results)
+{
+	FileSync file(path, FileAccess::Read, FileOpen::OpenExisting);
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Cannot open %s.\n", path);
+		return false;
+	}
+	String text(file.Size(), '\0');
+	JsonValue root;
+	if (file.Read(text.data(), text.size()) != text.size() || !JsonParser(text.c_str(), text.size()).Parse(root) || root.type != JsonValue::Type::Object)
+	{
+		fprintf(stderr, "%s is not a benchmark result file.\n", path);
+		return false;
+	}
+	if (JsonValue const* value = root.Find("context"))
+		context = *value;
+	JsonValue const* benchmarks = root.Find("benchmarks");
+	if (benchmarks == nullptr || benchmarks->type != JsonValue::Type::Array)
+	{
+		fprintf(stderr, "%s has no benchmarks.\n", path);
+		return false;
+	}
+	for (JsonValue const& benchmark : benchmarks->elements)
+	{
+		JsonValue const* name = benchmark.Find("name");
+		if (name == nullptr || name->type != JsonValue::Type::String)
+			continue;
+		Result& result = results.emplace_back();
+		result.name = name->string;
+		if (JsonValue const* error = benchmark.Find("error"))
+			result.error = error->string;
+		if (JsonValue const* samples = benchmark.Find("samples_ns"))
+		{
+			for (JsonValue const& sample : samples->elements)
+			{
+				if (sample.type == JsonValue::Type::Number)
+					result.samples.push_back(sample.number);
+			}
+		}
+	}
+	return true;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Compare
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Two-sided p-value of the Mann-Whitney U test, normal approximation with tie and continuity correction.
+// It's fine from about 8 samples a side, and unlike a t-test it doesn't mind the long tail timings have.
+static double MannWhitneyP(Vector<double> const& a, Vector<double> const& b)
+{
+	struct Item
+	{
+		double value;
+		bool fromA;
+	};
+
+	Vector<Item> items;
+	items.reserve(a.size() + b.size());
+	for (double value : a)
+		items.push_back({ value, true });
+	for (double value : b)
+		items.push_back({ value, false });
+	eastl::sort(items.begin(), items.end(), [](Item const& lhs, Item const& rhs) { return lhs.value < rhs.value; });
+	double rankSum = 0.0;
+	double ties = 0.0;
+	uint32_t n = items.size();
+	for (uint32_t i = 0; i < n;)
+	{
+		uint32_t j = i;
+		while (j < n && items[j].value == items[i].value)
+			j++;
+		// Ties share the average of ranks i + 1 to j.
+		double rank = (i + 1 + j) * 0.5;
+		for (uint32_t k = i; k < j; k++)
+		{
+			if (items[k].fromA)
+				rankSum += rank;
+		}
+		double t = j - i;
+		ties += t * t * t - t;
+		i = j;
+	}
+	double n1 = a.size();
+	double n2 = b.size();
+	double u = rankSum - n1 * (n1 + 1.0) * 0.5;
+	// Small samples without ties get the exact distribution, the normal one can't go below about 0.02 with 5 and 5.
+	if (ties == 0.0 && a.size() * b.size() <= 400)
+	{
+		uint32_t maxU = a.size() * b.size();
+		// counts[j][k]: orderings of i values of a and j values of b where U is k, built up one i at a time.
+		Vector<Vector<double>> counts(b.size() + 1, Vector<double>(maxU + 1, 0.0));
+		for (uint32_t j = 0; j <= b.size(); j++)
+			counts[j][0] = 1.0;
+		for (uint32_t i = 1; i <= a.size(); i++)
+		{
+			Vector<Vector<double>> next(b.size() + 1, Vector<double>(maxU + 1, 0.0));
+			next[0][0] = 1.0;
+			for (uint32_t j = 1; j <= b.size(); j++)
+			{
+				// Either the largest value is from a and beats all j of b, or it's from b.
+				for (uint32_t k = 0; k <= maxU; k++)
+					next[j][k] = (k >= j ? counts[j][k - j] : 0.0) + next[j - 1][k];
+			}
+			counts = std::move(next);
+		}
+		double total = 0.0, below = 0.0, above = 0.0;
+		for (uint32_t k = 0; k <= maxU; k++)
+		{
+			total += counts[b.size()][k];
+			below += k <= u ? counts[b.size()][k] : 0.0;
+			above += k >= u ? counts[b.size()][k] : 0.0;
+		}
+		return Min(2.0 * Min(below, above) / total, 1.0);
+	}
+	double variance = n1 * n2 / 12.0 * ((n + 1.0) - ties / (static_cast<double>(n) * (n - 1.0)));
+	if (variance <= 0.0)
+		return 1.0;
+	double z = Max(fabs(u - n1 * n2 * 0.5) - 0.5, 0.0) / sqrt(variance);
+	return erfc(z / sqrt(2.0));
+}
+
+static char const* ContextString(JsonValue const& context, char const* key)
+{
+	JsonValue const* value = context.Find(key);
+	return value != nullptr && value->type == JsonValue::Type::String ? value->string.c_str() : "";
+}
+
+static double ContextNumber(JsonValue const& context, char const* key)
+{
+	JsonValue const* value = context.Find(key);
+	return value != nullptr && value->type == JsonValue::Type::Number ? value->number : 0.0;
+}
+
+static int32_t Compare(Options const& options)
+{
+	JsonValue baselineContext, currentContext;
+	Vector<Result> baseline, current;
+	if (!ReadResults(options.baselinePath, baselineContext, baseline) || !ReadResults(options.currentPath, currentContext, current))
+		return 2;
+	if (strcmp(ContextString(baselineContext, "build"), ContextString(currentContext, "build")) != 0 || ContextNumber(baselineContext, "cpus") != ContextNumber(currentContext, "cpus"))
+		printf("Warning: the files come from different builds or machines.\n");
+
+	uint32_t numRegressions = 0;
+	uint32_t numImprovements = 0;
+	printf("%-48s %14s %14s %9s %9s\n", "benchmark", "base ns", "new ns", "change", "p");
+	for (Result const& after : current)
+	{
+		Result const* before = nullptr;
+		for (Result const& result : baseline)
+		{
+			if (result.name == after.name)
+			{
+				before = &result;
+				break;
+			}
+		}
+		if (before == nullptr)
+		{
+			printf("%-48s %14s %14.2f %9s %9s  new\n", after.name.c_str(), "-", Median(after.samples), "", "");
+			continue;
+		}
+		if (!before->error.empty() || !after.error.empty() || before->samples.empty() || after.samples.empty())
+		{
+			printf("%-48s failed in %s\n", after.name.c_str(), !after.error.empty() || after.samples.empty() ? "the new run" : "the baseline");
+			continue;
+		}
+		if (!Matches(after.name.c_str(), options))
+			continue;
+		double baseMedian = Median(before->samples);
+		double newMedian = Median(after.samples);
+		double change = baseMedian > 0.0 ? newMedian / baseMedian - 1.0 : 0.0;
+		double p = MannWhitneyP(before->samples, after.samples);
+		char const* verdict = "";
+		if (before->samples.size() < 3 || after.samples.size() < 3)
+			verdict = "too few samples";
+		else if (p < options.alpha && change > options.threshold)
+		{
+			verdict = "REGRESSION";
+			numRegressions++;
+		}
+		else if (p < options.alpha && change < -options.threshold)
+		{
+			verdict = "improved";
+			numImprovements++;
+		}
+		printf("%-48s %14.2f %14.2f %+8.1f%% %9.2g  %s\n", after.name.c_str(), baseMedian, newMedian, change * 100.0, p, verdict);
+	}
+	for (Result const& before : baseline)
+	{
+		bool found = false;
+		for (Result const& result : current)
+			found |= result.name == before.name;
+		if (!found && Matches(before.name.c_str(), options))
+			printf("%-48s %14.2f %14s %9s %9s  gone\n", before.name.c_str(), Median(before.samples), "-", "", "");
+	}
+	printf("%u regression(s), %u improvement(s) beyond %.1f%% at p < %g.\n", numRegressions, numImprovements, options.threshold * 100.0, options.alpha);
+	return numRegressions != 0 ? 1 : 0;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Command line
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+static void PrintUsage()
+{
+	printf(
+		"Usage: bench [options]\n"
+		"  --list                Lists the benchmarks and exits.\n"
+		"  --filter a,b          Runs the benchmarks whose names contain any of the substrings.\n"
+		"  --repetitions n       Samples per benchmark, 15 by default.\n"
+		"  --min-time ms         Shortest sample, 20 by default.\n"
+		"  --out path            Also writes the results as JSON.\n"
+		"  --compare base new    Compares two result files instead of running, exits with 1 on regressions.\n"
+		"  --threshold percent   Smallest change of the median compare flags, 5 by default.\n"
+		"  --alpha p             Significance level of compare, 0.01 by default.\n");
+}
+
+static bool ParseOptions(int32_t argc, char** argv, Options& options)
+{
+	for (int32_t i = 1; i < argc; i++)
+	{
+		char const* arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (strcmp(arg, "--list") == 0)
+			options.list = true;
+		else if (strcmp(arg, "--filter") == 0 && hasValue)
+		{
+			for (char const* p = argv[++i]; *p != '\0';)
+			{
+				char const* comma = strchr(p, ',');
+				uint32_t length = comma != nullptr ? comma - p : strlen(p);
+				if (length != 0)
+					options.filters.emplace_back(p, length);
+				p += length + (comma != nullptr ? 1 : 0);
+			}
+		}
+		else if (strcmp(arg, "--repetitions") == 0 && hasValue)
+			options.repetitions = Max(atoi(argv[++i]), 1);
+		else if (strcmp(arg, "--min-time") == 0 && hasValue)
+			options.minTime = Max(atof(argv[++i]), 0.001) * 1e-3;
+		else if (strcmp(arg, "--out") == 0 && hasValue)
+			options.outPath = argv[++i];
+		else if (strcmp(arg, "--compare") == 0 && i + 2 < argc)
+		{
+			options.baselinePath = argv[++i];
+			options.currentPath = argv[++i];
+		}
+		else if (strcmp(arg, "--threshold") == 0 && hasValue)
+			options.threshold = Max(atof(argv[++i]), 0.0) * 0.01;
+		else if (strcmp(arg, "--alpha") == 0 && hasValue)
+			options.alpha = atof(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Unknown option %s.\n", arg);
+			return false;
+		}
+	}
+	return true;
+}
+
+int32_t Benchmark::Main(int32_t argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 2;
+	}
+	if (options.baselinePath != nullptr)
+		return Compare(options);
+
+	eastl::sort(s_entries, s_entries + s_numEntries, [](Entry const& lhs, Entry const& rhs) { return strcmp(lhs.name, rhs.name) < 0; });
+	if (options.list)
+	{
+		for (uint32_t i = 0; i < s_numEntries; i++)
+			printf("%s\n", s_entries[i].name);
+		return 0;
+	}
+
+	double ticksPerNanosecond = Time::TicksPerSecond() * 1e-9;
+	Vector<Result> results;
+	printf("%-48s %14s %8s %14s\n", "benchmark", "ns/iteration", "mad", "throughput");
+	for (uint32_t i = 0; i < s_numEntries; i++)
+	{
+		if (!Matches(s_entries[i].name, options))
+			continue;
+		Result& result = results.emplace_back(Run(i, options, ticksPerNanosecond));
+		PrintResult(result);
+		fflush(stdout);
+	}
+	if (options.outPath != nullptr && !WriteResults(options.outPath, results, ticksPerNanosecond))
+	{
+		fprintf(stderr, "Cannot write %s.\n", options.outPath);
+		return 2;
+	}
+	for (Result const& result : results)
+	{
+		if (!result.error.empty())
+			return 1;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+/**
+ * Headless microbenchmarks.
+ * A benchmark is a function registered with GLEX_BENCHMARK. Whatever it does before its timed loop is setup:
+ *
+ *     GLEX_BENCHMARK("memory/frame_alloc_64")
+ *     {
+ *         for (auto _ : state)
+ *             Benchmark::KeepAlive(FrameMemory::Allocate(64, 16));
+ *     }
+ *
+ * The runner picks an iteration count so one sample lasts the minimum time, then takes a number of samples,
+ * each calling the function again. Results go to the console and optionally to a JSON file. Compare mode reads
+ * two of those files and runs a Mann-Whitney U test per benchmark, so noise isn't reported as a regression.
+ *
+ * Nothing here needs a window or a GPU. memory, thread, container and utils only link against Core and build
+ * on Linux too: GCC or Clang, -std=c++23 -fshort-wchar (the engine's UTF-16 is wchar_t), linking pthread,
+ * atomic (16-byte CAS) and glfw (Time). scene adds glm, zlib, Engine/ECS/transform.cpp and
+ * Engine/Renderer/frustum.cpp. gui needs the engine library, it never starts the renderer. CMakeLists.txt here
+ * builds all of that.
+ */
+#pragma once
+#include "Core/commdefs.h"
+#include "Core/Platform/time.h"
+#include "Core/Platform/platform.h"
+#include "Core/Container/basic.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/thread.h"
+
+namespace glex
+{
+	class BenchmarkState : private Uncopyable
+	{
+	public:
+		constexpr static uint32_t k_maxCounters = 4;
+
+		// Loops that don't need the index take it as auto _, the type keeps that from warning as unused.
+		struct [[maybe_unused]] Index
+		{
+			uint64_t value;
+			operator uint64_t() const { return value; }
+		};
+
+		// Ending the loop stops the clock, so teardown after it isn't timed either.
+		class Iterator
+		{
+		private:
+			BenchmarkState* m_state;
+			uint64_t m_index;
+
+		public:
+			Iterator(BenchmarkState* state, uint64_t index) : m_state(state), m_index(index) {}
+			Index operator*() const { return { m_index }; }
+			Iterator& operator++() { m_index++; return *this; }
+
+			bool operator!=(Iterator const& rhs) const
+			{
+				if (m_index != rhs.m_index) GLEX_LIKELY
+					return true;
+				m_state->m_end = Time::Ticks();
+				return false;
+			}
+		};
+
+	private:
+		friend class Benchmark;
+
+		uint64_t m_iterations = 0;
+		uint64_t m_begin = 0;
+		uint64_t m_end = 0;
+		uint64_t m_bytes = 0;
+		uint64_t m_items = 0;
+		char const* m_counterNames[k_maxCounters] = {};
+		double m_counters[k_maxCounters] = {};
+		uint32_t m_numCounters = 0;
+		char const* m_error = nullptr;
+
+	public:
+		uint64_t Iterations() const { return m_iterations; }
+		Iterator begin() { m_begin = Time::Ticks(); return Iterator(this, 0); }
+		Iterator end() { return Iterator(this, m_iterations); }
+		// Per iteration, reported as throughput.
+		void SetBytesProcessed(uint64_t bytes) { m_bytes = bytes; }
+		void SetItemsProcessed(uint64_t items) { m_items = items; }
+		// Reported as is from the last sample, for things like hit rates. Names must be literals.
+		void SetCounter(char const* name, double value);
+		// Return right after. The benchmark reports the message instead of timings.
+		void Fail(char const* message) { m_error = message; }
+		bool HasFailed() const { return m_error != nullptr; }
+
+		uint64_t BytesProcessed() const { return m_bytes; }
+		uint64_t ItemsProcessed() const { return m_items; }
+		uint32_t NumCounters() const { return m_numCounters; }
+		char const* CounterName(uint32_t index) const { return m_counterNames[index]; }
+		double Counter(uint32_t index) const { return m_counters[index]; }
+		char const* Error() const { return m_error; }
+	};
+
+	class Benchmark : private StaticClass
+	{
+	public:
+		constexpr static uint32_t k_maxBenchmarks = 512;
+
+		// Names must be literals, they're grouped by the part before the first slash.
+		static bool Register(char const* name, FunctionPtr<void(BenchmarkState&)> function);
+		// Runs the command line, see the usage it prints. Returns the exit code.
+		static int32_t Main(int32_t argc, char** argv);
+		// Runs the benchmark once with the iteration count. Returns the ticks its timed loop took, zero if it failed.
+		static uint64_t RunSample(uint32_t index, uint64_t iterations, BenchmarkState& state);
+
+		// Keeps the compiler from dropping the computation of value.
+		template <typename T>
+		static void KeepAlive(T const& value)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			UseAddress(&reinterpret_cast<char const volatile&>(value));
+			_ReadWriteBarrier();
+#else
+			asm volatile("" : : "r,m"(value) : "memory");
+#endif
+		}
+
+		// Splitmix64, cheap enough to sit in a timed loop. Benchmarks seed their own state so runs are repeatable.
+		static uint64_t Random(uint64_t& state)
+		{
+			uint64_t z = state += 0x9e3779b97f4a7c15ULL;
+			z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ z >> 27) * 0x94d049bb133111ebULL;
+			return z ^ z >> 31;
+		}
+
+		// For benchmarks that scale to every core, at least two so there's contention.
+		static uint32_t AllThreads() { return Max(Platform::GetProcessorCount(), 2u); }
+
+		// Makes the compiler forget what it knew about memory, so stores before it aren't dropped.
+		static void ClobberMemory()
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			_ReadWriteBarrier();
+#else
+			asm volatile("" : : : "memory");
+#endif
+		}
+
+	private:
+		static void UseAddress(char const volatile* p);
+	};
+}
+
+namespace glex
+{
+	// Calls fn in a loop on other threads until destroyed. Created before the timed loop, it measures under contention.
+	// fn is shared by all the threads and must not block, or they won't see the stop.
+	template <typename Fn>
+	class ContendingThreads : private Unmoveable
+	{
+	private:
+		Vector<Thread> m_threads;
+		uint32_t m_stop = 0;
+		Fn m_fn;
+
+	public:
+		ContendingThreads(uint32_t count, Fn fn) : m_fn(std::move(fn))
+		{
+			// Threads keep a pointer to themselves, they mustn't move.
+			m_threads.reserve(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				Thread& thread = m_threads.emplace_back([this]()
+				{
+					while (Atomic::Load(&m_stop) == 0)
+						m_fn();
+				}, ThreadPriority::Normal);
+				thread.Resume();
+			}
+		}
+
+		~ContendingThreads()
+		{
+			Atomic::Store(&m_stop, 1u);
+			for (Thread& thread : m_threads)
+				thread.Wait();
+		}
+	};
+}
+
+#define GLEX_BENCHMARK_CONCAT_INNER(a, b) a##b
+#define GLEX_BENCHMARK_CONCAT(a, b) GLEX_BENCHMARK_CONCAT_INNER(a, b)
+#define GLEX_BENCHMARK(name) \
+	static void GLEX_BENCHMARK_CONCAT(Benchmark, __LINE__)(::glex::BenchmarkState& state); \
+	static bool const GLEX_BENCHMARK_CONCAT(s_registered, __LINE__) = ::glex::Benchmark::Register(name, GLEX_BENCHMARK_CONCAT(Benchmark, __LINE__)); \
+	static void GLEX_BENCHMARK_CONCAT(Benchmark, __LINE__)(::glex::BenchmarkState& state)
@@ -0,0 +1,279 @@
+#include "Benchmarks/bench.h"
+#include "Core/Container/bounded_queue.h"
+#include "Core/Container/cache.h"
+#include "Core/Container/handle_pool.h"
+#include "Core/Container/list.h"
+#include "Core/Memory/smart_ptr.h"
+#include <EASTL/algorithm.h>
+#include <EASTL/hash_map.h>
+#include <math.h>
+#include <stdio.h>
+
+using namespace glex;
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Queues and lists
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// The timed thread is one of the producers. Pushes block when the queue is full, so a slow side shows.
+static void MPMCThroughput(BenchmarkState& state, uint32_t numProducers, uint32_t numConsumers)
+{
+	MPMCQueue<uint64_t> queue(1024);
+	uint64_t sum = 0;
+	ContendingThreads consumers(numConsumers, [&]()
+	{
+		uint64_t value;
+		if (queue.TryPop(value))
+			Atomic::Add(&sum, value);
+	});
+	ContendingThreads producers(numProducers - 1, [&]() { queue.TryPush(static_cast<uint64_t>(1)); });
+	for (uint64_t i : state)
+		queue.Push(i);
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("container/mpmc_1p1c") { MPMCThroughput(state, 1, 1); }
+GLEX_BENCHMARK("container/mpmc_4p4c") { MPMCThroughput(state, 4, 4); }
+
+GLEX_BENCHMARK("container/spsc_1p1c")
+{
+	SPSCQueue<uint64_t> queue(1024);
+	uint64_t sum = 0;
+	ContendingThreads consumer(1, [&]()
+	{
+		uint64_t value;
+		if (queue.TryPop(value))
+			sum += value;
+	});
+	for (uint64_t i : state)
+		queue.Push(i);
+	state.SetItemsProcessed(1);
+}
+
+// Every thread pushes its own range of values and pops whatever is on top. What's left is drained afterwards, each value
+// has to come out exactly once, or nodes were lost or handed out twice.
+static bool CheckLockFreeList(uint32_t numThreads)
+{
+	constexpr uint32_t k_valuesPerThread = 20000;
+	LockFreeList<uint32_t> list;
+	Vector<uint32_t> timesSeen(numThreads * k_valuesPerThread, 0u);
+	Vector<Thread> threads;
+	threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		Thread& thread = threads.emplace_back([&, i]()
+		{
+			for (uint32_t j = 0; j < k_valuesPerThread; j++)
+			{
+				uint32_t value;
+				list.Push(i * k_valuesPerThread + j);
+				if (j % 3 != 0 && list.Pop(value))
+					Atomic::Increment(&timesSeen[value]);
+			}
+		}, ThreadPriority::Normal);
+		thread.Resume();
+	}
+	for (Thread& thread : threads)
+		thread.Wait();
+	uint32_t value;
+	while (list.Pop(value))
+		timesSeen[value]++;
+	for (uint32_t count : timesSeen)
+	{
+		if (count != 1)
+			return false;
+	}
+	return true;
+}
+
+// Every thread pushes and pops its own values, so the list stays short and the head is what they fight over.
+static void LockFreeListThroughput(BenchmarkState& state, uint32_t numThreads)
+{
+	if (!CheckLockFreeList(Max(numThreads, 2u)))
+	{
+		state.Fail("LockFreeList lost or duplicated a value.");
+		return;
+	}
+	LockFreeList<uint64_t> list;
+	ContendingThreads others(numThreads - 1, [&]()
+	{
+		uint64_t value;
+		list.Push(static_cast<uint64_t>(1));
+		list.Pop(value);
+	});
+	for (uint64_t i : state)
+	{
+		uint64_t value;
+		list.Push(static_cast<uint64_t>(i));
+		list.Pop(value);
+	}
+	state.SetItemsProcessed(2);
+}
+
+GLEX_BENCHMARK("container/lock_free_list_1") { LockFreeListThroughput(state, 1); }
+GLEX_BENCHMARK("container/lock_free_list_4") { LockFreeListThroughput(state, 4); }
+GLEX_BENCHMARK("container/lock_free_list_all") { LockFreeListThroughput(state, Benchmark::AllThreads()); }
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Cache
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+namespace
+{
+	struct CachedValue
+	{
+		uint64_t value;
+
+		CachedValue(uint64_t value) : value(value) {}
+		uint32_t CacheWeight() const { return 1; }
+	};
+
+	// Keys drawn from a Zipf distribution over 64K names, precomputed so the loop only reads them.
+	class ZipfKeys : private Unmoveable
+	{
+	public:
+		constexpr static uint32_t k_numKeys = 65536;
+		constexpr static uint32_t k_streamLength = 1 << 18;
+
+	private:
+		Vector<String> m_names;
+		Vector<uint32_t> m_stream;
+
+	public:
+		ZipfKeys(double exponent)
+		{
+			m_names.reserve(k_numKeys);
+			char buffer[32];
+			for (uint32_t i = 0; i < k_numKeys; i++)
+			{
+				snprintf(buffer, sizeof(buffer), "asset/%u", i);
+				m_names.emplace_back(buffer);
+			}
+			Vector<double> cdf(k_numKeys);
+			double sum = 0.0;
+			for (uint32_t i = 0; i < k_numKeys; i++)
+				cdf[i] = sum += 1.0 / pow(i + 1.0, exponent);
+			uint64_t random = 7;
+			m_stream.reserve(k_streamLength);
+			for (uint32_t i = 0; i < k_streamLength; i++)
+			{
+				double target = (Benchmark::Random(random) >> 11) * 0x1.0p-53 * sum;
+				m_stream.push_back(eastl::lower_bound(cdf.begin(), cdf.end(), target) - cdf.begin());
+			}
+		}
+
+		char const* operator[](uint64_t i) const { return m_names[m_stream[i % k_streamLength]].c_str(); }
+	};
+
+	ZipfKeys const& Keys()
+	{
+		static ZipfKeys keys(0.9);
+		return keys;
+	}
+}
+
+// Capacity is 1/16th of the keys. The hit rate of the timed part is reported, it's what the admission policy buys.
+static void CacheLookups(BenchmarkState& state, uint32_t numThreads)
+{
+	ZipfKeys const& keys = Keys();
+	Cache<CachedValue> cache(ZipfKeys::k_numKeys / 16, ZipfKeys::k_numKeys / 16);
+	for (uint32_t i = 0; i < ZipfKeys::k_streamLength; i++)
+		cache.Get(keys[i], i);
+	CacheStats before = cache.GetStats();
+	{
+		ContendingThreads others(numThreads - 1, [&]()
+		{
+			thread_local uint64_t t_index = Thread::GetThreadID() * 7919ULL;
+			uint64_t index = t_index++;
+			Benchmark::KeepAlive(cache.Get(keys[index], index)->value);
+		});
+		for (uint64_t i : state)
+			Benchmark::KeepAlive(cache.Get(keys[i], i)->value);
+	}
+	CacheStats after = cache.GetStats();
+	uint64_t hits = after.hits - before.hits;
+	uint64_t lookups = hits + after.misses - before.misses;
+	state.SetCounter("hit_rate", lookups != 0 ? static_cast<double>(hits) / lookups : 0.0);
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("container/cache_zipf_1") { CacheLookups(state, 1); }
+GLEX_BENCHMARK("container/cache_zipf_4") { CacheLookups(state, 4); }
+GLEX_BENCHMARK("container/cache_zipf_all") { CacheLookups(state, Benchmark::AllThreads()); }
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Lookups
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+namespace
+{
+	struct PooledObject
+	{
+		uint64_t payload[4];
+	};
+
+	constexpr uint32_t k_numObjects = 16384;
+}
+
+// Random lookups of live objects, the ways resources have been addressed: handles, shared pointers, IDs in a map.
+GLEX_BENCHMARK("container/handle_pool_get")
+{
+	HandlePool<PooledObject> pool;
+	Vector<Handle<PooledObject>> handles;
+	for (uint32_t i = 0; i < k_numObjects; i++)
+		handles.push_back(pool.Insert(PooledObject { { i } }));
+	uint64_t random = 1;
+	uint64_t sum = 0;
+	for (auto _ : state)
+		sum += pool.Get(handles[Benchmark::Random(random) % k_numObjects])->payload[0];
+	Benchmark::KeepAlive(sum);
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("container/shared_ptr_deref")
+{
+	Vector<SharedPtr<PooledObject>> objects;
+	for (uint32_t i = 0; i < k_numObjects; i++)
+		objects.push_back(MakeShared<PooledObject>(PooledObject { { i } }));
+	uint64_t random = 1;
+	uint64_t sum = 0;
+	for (auto _ : state)
+	{
+		// Copied like an owner handing it out would.
+		SharedPtr<PooledObject> object = objects[Benchmark::Random(random) % k_numObjects];
+		sum += object->payload[0];
+	}
+	Benchmark::KeepAlive(sum);
+	state.SetItemsProcessed(1);
+}
+
+template <typename Map>
+static void MapFind(BenchmarkState& state)
+{
+	Map map;
+	for (uint32_t i = 0; i < k_numObjects; i++)
+		map[HashInt(i)] = PooledObject { { i } };
+	uint64_t random = 1;
+	uint64_t sum = 0;
+	for (auto _ : state)
+		sum += map.find(HashInt(Benchmark::Random(random) % k_numObjects))->second.payload[0];
+	Benchmark::KeepAlive(sum);
+	state.SetItemsProcessed(1);
+}
+
+template <typename Map>
+static void MapInsertErase(BenchmarkState& state)
+{
+	constexpr uint32_t k_window = 4096;
+	Map map;
+	for (uint64_t i : state)
+	{
+		map[HashInt(i)] = PooledObject { { i } };
+		if (i >= k_window)
+			map.erase(HashInt(i - k_window));
+	}
+	Benchmark::KeepAlive(map.size());
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("container/flat_hash_map_find") { MapFind<FlatHashMap<uint64_t, PooledObject>>(state); }
+GLEX_BENCHMARK("container/eastl_hash_map_find") { MapFind<eastl::hash_map<uint64_t, PooledObject>>(state); }
+GLEX_BENCHMARK("container/flat_hash_map_insert_erase") { MapInsertErase<FlatHashMap<uint64_t, PooledObject>>(state); }
+GLEX_BENCHMARK("container/eastl_hash_map_insert_erase") { MapInsertErase<eastl::hash_map<uint64_t, PooledObject>>(state); }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Benchmarks/bench.h"
+#include "Engine/GUI/batch.h"
+#include "Engine/GUI/color_block.h"
+#include "Engine/GUI/stack_panel.h"
+
+using namespace glex;
+using namespace glex::ui;
+
+namespace
+{
+	constexpr uint32_t k_numRows = 100;
+	constexpr uint32_t k_numColumns = 100;
+	constexpr uint32_t k_numControls = 1 + k_numRows + k_numRows * k_numColumns;
+	glm::vec2 const k_screenSize = glm::vec2(1920.0f, 1080.0f);
+
+	// A vertical box of rows, each a horizontal box of color blocks. Nothing is painted, so no renderer is needed.
+	struct ControlTree
+	{
+		UniquePtr<VerticalBox> root;
+		Vector<ColorBlock*> leaves;
+
+		ControlTree() : root(MakeUnique<VerticalBox>())
+		{
+			leaves.reserve(k_numRows * k_numColumns);
+			for (uint32_t row = 0; row < k_numRows; row++)
+			{
+				UniquePtr<HorizontalBox> box = MakeUnique<HorizontalBox>();
+				for (uint32_t column = 0; column < k_numColumns; column++)
+				{
+					UniquePtr<ColorBlock> leaf = MakeUnique<ColorBlock>();
+					leaf->SetSize(glm::vec2(8.0f, 8.0f));
+					leaf->SetColor(glm::vec4(row / 100.0f, column / 100.0f, 0.5f, 1.0f));
+					// Every tenth block on top, so the sort and the batch groups have something to do.
+					leaf->SetZOrder(column % 10 == 0 ? 1 : 0);
+					leaves.push_back(leaf.Get());
+					box->PushChild(std::move(leaf));
+				}
+				root->PushChild(std::move(box));
+			}
+			Layout();
+		}
+
+		void Layout()
+		{
+			root->Measure(k_screenSize);
+			root->Arrange(glm::vec2(0.0f, 0.0f), k_screenSize);
+		}
+	};
+}
+
+// Every leaf changes size, so every control is measured and arranged again.
+GLEX_BENCHMARK("gui/relayout_full_10k")
+{
+	ControlTree tree;
+	for (uint64_t i : state)
+	{
+		float size = 8.0f + (i & 1);
+		for (ColorBlock* leaf : tree.leaves)
+			leaf->SetSize(glm::vec2(size, size));
+		tree.Layout();
+	}
+	state.SetItemsProcessed(k_numControls);
+}
+
+// One leaf changes, the caches of everything else should hold.
+GLEX_BENCHMARK("gui/relayout_one_leaf_10k")
+{
+	ControlTree tree;
+	for (uint64_t i : state)
+	{
+		float size = 8.0f + (i & 1);
+		tree.leaves[i % tree.leaves.size()]->SetSize(glm::vec2(size, size));
+		tree.Layout();
+	}
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("gui/build_draw_list_10k")
+{
+	ControlTree tree;
+	uint32_t numElements = 0;
+	for (uint64_t i : state)
+		numElements = BatchRenderer::BuildDrawList(tree.root.Get());
+	if (numElements != k_numControls)
+		state.Fail("The draw list is missing controls.");
+	state.SetItemsProcessed(k_numControls);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "Benchmarks/bench.h"
+#include "Core/log.h"
+#include "Core/Memory/framealloc.h"
+#include "Core/Platform/platform.h"
+#include "Core/Thread/coroutine.h"
+#include "Core/Thread/task.h"
+#include "Core/Thread/thread.h"
+#include "Core/Utils/profiler.h"
+
+using namespace glex;
+
+// Brings up what the engine would minus the window and the renderer, the benchmarks register themselves.
+int main(int argc, char** argv)
+{
+	Thread::FillMainThread();
+	Logger::Startup();
+	GLEX_PROFILE_THREAD("Main");
+	FrameMemory::Startup(2);
+	Async::Startup(Max(Platform::GetProcessorCount(), 2u) - 1);
+
+	int32_t result = Benchmark::Main(argc, argv);
+
+	Coroutine::Shutdown();
+	Async::Shutdown();
+	Logger::Shutdown();
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "Benchmarks/bench.h"
+#include "Core/Memory/mem.h"
+#include "Core/Memory/framealloc.h"
+#include "Core/Memory/stackalloc.h"
+#include <mimalloc.h>
+#include <stdlib.h>
+
+using namespace glex;
+
+namespace
+{
+	constexpr uint32_t k_batch = 256;
+	constexpr uint32_t k_sizes[8] = { 16, 24, 32, 48, 64, 96, 128, 256 };
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		General purpose
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Allocations are made in batches and freed in reverse, a single alloc/free pair is too easy on any allocator.
+template <typename Alloc, typename Free>
+static void AllocBatches(BenchmarkState& state, Alloc&& alloc, Free&& free)
+{
+	void* blocks[k_batch];
+	for (uint64_t i : state)
+	{
+		uint32_t slot = i % k_batch;
+		if (slot == 0 && i != 0)
+		{
+			for (uint32_t j = k_batch; j > 0; j--)
+				free(blocks[j - 1]);
+		}
+		blocks[slot] = alloc(k_sizes[i & 7]);
+		Benchmark::ClobberMemory();
+	}
+	for (uint32_t j = 0; j <= (state.Iterations() - 1) % k_batch; j++)
+		free(blocks[j]);
+	state.SetItemsProcessed(1);
+}
+
+// Against memory/mimalloc_small it's what the tag accounting costs.
+GLEX_BENCHMARK("memory/mem_alloc_small")
+{
+	AllocBatches(state, [](uint32_t size) { return Mem::Alloc(size); }, [](void* p) { Mem::Free(p); });
+}
+
+GLEX_BENCHMARK("memory/slab_alloc_small")
+{
+	AllocBatches(state, [](uint32_t size) { return Mem::SmallAlloc(size, 8); }, [](void* p) { Mem::Free(p); });
+}
+
+GLEX_BENCHMARK("memory/mimalloc_small")
+{
+	AllocBatches(state, [](uint32_t size) { return mi_malloc(size); }, [](void* p) { mi_free(p); });
+}
+
+GLEX_BENCHMARK("memory/malloc_small")
+{
+	AllocBatches(state, [](uint32_t size) { return malloc(size); }, [](void* p) { free(p); });
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Linear allocators
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// The arena runs out after a few frames' worth of 64 byte blocks, so frames are turned like the renderer would.
+GLEX_BENCHMARK("memory/frame_alloc_64")
+{
+	constexpr uint32_t k_perFrame = 64 * 1024;
+	for (uint64_t i : state)
+	{
+		if (i % k_perFrame == 0) GLEX_UNLIKELY
+			FrameMemory::BeginFrame();
+		Benchmark::KeepAlive(FrameMemory::Allocate(64, 16));
+	}
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("memory/frame_vector_push_back")
+{
+	constexpr uint32_t k_perFrame = 64 * 1024;
+	FrameMemory::BeginFrame();
+	FrameVector<uint32_t> values;
+	for (uint64_t i : state)
+	{
+		if (i % k_perFrame == 0) GLEX_UNLIKELY
+		{
+			// The memory it had is recycled two frames later.
+			FrameMemory::BeginFrame();
+			FrameVector<uint32_t>().swap(values);
+		}
+		values.push_back(i);
+	}
+	Benchmark::KeepAlive(values.size());
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("memory/stack_alloc_bookmark")
+{
+	StackAllocator allocator(Limits::MB);
+	for (uint64_t i : state)
+	{
+		auto [p, bookmark] = allocator.Allocate(k_sizes[i & 7], 16);
+		auto [q, inner] = allocator.Allocate(64, 16);
+		Benchmark::KeepAlive(p);
+		Benchmark::KeepAlive(q);
+	}
+	state.SetItemsProcessed(2);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Pages
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Random reads over a range far beyond what 4K TLB entries cover, setup commits and touches all of it.
+static void PageTouches(BenchmarkState& state, PageKind kind)
+{
+	constexpr uint64_t k_size = 256 * Limits::MB;
+	uint64_t* base = static_cast<uint64_t*>(Mem::AllocPages(k_size, kind));
+	if (base == nullptr)
+	{
+		state.Fail("Cannot reserve the pages.");
+		return;
+	}
+	Mem::CommitPages(base, k_size);
+	for (uint64_t offset = 0; offset < k_size / sizeof(uint64_t); offset += Mem::k_pageSize / sizeof(uint64_t))
+		base[offset] = offset;
+	uint64_t random = 42;
+	uint64_t sum = 0;
+	for (auto _ : state)
+		sum += base[Benchmark::Random(random) % (k_size / sizeof(uint64_t))];
+	Benchmark::KeepAlive(sum);
+	Mem::FreePages(base, k_size);
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("memory/page_touch_normal")
+{
+	PageTouches(state, PageKind::Normal);
+}
+
+GLEX_BENCHMARK("memory/page_touch_transparent")
+{
+	PageTouches(state, PageKind::Transparent);
+}
+
+GLEX_BENCHMARK("memory/page_touch_huge")
+{
+	PageTouches(state, PageKind::Huge);
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "Benchmarks/bench.h"
+#include "Engine/ECS/transform.h"
+#include "Engine/Renderer/frustum.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <string.h>
+#if __has_include(<zlib/zlib.h>)
+#include <zlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+using namespace glex;
+
+namespace
+{
+	float RandomFloat(uint64_t& random, float min, float max)
+	{
+		return min + (Benchmark::Random(random) >> 40) * 0x1.0p-24f * (max - min);
+	}
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Transforms
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// A root with 100 children of 100 children each. Moving the root dirties all of them, reading the matrices flushes them.
+GLEX_BENCHMARK("scene/transform_hierarchy_10k")
+{
+	constexpr uint32_t k_fanOut = 100;
+	constexpr uint32_t k_numNodes = 1 + k_fanOut + k_fanOut * k_fanOut;
+	// Transforms link to each other, they must not move once parented.
+	Vector<Transform> nodes(k_numNodes);
+	uint64_t random = 9;
+	for (uint32_t i = 1; i < k_numNodes; i++)
+	{
+		nodes[i].SetParent(&nodes[i <= k_fanOut ? 0 : (i - k_fanOut - 1) / k_fanOut + 1]);
+		nodes[i].SetPosition(glm::vec3(RandomFloat(random, -10.0f, 10.0f), RandomFloat(random, -10.0f, 10.0f), RandomFloat(random, -10.0f, 10.0f)));
+	}
+	for (uint64_t i : state)
+	{
+		nodes[0].Rotate(glm::vec3(0.0f, 1.0f, 0.0f), 0.01f);
+		for (Transform const& node : nodes)
+			Benchmark::KeepAlive(node.GetModelMat()[3][0]);
+	}
+	state.SetItemsProcessed(k_numNodes);
+}
+
+GLEX_BENCHMARK("scene/frustum_cull_10k")
+{
+	constexpr uint32_t k_numSpheres = 10000;
+	Vector<glm::vec4> spheres;
+	spheres.reserve(k_numSpheres);
+	uint64_t random = 13;
+	for (uint32_t i = 0; i < k_numSpheres; i++)
+		spheres.emplace_back(RandomFloat(random, -200.0f, 200.0f), RandomFloat(random, -50.0f, 50.0f), RandomFloat(random, -200.0f, 200.0f), RandomFloat(random, 0.5f, 4.0f));
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, -50.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	impl::FrustumCuller culler(proj * view);
+	uint32_t visible = 0;
+	for (uint64_t i : state)
+	{
+		visible = 0;
+		for (glm::vec4 const& sphere : spheres)
+			visible += culler.IsInside(sphere);
+		Benchmark::KeepAlive(visible);
+	}
+	state.SetCounter("visible", visible);
+	state.SetItemsProcessed(k_numSpheres);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Meshes
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// A 256x256 grid in the layout of a mesh file's data: f3f3f2 vertices, then 32-bit indices, deflated together.
+GLEX_BENCHMARK("scene/mesh_decompress_grid")
+{
+	struct Vertex
+	{
+		float position[3];
+		float normal[3];
+		float uv[2];
+	};
+
+	constexpr uint32_t k_side = 256;
+	uint32_t vertexBufferSize = k_side * k_side * sizeof(Vertex);
+	uint32_t indexBufferSize = (k_side - 1) * (k_side - 1) * 6 * sizeof(uint32_t);
+	Vector<uint8_t> data(vertexBufferSize + indexBufferSize);
+	Vertex* vertices = reinterpret_cast<Vertex*>(data.data());
+	uint32_t* indices = reinterpret_cast<uint32_t*>(data.data() + vertexBufferSize);
+	uint64_t random = 17;
+	for (uint32_t y = 0; y < k_side; y++)
+	{
+		for (uint32_t x = 0; x < k_side; x++)
+		{
+			float height = RandomFloat(random, 0.0f, 0.5f);
+			vertices[y * k_side + x] = { { static_cast<float>(x), height, static_cast<float>(y) }, { 0.0f, 1.0f, 0.0f }, { x / (k_side - 1.0f), y / (k_side - 1.0f) } };
+		}
+	}
+	for (uint32_t y = 0; y + 1 < k_side; y++)
+	{
+		for (uint32_t x = 0; x + 1 < k_side; x++)
+		{
+			uint32_t corner = y * k_side + x;
+			uint32_t quad[6] = { corner, corner + k_side, corner + 1, corner + 1, corner + k_side, corner + k_side + 1 };
+			memcpy(indices, quad, sizeof(quad));
+			indices += 6;
+		}
+	}
+	uLongf compressedSize = compressBound(data.size());
+	Vector<uint8_t> compressed(compressedSize);
+	if (compress2(compressed.data(), &compressedSize, data.data(), data.size(), Z_BEST_COMPRESSION) != Z_OK)
+	{
+		state.Fail("Cannot compress the mesh.");
+		return;
+	}
+	Vector<uint8_t> out(data.size());
+	for (uint64_t i : state)
+	{
+		uLongf size = out.size();
+		if (uncompress(out.data(), &size, compressed.data(), compressedSize) != Z_OK || size != data.size()) GLEX_UNLIKELY
+		{
+			state.Fail("The mesh doesn't decompress to what was compressed.");
+			return;
+		}
+	}
+	state.SetCounter("ratio", static_cast<double>(data.size()) / compressedSize);
+	state.SetBytesProcessed(data.size());
+}
\ No newline at end of file
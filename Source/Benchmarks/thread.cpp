@@ -0,0 +1,392 @@
+#include "Benchmarks/bench.h"
+#include "Core/Memory/memtrack.h"
+#include "Core/Thread/coroutine.h"
+#include "Core/Thread/event.h"
+#include "Core/Thread/lock.h"
+#include "Core/Thread/task.h"
+#include "Core/Thread/thread.h"
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+using namespace glex;
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Pool and tasks
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+GLEX_BENCHMARK("thread/pool_submit_wait")
+{
+	constexpr uint32_t k_batch = 64;
+	uint32_t sum = 0;
+	for (auto _ : state)
+	{
+		JobCounter counter;
+		for (uint32_t j = 0; j < k_batch; j++)
+			Async::SubmitWork([&sum]() { Atomic::Increment(&sum); }, &counter);
+		Async::Wait(counter);
+	}
+	Benchmark::KeepAlive(sum);
+	state.SetItemsProcessed(k_batch);
+}
+
+// A few dozen nanoseconds of arithmetic, written to a slot of its own so jobs don't share cache lines.
+static void SmallJob(uint32_t* result, uint32_t seed)
+{
+	uint32_t x = seed | 1;
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+	}
+	*result = x;
+}
+
+// Job count sweep: per job overhead from a batch that barely wakes the workers to one that keeps them busy.
+static void SubmitJobs(BenchmarkState& state, uint32_t count, bool isEmpty)
+{
+	Vector<uint32_t> results(isEmpty ? 0 : count * 16);
+	for (auto _ : state)
+	{
+		JobCounter counter;
+		for (uint32_t j = 0; j < count; j++)
+		{
+			if (isEmpty)
+				Async::SubmitWork([]() {}, &counter);
+			else
+				Async::SubmitWork([result = results.data() + j * 16, j]() { SmallJob(result, j); }, &counter);
+		}
+		Async::Wait(counter);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(count);
+}
+
+GLEX_BENCHMARK("thread/pool_jobs_empty_1k") { SubmitJobs(state, 1000, true); }
+GLEX_BENCHMARK("thread/pool_jobs_empty_100k") { SubmitJobs(state, 100000, true); }
+GLEX_BENCHMARK("thread/pool_jobs_empty_1m") { SubmitJobs(state, 1000000, true); }
+GLEX_BENCHMARK("thread/pool_jobs_small_1k") { SubmitJobs(state, 1000, false); }
+GLEX_BENCHMARK("thread/pool_jobs_small_100k") { SubmitJobs(state, 100000, false); }
+GLEX_BENCHMARK("thread/pool_jobs_small_1m") { SubmitJobs(state, 1000000, false); }
+
+// The small jobs run in place, what the pool has to beat.
+GLEX_BENCHMARK("thread/inline_jobs_small_100k")
+{
+	constexpr uint32_t k_count = 100000;
+	Vector<uint32_t> results(k_count * 16);
+	for (auto _ : state)
+	{
+		for (uint32_t j = 0; j < k_count; j++)
+			SmallJob(results.data() + j * 16, j);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(k_count);
+}
+
+GLEX_BENCHMARK("thread/parallel_for_4k")
+{
+	constexpr uint32_t k_count = 4096;
+	Vector<uint32_t> values(k_count, 1u);
+	for (auto _ : state)
+	{
+		Async::ParallelFor(0, k_count, 64, [&values](uint32_t index) { values[index] = values[index] * 3 + 1; });
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(k_count);
+}
+
+GLEX_BENCHMARK("thread/async_run_await")
+{
+	for (uint64_t i : state)
+		Benchmark::KeepAlive(Async::Run([i]() { return static_cast<uint32_t>(i); }).Await());
+	state.SetItemsProcessed(1);
+}
+
+// Once the block caches are warm, a task and its continuation shouldn't need Mem at all.
+GLEX_BENCHMARK("thread/task_allocations")
+{
+	uint64_t numAllocations = MemoryTracker::GetAllocationCount();
+	for (uint64_t i : state)
+		Benchmark::KeepAlive(Async::Run([i]() { return static_cast<uint32_t>(i); }).Then([](uint32_t value) { return value + 1; }).Await());
+	numAllocations = MemoryTracker::GetAllocationCount() - numAllocations;
+	state.SetCounter("allocs_per_task", static_cast<double>(numAllocations) / (state.Iterations() * 2));
+	state.SetItemsProcessed(2);
+}
+
+// Every link is a task state allocation and a continuation dispatched on completion.
+static void ThenChain(BenchmarkState& state, uint32_t length)
+{
+	for (auto _ : state)
+	{
+		Task<uint32_t> task = Async::Run([]() { return 0u; });
+		for (uint32_t j = 0; j < length; j++)
+			task = task.Then([](uint32_t value) { return value + 1; });
+		Benchmark::KeepAlive(task.Await());
+	}
+	state.SetItemsProcessed(length);
+}
+
+GLEX_BENCHMARK("thread/then_chain_100") { ThenChain(state, 100); }
+GLEX_BENCHMARK("thread/then_chain_1000") { ThenChain(state, 1000); }
+
+GLEX_BENCHMARK("thread/when_all_16")
+{
+	constexpr uint32_t k_count = 16;
+	Task<uint32_t> tasks[k_count];
+	for (auto _ : state)
+	{
+		for (uint32_t j = 0; j < k_count; j++)
+			tasks[j] = Async::Run([j]() { return j; });
+		[&]<size_t... I>(std::index_sequence<I...>) { Async::WhenAll(tasks[I]...).Await(); }(std::make_index_sequence<k_count>());
+	}
+	state.SetItemsProcessed(k_count);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Coroutines
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+static Task<uint32_t> Leaf(uint32_t value)
+{
+	co_return value + 1;
+}
+
+static Task<uint32_t> AwaitLeaves(uint32_t count)
+{
+	uint32_t sum = 0;
+	for (uint32_t i = 0; i < count; i++)
+		sum += co_await Leaf(i);
+	co_return sum;
+}
+
+static Task<uint32_t> HopWorkers(uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		co_await Coroutine::ResumeOnWorker();
+	co_return count;
+}
+
+// Frames and awaits that complete synchronously, what's left is the coroutine machinery itself.
+GLEX_BENCHMARK("thread/coroutine_await_ready")
+{
+	constexpr uint32_t k_count = 64;
+	for (auto _ : state)
+		Benchmark::KeepAlive(AwaitLeaves(k_count).Await());
+	state.SetItemsProcessed(k_count);
+}
+
+GLEX_BENCHMARK("thread/coroutine_worker_hop")
+{
+	constexpr uint32_t k_count = 16;
+	for (auto _ : state)
+		Benchmark::KeepAlive(HopWorkers(k_count).Await());
+	state.SetItemsProcessed(k_count);
+}
+
+namespace
+{
+	// Stack addresses the levels of a chain see when they resume.
+	struct StackRange
+	{
+		uintptr_t low = UINTPTR_MAX;
+		uintptr_t high = 0;
+	};
+
+	// Locals of a coroutine live in its frame, this one is on the stack of whoever resumed it.
+	void RecordStack(StackRange& range)
+	{
+		char marker = 0;
+		char* markerAddress = &marker;
+		Benchmark::KeepAlive(markerAddress);
+		uintptr_t address = reinterpret_cast<uintptr_t>(markerAddress);
+		range.low = Min(range.low, address);
+		range.high = Max(range.high, address);
+	}
+}
+
+// Every level suspends until the innermost one is resumed by Coroutine::Tick, then they finish one after another.
+static Task<uint32_t> Chain(uint32_t depth, StackRange& range)
+{
+	uint32_t value = 0;
+	if (depth == 0)
+		co_await Coroutine::ResumeOnMainThread();
+	else
+		value = co_await Chain(depth - 1, range) + 1;
+	RecordStack(range);
+	co_return value;
+}
+
+static Task<uint32_t> WaitForTick(bool& isResumed)
+{
+	co_await Coroutine::ResumeOnMainThread();
+	isResumed = true;
+	co_return 1;
+}
+
+static Task<uint32_t> AwaitTask(Task<uint32_t> task, bool& isResumed)
+{
+	uint32_t value = co_await task;
+	isResumed = true;
+	co_return value + 1;
+}
+
+// Symmetric transfer has to resume all of them at the same stack depth, or a long chain would overflow it.
+GLEX_BENCHMARK("thread/coroutine_deep_chain")
+{
+	constexpr uint32_t k_depth = 10000;
+	constexpr uintptr_t k_maxStackGrowth = 16 * 1024;
+	StackRange range;
+	Task<uint32_t> chain = Chain(k_depth, range);
+	Coroutine::Tick();
+	if (!chain.IsDone() || !chain.HasValue() || chain.Await() != k_depth || range.high - range.low > k_maxStackGrowth)
+	{
+		state.Fail("Resuming a deep chain grows the stack.");
+		return;
+	}
+	for (auto _ : state)
+	{
+		chain = Chain(k_depth, range);
+		Coroutine::Tick();
+		Benchmark::KeepAlive(chain.Await());
+	}
+	state.SetItemsProcessed(k_depth);
+}
+
+// A cancelled coroutine finishes without a value at its next resumption, and so does the one awaiting it.
+GLEX_BENCHMARK("thread/coroutine_cancel")
+{
+	bool isInnerResumed = false;
+	bool isOuterResumed = false;
+	Task<uint32_t> inner = WaitForTick(isInnerResumed);
+	Task<uint32_t> outer = AwaitTask(inner, isOuterResumed);
+	inner.Cancel();
+	Coroutine::Tick();
+	bool isCancelled = inner.IsDone() && !inner.HasValue() && outer.IsDone() && !outer.HasValue() && !isInnerResumed && !isOuterResumed;
+	// Without the cancel the same pair runs to the end.
+	inner = WaitForTick(isInnerResumed);
+	outer = AwaitTask(inner, isOuterResumed);
+	Coroutine::Tick();
+	if (!isCancelled || !outer.IsDone() || !outer.HasValue() || outer.Await() != 2)
+	{
+		state.Fail("Cancellation doesn't stop the coroutines.");
+		return;
+	}
+	for (auto _ : state)
+	{
+		Task<uint32_t> task = WaitForTick(isInnerResumed);
+		task.Cancel();
+		Coroutine::Tick();
+		Benchmark::KeepAlive(task.HasValue());
+	}
+	state.SetItemsProcessed(1);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Locks
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// A short critical section, about what the engine's locks protect.
+template <typename Lock>
+static void LockContention(BenchmarkState& state, uint32_t numThreads)
+{
+	Lock lock;
+	uint64_t shared = 0;
+	ContendingThreads contenders(numThreads - 1, [&]()
+	{
+		lock.lock();
+		shared++;
+		lock.unlock();
+	});
+	for (auto _ : state)
+	{
+		lock.lock();
+		shared++;
+		lock.unlock();
+	}
+	Benchmark::KeepAlive(shared);
+	state.SetItemsProcessed(1);
+}
+
+// Same interface as std::mutex, so both go through LockContention.
+template <typename T>
+class StdNames
+{
+private:
+	T m_lock;
+
+public:
+	void lock() { m_lock.Lock(); }
+	void unlock() { m_lock.Unlock(); }
+	void lock_shared() { m_lock.LockShared(); }
+	void unlock_shared() { m_lock.UnlockShared(); }
+};
+
+GLEX_BENCHMARK("thread/mutex_1") { LockContention<StdNames<Mutex>>(state, 1); }
+GLEX_BENCHMARK("thread/mutex_2") { LockContention<StdNames<Mutex>>(state, 2); }
+GLEX_BENCHMARK("thread/mutex_4") { LockContention<StdNames<Mutex>>(state, 4); }
+GLEX_BENCHMARK("thread/mutex_all") { LockContention<StdNames<Mutex>>(state, Benchmark::AllThreads()); }
+GLEX_BENCHMARK("thread/std_mutex_1") { LockContention<std::mutex>(state, 1); }
+GLEX_BENCHMARK("thread/std_mutex_4") { LockContention<std::mutex>(state, 4); }
+GLEX_BENCHMARK("thread/std_mutex_all") { LockContention<std::mutex>(state, Benchmark::AllThreads()); }
+GLEX_BENCHMARK("thread/rwlock_write_4") { LockContention<StdNames<RWLock>>(state, 4); }
+
+// Readers with one write in every 16 locks.
+template <typename Lock>
+static void ReadMostly(BenchmarkState& state, uint32_t numThreads)
+{
+	Lock lock;
+	uint64_t shared = 0;
+	auto access = [&](uint64_t i)
+	{
+		if (i % 16 == 0)
+		{
+			lock.lock();
+			shared++;
+			lock.unlock();
+		}
+		else
+		{
+			lock.lock_shared();
+			Benchmark::KeepAlive(shared);
+			lock.unlock_shared();
+		}
+	};
+	ContendingThreads contenders(numThreads - 1, [&]()
+	{
+		thread_local uint64_t t_counter = 0;
+		access(t_counter++);
+	});
+	for (uint64_t i : state)
+		access(i);
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("thread/rwlock_read_mostly_4") { ReadMostly<StdNames<RWLock>>(state, 4); }
+GLEX_BENCHMARK("thread/rwlock_read_mostly_all") { ReadMostly<StdNames<RWLock>>(state, Benchmark::AllThreads()); }
+GLEX_BENCHMARK("thread/std_shared_mutex_read_mostly_all") { ReadMostly<std::shared_mutex>(state, Benchmark::AllThreads()); }
+
+// Round trip between two threads through a pair of auto-reset events, so every wait parks.
+GLEX_BENCHMARK("thread/event_ping_pong")
+{
+	Event ping(false);
+	Event pong(false);
+	uint32_t stop = 0;
+	Thread thread([&]()
+	{
+		for (;;)
+		{
+			ping.Wait();
+			if (Atomic::Load(&stop) != 0)
+				break;
+			pong.Set();
+		}
+	}, ThreadPriority::Normal);
+	thread.Resume();
+	for (auto _ : state)
+	{
+		ping.Set();
+		pong.Wait();
+	}
+	Atomic::Store(&stop, 1u);
+	ping.Set();
+	thread.Wait();
+	state.SetItemsProcessed(1);
+}
\ No newline at end of file
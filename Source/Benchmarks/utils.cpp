@@ -0,0 +1,342 @@
+#include "Benchmarks/bench.h"
+#include "Core/log.h"
+#include "Core/Utils/hash.h"
+#include "Core/Utils/name.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Utils/string.h"
+#include "Core/Utils/telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace glex;
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Hashing and names
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+static void HashThroughput(BenchmarkState& state, uint32_t size)
+{
+	Vector<char> data(size);
+	uint64_t random = 3;
+	for (char& c : data)
+		c = static_cast<char>(Benchmark::Random(random));
+	uint64_t seed = 0;
+	for (auto _ : state)
+		seed = HashBytes(data.data(), size, seed);
+	Benchmark::KeepAlive(seed);
+	state.SetBytesProcessed(size);
+}
+
+GLEX_BENCHMARK("utils/hash_bytes_8") { HashThroughput(state, 8); }
+GLEX_BENCHMARK("utils/hash_bytes_64") { HashThroughput(state, 64); }
+GLEX_BENCHMARK("utils/hash_bytes_4k") { HashThroughput(state, 4096); }
+
+// Keys that differ in a few digits, the way asset paths do. Timed is hashing one, the counter is the number of
+// colliding pairs in a million buckets over what uniform hashing would give, about n²/2m.
+GLEX_BENCHMARK("utils/hash_collisions")
+{
+	constexpr uint32_t k_numKeys = 65536;
+	constexpr uint32_t k_numBuckets = 1 << 20;
+	Vector<uint32_t> buckets(k_numBuckets);
+	char key[32];
+	for (uint32_t i = 0; i < k_numKeys; i++)
+	{
+		uint32_t length = snprintf(key, sizeof(key), "mesh/lod0/%06u.bin", i);
+		buckets[HashBytes(key, length) & (k_numBuckets - 1)]++;
+	}
+	double pairs = 0.0;
+	for (uint32_t count : buckets)
+		pairs += count * (count - 1.0) * 0.5;
+	double expected = k_numKeys * (k_numKeys - 1.0) * 0.5 / k_numBuckets;
+	uint32_t length = snprintf(key, sizeof(key), "mesh/lod0/%06u.bin", 0u);
+	for (uint64_t i : state)
+	{
+		key[15] = '0' + i % 10;
+		Benchmark::KeepAlive(HashBytes(key, length));
+	}
+	state.SetCounter("collision_ratio", pairs / expected);
+	state.SetBytesProcessed(length);
+}
+
+GLEX_BENCHMARK("utils/name_intern")
+{
+	constexpr uint32_t k_numNames = 1024;
+	char names[k_numNames][24];
+	for (uint32_t i = 0; i < k_numNames; i++)
+		snprintf(names[i], sizeof(names[i]), "property_%u", i);
+	for (uint64_t i : state)
+		Benchmark::KeepAlive(Name(names[i % k_numNames]).GetId());
+	state.SetItemsProcessed(1);
+}
+
+// Setting a property by name, keyed by Name against keyed by string.
+template <typename Key>
+static void PropertySet(BenchmarkState& state)
+{
+	constexpr uint32_t k_numProperties = 64;
+	HashMap<Key, float> properties;
+	Key keys[k_numProperties];
+	char buffer[24];
+	for (uint32_t i = 0; i < k_numProperties; i++)
+	{
+		snprintf(buffer, sizeof(buffer), "property_%u", i);
+		keys[i] = Key(buffer);
+		properties[keys[i]] = 0.0f;
+	}
+	for (uint64_t i : state)
+		properties.find(keys[i % k_numProperties])->second += 1.0f;
+	Benchmark::KeepAlive(properties.size());
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("utils/property_set_name") { PropertySet<Name>(state); }
+GLEX_BENCHMARK("utils/property_set_string") { PropertySet<String>(state); }
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		Instrumentation
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// What a call costs the calling thread. The lines go nowhere, so the logging thread keeps up.
+GLEX_BENCHMARK("utils/log_call")
+{
+	uint64_t written = 0;
+	Logger::RedirectLog([&written](LogLevel, char const*) { written++; });
+	for (uint64_t i : state)
+		Logger::Warn("Frame %d took %f ms on %s.", static_cast<int32_t>(i), 16.6, "main");
+	Logger::Flush();
+	Logger::RedirectLog(Function<void(LogLevel, char const*)>());
+	if (written == 0)
+		state.Fail("No line was written, the level is compiled out.");
+	state.SetItemsProcessed(1);
+}
+
+// The two timestamps a scope takes, the floor under profile_scope. Virtual machines that trap RDTSC make it most of it.
+GLEX_BENCHMARK("utils/tsc_read_pair")
+{
+	for (auto _ : state)
+	{
+		Benchmark::KeepAlive(Time::Ticks());
+		Benchmark::KeepAlive(Time::Ticks());
+	}
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("utils/profile_scope")
+{
+	for (auto _ : state)
+	{
+		GLEX_PROFILE_SCOPE("Benchmark");
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("utils/profile_scope_disabled")
+{
+	Profiler::SetEnabled(false);
+	for (auto _ : state)
+	{
+		GLEX_PROFILE_SCOPE("Benchmark");
+		Benchmark::ClobberMemory();
+	}
+	Profiler::SetEnabled(true);
+	state.SetItemsProcessed(1);
+}
+
+GLEX_BENCHMARK("utils/telemetry_scope")
+{
+	for (auto _ : state)
+	{
+		TelemetryScope scope(TelemetryCounter::GuiBatch);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(1);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		UTF-8
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+namespace
+{
+	enum class TextKind : uint8_t
+	{
+		Ascii,
+		Cjk,
+		Emoji,
+		Mixed
+	};
+
+	constexpr uint32_t k_textSize = 64 * 1024;
+
+	// Byte at a time, the way the standard spells it out. Length of the character at p, zero if it's invalid.
+	uint32_t ReferenceDecode(uint8_t const* p, uint32_t remaining, uint32_t& outCode)
+	{
+		uint32_t length, min;
+		if (p[0] < 0x80)
+		{
+			outCode = p[0];
+			return 1;
+		}
+		if (p[0] >= 0xc0 && p[0] < 0xe0)
+		{
+			length = 2;
+			min = 0x80;
+			outCode = p[0] & 0x1f;
+		}
+		else if (p[0] >= 0xe0 && p[0] < 0xf0)
+		{
+			length = 3;
+			min = 0x800;
+			outCode = p[0] & 0x0f;
+		}
+		else if (p[0] >= 0xf0 && p[0] < 0xf8)
+		{
+			length = 4;
+			min = 0x10000;
+			outCode = p[0] & 0x07;
+		}
+		else
+			return 0;
+		if (remaining < length)
+			return 0;
+		for (uint32_t i = 1; i < length; i++)
+		{
+			if ((p[i] & 0xc0) != 0x80)
+				return 0;
+			outCode = outCode << 6 | (p[i] & 0x3f);
+		}
+		if (outCode < min || outCode > 0x10ffff || (outCode >= 0xd800 && outCode < 0xe000))
+			return 0;
+		return length;
+	}
+
+	bool ReferenceIsValid(uint8_t const* p, uint32_t length)
+	{
+		uint32_t code;
+		for (uint32_t i = 0; i < length;)
+		{
+			uint32_t size = ReferenceDecode(p + i, length - i, code);
+			if (size == 0)
+				return false;
+			i += size;
+		}
+		return true;
+	}
+
+	void AppendCode(String& out, uint32_t code)
+	{
+		Utf8Char utf8 = StringUtils::Utf8OfCode(code);
+		out.append(utf8.str, utf8.length);
+	}
+
+	String MakeText(TextKind kind)
+	{
+		String text;
+		text.reserve(k_textSize + 4);
+		uint64_t random = static_cast<uint64_t>(kind) + 11;
+		while (text.size() < k_textSize)
+		{
+			uint64_t r = Benchmark::Random(random);
+			TextKind pick = kind == TextKind::Mixed ? static_cast<TextKind>(r % 3) : kind;
+			r >>= 8;
+			if (pick == TextKind::Ascii)
+				text.push_back(0x20 + r % 95);
+			else if (pick == TextKind::Cjk)
+				AppendCode(text, 0x4e00 + r % 0x5200);
+			else
+				AppendCode(text, 0x1f300 + r % 0x300);
+		}
+		return text;
+	}
+
+	// Checks the vectorized paths against the reference before timing them.
+	bool CheckText(String const& text)
+	{
+		uint8_t const* p = reinterpret_cast<uint8_t const*>(text.data());
+		uint32_t length = text.size();
+		if (!StringUtils::IsValidUtf8(text.data(), length) || !ReferenceIsValid(p, length))
+			return false;
+		Vector<uint32_t> codes(length);
+		uint32_t numCodes = StringUtils::DecodeUtf8(text.data(), length, codes.data());
+		uint32_t index = 0;
+		for (uint32_t i = 0; i < length; index++)
+		{
+			uint32_t code = 0;
+			i += ReferenceDecode(p + i, length - i, code);
+			if (index >= numCodes || codes[index] != code)
+				return false;
+		}
+		if (index != numCodes || StringUtils::CountUtf8(text.data(), length) != numCodes)
+			return false;
+		Vector<wchar_t> utf16(StringUtils::Utf16LengthOfUtf8(text.data(), length));
+		if (StringUtils::ConvertUtf8ToUtf16(text.data(), length, utf16.data()) != utf16.size())
+			return false;
+		Vector<char> back(utf16.size() * 3);
+		uint32_t backLength = StringUtils::ConvertUtf16ToUtf8(utf16.data(), utf16.size(), back.data());
+		return backLength == length && memcmp(back.data(), text.data(), length) == 0;
+	}
+
+	// Random corruptions of valid text, validation has to agree with the reference on every one.
+	bool FuzzValidation(String const& text)
+	{
+		constexpr uint32_t k_numCases = 2000;
+		constexpr uint32_t k_caseSize = 96;
+		uint64_t random = 5;
+		char buffer[k_caseSize];
+		for (uint32_t i = 0; i < k_numCases; i++)
+		{
+			uint32_t offset = Benchmark::Random(random) % (text.size() - k_caseSize);
+			memcpy(buffer, text.data() + offset, k_caseSize);
+			uint32_t numFlips = Benchmark::Random(random) % 4;
+			for (uint32_t j = 0; j < numFlips; j++)
+			{
+				uint64_t r = Benchmark::Random(random);
+				buffer[r % k_caseSize] = static_cast<char>(r >> 32);
+			}
+			uint32_t length = Benchmark::Random(random) % (k_caseSize + 1);
+			if (StringUtils::IsValidUtf8(buffer, length) != ReferenceIsValid(reinterpret_cast<uint8_t const*>(buffer), length))
+				return false;
+		}
+		return true;
+	}
+
+	enum class Utf8Operation : uint8_t
+	{
+		Validate,
+		Decode,
+		ToUtf16
+	};
+}
+
+static void Utf8Throughput(BenchmarkState& state, TextKind kind, Utf8Operation operation)
+{
+	String text = MakeText(kind);
+	if (!CheckText(text) || (operation == Utf8Operation::Validate && !FuzzValidation(text)))
+	{
+		state.Fail("The result differs from the scalar reference.");
+		return;
+	}
+	uint32_t length = text.size();
+	Vector<uint32_t> codes(length);
+	Vector<wchar_t> utf16(length);
+	for (auto _ : state)
+	{
+		switch (operation)
+		{
+			case Utf8Operation::Validate: Benchmark::KeepAlive(StringUtils::IsValidUtf8(text.data(), length)); break;
+			case Utf8Operation::Decode: Benchmark::KeepAlive(StringUtils::DecodeUtf8(text.data(), length, codes.data())); break;
+			case Utf8Operation::ToUtf16: Benchmark::KeepAlive(StringUtils::ConvertUtf8ToUtf16(text.data(), length, utf16.data())); break;
+		}
+		Benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(length);
+}
+
+GLEX_BENCHMARK("utils/utf8_validate_ascii") { Utf8Throughput(state, TextKind::Ascii, Utf8Operation::Validate); }
+GLEX_BENCHMARK("utils/utf8_validate_cjk") { Utf8Throughput(state, TextKind::Cjk, Utf8Operation::Validate); }
+GLEX_BENCHMARK("utils/utf8_validate_emoji") { Utf8Throughput(state, TextKind::Emoji, Utf8Operation::Validate); }
+GLEX_BENCHMARK("utils/utf8_validate_mixed") { Utf8Throughput(state, TextKind::Mixed, Utf8Operation::Validate); }
+GLEX_BENCHMARK("utils/utf8_decode_ascii") { Utf8Throughput(state, TextKind::Ascii, Utf8Operation::Decode); }
+GLEX_BENCHMARK("utils/utf8_decode_cjk") { Utf8Throughput(state, TextKind::Cjk, Utf8Operation::Decode); }
+GLEX_BENCHMARK("utils/utf8_decode_emoji") { Utf8Throughput(state, TextKind::Emoji, Utf8Operation::Decode); }
+GLEX_BENCHMARK("utils/utf8_to_utf16_ascii") { Utf8Throughput(state, TextKind::Ascii, Utf8Operation::ToUtf16); }
+GLEX_BENCHMARK("utils/utf8_to_utf16_cjk") { Utf8Throughput(state, TextKind::Cjk, Utf8Operation::ToUtf16); }
+GLEX_BENCHMARK("utils/utf8_to_utf16_emoji") { Utf8Throughput(state, TextKind::Emoji, Utf8Operation::ToUtf16); }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <EASTL/stack.h>
 #include <EASTL/queue.h>
 #include <EASTL/string.h>
+#include "Core/Container/flat_map.h"
+#include "Core/Utils/hash.h"
 
 namespace glex
 {
@@ -27,7 +29,11 @@ namespace glex
 	using Queue = eastl::queue<T, Deque<T>>;
 
 	template <typename K, typename V, typename Hasher = eastl::hash<K>, typename Comparator = eastl::equal_to<K>>
+#if GLEX_USE_FLAT_HASH_MAP
+	using HashMap = FlatHashMap<K, V, Hasher, Comparator>;
+#else
 	using HashMap = eastl::hash_map<K, V, Hasher, Comparator, Allocator>;
+#endif
 
 	template <typename K, typename Hasher = eastl::hash<K>>
 	using HashSet = eastl::hash_set<K, Hasher, eastl::equal_to<K>, Allocator>;
@@ -36,17 +42,21 @@ namespace glex
 	using WideString = eastl::basic_string<wchar_t, Allocator>;
 
 	using StringView = eastl::string_view;
+
+	// Hashes strings, views and C strings alike, so a map keyed by one can be searched with the others through find_as.
+	class StringHasher
+	{
+	public:
+		using is_transparent = void;
+
+		size_t operator()(String const& string) const { return HashBytes(string.data(), string.size()); }
+		size_t operator()(StringView string) const { return HashBytes(string.data(), string.size()); }
+		size_t operator()(char const* string) const { return HashString(string); }
+	};
 }
 
 template <>
-class eastl::hash<glex::String>
-{
-public:
-	size_t operator()(glex::String const& string) const
-	{
-		return eastl::hash<char const*>()(string.c_str());
-	}
-};
+class eastl::hash<glex::String> : public glex::StringHasher {};
 
 template <>
 class eastl::hash<glex::WideString>
@@ -54,6 +64,6 @@ class eastl::hash<glex::WideString>
 public:
 	size_t operator()(glex::WideString const& string) const
 	{
-		return eastl::hash<wchar_t const*>()(string.c_str());
+		return glex::HashBytes(string.data(), string.size() * sizeof(wchar_t));
 	}
 };
\ No newline at end of file
@@ -0,0 +1,249 @@
+/**
+ * Bounded lock-free FIFO queues.
+ * MPMCQueue is Vyukov's queue: every slot carries a sequence number telling producers and consumers
+ * whose turn it is, so the only contended writes are the two position counters.
+ * SPSCQueue drops the CAS altogether when there's exactly one producer and one consumer.
+ * Try variants fail right away, the others sleep on an EventCount until there's room or data.
+ */
+#pragma once
+#include "Core/Memory/mem.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/futex.h"
+#include "Core/Container/optional.h"
+#include "Core/assert.h"
+
+namespace glex
+{
+	template <typename T>
+	class MPMCQueue : private Unmoveable
+	{
+	private:
+		struct Slot
+		{
+			uint32_t sequence;
+			Optional<T> value;
+		};
+
+		alignas(64) uint32_t m_enqueuePos;
+		alignas(64) uint32_t m_dequeuePos;
+		alignas(64) Slot* m_slots;
+		uint32_t m_mask;
+		EventCount m_notEmpty;
+		EventCount m_notFull;
+
+		bool CanPush() const
+		{
+			uint32_t pos = Atomic::Load(&m_enqueuePos);
+			return static_cast<int32_t>(Atomic::Load(&m_slots[pos & m_mask].sequence) - pos) >= 0;
+		}
+
+		bool CanPop() const
+		{
+			uint32_t pos = Atomic::Load(&m_dequeuePos);
+			return static_cast<int32_t>(Atomic::Load(&m_slots[pos & m_mask].sequence) - (pos + 1)) >= 0;
+		}
+
+	public:
+		MPMCQueue(uint32_t capacity) : m_enqueuePos(0), m_dequeuePos(0), m_mask(capacity - 1)
+		{
+			GLEX_DEBUG_ASSERT(capacity > 1 && (capacity & (capacity - 1)) == 0) {}
+			m_slots = Mem::Alloc<Slot>(capacity);
+			for (uint32_t i = 0; i < capacity; i++)
+				m_slots[i].sequence = i;
+		}
+
+		~MPMCQueue()
+		{
+			for (uint32_t pos = m_dequeuePos; pos != m_enqueuePos; pos++)
+				m_slots[pos & m_mask].value.Destroy();
+			Mem::Free(m_slots);
+		}
+
+		uint32_t Capacity() const { return m_mask + 1; }
+		// Approximate when called concurrently.
+		uint32_t Size() const { return Atomic::Load(&m_enqueuePos) - Atomic::Load(&m_dequeuePos); }
+
+		template <typename R>
+		bool TryPush(R&& value)
+		{
+			uint32_t pos = Atomic::Load(&m_enqueuePos);
+			for (;;)
+			{
+				Slot& slot = m_slots[pos & m_mask];
+				uint32_t sequence = Atomic::Load(&slot.sequence);
+				Atomic::ReadBarrier();
+				int32_t diff = static_cast<int32_t>(sequence - pos);
+				if (diff == 0)
+				{
+					uint32_t oldPos = Atomic::CompareAndExchange(&m_enqueuePos, pos, pos + 1);
+					if (oldPos == pos)
+					{
+						slot.value.Emplace(std::forward<R>(value));
+						Atomic::WriteBarrier();
+						Atomic::Store(&slot.sequence, pos + 1);
+						m_notEmpty.Notify();
+						return true;
+					}
+					pos = oldPos;
+				}
+				else if (diff < 0)
+					return false;		// Full. The slot's last value hasn't been popped.
+				else
+					pos = Atomic::Load(&m_enqueuePos);
+			}
+		}
+
+		bool TryPop(T& out)
+		{
+			uint32_t pos = Atomic::Load(&m_dequeuePos);
+			for (;;)
+			{
+				Slot& slot = m_slots[pos & m_mask];
+				uint32_t sequence = Atomic::Load(&slot.sequence);
+				Atomic::ReadBarrier();
+				int32_t diff = static_cast<int32_t>(sequence - (pos + 1));
+				if (diff == 0)
+				{
+					uint32_t oldPos = Atomic::CompareAndExchange(&m_dequeuePos, pos, pos + 1);
+					if (oldPos == pos)
+					{
+						out = std::move(*slot.value);
+						slot.value.Destroy();
+						Atomic::WriteBarrier();
+						// Ready for the producer one round later.
+						Atomic::Store(&slot.sequence, pos + m_mask + 1);
+						m_notFull.Notify();
+						return true;
+					}
+					pos = oldPos;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = Atomic::Load(&m_dequeuePos);
+			}
+		}
+
+		template <typename R>
+		void Push(R&& value)
+		{
+			// TryPush only consumes the value when it succeeds.
+			while (!TryPush(std::forward<R>(value)))
+			{
+				uint32_t epoch = m_notFull.PrepareWait();
+				if (CanPush())
+					m_notFull.CancelWait();
+				else
+					m_notFull.Wait(epoch);
+			}
+		}
+
+		void Pop(T& out)
+		{
+			while (!TryPop(out))
+			{
+				uint32_t epoch = m_notEmpty.PrepareWait();
+				if (CanPop())
+					m_notEmpty.CancelWait();
+				else
+					m_notEmpty.Wait(epoch);
+			}
+		}
+	};
+
+	template <typename T>
+	class SPSCQueue : private Unmoveable
+	{
+	private:
+		// Each side caches the other's position and only rereads it when it seems full or empty.
+		alignas(64) uint32_t m_tail;
+		uint32_t m_cachedHead;
+		alignas(64) uint32_t m_head;
+		uint32_t m_cachedTail;
+		alignas(64) Optional<T>* m_slots;
+		uint32_t m_mask;
+		EventCount m_notEmpty;
+		EventCount m_notFull;
+
+	public:
+		SPSCQueue(uint32_t capacity) : m_tail(0), m_cachedHead(0), m_head(0), m_cachedTail(0), m_mask(capacity - 1)
+		{
+			GLEX_DEBUG_ASSERT(capacity > 1 && (capacity & (capacity - 1)) == 0) {}
+			m_slots = Mem::Alloc<Optional<T>>(capacity);
+		}
+
+		~SPSCQueue()
+		{
+			for (uint32_t pos = m_head; pos != m_tail; pos++)
+				m_slots[pos & m_mask].Destroy();
+			Mem::Free(m_slots);
+		}
+
+		uint32_t Capacity() const { return m_mask + 1; }
+		uint32_t Size() const { return Atomic::Load(&m_tail) - Atomic::Load(&m_head); }
+
+		// Producer only.
+		template <typename R>
+		bool TryPush(R&& value)
+		{
+			uint32_t tail = m_tail;
+			if (tail - m_cachedHead > m_mask)
+			{
+				m_cachedHead = Atomic::Load(&m_head);
+				Atomic::ReadBarrier();
+				if (tail - m_cachedHead > m_mask)
+					return false;
+			}
+			m_slots[tail & m_mask].Emplace(std::forward<R>(value));
+			Atomic::WriteBarrier();
+			Atomic::Store(&m_tail, tail + 1);
+			m_notEmpty.Notify();
+			return true;
+		}
+
+		// Consumer only.
+		bool TryPop(T& out)
+		{
+			uint32_t head = m_head;
+			if (head == m_cachedTail)
+			{
+				m_cachedTail = Atomic::Load(&m_tail);
+				Atomic::ReadBarrier();
+				if (head == m_cachedTail)
+					return false;
+			}
+			Optional<T>& slot = m_slots[head & m_mask];
+			out = std::move(*slot);
+			slot.Destroy();
+			Atomic::WriteBarrier();
+			Atomic::Store(&m_head, head + 1);
+			m_notFull.Notify();
+			return true;
+		}
+
+		template <typename R>
+		void Push(R&& value)
+		{
+			while (!TryPush(std::forward<R>(value)))
+			{
+				uint32_t epoch = m_notFull.PrepareWait();
+				if (Atomic::Load(&m_tail) - Atomic::Load(&m_head) <= m_mask)
+					m_notFull.CancelWait();
+				else
+					m_notFull.Wait(epoch);
+			}
+		}
+
+		void Pop(T& out)
+		{
+			while (!TryPop(out))
+			{
+				uint32_t epoch = m_notEmpty.PrepareWait();
+				if (Atomic::Load(&m_tail) != Atomic::Load(&m_head))
+					m_notEmpty.CancelWait();
+				else
+					m_notEmpty.Wait(epoch);
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -1,81 +1,401 @@
 /**
- * A general-purpose LRU cache with lifetime for each element.
- * Try to make it thread-safe.
+ * A general-purpose concurrent cache bounded by the total weight of its elements.
+ * Keys are split over shards by hash, each with its own lock and hash index. Hits take the shard's lock
+ * shared and write only to the calling thread's stripe of it, misses take it exclusively.
+ * Hits reach the frequency sketch through small per-stripe buffers drained under the exclusive lock. A hit
+ * that finds its buffer full is dropped from the sketch, which only needs a sample.
+ * Eviction is W-TinyLFU: new elements enter a small window, and leaving the window they're admitted
+ * to the main space only if a frequency sketch says they're used more often than the element they'd evict.
+ * Both spaces are CLOCK queues, a hit only sets a bit.
+ * Elements are weighed by their CacheWeight() member if they have one, by their size otherwise.
  */
 #pragma once
 #include "config.h"
 #include "Core/Memory/allocator.h"
 #include "Core/Thread/lock.h"
-#include "Core/Container/optional.h"
 #include "Core/Memory/smart_ptr.h"
 #include "Core/Container/basic.h"
+#include "Core/Utils/hash.h"
+#include <EASTL/algorithm.h>
+#include <bit>
 
 namespace glex
 {
+	namespace inner
+	{
+		// Threads take stripes round-robin the first time they ask.
+		inline uint32_t CacheStripe()
+		{
+			static uint32_t s_numThreads = 0;
+			thread_local uint32_t t_stripe = Atomic::Increment(&s_numThreads);
+			return t_stripe;
+		}
+	}
+
+	struct CacheStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		uint64_t weight;
+		uint32_t size;
+	};
+
 	template <typename Elem>
 	class Cache : private Unmoveable
 	{
 	private:
-		struct Slot
+		constexpr static uint32_t k_none = UINT32_MAX;
+		constexpr static uint32_t k_sketchDepth = 4;
+		constexpr static uint64_t k_sketchCap = 15;
+		constexpr static uint32_t k_numStripes = 4;
+		constexpr static uint32_t k_readBufferSize = 16;
+
+		struct Entry
 		{
 			String name;
-			uint32_t hash;	// hash cache, we use linear search because size isn't too big.
-			uint32_t life;	// 0 if slot is free.
 			SharedPtr<Elem> elem;
+			uint64_t hash;
+			uint64_t weight;
+			uint32_t referenced;	// Set by hits under the shared lock.
+			bool inWindow;
 		};
 
-		Mutex m_mutex;
-		Vector<Slot> m_slots;
-		uint32_t m_init;
-		uint16_t m_boost, m_decrease;
+		// Count-min sketch with 4-bit counters, 16 to a word. Halved every so often so old popularity fades.
+		class Sketch
+		{
+		private:
+			Vector<uint64_t> m_table;
+			uint32_t m_additions = 0;
+			uint32_t m_resetPeriod;
 
-	public:
-		Cache(uint32_t size, uint32_t spinCount, uint32_t init, uint16_t boost, uint16_t decrease) :
-			m_mutex(spinCount), m_slots(size), m_init(init), m_boost(boost), m_decrease(decrease) {}
+			uint32_t Word(uint64_t hash, uint32_t row) const { return static_cast<uint32_t>(HashCombine(hash, row)) & (m_table.size() - 1); }
+			static uint32_t Shift(uint64_t hash, uint32_t row) { return (static_cast<uint32_t>(hash >> (row * 4)) & 15) * 4; }
 
-		template <typename... Args>
-		SharedPtr<Elem> Get(char const* name, Args&&... args)
+		public:
+			Sketch(uint32_t width) : m_table(width, 0), m_resetPeriod(width * 10) {}
+
+			void Increment(uint64_t hash)
+			{
+				for (uint32_t row = 0; row < k_sketchDepth; row++)
+				{
+					uint64_t* word = &m_table[Word(hash, row)];
+					uint32_t shift = Shift(hash, row);
+					uint64_t value = Atomic::Load(word);
+					// Losing an increment to a racing one is fine.
+					if ((value >> shift & k_sketchCap) != k_sketchCap)
+						Atomic::CompareAndExchange(word, value, value + (static_cast<uint64_t>(1) << shift));
+				}
+				Atomic::Increment(&m_additions);
+			}
+
+			uint64_t Frequency(uint64_t hash) const
+			{
+				uint64_t frequency = k_sketchCap;
+				for (uint32_t row = 0; row < k_sketchDepth; row++)
+				{
+					uint32_t shift = Shift(hash, row);
+					frequency = Min(frequency, Atomic::Load(&m_table[Word(hash, row)]) >> shift & k_sketchCap);
+				}
+				return frequency;
+			}
+
+			// Under the exclusive lock.
+			void Age()
+			{
+				if (Atomic::Load(&m_additions) < m_resetPeriod)
+					return;
+				for (uint64_t& word : m_table)
+					Atomic::Store(&word, Atomic::Load(&word) >> 1 & 0x7777777777777777);
+				Atomic::Store(&m_additions, 0u);
+			}
+		};
+
+		// Hashes of hits waiting for the sketch. Slots are claimed under the shared lock and read under the exclusive one.
+		struct alignas(64) ReadStripe
+		{
+			uint64_t hashes[k_readBufferSize];
+			uint32_t writes = 0;
+			uint32_t reads = 0;
+			uint64_t hits = 0;
+		};
+
+		struct alignas(64) Shard
+		{
+			ReadStripe stripes[k_numStripes];
+			RWLock lock;
+			HashMap<String, uint32_t, StringHasher> index;
+			Vector<Entry> entries;
+			Vector<uint32_t> freeEntries;
+			Deque<uint32_t> window;
+			Deque<uint32_t> main;
+			Vector<uint32_t> victims;
+			Sketch sketch;
+			uint64_t windowWeight = 0;
+			uint64_t mainWeight = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+
+			Shard(uint32_t sketchWidth) : sketch(sketchWidth) {}
+		};
+
+		Shard* m_shards;
+		uint32_t m_numShards;
+		uint64_t m_windowCapacity;
+		uint64_t m_mainCapacity;
+
+		Shard& ShardOf(uint64_t hash) { return m_shards[(hash >> 32) & (m_numShards - 1)]; }
+
+		static uint64_t Weigh(Elem const& elem)
+		{
+			if constexpr (requires { elem.CacheWeight(); })
+				return elem.CacheWeight();
+			else
+				return sizeof(Elem);
+		}
+
+		// Second chance: referenced entries are moved to the back with the bit cleared.
+		static uint32_t NextVictim(Shard& shard, Deque<uint32_t>& queue)
+		{
+			for (;;)
+			{
+				uint32_t index = queue.front();
+				Entry& entry = shard.entries[index];
+				if (!Atomic::Exchange(&entry.referenced, 0u))
+					return index;
+				queue.pop_front();
+				queue.push_back(index);
+			}
+		}
+
+		static void Evict(Shard& shard, uint32_t index)
+		{
+			Entry& entry = shard.entries[index];
+			shard.index.erase(entry.name);
+			entry.name.clear();
+			entry.elem = nullptr;
+			shard.freeEntries.push_back(index);
+		}
+
+		// Moves entries out of the window, each either into the main space or out of the cache.
+		void Balance(Shard& shard)
 		{
-			eastl::hash<char const*> hasher;
-			uint32_t hash = hasher(name);
-			uint32_t minLife = -1;
-			uint32_t minIndex = -1;
-			ScopedLock lock(m_mutex);
-			for (uint32_t i = 0; i < m_slots.size(); i++)
+			while (shard.windowWeight > m_windowCapacity)
 			{
-				Slot& slot = m_slots[i];
-				if (slot.life != 0 && slot.hash == hash && slot.name == name)
+				uint32_t candidate = NextVictim(shard, shard.window);
+				shard.window.pop_front();
+				Entry& entry = shard.entries[candidate];
+				shard.windowWeight -= entry.weight;
+				if (entry.weight > m_mainCapacity)
+				{
+					Evict(shard, candidate);
+					shard.evictions++;
+					continue;
+				}
+				// Takes as many victims as the candidate needs room for and compares first, so only the loser is evicted.
+				uint64_t frequency = shard.sketch.Frequency(entry.hash);
+				uint64_t freedWeight = 0;
+				bool admitted = true;
+				shard.victims.clear();
+				while (shard.mainWeight - freedWeight + entry.weight > m_mainCapacity)
 				{
-					slot.life = std::min(m_init, slot.life + m_boost);
-					return slot.elem;
+					uint32_t victim = NextVictim(shard, shard.main);
+					shard.main.pop_front();
+					shard.victims.push_back(victim);
+					freedWeight += shard.entries[victim].weight;
+					if (shard.sketch.Frequency(shard.entries[victim].hash) >= frequency)
+					{
+						admitted = false;
+						break;
+					}
 				}
-				if (slot.life < minLife)
+				if (!admitted)
 				{
-					minLife = slot.life;
-					minIndex = i;
+					for (auto iter = shard.victims.rbegin(); iter != shard.victims.rend(); ++iter)
+						shard.main.push_front(*iter);
+					Evict(shard, candidate);
+					shard.evictions++;
+					continue;
 				}
+				for (uint32_t victim : shard.victims)
+					Evict(shard, victim);
+				shard.mainWeight -= freedWeight;
+				shard.evictions += shard.victims.size();
+				entry.inWindow = false;
+				shard.main.push_back(candidate);
+				shard.mainWeight += entry.weight;
 			}
-			Slot& slot = m_slots[minIndex];
-			slot.name = name;
-			slot.hash = hash;
-			slot.life = m_init;
-			slot.elem = MakeShared<Elem>(std::forward<Args>(args)...);
-			return slot.elem;
 		}
 
-		void ReduceLifetime()
+		// Under the shared lock. Returns whether the buffer is full after this hit.
+		static bool RecordHit(ReadStripe& stripe, uint64_t hash)
+		{
+			Atomic::Add(&stripe.hits, static_cast<uint64_t>(1));
+			uint32_t writes = Atomic::Load(&stripe.writes);
+			if (writes - stripe.reads >= k_readBufferSize)
+				return true;
+			if (Atomic::CompareAndExchange(&stripe.writes, writes, writes + 1) == writes)
+				Atomic::Store(&stripe.hashes[writes % k_readBufferSize], hash);
+			return writes + 1 - stripe.reads >= k_readBufferSize;
+		}
+
+		// Under the exclusive lock, so every claimed slot has been written.
+		static void DrainReads(Shard& shard)
 		{
-			ScopedLock lock(m_mutex);
-			for (Slot& slot : m_slots)
+			for (ReadStripe& stripe : shard.stripes)
 			{
-				if (slot.life > m_decrease)
-					slot.life -= m_decrease;
-				else
+				uint32_t writes = Atomic::Load(&stripe.writes);
+				for (; stripe.reads != writes; stripe.reads++)
+					shard.sketch.Increment(stripe.hashes[stripe.reads % k_readBufferSize]);
+			}
+		}
+
+		uint32_t Lookup(Shard& shard, char const* name)
+		{
+			auto iter = shard.index.find_as(name);
+			if (iter == shard.index.end())
+				return k_none;
+			return iter->second;
+		}
+
+	public:
+		// Weights of all elements stay under capacity, less whatever a shard can't use because elements don't divide it evenly.
+		Cache(uint64_t capacity, uint32_t expectedSize = 1024, uint32_t numShards = 16) : m_numShards(std::bit_ceil(numShards))
+		{
+			uint64_t shardCapacity = capacity / m_numShards;
+			m_windowCapacity = shardCapacity / 100;
+			m_mainCapacity = shardCapacity - m_windowCapacity;
+			uint32_t sketchWidth = std::bit_ceil(Max(expectedSize / m_numShards / 4, 16u));
+			m_shards = Mem::Alloc<Shard>(m_numShards, MemoryTag::Containers);
+			for (uint32_t i = 0; i < m_numShards; i++)
+				new (&m_shards[i]) Shard(sketchWidth);
+		}
+
+		~Cache()
+		{
+			for (uint32_t i = 0; i < m_numShards; i++)
+				m_shards[i].~Shard();
+			Mem::Free(m_shards);
+		}
+
+		SharedPtr<Elem> Find(char const* name)
+		{
+			uint64_t hash = HashString(name);
+			Shard& shard = ShardOf(hash);
+			SharedPtr<Elem> elem;
+			bool isBufferFull;
+			{
+				ScopedSharedLock lock(shard.lock);
+				uint32_t index = Lookup(shard, name);
+				if (index == k_none)
 				{
-					slot.life = 0;
-					slot.elem = nullptr;
+					shard.sketch.Increment(hash);
+					Atomic::Add(&shard.misses, static_cast<uint64_t>(1));
+					return nullptr;
 				}
+				Entry& entry = shard.entries[index];
+				// Only the first hit since the last eviction pass dirties the entry.
+				if (Atomic::Load(&entry.referenced) == 0)
+					Atomic::Store(&entry.referenced, 1u);
+				isBufferFull = RecordHit(shard.stripes[inner::CacheStripe() % k_numStripes], hash);
+				elem = entry.elem;
+			}
+			// Not worth waiting for, the next miss drains it anyway.
+			if (isBufferFull && shard.lock.TryLock())
+			{
+				DrainReads(shard);
+				shard.lock.Unlock();
+			}
+			return elem;
+		}
+
+		// Constructs the element from args if it isn't cached. It may not stay cached if it's used less than what it would evict.
+		template <typename... Args>
+		SharedPtr<Elem> Get(char const* name, Args&&... args)
+		{
+			SharedPtr<Elem> elem = Find(name);
+			if (elem != nullptr)
+				return elem;
+			// Constructed outside the lock. If somebody else got there first this one is dropped.
+			elem = MakeShared<Elem>(std::forward<Args>(args)...);
+			uint64_t hash = HashString(name);
+			Shard& shard = ShardOf(hash);
+			ScopedLock lock(shard.lock);
+			uint32_t index = Lookup(shard, name);
+			if (index != k_none)
+				return shard.entries[index].elem;
+			if (shard.freeEntries.empty())
+			{
+				index = shard.entries.size();
+				shard.entries.emplace_back();
+			}
+			else
+			{
+				index = shard.freeEntries.back();
+				shard.freeEntries.pop_back();
+			}
+			Entry& entry = shard.entries[index];
+			entry.name = name;
+			entry.elem = elem;
+			entry.hash = hash;
+			entry.weight = Weigh(*elem);
+			entry.referenced = 0;
+			entry.inWindow = true;
+			shard.index.insert(entry.name).first->second = index;
+			shard.window.push_back(index);
+			shard.windowWeight += entry.weight;
+			DrainReads(shard);
+			shard.sketch.Age();
+			Balance(shard);
+			return elem;
+		}
+
+		void Remove(char const* name)
+		{
+			uint64_t hash = HashString(name);
+			Shard& shard = ShardOf(hash);
+			ScopedLock lock(shard.lock);
+			uint32_t index = Lookup(shard, name);
+			if (index == k_none)
+				return;
+			Entry& entry = shard.entries[index];
+			Deque<uint32_t>& queue = entry.inWindow ? shard.window : shard.main;
+			(entry.inWindow ? shard.windowWeight : shard.mainWeight) -= entry.weight;
+			queue.erase(eastl::find(queue.begin(), queue.end(), index));
+			Evict(shard, index);
+		}
+
+		void Clear()
+		{
+			for (uint32_t i = 0; i < m_numShards; i++)
+			{
+				Shard& shard = m_shards[i];
+				ScopedLock lock(shard.lock);
+				shard.index.clear();
+				shard.entries.clear();
+				shard.freeEntries.clear();
+				shard.window.clear();
+				shard.main.clear();
+				shard.windowWeight = 0;
+				shard.mainWeight = 0;
+			}
+		}
+
+		CacheStats GetStats()
+		{
+			CacheStats stats = {};
+			for (uint32_t i = 0; i < m_numShards; i++)
+			{
+				Shard& shard = m_shards[i];
+				ScopedSharedLock lock(shard.lock);
+				for (ReadStripe const& stripe : shard.stripes)
+					stats.hits += Atomic::Load(&stripe.hits);
+				stats.misses += Atomic::Load(&shard.misses);
+				stats.evictions += shard.evictions;
+				stats.weight += shard.windowWeight + shard.mainWeight;
+				stats.size += shard.index.size();
 			}
+			return stats;
 		}
 	};
 }
\ No newline at end of file
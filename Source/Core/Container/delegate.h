@@ -67,8 +67,13 @@ namespace glex
 			// Fast path.
 			if (m_callbacks.empty())
 				return;
-			ScopedLock lock(m_mutex);
-			for (auto& fn : m_callbacks)
+			// Called on a copy outside the lock, so callbacks may bind, unbind and broadcast themselves.
+			InlineVector<Function<Ret(Args...)>, 4> callbacks;
+			{
+				ScopedLock lock(m_mutex);
+				callbacks.assign(m_callbacks.begin(), m_callbacks.end());
+			}
+			for (auto& fn : callbacks)
 				fn(std::forward<Args>(args)...);
 		}
 
@@ -0,0 +1,438 @@
+/**
+ * Open-addressing hash map in the style of SwissTable.
+ * Entries sit in one flat array, each with a metadata byte holding 7 bits of its hash, or empty, or deleted.
+ * Lookups match 16 metadata bytes at a time with SSE2, so a probe is one load of metadata plus the slots that match.
+ * Same interface as the EASTL map, but inserting may move entries: references and iterators don't survive inserts.
+ * Erasing never moves anything.
+ */
+#pragma once
+#include "Core/Memory/mem.h"
+#include <EASTL/functional.h>
+#include <EASTL/utility.h>
+#include <EASTL/iterator.h>
+#include <bit>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace glex
+{
+	namespace inner
+	{
+		// Full slots store the low 7 bits of the hash, so only these are negative.
+		constexpr int8_t k_ctrlEmpty = -128;
+		constexpr int8_t k_ctrlDeleted = -2;
+		constexpr int8_t k_ctrlSentinel = -1;	// After the last slot, stops iteration.
+		constexpr uint32_t k_groupSize = 16;
+
+		class ControlGroup
+		{
+		private:
+#if defined(_M_X64) || defined(__SSE2__)
+			__m128i m_ctrl;
+
+		public:
+			explicit ControlGroup(int8_t const* ctrl) : m_ctrl(_mm_load_si128(reinterpret_cast<__m128i const*>(ctrl))) {}
+			uint32_t Match(int8_t h2) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl)); }
+			// Empty or deleted.
+			uint32_t MatchFree() const { return _mm_movemask_epi8(_mm_cmplt_epi8(m_ctrl, _mm_set1_epi8(k_ctrlSentinel))); }
+#else
+			int8_t const* m_ctrl;
+
+		public:
+			explicit ControlGroup(int8_t const* ctrl) : m_ctrl(ctrl) {}
+
+			uint32_t Match(int8_t h2) const
+			{
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < k_groupSize; i++)
+					mask |= static_cast<uint32_t>(m_ctrl[i] == h2) << i;
+				return mask;
+			}
+
+			uint32_t MatchFree() const
+			{
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < k_groupSize; i++)
+					mask |= static_cast<uint32_t>(m_ctrl[i] < k_ctrlSentinel) << i;
+				return mask;
+			}
+#endif
+			uint32_t MatchEmpty() const { return Match(k_ctrlEmpty); }
+		};
+
+		// For maps that haven't allocated yet, so begin() finds the end right away.
+		alignas(k_groupSize) inline int8_t const k_emptyCtrl[1] = { k_ctrlSentinel };
+	}
+
+	template <typename K, typename V, typename Hasher = eastl::hash<K>, typename Comparator = eastl::equal_to<K>>
+	class FlatHashMap
+	{
+	public:
+		using key_type = K;
+		using mapped_type = V;
+		using value_type = eastl::pair<K const, V>;
+		using size_type = size_t;
+		using hasher = Hasher;
+		using key_equal = Comparator;
+
+	private:
+		template <bool IsConst>
+		class Iterator
+		{
+		private:
+			friend class FlatHashMap;
+			template <bool> friend class Iterator;
+			using Value = std::conditional_t<IsConst, typename FlatHashMap::value_type const, typename FlatHashMap::value_type>;
+
+			int8_t const* m_ctrl = nullptr;
+			Value* m_slot = nullptr;
+
+			Iterator(int8_t const* ctrl, Value* slot) : m_ctrl(ctrl), m_slot(slot) {}
+
+			void SkipFree()
+			{
+				while (*m_ctrl < inner::k_ctrlSentinel)
+				{
+					m_ctrl++;
+					m_slot++;
+				}
+			}
+
+		public:
+			using iterator_category = eastl::forward_iterator_tag;
+			using value_type = FlatHashMap::value_type;
+			using difference_type = ptrdiff_t;
+			using pointer = Value*;
+			using reference = Value&;
+
+			Iterator() = default;
+			operator Iterator<true>() const { return Iterator<true>(m_ctrl, m_slot); }
+			Value& operator*() const { return *m_slot; }
+			Value* operator->() const { return m_slot; }
+			Iterator& operator++() { m_ctrl++; m_slot++; SkipFree(); return *this; }
+			Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+			template <bool C> bool operator==(Iterator<C> const& rhs) const { return m_ctrl == rhs.m_ctrl; }
+		};
+
+	public:
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+		using insert_return_type = eastl::pair<iterator, bool>;
+
+	private:
+		constexpr static size_t k_notFound = SIZE_MAX;
+
+		int8_t* m_ctrl = const_cast<int8_t*>(inner::k_emptyCtrl);
+		value_type* m_slots = nullptr;
+		size_t m_capacity = 0;		// Zero or a power of two, at least a group.
+		size_t m_size = 0;
+		size_t m_growthLeft = 0;	// Empty slots we may still fill before growing. Keeps the load factor at 7/8.
+		Hasher m_hasher;
+		Comparator m_equal;
+
+		// Spreads hashes like identity hashes of integers and pointers over all bits.
+		static size_t Mix(size_t hash)
+		{
+			uint64_t h = static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+			return static_cast<size_t>(h ^ (h >> 32));
+		}
+
+		static int8_t H2(size_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+		static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+		size_t Allocation(size_t capacity) const { return Mem::Align(static_cast<uint64_t>(capacity + inner::k_groupSize), alignof(value_type)) + sizeof(value_type) * capacity; }
+
+		// Groups are visited in triangular steps, which covers all of them with a power of two count.
+		template <typename U, typename Eq>
+		size_t FindIndex(U const& key, size_t hash, Eq&& equal) const
+		{
+			if (m_capacity == 0)
+				return k_notFound;
+			size_t groupMask = m_capacity / inner::k_groupSize - 1;
+			size_t group = (hash >> 7) & groupMask;
+			for (size_t step = 1; ; step++)
+			{
+				inner::ControlGroup ctrl(m_ctrl + group * inner::k_groupSize);
+				for (uint32_t match = ctrl.Match(H2(hash)); match != 0; match &= match - 1)
+				{
+					size_t index = group * inner::k_groupSize + std::countr_zero(match);
+					if (equal(m_slots[index].first, key))
+						return index;
+				}
+				// An empty slot would've been taken by the key if it were here.
+				if (ctrl.MatchEmpty() != 0)
+					return k_notFound;
+				group = (group + step) & groupMask;
+			}
+		}
+
+		size_t FindFreeSlot(size_t hash) const
+		{
+			size_t groupMask = m_capacity / inner::k_groupSize - 1;
+			size_t group = (hash >> 7) & groupMask;
+			for (size_t step = 1; ; step++)
+			{
+				uint32_t match = inner::ControlGroup(m_ctrl + group * inner::k_groupSize).MatchFree();
+				if (match != 0)
+					return group * inner::k_groupSize + std::countr_zero(match);
+				group = (group + step) & groupMask;
+			}
+		}
+
+		void Rehash(size_t capacity)
+		{
+			int8_t* oldCtrl = m_ctrl;
+			value_type* oldSlots = m_slots;
+			size_t oldCapacity = m_capacity;
+			m_ctrl = static_cast<int8_t*>(Mem::Alloc(Allocation(capacity), Max(inner::k_groupSize, static_cast<uint32_t>(alignof(value_type)))));
+			m_slots = Mem::Offset<value_type>(m_ctrl, static_cast<uint32_t>(Mem::Align(static_cast<uint64_t>(capacity + inner::k_groupSize), alignof(value_type))));
+			m_capacity = capacity;
+			memset(m_ctrl, inner::k_ctrlEmpty, capacity);
+			m_ctrl[capacity] = inner::k_ctrlSentinel;
+			m_growthLeft = MaxLoad(capacity) - m_size;
+			if (oldCapacity == 0)
+				return;
+			for (size_t i = 0; i < oldCapacity; i++)
+			{
+				if (oldCtrl[i] < 0)
+					continue;
+				size_t hash = Mix(m_hasher(oldSlots[i].first));
+				size_t index = FindFreeSlot(hash);
+				m_ctrl[index] = H2(hash);
+				new (&m_slots[index]) value_type(std::move(oldSlots[i]));
+				oldSlots[i].~value_type();
+			}
+			Mem::Free(oldCtrl);
+		}
+
+		// Claims a slot for a new key. The caller constructs the entry.
+		size_t PrepareInsert(size_t hash)
+		{
+			size_t index = m_capacity == 0 ? k_notFound : FindFreeSlot(hash);
+			if (m_growthLeft == 0 && (index == k_notFound || m_ctrl[index] != inner::k_ctrlDeleted))
+			{
+				// Rehashing in place is enough if deleted slots are what's filling the table.
+				Rehash(m_capacity == 0 ? inner::k_groupSize : m_size * 2 < MaxLoad(m_capacity) ? m_capacity : m_capacity * 2);
+				index = FindFreeSlot(hash);
+			}
+			if (m_ctrl[index] == inner::k_ctrlEmpty)
+				m_growthLeft--;
+			m_ctrl[index] = H2(hash);
+			m_size++;
+			return index;
+		}
+
+		void EraseIndex(size_t index)
+		{
+			m_slots[index].~value_type();
+			m_size--;
+			// Probes stop at a group with an empty slot, so if this group already has one, nobody can be past it.
+			if (inner::ControlGroup(m_ctrl + index / inner::k_groupSize * inner::k_groupSize).MatchEmpty() != 0)
+			{
+				m_ctrl[index] = inner::k_ctrlEmpty;
+				m_growthLeft++;
+			}
+			else
+				m_ctrl[index] = inner::k_ctrlDeleted;
+		}
+
+		void DestroyAll()
+		{
+			if constexpr (!std::is_trivially_destructible_v<value_type>)
+			{
+				for (size_t i = 0; i < m_capacity; i++)
+					if (m_ctrl[i] >= 0)
+						m_slots[i].~value_type();
+			}
+		}
+
+		template <typename Key, typename... Args>
+		insert_return_type Emplace(Key&& key, Args&&... args)
+		{
+			size_t hash = Mix(m_hasher(key));
+			size_t index = FindIndex(key, hash, m_equal);
+			if (index != k_notFound)
+				return { IteratorAt(index), false };
+			index = PrepareInsert(hash);
+			new (&m_slots[index]) value_type(std::forward<Key>(key), V(std::forward<Args>(args)...));
+			return { IteratorAt(index), true };
+		}
+
+		iterator IteratorAt(size_t index) { return iterator(m_ctrl + index, m_slots + index); }
+		const_iterator IteratorAt(size_t index) const { return const_iterator(m_ctrl + index, m_slots + index); }
+
+		template <typename U>
+		size_t HashAs(U const& key) const
+		{
+			if constexpr (requires { typename Hasher::is_transparent; })
+				return m_hasher(key);
+			else
+				return eastl::hash<std::decay_t<U const>>()(key);
+		}
+
+	public:
+		FlatHashMap() = default;
+
+		FlatHashMap(FlatHashMap const& rhs) : m_hasher(rhs.m_hasher), m_equal(rhs.m_equal)
+		{
+			if (rhs.m_size == 0)
+				return;
+			// Same capacity, so every entry can stay at its index.
+			Rehash(rhs.m_capacity);
+			memcpy(m_ctrl, rhs.m_ctrl, m_capacity);
+			for (size_t i = 0; i < m_capacity; i++)
+				if (m_ctrl[i] >= 0)
+					new (&m_slots[i]) value_type(rhs.m_slots[i]);
+			m_size = rhs.m_size;
+			m_growthLeft = rhs.m_growthLeft;
+		}
+
+		FlatHashMap(FlatHashMap&& rhs) noexcept { swap(rhs); }
+
+		~FlatHashMap()
+		{
+			DestroyAll();
+			if (m_capacity != 0)
+				Mem::Free(m_ctrl);
+		}
+
+		FlatHashMap& operator=(FlatHashMap const& rhs)
+		{
+			if (this != &rhs)
+			{
+				FlatHashMap copy(rhs);
+				swap(copy);
+			}
+			return *this;
+		}
+
+		FlatHashMap& operator=(FlatHashMap&& rhs) noexcept
+		{
+			FlatHashMap moved(std::move(rhs));
+			swap(moved);
+			return *this;
+		}
+
+		void swap(FlatHashMap& rhs)
+		{
+			std::swap(m_ctrl, rhs.m_ctrl);
+			std::swap(m_slots, rhs.m_slots);
+			std::swap(m_capacity, rhs.m_capacity);
+			std::swap(m_size, rhs.m_size);
+			std::swap(m_growthLeft, rhs.m_growthLeft);
+			std::swap(m_hasher, rhs.m_hasher);
+			std::swap(m_equal, rhs.m_equal);
+		}
+
+		iterator begin() { iterator iter(m_ctrl, m_slots); iter.SkipFree(); return iter; }
+		const_iterator begin() const { const_iterator iter(m_ctrl, m_slots); iter.SkipFree(); return iter; }
+		iterator end() { return IteratorAt(m_capacity); }
+		const_iterator end() const { return IteratorAt(m_capacity); }
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend() const { return end(); }
+
+		bool empty() const { return m_size == 0; }
+		size_t size() const { return m_size; }
+		size_t bucket_count() const { return m_capacity; }
+
+		void clear()
+		{
+			DestroyAll();
+			if (m_capacity == 0)
+				return;
+			memset(m_ctrl, inner::k_ctrlEmpty, m_capacity);
+			m_size = 0;
+			m_growthLeft = MaxLoad(m_capacity);
+		}
+
+		void reserve(size_t count)
+		{
+			size_t capacity = inner::k_groupSize;
+			while (MaxLoad(capacity) < count)
+				capacity *= 2;
+			if (capacity > m_capacity)
+				Rehash(capacity);
+		}
+
+		iterator find(K const& key)
+		{
+			size_t index = FindIndex(key, Mix(m_hasher(key)), m_equal);
+			return index == k_notFound ? end() : IteratorAt(index);
+		}
+
+		const_iterator find(K const& key) const
+		{
+			size_t index = FindIndex(key, Mix(m_hasher(key)), m_equal);
+			return index == k_notFound ? end() : IteratorAt(index);
+		}
+
+		// Looks up by another type, e.g. a char const* or StringView against String keys. Its hash must agree with the key's:
+		// it comes from the map's hasher if that declares is_transparent, otherwise from eastl::hash of the other type.
+		template <typename U>
+		iterator find_as(U const& key)
+		{
+			size_t index = FindIndex(key, Mix(HashAs(key)), [](K const& lhs, U const& rhs) { return lhs == rhs; });
+			return index == k_notFound ? end() : IteratorAt(index);
+		}
+
+		template <typename U>
+		const_iterator find_as(U const& key) const
+		{
+			size_t index = FindIndex(key, Mix(HashAs(key)), [](K const& lhs, U const& rhs) { return lhs == rhs; });
+			return index == k_notFound ? end() : IteratorAt(index);
+		}
+
+		size_t count(K const& key) const { return find(key) != end(); }
+		bool contains(K const& key) const { return find(key) != end(); }
+
+		template <typename... Args>
+		insert_return_type try_emplace(K const& key, Args&&... args) { return Emplace(key, std::forward<Args>(args)...); }
+		template <typename... Args>
+		insert_return_type try_emplace(K&& key, Args&&... args) { return Emplace(std::move(key), std::forward<Args>(args)...); }
+
+		template <typename... Args>
+		insert_return_type emplace(Args&&... args)
+		{
+			value_type value(std::forward<Args>(args)...);
+			return try_emplace(value.first, std::move(value.second));
+		}
+
+		insert_return_type insert(value_type const& value) { return try_emplace(value.first, value.second); }
+		insert_return_type insert(value_type&& value) { return try_emplace(value.first, std::move(value.second)); }
+		// Default-constructs the value, like the EASTL map.
+		insert_return_type insert(K const& key) { return try_emplace(key); }
+
+		template <typename Value>
+		insert_return_type insert_or_assign(K const& key, Value&& value)
+		{
+			insert_return_type result = try_emplace(key, std::forward<Value>(value));
+			if (!result.second)
+				result.first->second = std::forward<Value>(value);
+			return result;
+		}
+
+		V& operator[](K const& key) { return try_emplace(key).first->second; }
+		V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+		iterator erase(const_iterator pos)
+		{
+			size_t index = pos.m_ctrl - m_ctrl;
+			EraseIndex(index);
+			iterator next = IteratorAt(index + 1);
+			next.SkipFree();
+			return next;
+		}
+
+		iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+		size_t erase(K const& key)
+		{
+			size_t index = FindIndex(key, Mix(m_hasher(key)), m_equal);
+			if (index == k_notFound)
+				return 0;
+			EraseIndex(index);
+			return 1;
+		}
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Core/commdefs.h"
 #include "Core/Memory/mem.h"
 #include <array>
+#include <string.h>
 
 namespace glex
 {
@@ -57,10 +58,10 @@ namespace glex
 
 		using ThisType = Function<Ret(Args...), InlineStorage>;
 
-		template <uint32_t InlineStorage>
-		using Rebind = Function<Ret(Args...), InlineStorage>;
+		template <uint32_t NewInlineStorage>
+		using Rebind = Function<Ret(Args...), NewInlineStorage>;
 
-		template <typename Fn, uint32_t InlineStorage>
+		template <typename Fn, uint32_t HisInlineStorage>
 		friend class Function;
 
 		void const* GetObjectPointer() const
@@ -90,7 +91,7 @@ namespace glex
 		{
 			if (m_objectSize > InlineStorage) // Cannot fit.
 			{
-				m_objectPointer = Mem::Alloc(m_objectSize, 8);
+				m_objectPointer = Mem::SmallAlloc(m_objectSize, 8);
 				memcpy(m_objectPointer, rhs.GetObjectPointer(), m_objectSize);
 				m_useExternalStorage = true;
 			}
@@ -115,7 +116,7 @@ namespace glex
 			}
 			else if (m_objectSize > InlineStorage) // Cannot fit.
 			{
-				m_objectPointer = Mem::Alloc(m_objectSize, 8);
+				m_objectPointer = Mem::SmallAlloc(m_objectSize, 8);
 				memcpy(m_objectPointer, &rhs.m_objectStorage, m_objectSize);
 				m_useExternalStorage = true;
 			}
@@ -131,7 +132,7 @@ namespace glex
 			m_objectSize = rhs.m_objectSize;
 			if (m_objectSize > InlineStorage) // Cannot fit.
 			{
-				m_objectPointer = Mem::Alloc(m_objectSize, 8);
+				m_objectPointer = Mem::SmallAlloc(m_objectSize, 8);
 				memcpy(m_objectPointer, rhs.GetObjectPointer(), m_objectSize);
 				m_useExternalStorage = true;
 			}
@@ -162,7 +163,7 @@ namespace glex
 			}
 			else if (m_objectSize > InlineStorage)
 			{
-				m_objectPointer = Mem::Alloc(m_objectSize, 8);
+				m_objectPointer = Mem::SmallAlloc(m_objectSize, 8);
 				memcpy(m_objectPointer, &rhs.m_objectStorage, m_objectSize);
 				m_useExternalStorage = true;
 			}
@@ -283,7 +284,8 @@ namespace glex
 			{
 				BindOperator(&Type::operator());
 				m_useExternalStorage = true;
-				m_objectPointer = Mem::New<Type>(std::forward<Fn>(fn));
+				m_objectPointer = Mem::SmallAlloc(sizeof(Type), alignof(Type));
+				new (m_objectPointer) Type(std::forward<Fn>(fn));
 			}
 		}
 
@@ -313,7 +315,8 @@ namespace glex
 			{
 				BindOperator(&Type::operator());
 				m_useExternalStorage = true;
-				m_objectPointer = Mem::New<Type>(std::forward<Fn>(fn));
+				m_objectPointer = Mem::SmallAlloc(sizeof(Type), alignof(Type));
+				new (m_objectPointer) Type(std::forward<Fn>(fn));
 			}
 			return *this;
 		}
@@ -330,7 +333,7 @@ namespace glex
 		}
 
 		template <typename Fn>
-		bool operator==(Fn const& fn) const requires !std::is_function_v<std::remove_pointer_t<std::remove_reference_t<Fn>>>
+		bool operator==(Fn const& fn) const requires (!std::is_function_v<std::remove_pointer_t<std::remove_reference_t<Fn>>>)
 		{
 			using Type = std::remove_cv_t<std::remove_reference_t<Fn>>;
 			auto op = &Type::operator();
@@ -349,7 +352,9 @@ namespace glex
 		Ret InvokeThisCall(void const* function, void* object, RealArgs&&... args) const
 		{
 			using MemberFunctionType = MemberFunctionPtr<ThisCall, Ret(Args...)>;
-			MemberFunctionType memfn = *reinterpret_cast<MemberFunctionType*>(&function);
+			// Itanium member pointers also carry a this adjustment, which is zero for everything bound here.
+			MemberFunctionType memfn {};
+			memcpy(&memfn, &function, sizeof(function));
 			return (reinterpret_cast<ThisCall*>(object)->*memfn)(std::forward<RealArgs>(args)...);
 		}
 
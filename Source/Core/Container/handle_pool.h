@@ -0,0 +1,239 @@
+/**
+ * Generational handles. A handle is a slot index plus the generation of the slot when it was handed out.
+ * Freeing bumps the generation, so a stale handle fails its lookup instead of dangling.
+ * HandlePool keeps its objects packed for iteration, removing moves the last one into the hole.
+ * ConcurrentHandlePool has a fixed capacity and never moves objects, everything in it is lock-free.
+ */
+#pragma once
+#include "Core/Container/basic.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Utils/hash.h"
+
+namespace glex
+{
+	template <typename T, typename Tag> class HandlePool;
+	template <typename T, typename Tag> class ConcurrentHandlePool;
+
+	// Live slots have odd generations, so a null handle or one to a free slot never matches.
+	template <typename Tag>
+	class Handle
+	{
+	private:
+		template <typename, typename> friend class HandlePool;
+		template <typename, typename> friend class ConcurrentHandlePool;
+
+		uint32_t m_index;
+		uint32_t m_generation;
+
+		constexpr Handle(uint32_t index, uint32_t generation) : m_index(index), m_generation(generation) {}
+
+	public:
+		constexpr Handle() : m_index(0), m_generation(0) {}
+		constexpr bool IsNull() const { return m_generation == 0; }
+		constexpr uint64_t GetValue() const { return static_cast<uint64_t>(m_generation) << 32 | m_index; }
+		constexpr bool operator==(Handle const& rhs) const = default;
+	};
+
+	template <typename T, typename Tag = T>
+	class HandlePool
+	{
+	private:
+		constexpr static uint32_t k_none = UINT32_MAX;
+
+		// Dense is the index of the object while the slot is live, the next free slot otherwise.
+		struct Slot
+		{
+			uint32_t generation;
+			uint32_t dense;
+		};
+
+		Vector<Slot> m_slots;
+		Vector<T> m_objects;
+		Vector<uint32_t> m_owners;	// Slot of each object.
+		uint32_t m_freeHead = k_none;
+
+	public:
+		template <typename... Args>
+		Handle<Tag> Insert(Args&&... args)
+		{
+			uint32_t index;
+			if (m_freeHead != k_none)
+			{
+				index = m_freeHead;
+				m_freeHead = m_slots[index].dense;
+				m_slots[index].generation++;
+			}
+			else
+			{
+				index = m_slots.size();
+				m_slots.push_back({ 1, 0 });
+			}
+			Slot& slot = m_slots[index];
+			slot.dense = m_objects.size();
+			m_objects.emplace_back(std::forward<Args>(args)...);
+			m_owners.push_back(index);
+			return Handle<Tag>(index, slot.generation);
+		}
+
+		bool Remove(Handle<Tag> handle)
+		{
+			if (!Contains(handle))
+				return false;
+			Slot& slot = m_slots[handle.m_index];
+			uint32_t last = m_objects.size() - 1;
+			if (slot.dense != last)
+			{
+				m_objects[slot.dense] = std::move(m_objects[last]);
+				m_owners[slot.dense] = m_owners[last];
+				m_slots[m_owners[last]].dense = slot.dense;
+			}
+			m_objects.pop_back();
+			m_owners.pop_back();
+			// A slot whose generation wraps around is retired, not reused.
+			if (++slot.generation != 0)
+			{
+				slot.dense = m_freeHead;
+				m_freeHead = handle.m_index;
+			}
+			return true;
+		}
+
+		bool Contains(Handle<Tag> handle) const { return handle.m_index < m_slots.size() && (handle.m_generation & 1) != 0 && m_slots[handle.m_index].generation == handle.m_generation; }
+		T* Get(Handle<Tag> handle) { return Contains(handle) ? &m_objects[m_slots[handle.m_index].dense] : nullptr; }
+		T const* Get(Handle<Tag> handle) const { return Contains(handle) ? &m_objects[m_slots[handle.m_index].dense] : nullptr; }
+
+		// Objects are packed, iterating doesn't skip holes. The order changes when something is removed.
+		uint32_t Size() const { return m_objects.size(); }
+		T* begin() { return m_objects.data(); }
+		T* end() { return m_objects.data() + m_objects.size(); }
+		T const* begin() const { return m_objects.data(); }
+		T const* end() const { return m_objects.data() + m_objects.size(); }
+		Handle<Tag> HandleAt(uint32_t dense) const { return Handle<Tag>(m_owners[dense], m_slots[m_owners[dense]].generation); }
+
+		// Invalidates all handles.
+		void Clear()
+		{
+			while (!m_objects.empty())
+				Remove(HandleAt(m_objects.size() - 1));
+		}
+	};
+
+	// Lookups are safe against handles freed before, not against the object being removed while it's used.
+	template <typename T, typename Tag = T>
+	class ConcurrentHandlePool : private Unmoveable
+	{
+	private:
+		constexpr static uint32_t k_none = UINT32_MAX;
+
+		struct Slot
+		{
+			uint32_t generation;
+			uint32_t nextFree;
+			alignas(T) uint8_t storage[sizeof(T)];
+
+			T* Object() { return reinterpret_cast<T*>(storage); }
+		};
+
+		Slot* m_slots;
+		uint32_t m_capacity;
+		uint32_t m_numUsed = 0;		// Slots below this have been handed out at least once.
+		uint64_t m_freeHead;		// Slot index in the low half, a counter against ABA in the high half.
+
+		uint32_t PopFree()
+		{
+			uint64_t head = Atomic::Load(&m_freeHead);
+			for (;;)
+			{
+				uint32_t index = static_cast<uint32_t>(head);
+				if (index == k_none)
+					return k_none;
+				uint64_t next = (head & 0xffffffff00000000) + (static_cast<uint64_t>(1) << 32) | Atomic::Load(&m_slots[index].nextFree);
+				uint64_t old = Atomic::CompareAndExchange(&m_freeHead, head, next);
+				if (old == head)
+					return index;
+				head = old;
+			}
+		}
+
+		void PushFree(uint32_t index)
+		{
+			uint64_t head = Atomic::Load(&m_freeHead);
+			for (;;)
+			{
+				Atomic::Store(&m_slots[index].nextFree, static_cast<uint32_t>(head));
+				uint64_t next = (head & 0xffffffff00000000) + (static_cast<uint64_t>(1) << 32) | index;
+				uint64_t old = Atomic::CompareAndExchange(&m_freeHead, head, next);
+				if (old == head)
+					return;
+				head = old;
+			}
+		}
+
+	public:
+		ConcurrentHandlePool(uint32_t capacity) : m_capacity(capacity), m_freeHead(k_none)
+		{
+			m_slots = Mem::Alloc<Slot>(capacity, MemoryTag::Containers);
+			for (uint32_t i = 0; i < capacity; i++)
+				m_slots[i].generation = 0;
+		}
+
+		~ConcurrentHandlePool()
+		{
+			for (uint32_t i = 0; i < Min(m_numUsed, m_capacity); i++)
+			{
+				if ((m_slots[i].generation & 1) != 0)
+					std::destroy_at(m_slots[i].Object());
+			}
+			Mem::Free(m_slots);
+		}
+
+		// Null if the pool is full.
+		template <typename... Args>
+		Handle<Tag> Insert(Args&&... args)
+		{
+			uint32_t index = PopFree();
+			if (index == k_none)
+			{
+				if (Atomic::Load(&m_numUsed) >= m_capacity)
+					return {};
+				index = Atomic::Increment(&m_numUsed) - 1;
+				if (index >= m_capacity)
+					return {};
+			}
+			Slot& slot = m_slots[index];
+			new (slot.storage) T(std::forward<Args>(args)...);
+			uint32_t generation = slot.generation + 1;
+			Atomic::Store(&slot.generation, generation);
+			return Handle<Tag>(index, generation);
+		}
+
+		// Only one of several racing removes of the same handle succeeds.
+		bool Remove(Handle<Tag> handle)
+		{
+			if (!Contains(handle))
+				return false;
+			Slot& slot = m_slots[handle.m_index];
+			uint32_t generation = handle.m_generation + 1;
+			if (Atomic::CompareAndExchange(&slot.generation, handle.m_generation, generation) != handle.m_generation)
+				return false;
+			std::destroy_at(slot.Object());
+			// A slot whose generation wraps around is retired, not reused.
+			if (generation != 0)
+				PushFree(handle.m_index);
+			return true;
+		}
+
+		bool Contains(Handle<Tag> handle) const { return handle.m_index < m_capacity && (handle.m_generation & 1) != 0 && Atomic::Load(&m_slots[handle.m_index].generation) == handle.m_generation; }
+		T* Get(Handle<Tag> handle) { return Contains(handle) ? m_slots[handle.m_index].Object() : nullptr; }
+	};
+}
+
+template <typename Tag>
+class eastl::hash<glex::Handle<Tag>>
+{
+public:
+	size_t operator()(glex::Handle<Tag> handle) const
+	{
+		return glex::HashInt(handle.GetValue());
+	}
+};
\ No newline at end of file
@@ -1,47 +1,117 @@
+/**
+ * Lock-free stacks.
+ * The head is a pointer plus a counter swapped with a 16-byte CAS, so a node popped and pushed back
+ * in between can't fool another thread's Pop (ABA).
+ */
 #pragma once
 #include "Core/Memory/mem.h"
 #include "Core/Thread/atomic.h"
+#include "Core/Container/optional.h"
 #include <concepts>
 
 namespace glex
 {
+	// Nodes embed the link as a T* next member, so Push and Pop never allocate.
+	// Pop may still read a node another thread has just popped, so nodes must stay readable as long as the list is in use.
+	template <typename T> requires std::is_same_v<decltype(T::next), T*>
+	class IntrusiveLockFreeList : private Unmoveable
+	{
+	private:
+		struct alignas(16) Head
+		{
+			T* node;
+			uint64_t tag;
+		};
+
+		Head m_head;
+
+		Head LoadHead() const
+		{
+			// May tear. Then the CAS fails and hands us the real one.
+			Head head;
+			head.tag = Atomic::Load(&m_head.tag);
+			head.node = Atomic::Load(&m_head.node);
+			return head;
+		}
+
+	public:
+		IntrusiveLockFreeList() : m_head { nullptr, 0 } {}
+		bool IsEmpty() const { return Atomic::Load(&m_head.node) == nullptr; }
+
+		void Push(T* node)
+		{
+			Head oldHead = LoadHead();
+			do
+				node->next = oldHead.node;
+			while (!Atomic::CompareAndExchange128(&m_head, oldHead, Head { node, oldHead.tag + 1 }));
+		}
+
+		T* Pop()
+		{
+			Head oldHead = LoadHead();
+			do
+			{
+				if (oldHead.node == nullptr)
+					return nullptr;
+			} while (!Atomic::CompareAndExchange128(&m_head, oldHead, Head { Atomic::Load(&oldHead.node->next), oldHead.tag + 1 }));
+			return oldHead.node;
+		}
+
+		// Takes every node at once, newest first.
+		T* PopAll()
+		{
+			Head oldHead = LoadHead();
+			while (oldHead.node != nullptr && !Atomic::CompareAndExchange128(&m_head, oldHead, Head { nullptr, oldHead.tag + 1 }));
+			return oldHead.node;
+		}
+	};
+
+	// Nodes are recycled instead of freed, so Push and Pop don't allocate once warmed up.
 	template <typename T>
-	class LockFreeList
+	class LockFreeList : private Unmoveable
 	{
 	private:
-		struct Node
+		struct Node : SlabAllocated
 		{
 			Node* next;
-			T value;
+			Optional<T> value;
 		};
 
-		Node* m_head;
+		IntrusiveLockFreeList<Node> m_values;
+		IntrusiveLockFreeList<Node> m_freeNodes;
 
 	public:
-		LockFreeList() : m_head(nullptr) {}
+		~LockFreeList()
+		{
+			while (Node* node = m_values.Pop())
+			{
+				node->value.Destroy();
+				Mem::Delete(node);
+			}
+			while (Node* node = m_freeNodes.Pop())
+				Mem::Delete(node);
+		}
+
+		bool IsEmpty() const { return m_values.IsEmpty(); }
 
 		template <typename R>
-		void Push(R&& value) requires std::is_same_v<std::remove_reference_t<R>, T>
+		void Push(R&& value) requires std::is_same_v<std::remove_cvref_t<R>, T>
 		{
-			Node* oldHead;
-			Node* newNode = Mem::New<Node>(nullptr, std::forward<R>(value));
-			do
-			{
-				oldHead = Atomic::Load(&m_head);
-				newNode->next = oldHead;
-			} while (Atomic::CompareAndExchange(&m_head, oldHead, newNode) != oldHead);
+			Node* node = m_freeNodes.Pop();
+			if (node == nullptr)
+				node = Mem::New<Node>();
+			node->value.Emplace(std::forward<R>(value));
+			m_values.Push(node);
 		}
 
 		bool Pop(T& out)
 		{
-			Node* oldHead = Atomic::Load(&m_head);
-			do
-			{
-				if (oldHead == nullptr)
-					return false;
-			} while (Atomic::CompareAndExchange(&m_head, oldHead, oldHead->next) != oldHead);
-			out = std::move(oldHead->value);
-			Mem::Delete(oldHead); // Use delete because T may want to be destructed.
+			Node* node = m_values.Pop();
+			if (node == nullptr)
+				return false;
+			out = std::move(*node->value);
+			node->value.Destroy();
+			m_freeNodes.Push(node);
 			return true;
 		}
 	};
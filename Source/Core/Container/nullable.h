@@ -19,13 +19,13 @@ namespace glex
 		Nullable(Nullable<T> const& rhs) : m_hasValue(rhs.m_hasValue)
 		{
 			if (m_hasValue)
-				m_value.Emplace(rhs.m_value);
+				m_value.Emplace(*rhs.m_value);
 		}
 
 		Nullable(Nullable<T>&& rhs) : m_hasValue(rhs.m_hasValue)
 		{
 			if (m_hasValue)
-				m_value.Emplace(std::move(rhs.m_value));
+				m_value.Emplace(std::move(*rhs.m_value));
 			rhs.m_hasValue = false;
 		}
 
@@ -35,7 +35,7 @@ namespace glex
 				m_value.Destroy();
 			m_hasValue = rhs.m_hasValue;
 			if (m_hasValue)
-				m_value.Emplace(rhs.m_value);
+				m_value.Emplace(*rhs.m_value);
 			return *this;
 		}
 
@@ -45,14 +45,14 @@ namespace glex
 				m_value.Destroy();
 			m_hasValue = rhs.m_hasValue;
 			if (m_hasValue)
-				m_value.Emplace(std::move(rhs.m_value));
+				m_value.Emplace(std::move(*rhs.m_value));
 			rhs.m_hasValue = false;
 			return *this;
 		}
 
 		bool operator==(nullptr_t rhs) const { return !m_hasValue; }
-		Nullable<T>& operator*() { return *m_value; }
-		Nullable<T> const& operator*() const { return *m_value; }
+		T& operator*() { return *m_value; }
+		T const& operator*() const { return *m_value; }
 		T* operator->() { return m_value.operator->(); }
 		T const* operator->() const { return m_value.operator->(); }
 	};
@@ -79,6 +79,7 @@ namespace glex
 		{
 			m_value = rhs.m_value;
 			rhs.m_value = -1;
+			return *this;
 		}
 
 		bool operator==(nullptr_t rhs) const { return m_value == -1; }
@@ -130,10 +130,16 @@ class eastl::hash<glex::SequenceView<T>>
 public:
 	size_t operator()(glex::SequenceView<T> const& seq) const
 	{
-		uint64_t hash = 0;
-		eastl::hash<std::remove_const_t<T>> elemHasher;
-		for (T const& elem : seq)
-			hash = hash * 4397 + elemHasher(elem) * 3;
-		return static_cast<uint32_t>(hash);
+		// Plain integer keys like the render pass descriptions are hashed as bytes in one go.
+		if constexpr (std::is_integral_v<T>)
+			return glex::HashBytes(seq.begin(), seq.Size() * sizeof(T));
+		else
+		{
+			uint64_t hash = seq.Size();
+			eastl::hash<std::remove_const_t<T>> elemHasher;
+			for (T const& elem : seq)
+				hash = glex::HashCombine(hash, elemHasher(elem));
+			return hash;
+		}
 	}
 };
\ No newline at end of file
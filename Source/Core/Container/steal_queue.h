@@ -0,0 +1,123 @@
+/**
+ * Chase-Lev work-stealing deque.
+ * Only the owner thread pushes and pops at the bottom, any thread can steal from the top.
+ */
+#pragma once
+#include "Core/Memory/mem.h"
+#include "Core/Thread/atomic.h"
+#include "Core/assert.h"
+
+namespace glex
+{
+	template <typename T> requires std::is_trivially_copyable_v<T>
+	class WorkStealingQueue : private Unmoveable
+	{
+	private:
+		struct Array
+		{
+			int64_t mask;
+			Array* retired;		// Thieves may still be reading old arrays, so they live as long as the queue.
+			T* Data() { return reinterpret_cast<T*>(this + 1); }
+		};
+
+		// Thieves hammer the top, keep it away from the owner's cache line.
+		alignas(64) int64_t m_top;
+		alignas(64) int64_t m_bottom;
+		Array* m_array;
+
+		static Array* AllocateArray(int64_t capacity, Array* retired)
+		{
+			Array* array = static_cast<Array*>(Mem::Alloc(sizeof(Array) + sizeof(T) * capacity, Max(alignof(Array), alignof(T))));
+			array->mask = capacity - 1;
+			array->retired = retired;
+			return array;
+		}
+
+		Array* Grow(Array* array, int64_t top, int64_t bottom)
+		{
+			Array* newArray = AllocateArray((array->mask + 1) * 2, array);
+			for (int64_t i = top; i < bottom; i++)
+				newArray->Data()[i & newArray->mask] = array->Data()[i & array->mask];
+			Atomic::WriteBarrier();
+			Atomic::Store(&m_array, newArray);
+			return newArray;
+		}
+
+	public:
+		WorkStealingQueue(uint32_t capacity = 256) : m_top(0), m_bottom(0)
+		{
+			GLEX_DEBUG_ASSERT(capacity > 1 && (capacity & (capacity - 1)) == 0) {}
+			m_array = AllocateArray(capacity, nullptr);
+		}
+
+		~WorkStealingQueue()
+		{
+			Array* array = m_array;
+			while (array != nullptr)
+			{
+				Array* retired = array->retired;
+				Mem::Free(array);
+				array = retired;
+			}
+		}
+
+		// Approximate when called from other threads.
+		uint32_t Size() const
+		{
+			int64_t size = Atomic::Load(&m_bottom) - Atomic::Load(&m_top);
+			return size > 0 ? static_cast<uint32_t>(size) : 0;
+		}
+
+		// Owner only.
+		void Push(T value)
+		{
+			int64_t bottom = m_bottom;
+			int64_t top = Atomic::Load(&m_top);
+			Array* array = m_array;
+			if (bottom - top > array->mask) GLEX_UNLIKELY
+				array = Grow(array, top, bottom);
+			array->Data()[bottom & array->mask] = value;
+			Atomic::WriteBarrier();
+			Atomic::Store(&m_bottom, bottom + 1);
+		}
+
+		// Owner only. LIFO, so recently pushed work is still hot in cache.
+		bool Pop(T& out)
+		{
+			int64_t bottom = m_bottom - 1;
+			Array* array = m_array;
+			Atomic::Store(&m_bottom, bottom);
+			Atomic::FullBarrier();
+			int64_t top = Atomic::Load(&m_top);
+			if (top > bottom)
+			{
+				Atomic::Store(&m_bottom, bottom + 1);
+				return false;
+			}
+			out = array->Data()[bottom & array->mask];
+			if (top != bottom)
+				return true;
+			// Last element. Race against thieves for it.
+			bool won = Atomic::CompareAndExchange(&m_top, top, top + 1) == top;
+			Atomic::Store(&m_bottom, bottom + 1);
+			return won;
+		}
+
+		// Any thread. Fails spuriously if another thief wins the race.
+		bool Steal(T& out)
+		{
+			int64_t top = Atomic::Load(&m_top);
+			Atomic::FullBarrier();
+			int64_t bottom = Atomic::Load(&m_bottom);
+			if (top >= bottom)
+				return false;
+			Array* array = Atomic::Load(&m_array);
+			Atomic::ReadBarrier();
+			T value = Atomic::Load(&array->Data()[top & array->mask]);
+			if (Atomic::CompareAndExchange(&m_top, top, top + 1) != top)
+				return false;
+			out = value;
+			return true;
+		}
+	};
+}
\ No newline at end of file
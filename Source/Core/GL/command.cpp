@@ -25,12 +25,12 @@ void CommandPool::Destroy()
 	vkDestroyCommandPool(Context::GetDevice(), m_handle, Context::HostAllocator());
 }
 
-CommandBuffer CommandPool::AllocateCommandBuffer()
+CommandBuffer CommandPool::AllocateCommandBuffer(bool secondary)
 {
 	VkCommandBufferAllocateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	info.commandPool = m_handle;
-	info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	info.level = secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 	info.commandBufferCount = 1;
 	CommandBuffer result;
 	if (vkAllocateCommandBuffers(Context::GetDevice(), &info, reinterpret_cast<VkCommandBuffer*>(&result)) != VK_SUCCESS)
@@ -43,6 +43,11 @@ void CommandPool::FreeCommandBuffer(CommandBuffer commandBuffer)
 	vkFreeCommandBuffers(Context::GetDevice(), m_handle, 1, reinterpret_cast<VkCommandBuffer*>(&commandBuffer));
 }
 
+void CommandPool::Reset()
+{
+	!vkResetCommandPool(Context::GetDevice(), m_handle, 0);
+}
+
 /*————————————————————————————————————————————————————————————————————————————————————————————————————————————
 		Command buffer.
  ————————————————————————————————————————————————————————————————————————————————————————————————————————————*/
@@ -59,12 +64,29 @@ void CommandBuffer::Begin()
 	!vkBeginCommandBuffer(m_handle, &beginInfo);
 }
 
+void CommandBuffer::BeginSecondary(RenderPass renderPass, uint32_t subpass, FrameBuffer frameBuffer)
+{
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass.GetHandle();
+	inheritanceInfo.subpass = subpass;
+	inheritanceInfo.framebuffer = frameBuffer.GetHandle();
+	// Statistics queries of the primary may stay active while we run.
+	if (Context::DeviceInfo().supportsInheritedQueries)
+		inheritanceInfo.pipelineStatistics = QueryPool::PIPELINE_STATISTICS;
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	!vkBeginCommandBuffer(m_handle, &beginInfo);
+}
+
 void CommandBuffer::End()
 {
 	!vkEndCommandBuffer(m_handle);
 }
 
-void CommandBuffer::BeginRenderPass(RenderPass renderPass, FrameBuffer frameBuffer, glm::uvec2 size, SequenceView<ClearValue const> clearValues)
+void CommandBuffer::BeginRenderPass(RenderPass renderPass, FrameBuffer frameBuffer, glm::uvec2 size, SequenceView<ClearValue const> clearValues, bool secondaryContents)
 {
 	VkRenderPassBeginInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -74,12 +96,17 @@ void CommandBuffer::BeginRenderPass(RenderPass renderPass, FrameBuffer frameBuff
 	renderPassInfo.renderArea.extent = { size.x, size.y };
 	renderPassInfo.clearValueCount = clearValues.Size();
 	renderPassInfo.pClearValues = reinterpret_cast<VkClearValue const*>(clearValues.Data());
-	vkCmdBeginRenderPass(m_handle, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(m_handle, &renderPassInfo, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void CommandBuffer::NextSubpass(bool secondaryContents)
+{
+	vkCmdNextSubpass(m_handle, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 }
 
-void CommandBuffer::NextSubpass()
+void CommandBuffer::ExecuteCommands(SequenceView<CommandBuffer const> commandBuffers)
 {
-	vkCmdNextSubpass(m_handle, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdExecuteCommands(m_handle, commandBuffers.Size(), reinterpret_cast<VkCommandBuffer const*>(commandBuffers.Data()));
 }
 
 void CommandBuffer::EndRenderPass()
@@ -87,6 +114,26 @@ void CommandBuffer::EndRenderPass()
 	vkCmdEndRenderPass(m_handle);
 }
 
+void CommandBuffer::ResetQueries(QueryPool queryPool, uint32_t firstQuery, uint32_t numQueries)
+{
+	vkCmdResetQueryPool(m_handle, queryPool.GetHandle(), firstQuery, numQueries);
+}
+
+void CommandBuffer::WriteTimestamp(QueryPool queryPool, uint32_t query, PipelineStage stage)
+{
+	vkCmdWriteTimestamp2(m_handle, static_cast<VkPipelineStageFlags2>(stage), queryPool.GetHandle(), query);
+}
+
+void CommandBuffer::BeginQuery(QueryPool queryPool, uint32_t query)
+{
+	vkCmdBeginQuery(m_handle, queryPool.GetHandle(), query, 0);
+}
+
+void CommandBuffer::EndQuery(QueryPool queryPool, uint32_t query)
+{
+	vkCmdEndQuery(m_handle, queryPool.GetHandle(), query);
+}
+
 void CommandBuffer::BindPipelineState(PipelineState pipelineState)
 {
 	vkCmdBindPipeline(m_handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineState.GetHandle());
@@ -218,7 +265,8 @@ void CommandBuffer::MemoryBarrier(PipelineStage stageBefore, PipelineStage stage
 	vkCmdPipelineBarrier(m_handle, static_cast<VkPipelineStageFlags2>(stageBefore), static_cast<VkPipelineStageFlags2>(stageAfter), 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
 }
 
-void CommandBuffer::ImageMemoryBarrier(Image image, uint32_t layerIndex, uint32_t numLayers, ImageAspect aspect, PipelineStage stageBefore, Access accessBefore, ImageLayout oldLayout, PipelineStage stageAfter, Access accessAfter, ImageLayout newLayout)
+void CommandBuffer::ImageMemoryBarrier(Image image, uint32_t layerIndex, uint32_t numLayers, ImageAspect aspect, PipelineStage stageBefore, Access accessBefore, ImageLayout oldLayout, PipelineStage stageAfter, Access accessAfter, ImageLayout newLayout,
+	uint32_t sourceQueueFamily, uint32_t destQueueFamily)
 {
 	VkImageMemoryBarrier2 imageBarrier = {};
 	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
@@ -228,8 +276,8 @@ void CommandBuffer::ImageMemoryBarrier(Image image, uint32_t layerIndex, uint32_
 	imageBarrier.dstAccessMask = static_cast<VkAccessFlags2>(accessAfter);
 	imageBarrier.oldLayout = VulkanEnum::GetImageLayout(oldLayout);
 	imageBarrier.newLayout = VulkanEnum::GetImageLayout(newLayout);
-	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.srcQueueFamilyIndex = sourceQueueFamily;
+	imageBarrier.dstQueueFamilyIndex = destQueueFamily;
 	imageBarrier.image = image.GetHandle();
 	imageBarrier.subresourceRange.aspectMask = VulkanEnum::GetImageAspect(aspect);
 	imageBarrier.subresourceRange.baseMipLevel = 0;
@@ -243,7 +291,8 @@ void CommandBuffer::ImageMemoryBarrier(Image image, uint32_t layerIndex, uint32_
 	vkCmdPipelineBarrier2(m_handle, &depInfo);
 }
 
-void CommandBuffer::BufferMemoryBarrier(Buffer buffer, uint32_t offset, uint32_t size, PipelineStage stageBefore, Access accessBefore, PipelineStage stageAfter, Access accessAfter)
+void CommandBuffer::BufferMemoryBarrier(Buffer buffer, uint32_t offset, uint32_t size, PipelineStage stageBefore, Access accessBefore, PipelineStage stageAfter, Access accessAfter,
+	uint32_t sourceQueueFamily, uint32_t destQueueFamily)
 {
 	VkBufferMemoryBarrier2 bufferBarrier = {};
 	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
@@ -251,8 +300,8 @@ void CommandBuffer::BufferMemoryBarrier(Buffer buffer, uint32_t offset, uint32_t
 	bufferBarrier.srcAccessMask = static_cast<VkAccessFlags2>(accessBefore);
 	bufferBarrier.dstStageMask = static_cast<VkPipelineStageFlags2>(stageAfter);
 	bufferBarrier.dstAccessMask = static_cast<VkAccessFlags2>(accessAfter);
-	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.srcQueueFamilyIndex = sourceQueueFamily;
+	bufferBarrier.dstQueueFamilyIndex = destQueueFamily;
 	bufferBarrier.buffer = buffer.GetHandle();
 	bufferBarrier.offset = offset;
 	bufferBarrier.size = size;
@@ -3,6 +3,7 @@
 #include "Core/GL/frame_buffer.h"
 #include "Core/GL/descriptor.h"
 #include "Core/GL/pipeline_state.h"
+#include "Core/GL/query.h"
 #include <vulkan/vulkan.h>
 
 namespace glex::gl
@@ -32,9 +33,13 @@ namespace glex::gl
 		VkCommandBuffer GetHandle() const { return m_handle; }
 		void Reset();
 		void Begin();
+		// For secondary command buffers executed inside the subpass. Viewport and scissor aren't inherited.
+		void BeginSecondary(RenderPass renderPass, uint32_t subpass, FrameBuffer frameBuffer);
 		void End();
-		void BeginRenderPass(RenderPass renderPass, FrameBuffer frameBuffer, glm::uvec2 size, SequenceView<ClearValue const> clearValues);
-		void NextSubpass();
+		// Subpasses with secondary contents take nothing but ExecuteCommands.
+		void BeginRenderPass(RenderPass renderPass, FrameBuffer frameBuffer, glm::uvec2 size, SequenceView<ClearValue const> clearValues, bool secondaryContents = false);
+		void NextSubpass(bool secondaryContents = false);
+		void ExecuteCommands(SequenceView<CommandBuffer const> commandBuffers);
 		void EndRenderPass();
 		void BindPipelineState(PipelineState pipelineState);
 		void SetViewport(glm::vec4 const& border);
@@ -51,8 +56,16 @@ namespace glex::gl
 		void CopyImage(Buffer source, uint32_t offset, Image dest, uint32_t layer, ImageAspect aspect, glm::uvec2 size);
 		void ExecutionBarrier(PipelineStage stageBefore, PipelineStage stageAfter);
 		void MemoryBarrier(PipelineStage stageBefore, PipelineStage stageAfter, Access accessBefore, Access accessAfter);
-		void ImageMemoryBarrier(Image image, uint32_t layerIndex, uint32_t numLayers, ImageAspect aspect, PipelineStage stageBefore, Access accessBefore, ImageLayout oldLayout, PipelineStage stageAfter, Access accessAfter, ImageLayout newLayout);
-		void BufferMemoryBarrier(Buffer buffer, uint32_t offset, uint32_t size, PipelineStage stageBefore, Access accessBefore, PipelineStage stageAfter, Access accessAfter);
+		void ImageMemoryBarrier(Image image, uint32_t layerIndex, uint32_t numLayers, ImageAspect aspect, PipelineStage stageBefore, Access accessBefore, ImageLayout oldLayout, PipelineStage stageAfter, Access accessAfter, ImageLayout newLayout,
+			uint32_t sourceQueueFamily = VK_QUEUE_FAMILY_IGNORED, uint32_t destQueueFamily = VK_QUEUE_FAMILY_IGNORED);
+		void BufferMemoryBarrier(Buffer buffer, uint32_t offset, uint32_t size, PipelineStage stageBefore, Access accessBefore, PipelineStage stageAfter, Access accessAfter,
+			uint32_t sourceQueueFamily = VK_QUEUE_FAMILY_IGNORED, uint32_t destQueueFamily = VK_QUEUE_FAMILY_IGNORED);
+		// Queries have to be reset outside of render passes before they are used again.
+		void ResetQueries(QueryPool queryPool, uint32_t firstQuery, uint32_t numQueries);
+		// Written once everything before it has passed the stage.
+		void WriteTimestamp(QueryPool queryPool, uint32_t query, PipelineStage stage);
+		void BeginQuery(QueryPool queryPool, uint32_t query);
+		void EndQuery(QueryPool queryPool, uint32_t query);
 	};
 
 	class CommandPool
@@ -66,7 +79,9 @@ namespace glex::gl
 		bool Create(uint32_t queueFamily, bool transient);
 		void Destroy();
 		VkCommandPool GetHandle() const { return m_handle; }
-		CommandBuffer AllocateCommandBuffer();
+		CommandBuffer AllocateCommandBuffer(bool secondary = false);
 		void FreeCommandBuffer(CommandBuffer commandBuffer);
+		// Resets every command buffer allocated from it, none of them may be pending.
+		void Reset();
 	};
 }
\ No newline at end of file
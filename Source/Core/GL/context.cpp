@@ -4,6 +4,9 @@
 #include "Core/Container/basic.h"
 #include "Core/Platform/window.h"
 #include "Core/Platform/filesync.h"
+#include "Core/Platform/time.h"
+#include "Core/Utils/hash.h"
+#include "Core/Thread/task.h"
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_profiles.hpp>
 #include <bit>
@@ -23,13 +26,13 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityF
 	switch (messageSeverity)
 	{
 		case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-		Logger::Warn(pCallbackData->pMessage);
+		Logger::Warn("%s", pCallbackData->pMessage);
 		break;
 		case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-		Logger::Error(pCallbackData->pMessage);
+		Logger::Error("%s", pCallbackData->pMessage);
 		break;
 		default:
-		Logger::Info(pCallbackData->pMessage);
+		Logger::Info("%s", pCallbackData->pMessage);
 	}
 	return VK_FALSE;
 }
@@ -170,13 +173,19 @@ void Context::CreateDevice()
 
 	// If it supports the feature, just turn it on, so we don't have to recreate the device over and over again.
 	char const* const SWAP_CHAIN_NAME = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+	VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeature = {};
+	timelineFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	timelineFeature.timelineSemaphore = VK_TRUE;
 	VkPhysicalDeviceSynchronization2Features sync2Feature = {};
 	sync2Feature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
 	sync2Feature.synchronization2 = VK_TRUE;
+	sync2Feature.pNext = &timelineFeature;
 	VkPhysicalDeviceFeatures features = {};
 	features.fillModeNonSolid = s_deviceInfo.supportsWireframeRendering;
 	features.wideLines = s_deviceInfo.supportsWideLineRendering;
 	features.samplerAnisotropy = s_deviceInfo.supportsAnisotropicSampling;
+	features.pipelineStatisticsQuery = s_deviceInfo.supportsPipelineStatistics;
+	features.inheritedQueries = s_deviceInfo.supportsInheritedQueries;
 	VkDeviceCreateInfo deviceInfo = {};
 	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceInfo.pNext = &sync2Feature;
@@ -215,6 +224,8 @@ void Context::Startup(ContextStartupInfo const& info)
 	// Create swapchain.
 	CreateSwapChain(info.enableVsync, info.useTripleBuffering && s_deviceInfo.supportsTripleBuffering);
 
+	LoadPipelineCache(info.pipelineCacheFile);
+
 	// Log some information.
 	Logger::Info(R"~(+----------------------------------+
 |        DEVICE INFORMATION        |
@@ -264,13 +275,16 @@ Vector<PhysicalDevice> Context::FilterCards(Vector<VkPhysicalDevice> const& card
 		*/
 
 		////// Check synchronization 2 support. //////
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeature = {};
+		timelineFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
 		VkPhysicalDeviceSynchronization2Features sync2Feature = {};
 		sync2Feature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+		sync2Feature.pNext = &timelineFeature;
 		VkPhysicalDeviceFeatures2 features = {};
 		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
 		features.pNext = &sync2Feature;
 		vkGetPhysicalDeviceFeatures2(device, &features);
-		if (!sync2Feature.synchronization2)
+		if (!sync2Feature.synchronization2 || !timelineFeature.timelineSemaphore)
 			continue;
 
 		////// Check swap chain availability. //////
@@ -383,6 +397,15 @@ Vector<PhysicalDevice> Context::FilterCards(Vector<VkPhysicalDevice> const& card
 			deviceInfo.name = properties.deviceName;
 			deviceInfo.vendorID = properties.vendorID;
 			deviceInfo.deviceID = properties.deviceID;
+			deviceInfo.driverVersion = properties.driverVersion;
+			memcpy(deviceInfo.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+			VkPhysicalDeviceIDProperties idProperties = {};
+			idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+			VkPhysicalDeviceProperties2 properties2 = {};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties2.pNext = &idProperties;
+			vkGetPhysicalDeviceProperties2(device, &properties2);
+			memcpy(deviceInfo.driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
 			deviceInfo.isDedicated = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
 			deviceInfo.pushConstantsSize = properties.limits.maxPushConstantsSize;
 			deviceInfo.minWidth = capabilities.minImageExtent.width;
@@ -392,6 +415,10 @@ Vector<PhysicalDevice> Context::FilterCards(Vector<VkPhysicalDevice> const& card
 			deviceInfo.supportsWireframeRendering = features.features.fillModeNonSolid;
 			deviceInfo.supportsWideLineRendering = features.features.wideLines;
 			deviceInfo.supportsAnisotropicSampling = features.features.samplerAnisotropy;
+			deviceInfo.supportsPipelineStatistics = features.features.pipelineStatisticsQuery;
+			deviceInfo.supportsInheritedQueries = features.features.pipelineStatisticsQuery && features.features.inheritedQueries;
+			deviceInfo.supportsTimestamps = queueFamilies[deviceInfo.graphicsQueueIndex].timestampValidBits != 0;
+			deviceInfo.timestampPeriod = properties.limits.timestampPeriod;
 			deviceInfo.maxMSAALevel = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
 			deviceInfo.maxAnisotropyLevel = properties.limits.maxSamplerAnisotropy;
 			deviceInfo.maxTextureCount = properties.limits.maxPerStageDescriptorSampledImages;
@@ -424,6 +451,13 @@ void Context::Shutdown()
 	vmaDestroyAllocator(s_memoryAllocator);
 	s_transferCommandPool.Destroy();
 	s_graphicsCommandPool.Destroy();
+	SavePipelineCache();
+	Logger::Info("%u pipelines created in %.2f ms.", PipelineState::NumCreated(), PipelineState::CreationMilliseconds());
+	s_pipelineCache.Destroy();
+#if GLEX_REPORT_MEMORY_LEAKS
+	s_pipelineCacheFile.clear();
+	s_pipelineCacheFile.shrink_to_fit();
+#endif
 	vkDestroyDevice(s_device, nullptr);
 	vkDestroySurfaceKHR(s_instance, s_windowSurface, nullptr);
 #if GLEX_ENABLE_VALIDATION_LAYER
@@ -434,6 +468,153 @@ void Context::Shutdown()
 	vkDestroyInstance(s_instance, nullptr);
 }
 
+/*————————————————————————————————————————————————————————————————————————————————————————————————————————————
+		PIPELINE CACHE
+ ————————————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Goes in front of the driver's data. Drivers check their own header, but not all of them survive data that is
+// corrupted past it, so the checksum covers everything.
+struct PipelineCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t driverVersion;
+	uint8_t driverUUID[VK_UUID_SIZE];
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+	uint64_t dataSize;
+	uint64_t dataHash;
+};
+
+constexpr uint32_t k_pipelineCacheMagic = 0x43505847; // "GXPC"
+constexpr uint32_t k_pipelineCacheVersion = 1;
+
+// Returns why the file can't be used, or null if it can.
+static char const* CheckPipelineCacheFile(void const* content, uint64_t size, PhysicalDevice const& device)
+{
+	PipelineCacheFileHeader header;
+	if (size < sizeof(header))
+		return "it is truncated";
+	memcpy(&header, content, sizeof(header));
+	if (header.magic != k_pipelineCacheMagic || header.version != k_pipelineCacheVersion)
+		return "it is not a pipeline cache of this version";
+	if (header.vendorID != device.vendorID || header.deviceID != device.deviceID || header.driverVersion != device.driverVersion ||
+		memcmp(header.driverUUID, device.driverUUID, VK_UUID_SIZE) != 0 || memcmp(header.pipelineCacheUUID, device.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return "it is from another GPU or driver";
+	if (header.dataSize != size - sizeof(header))
+		return "it is truncated";
+	char const* data = static_cast<char const*>(content) + sizeof(header);
+	if (HashBytes(data, header.dataSize) != header.dataHash)
+		return "it is corrupted";
+	VkPipelineCacheHeaderVersionOne driverHeader;
+	if (header.dataSize < sizeof(driverHeader))
+		return "it is corrupted";
+	memcpy(&driverHeader, data, sizeof(driverHeader));
+	if (driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		driverHeader.vendorID != device.vendorID || driverHeader.deviceID != device.deviceID ||
+		memcmp(driverHeader.pipelineCacheUUID, device.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return "the driver's header doesn't match";
+	return nullptr;
+}
+
+void Context::LoadPipelineCache(char const* file)
+{
+	uint64_t begin = Time::Ticks();
+	s_pipelineCacheFile = file != nullptr ? file : "";
+	s_savedPipelineCacheSize = 0;
+	if (file != nullptr)
+	{
+		// A missing file is a cold start, nothing to warn about.
+		auto [content, size] = FileSync::ReadAllContent(file);
+		if (content != nullptr)
+		{
+			char const* rejection = CheckPipelineCacheFile(content, size, s_deviceInfo);
+			size_t dataSize = size - sizeof(PipelineCacheFileHeader);
+			if (rejection == nullptr && s_pipelineCache.Create(Mem::Offset(content.Get(), sizeof(PipelineCacheFileHeader)), dataSize))
+			{
+				s_savedPipelineCacheSize = dataSize;
+				Logger::Info("Pipeline cache loaded from %s in %.2f ms, %llu bytes.", file, (Time::Ticks() - begin) * 1e3 / Time::TicksPerSecond(), static_cast<unsigned long long>(dataSize));
+				return;
+			}
+			Logger::Warn("Pipeline cache %s is discarded because %s.", file, rejection != nullptr ? rejection : "the driver rejected it");
+		}
+	}
+	if (!s_pipelineCache.Create())
+		Logger::Fatal("Cannot create pipeline cache.");
+	Logger::Info("Pipeline cache starts cold.");
+}
+
+// Everything but the checksum, which is taken where the file is written.
+static PipelineCacheFileHeader MakePipelineCacheHeader(PhysicalDevice const& device, size_t dataSize)
+{
+	PipelineCacheFileHeader header = {};
+	header.magic = k_pipelineCacheMagic;
+	header.version = k_pipelineCacheVersion;
+	header.vendorID = device.vendorID;
+	header.deviceID = device.deviceID;
+	header.driverVersion = device.driverVersion;
+	memcpy(header.driverUUID, device.driverUUID, VK_UUID_SIZE);
+	memcpy(header.pipelineCacheUUID, device.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = dataSize;
+	return header;
+}
+
+// Touches nothing of the context, so it can run on any thread.
+static bool WritePipelineCacheFile(char const* path, PipelineCacheFileHeader header, Vector<uint8_t> const& data)
+{
+	header.dataHash = HashBytes(reinterpret_cast<char const*>(data.data()), data.size());
+	// A write cut short fails the checksum when loaded, and that run starts cold.
+	FileSync file(path, FileAccess::Write, FileOpen::CreateOrOverwrite);
+	if (file == nullptr || !file.Write(header) || file.Write(data.data(), data.size()) != data.size())
+	{
+		Logger::Warn("Cannot write pipeline cache to %s.", path);
+		return false;
+	}
+	return true;
+}
+
+bool Context::PipelineCacheChanged()
+{
+	// Caches only grow, so an unchanged size means nothing new.
+	size_t size = s_pipelineCache.DataSize();
+	return size != 0 && size != Atomic::Load(&s_savedPipelineCacheSize);
+}
+
+bool Context::SavePipelineCache()
+{
+	if (s_pipelineCacheFile.empty())
+		return false;
+	// An aborted write leaves the saved size alone, so what it had is written here. Engine::Shutdown calls this before
+	// the pool is gone, so a write in flight finishes first.
+	if (!s_pipelineCacheWrite.IsDone())
+		Async::Wait(s_pipelineCacheWrite);
+	if (!PipelineCacheChanged())
+		return true;
+	Vector<uint8_t> data;
+	if (!s_pipelineCache.GetData(data) || !WritePipelineCacheFile(s_pipelineCacheFile.c_str(), MakePipelineCacheHeader(s_deviceInfo, data.size()), data))
+		return false;
+	Atomic::Store(&s_savedPipelineCacheSize, data.size());
+	return true;
+}
+
+void Context::SavePipelineCacheAsync()
+{
+	if (s_pipelineCacheFile.empty() || !s_pipelineCacheWrite.IsDone() || !PipelineCacheChanged())
+		return;
+	Vector<uint8_t> data;
+	if (!s_pipelineCache.GetData(data))
+		return;
+	auto write = [path = s_pipelineCacheFile, header = MakePipelineCacheHeader(s_deviceInfo, data.size()), data = std::move(data)]()
+	{
+		if (WritePipelineCacheFile(path.c_str(), header, data))
+			Atomic::Store(&s_savedPipelineCacheSize, data.size());
+	};
+	if (Async::ThreadCount() != 0)
+		Async::SubmitWork(std::move(write), &s_pipelineCacheWrite);
+	else
+		write();
+}
+
 /*————————————————————————————————————————————————————————————————————————————————————————————————————————————
 		SWAPCHAIN CREATION
  ————————————————————————————————————————————————————————————————————————————————————————————————————————————*/
@@ -530,6 +711,39 @@ void Context::SubmitCommand(VkQueue queue, CommandBuffer commandBuffer, Semaphor
 	!vkQueueSubmit2(queue, 1, &submitInfo, signalFence.GetHandle());
 }
 
+void Context::SubmitCommand(VkQueue queue, CommandBuffer commandBuffer, SequenceView<SemaphoreSubmit const> waitSemaphores, SequenceView<SemaphoreSubmit const> signalSemaphores, Fence signalFence)
+{
+	constexpr uint32_t k_maxSemaphores = 4;
+	GLEX_DEBUG_ASSERT(waitSemaphores.Size() <= k_maxSemaphores && signalSemaphores.Size() <= k_maxSemaphores) {}
+	VkSemaphoreSubmitInfo waitInfo[k_maxSemaphores];
+	VkSemaphoreSubmitInfo signalInfo[k_maxSemaphores];
+	auto Fill = [](VkSemaphoreSubmitInfo* info, SequenceView<SemaphoreSubmit const> semaphores)
+	{
+		for (uint32_t i = 0; i < semaphores.Size(); i++)
+		{
+			info[i] = {};
+			info[i].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+			info[i].semaphore = semaphores[i].semaphore;
+			info[i].value = semaphores[i].value;
+			info[i].stageMask = static_cast<VkPipelineStageFlags2>(semaphores[i].stage);
+		}
+	};
+	Fill(waitInfo, waitSemaphores);
+	Fill(signalInfo, signalSemaphores);
+	VkCommandBufferSubmitInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	bufferInfo.commandBuffer = commandBuffer.GetHandle();
+	VkSubmitInfo2 submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submitInfo.waitSemaphoreInfoCount = waitSemaphores.Size();
+	submitInfo.pWaitSemaphoreInfos = waitInfo;
+	submitInfo.commandBufferInfoCount = 1;
+	submitInfo.pCommandBufferInfos = &bufferInfo;
+	submitInfo.signalSemaphoreInfoCount = signalSemaphores.Size();
+	submitInfo.pSignalSemaphoreInfos = signalInfo;
+	!vkQueueSubmit2(queue, 1, &submitInfo, signalFence.GetHandle());
+}
+
 void Context::WaitQueue(VkQueue queue)
 {
 	!vkQueueWaitIdle(queue);
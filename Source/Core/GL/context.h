@@ -10,6 +10,7 @@
 #include "Core/GL/frame_buffer.h"
 #include "Core/GL/command.h"
 #include "Core/GL/sync.h"
+#include "Core/Thread/pool.h"
 #include <vma/vk_mem_alloc.h>
 
 namespace glex
@@ -19,10 +20,19 @@ namespace glex
 		Function<PhysicalDevice*(SequenceView<PhysicalDevice const>)> cardSelector;
 		bool useTripleBuffering = false;
 		bool enableVsync = true;
+		char const* pipelineCacheFile = "pipeline.cache"; // Compiled pipelines are not kept across runs if null.
 	};
 
 	namespace gl
 	{
+		// Value is what a timeline semaphore is waited for or signaled with, binary semaphores ignore it.
+		struct SemaphoreSubmit
+		{
+			VkSemaphore semaphore;
+			uint64_t value;
+			PipelineStage stage;
+		};
+
 		class Context : private StaticClass
 		{
 		private:
@@ -44,12 +54,18 @@ namespace glex
 			inline static glm::uvec2 s_size;
 			inline static PhysicalDevice s_deviceInfo;
 			inline static VmaAllocator s_memoryAllocator;
+			inline static PipelineCache s_pipelineCache;
+			inline static String s_pipelineCacheFile;
+			inline static size_t s_savedPipelineCacheSize;	// Also stored by the worker writing the file.
+			inline static JobCounter s_pipelineCacheWrite;
 
 			static uint32_t CreateInstance();
 			static void SelectCard(Function<PhysicalDevice*(SequenceView<PhysicalDevice const>)> const& cardSelector);
 			static Vector<PhysicalDevice> FilterCards(Vector<VkPhysicalDevice> const& cards);
 			static void CreateDevice();
 			static void CreateSwapChain(bool enableVsync, bool useTripleBuffering);
+			static void LoadPipelineCache(char const* file);
+			static bool PipelineCacheChanged();
 
 		public:
 			static void Startup(ContextStartupInfo const& info);
@@ -67,7 +83,15 @@ namespace glex
 			static CommandPool GetTransferCommandPool() { return s_transferCommandPool; }
 			static VkQueue GetGraphicsQueue() { return s_graphicsQueue; }
 			static VkQueue GetTransferQueue() { return s_transferQueue; }
+			static PipelineCache GetPipelineCache() { return s_pipelineCache; }
+			// Writes the cache if it has grown since the last time. Also done at shutdown.
+			static bool SavePipelineCache();
+			// Same, but only the cache data is taken here, the file is written on a worker. Skipped while the last write runs.
+			static void SavePipelineCacheAsync();
+			// Nothing may be creating pipelines with the context's cache meanwhile.
+			static bool MergePipelineCaches(SequenceView<PipelineCache const> sources) { return s_pipelineCache.Merge(sources); }
 			static void SubmitCommand(VkQueue queue, CommandBuffer commandBuffer, Semaphore waitSemaphore, PipelineStage waitStage, Semaphore signalSemaphore, PipelineStage signalStage, Fence signalFence);
+			static void SubmitCommand(VkQueue queue, CommandBuffer commandBuffer, SequenceView<SemaphoreSubmit const> waitSemaphores, SequenceView<SemaphoreSubmit const> signalSemaphores, Fence signalFence);
 			static void WaitQueue(VkQueue queue);
 			static Image AcquireSwapchainImage(Semaphore signalSemaphore);
 			static void Present(Semaphore waitSemaphore);
@@ -11,6 +11,9 @@ namespace glex
 		VkPhysicalDevice handle;
 		String name;
 		uint32_t vendorID, deviceID;
+		uint32_t driverVersion;
+		uint8_t driverUUID[VK_UUID_SIZE];
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
 		uint64_t dedicatedMemory;
 		uint64_t sharedMemory;
 		uint32_t pushConstantsSize;
@@ -25,8 +28,12 @@ namespace glex
 		bool supportsWireframeRendering;
 		bool supportsWideLineRendering;
 		bool supportsAnisotropicSampling;
+		bool supportsPipelineStatistics;
+		bool supportsTimestamps;
+		bool supportsInheritedQueries; // Secondary command buffers can run inside statistics queries.
 		uint8_t maxMSAALevel;
 		float maxAnisotropyLevel;
+		float timestampPeriod; // Nanoseconds per tick.
 		uint32_t maxTextureCount;
 		uint32_t maxSamplerCount;
 
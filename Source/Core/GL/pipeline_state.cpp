@@ -1,9 +1,61 @@
 #include "Core/GL/pipeline_state.h"
 #include "Core/GL/context.h"
+#include "Core/Platform/time.h"
+#include "Core/Thread/atomic.h"
 
+using namespace glex;
 using namespace glex::gl;
 
-bool PipelineState::Create(PipelineInfo const& info)
+bool PipelineCache::Create(void const* initialData, size_t initialSize)
+{
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = initialSize;
+	cacheInfo.pInitialData = initialData;
+	if (vkCreatePipelineCache(Context::GetDevice(), &cacheInfo, Context::HostAllocator(), &m_handle) == VK_SUCCESS)
+		return true;
+	m_handle = VK_NULL_HANDLE;
+	return false;
+}
+
+void PipelineCache::Destroy()
+{
+	vkDestroyPipelineCache(Context::GetDevice(), m_handle, Context::HostAllocator());
+}
+
+size_t PipelineCache::DataSize() const
+{
+	size_t size;
+	if (vkGetPipelineCacheData(Context::GetDevice(), m_handle, &size, nullptr) != VK_SUCCESS)
+		return 0;
+	return size;
+}
+
+bool PipelineCache::GetData(Vector<uint8_t>& outData) const
+{
+	VkResult result;
+	do
+	{
+		// Pipelines created in between make it grow.
+		size_t size = DataSize();
+		if (size == 0)
+			return false;
+		outData.resize(size);
+		result = vkGetPipelineCacheData(Context::GetDevice(), m_handle, &size, outData.data());
+		outData.resize(size);
+	} while (result == VK_INCOMPLETE);
+	return result == VK_SUCCESS;
+}
+
+bool PipelineCache::Merge(SequenceView<PipelineCache const> sources)
+{
+	Vector<VkPipelineCache> handles(sources.Size());
+	for (uint32_t i = 0; i < sources.Size(); i++)
+		handles[i] = sources[i].GetHandle();
+	return vkMergePipelineCaches(Context::GetDevice(), m_handle, handles.size(), handles.data()) == VK_SUCCESS;
+}
+
+bool PipelineState::Create(PipelineInfo const& info, PipelineCache cache)
 {
 	// Dynamic state.
 	VkDynamicState dynamicStates[] =
@@ -154,12 +206,25 @@ bool PipelineState::Create(PipelineInfo const& info)
 	pipelineInfo.layout = info.descriptorLayout.GetHandle();
 	pipelineInfo.renderPass = info.renderPass.GetHandle();
 	pipelineInfo.subpass = info.subpass;
-	if (vkCreateGraphicsPipelines(Context::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, Context::HostAllocator(), &m_handle) == VK_SUCCESS)
+	if (cache.GetHandle() == VK_NULL_HANDLE)
+		cache = Context::GetPipelineCache();
+	uint64_t begin = Time::Ticks();
+	VkResult result = vkCreateGraphicsPipelines(Context::GetDevice(), cache.GetHandle(), 1, &pipelineInfo, Context::HostAllocator(), &m_handle);
+	Atomic::Add(&s_creationTicks, Time::Ticks() - begin);
+	if (result == VK_SUCCESS)
+	{
+		Atomic::Increment(&s_numCreated);
 		return true;
+	}
 	m_handle = VK_NULL_HANDLE;
 	return false;
 }
 
+double PipelineState::CreationMilliseconds()
+{
+	return s_creationTicks * 1e3 / Time::TicksPerSecond();
+}
+
 void PipelineState::Destroy()
 {
 	vkDestroyPipeline(Context::GetDevice(), m_handle, Context::HostAllocator());
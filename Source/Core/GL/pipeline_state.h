@@ -34,16 +34,41 @@ namespace glex::gl
 		Shader fragmentShader;
 	};
 
+	// Lets the driver skip compiling pipelines it has already seen. Pipelines can be created with the same cache from
+	// several threads at once, but a cache merged into must not be in use.
+	class PipelineCache
+	{
+	private:
+		VkPipelineCache m_handle;
+
+	public:
+		PipelineCache() : m_handle(VK_NULL_HANDLE) {}
+		PipelineCache(VkPipelineCache handle) : m_handle(handle) {}
+		// The initial data must come from a cache of the same device and driver, see Context::LoadPipelineCache.
+		bool Create(void const* initialData = nullptr, size_t initialSize = 0);
+		void Destroy();
+		VkPipelineCache GetHandle() const { return m_handle; }
+		size_t DataSize() const;
+		bool GetData(Vector<uint8_t>& outData) const;
+		bool Merge(SequenceView<PipelineCache const> sources);
+	};
+
 	class PipelineState
 	{
 	private:
 		VkPipeline m_handle;
+		inline static uint32_t s_numCreated;
+		inline static uint64_t s_creationTicks;
 
 	public:
 		PipelineState() : m_handle(VK_NULL_HANDLE) {}
 		PipelineState(VkPipeline handle) : m_handle(handle) {}
-		bool Create(PipelineInfo const& info);
+		// Uses the context's cache if none is given.
+		bool Create(PipelineInfo const& info, PipelineCache cache = PipelineCache());
 		void Destroy();
+		// Pipelines created so far and the time spent on them, which is how much a warm cache saves shows.
+		static uint32_t NumCreated() { return s_numCreated; }
+		static double CreationMilliseconds();
 		VkPipeline GetHandle() const { return m_handle; }
 		bool operator==(PipelineState const& rhs) const { return m_handle == rhs.m_handle; }
 	};
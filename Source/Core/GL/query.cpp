@@ -0,0 +1,33 @@
+#include "Core/GL/query.h"
+#include "Core/GL/context.h"
+
+using namespace glex::gl;
+
+bool QueryPool::Create(QueryType type, uint32_t numQueries)
+{
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryCount = numQueries;
+	if (type == QueryType::Timestamp)
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	else
+	{
+		poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		poolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+	}
+	if (vkCreateQueryPool(Context::GetDevice(), &poolInfo, Context::HostAllocator(), &m_handle) == VK_SUCCESS)
+		return true;
+	m_handle = VK_NULL_HANDLE;
+	return false;
+}
+
+void QueryPool::Destroy()
+{
+	vkDestroyQueryPool(Context::GetDevice(), m_handle, Context::HostAllocator());
+}
+
+bool QueryPool::GetResults(uint32_t firstQuery, uint32_t numQueries, uint32_t valuesPerQuery, uint64_t* outResults) const
+{
+	uint32_t stride = valuesPerQuery * sizeof(uint64_t);
+	return vkGetQueryPoolResults(Context::GetDevice(), m_handle, firstQuery, numQueries, numQueries * stride, outResults, stride, VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+namespace glex::gl
+{
+	enum class QueryType : uint8_t
+	{
+		Timestamp,
+		// Input assembly primitives, vertex shader invocations, clipping primitives and fragment shader invocations, in this order.
+		PipelineStatistics
+	};
+
+	class QueryPool
+	{
+	private:
+		VkQueryPool m_handle;
+
+	public:
+		constexpr static uint32_t NUM_PIPELINE_STATISTICS = 4;
+		constexpr static VkQueryPipelineStatisticFlags PIPELINE_STATISTICS = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+		QueryPool() : m_handle(VK_NULL_HANDLE) {}
+		QueryPool(VkQueryPool handle) : m_handle(handle) {}
+		bool Create(QueryType type, uint32_t numQueries);
+		void Destroy();
+		VkQueryPool GetHandle() const { return m_handle; }
+		// One value per timestamp, NUM_PIPELINE_STATISTICS per statistics query. Never waits, false if any of them isn't available.
+		bool GetResults(uint32_t firstQuery, uint32_t numQueries, uint32_t valuesPerQuery, uint64_t* outResults) const;
+	};
+}
\ No newline at end of file
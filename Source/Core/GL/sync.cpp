@@ -18,6 +18,43 @@ void Semaphore::Destroy()
 	vkDestroySemaphore(Context::GetDevice(), m_handle, Context::HostAllocator());
 }
 
+bool TimelineSemaphore::Create(uint64_t initialValue)
+{
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = initialValue;
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+	if (vkCreateSemaphore(Context::GetDevice(), &semaphoreInfo, Context::HostAllocator(), &m_handle) == VK_SUCCESS)
+		return true;
+	m_handle = VK_NULL_HANDLE;
+	return false;
+}
+
+void TimelineSemaphore::Destroy()
+{
+	vkDestroySemaphore(Context::GetDevice(), m_handle, Context::HostAllocator());
+}
+
+uint64_t TimelineSemaphore::GetValue() const
+{
+	uint64_t value;
+	!vkGetSemaphoreCounterValue(Context::GetDevice(), m_handle, &value);
+	return value;
+}
+
+void TimelineSemaphore::Wait(uint64_t value) const
+{
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_handle;
+	waitInfo.pValues = &value;
+	!vkWaitSemaphores(Context::GetDevice(), &waitInfo, UINT64_MAX);
+}
+
 bool Fence::Create(bool signaled)
 {
 	VkFenceCreateInfo fenceInfo = {};
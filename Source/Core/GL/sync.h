@@ -16,6 +16,22 @@ namespace glex::gl
 		VkSemaphore GetHandle() const { return m_handle; }
 	};
 
+	// Counts up instead of flipping, so the host and any number of submissions can wait for any value.
+	class TimelineSemaphore
+	{
+	private:
+		VkSemaphore m_handle;
+
+	public:
+		TimelineSemaphore() : m_handle(VK_NULL_HANDLE) {}
+		TimelineSemaphore(VkSemaphore handle) : m_handle(handle) {}
+		bool Create(uint64_t initialValue);
+		void Destroy();
+		VkSemaphore GetHandle() const { return m_handle; }
+		uint64_t GetValue() const;
+		void Wait(uint64_t value) const;
+	};
+
 	class Fence
 	{
 	private:
@@ -1,90 +1,125 @@
 #include "Core/Memory/framealloc.h"
-#include "Core/Memory/mem.h"
+#include "Core/Thread/lock.h"
+#include "Core/Thread/thread.h"
 #include "Core/log.h"
 
 using namespace glex;
 
-FrameAllocator::FrameAllocator(uint32_t size)
+namespace
 {
-	m_start = Mem::AllocPages(size);
-	m_end = Mem::Offset(m_start, size);
-	m_startCommited = m_start;
-	m_endCommited = m_end;
-	m_startStackPointer = m_start;
-	m_endStackPointer = m_end;
-	m_growFromStart = true;
+	struct ThreadArena
+	{
+		ThreadArena* prev;
+		ThreadArena* next;
+		void* base;
+		uint32_t threadID;
+		uint32_t currentSlot;
+		uint32_t lastFrameBytes;
+		uint32_t peakBytes;
+		uint32_t frames[FrameMemory::k_maxFramesInFlight];	// Frame each slot is serving.
+		uint32_t used[FrameMemory::k_maxFramesInFlight];
+		uint32_t committed[FrameMemory::k_maxFramesInFlight];
+
+		ThreadArena();
+		~ThreadArena();
+	};
+
+	// Created on first use, so threads that never touch frame memory don't reserve anything.
+	struct ArenaHolder
+	{
+		ThreadArena* arena = nullptr;
+		~ArenaHolder() { if (arena != nullptr) Mem::Delete(arena); }
+	};
+
+	// Registered so stats can be collected from any thread.
+	Mutex s_registryLock;
+	ThreadArena* s_arenas = nullptr;
 }
 
-FrameAllocator::~FrameAllocator()
+static thread_local ArenaHolder t_arena;
+
+ThreadArena::ThreadArena() : prev(nullptr), threadID(Thread::GetThreadID()), currentSlot(0), lastFrameBytes(0), peakBytes(0)
 {
-	Mem::FreePages(m_start);
+	base = Mem::AllocPages(static_cast<uint64_t>(FrameMemory::k_arenaSize) * FrameMemory::k_maxFramesInFlight, FrameMemory::k_pageKind);
+	for (uint32_t i = 0; i < FrameMemory::k_maxFramesInFlight; i++)
+	{
+		frames[i] = UINT32_MAX;
+		used[i] = 0;
+		committed[i] = 0;
+	}
+	ScopedLock lock(s_registryLock);
+	next = s_arenas;
+	if (next != nullptr)
+		next->prev = this;
+	s_arenas = this;
 }
 
-void* FrameAllocator::Allocate(uint32_t size, uint32_t alignment)
+ThreadArena::~ThreadArena()
 {
-	if (m_growFromStart)
 	{
-		void* ptr = Mem::Align(m_startStackPointer, alignment);
-		m_startStackPointer = Mem::Offset(ptr, size);
-		if (m_startStackPointer > m_endStackPointer)
-			Logger::Fatal("Frame allocator is too small. Current size: %d. Allocating: %d.", Mem::Diff(m_start, m_end), size);
-		if (m_startStackPointer > m_startCommited)
-		{
-			void* end = Mem::Align(m_startStackPointer, Mem::k_pageSize);
-			if (end > m_endCommited) [[unlikely]]
-			{
-				end = m_endCommited;
-				uint32_t commitSize = Mem::Diff(m_startCommited, end);
-				Mem::CommitPages(m_startCommited, commitSize);
-				m_startCommited = m_end;
-				m_endCommited = m_start;
-			}
-			else
-			{
-				uint32_t commitSize = Mem::Diff(m_startCommited, end);
-				Mem::CommitPages(m_startCommited, commitSize);
-				m_startCommited = end;
-			}
-		}
-		return ptr;
+		ScopedLock lock(s_registryLock);
+		if (prev != nullptr)
+			prev->next = next;
+		else
+			s_arenas = next;
+		if (next != nullptr)
+			next->prev = prev;
 	}
-	else
+	Mem::FreePages(base, static_cast<uint64_t>(FrameMemory::k_arenaSize) * FrameMemory::k_maxFramesInFlight);
+}
+
+void FrameMemory::Startup(uint32_t numFramesInFlight)
+{
+	if (numFramesInFlight == 0 || numFramesInFlight > k_maxFramesInFlight)
 	{
-		m_endStackPointer = Mem::DownAlign(Mem::DownOffset(m_endStackPointer, size), alignment);
-		if (m_endStackPointer < m_startStackPointer)
-			Logger::Fatal("Frame allocator is too small. Current size: %d. Allocating: %d.", Mem::Diff(m_start, m_end), size);
-		if (m_endStackPointer < m_endCommited)
-		{
-			void* start = Mem::DownAlign(m_endStackPointer, Mem::k_pageSize);
-			if (start < m_startCommited) [[unlikely]]
-			{
-				start = m_startCommited;
-				uint32_t commitSize = Mem::Diff(start, m_endCommited);
-				Mem::CommitPages(start, commitSize);
-				m_startCommited = m_end;
-				m_endCommited = m_start;
-			}
-			else
-			{
-				uint32_t commitSize = Mem::Diff(start, m_endCommited);
-				Mem::CommitPages(start, commitSize);
-				m_endCommited = start;
-			}
-		}
-		return m_endStackPointer;
+		Logger::Warn("Frame memory supports 1 to %d frames in flight.", k_maxFramesInFlight);
+		numFramesInFlight = Min(Max(numFramesInFlight, 1u), k_maxFramesInFlight);
 	}
+	s_numFramesInFlight = numFramesInFlight;
 }
 
-void FrameAllocator::Swap()
+void* FrameMemory::Allocate(uint32_t size, uint32_t alignment)
 {
-	if (m_growFromStart)
+	if (t_arena.arena == nullptr) GLEX_UNLIKELY
+		t_arena.arena = Mem::New<ThreadArena>();
+	ThreadArena& arena = *t_arena.arena;
+	uint32_t frame = Atomic::Load(&s_frameIndex);
+	uint32_t slot = frame % s_numFramesInFlight;
+	if (arena.frames[slot] != frame) GLEX_UNLIKELY
+	{
+		// First allocation of this frame on this thread. The slot's previous frame is done on the GPU.
+		uint32_t lastBytes = arena.used[arena.currentSlot];
+		Atomic::Store(&arena.lastFrameBytes, lastBytes);
+		Atomic::Store(&arena.peakBytes, Max(arena.peakBytes, lastBytes));
+		arena.frames[slot] = frame;
+		Atomic::Store(&arena.used[slot], 0u);
+		Atomic::Store(&arena.currentSlot, slot);
+	}
+	uint32_t offset = Mem::Align(arena.used[slot], alignment);
+	uint64_t end = static_cast<uint64_t>(offset) + size;
+	if (end > k_arenaSize)
+		Logger::Fatal("Frame arena is too small. Current size: %d. Allocating: %d.", k_arenaSize, size);
+	void* slotBase = Mem::Offset(arena.base, slot * k_arenaSize);
+	if (end > arena.committed[slot])
 	{
-		m_endStackPointer = m_end;
-		m_growFromStart = false;
+		// Pages stay committed for later frames.
+		uint32_t committedEnd = Mem::Align(static_cast<uint32_t>(end), Mem::CommitGranularity(k_pageKind));
+		Mem::CommitPages(Mem::Offset(slotBase, arena.committed[slot]), committedEnd - arena.committed[slot]);
+		arena.committed[slot] = committedEnd;
 	}
-	else
+	Atomic::Store(&arena.used[slot], static_cast<uint32_t>(end));
+	return Mem::Offset(slotBase, offset);
+}
+
+void FrameMemory::GetStats(Vector<FrameMemoryStats>& out)
+{
+	ScopedLock lock(s_registryLock);
+	for (ThreadArena* arena = s_arenas; arena != nullptr; arena = arena->next)
 	{
-		m_startStackPointer = m_start;
-		m_growFromStart = true;
+		FrameMemoryStats& stats = out.emplace_back();
+		stats.threadID = arena->threadID;
+		stats.currentFrameBytes = Atomic::Load(&arena->used[Atomic::Load(&arena->currentSlot)]);
+		stats.lastFrameBytes = Atomic::Load(&arena->lastFrameBytes);
+		stats.peakBytes = Max(Atomic::Load(&arena->peakBytes), stats.currentFrameBytes);
 	}
 }
\ No newline at end of file
@@ -1,26 +1,102 @@
+/**
+ * Per-thread frame memory.
+ * Every thread bump-allocates from its own arena, one per frame in flight, so no allocation touches shared state.
+ * An arena is recycled when its slot comes around again, after the renderer has waited for that frame's fence,
+ * so frame memory can be handed to the GPU. Nothing allocated here is ever destructed.
+ */
 #pragma once
-#include "Core/commdefs.h"
-#include <stdint.h>
+#include "Core/Memory/mem.h"
+#include "Core/Container/basic.h"
+#include "Core/Thread/atomic.h"
+#include "Core/assert.h"
+#include "config.h"
 
 namespace glex
 {
+	struct FrameMemoryStats
+	{
+		uint32_t threadID;
+		uint32_t currentFrameBytes;
+		uint32_t lastFrameBytes;	// The last frame this thread allocated in before the current one.
+		uint32_t peakBytes;			// Most bytes used by this thread in a single frame.
+	};
 
-	class FrameAllocator : private Unmoveable
+	class FrameMemory : private StaticClass
 	{
+	public:
+		constexpr static uint32_t k_maxFramesInFlight = 4;
+		constexpr static uint32_t k_arenaSize = 64 * Limits::MB;	// Reserved per thread per frame in flight, committed on demand.
+		constexpr static PageKind k_pageKind = PageKind::Transparent;
+
 	private:
-		void* m_start;
-		void* m_end;
-		void* m_startCommited;
-		void* m_endCommited;
-		void* m_startStackPointer;
-		void* m_endStackPointer;
-		bool m_growFromStart;
+		inline static uint32_t s_frameIndex = 0;
+		inline static uint32_t s_numFramesInFlight = 1;
+
+	public:
+		// Valid until the frame has finished on the GPU, numFramesInFlight frames later.
+		static void* Allocate(uint32_t size, uint32_t alignment);
+		static uint32_t FrameIndex() { return Atomic::Load(&s_frameIndex); }
+		static uint32_t NumFramesInFlight() { return s_numFramesInFlight; }
+		static void GetStats(Vector<FrameMemoryStats>& out);
+
+		template <typename T, typename... Args> requires std::is_trivially_destructible_v<T>
+		static T* New(Args&&... args)
+		{
+			return new(Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		template <typename T> requires std::is_trivially_destructible_v<T>
+		static T* Alloc(uint32_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+#if GLEX_INTERNAL
+		// Must match the renderer's frames in flight.
+		static void Startup(uint32_t numFramesInFlight);
+		// Called by the renderer once the frame about to reuse its slot has finished on the GPU.
+		static void BeginFrame() { Atomic::Increment(&s_frameIndex); }
+#endif
+	};
 
+	// EASTL allocator over frame memory. Deallocation does nothing, the memory goes away with the frame.
+	class FrameAllocator
+	{
 	public:
-		FrameAllocator(uint32_t size);
-		~FrameAllocator();
-		void* Allocate(uint32_t size, uint32_t alignment);
-		void Swap();
+		FrameAllocator(char const* name = nullptr) {}
+		char const* get_name() const { return nullptr; }
+		void set_name(char const* name) {}
+
+		void* allocate(uint32_t n, int flags = 0)
+		{
+			return FrameMemory::Allocate(n, 16);
+		}
+
+		void* allocate(uint32_t n, uint32_t alignment, uint32_t offset, int flags = 0)
+		{
+			if (offset == 0)
+				return FrameMemory::Allocate(n, alignment);
+			// p + offset has to be aligned.
+			void* p = FrameMemory::Allocate(n + alignment, 1);
+			return Mem::DownOffset(Mem::Align(Mem::Offset(p, offset), alignment), offset);
+		}
+
+		void deallocate(void* p, uint32_t n) {}
+
+		bool operator==(FrameAllocator const& rhs) const
+		{
+			return true;
+		}
 	};
 
+	template <typename T>
+	using FrameVector = eastl::vector<T, FrameAllocator>;
+
+	template <typename K, typename V, typename Hasher = eastl::hash<K>, typename Comparator = eastl::equal_to<K>>
+	using FrameHashMap = eastl::hash_map<K, V, Hasher, Comparator, FrameAllocator>;
+
+	template <typename K, typename Hasher = eastl::hash<K>>
+	using FrameHashSet = eastl::hash_set<K, Hasher, eastl::equal_to<K>, FrameAllocator>;
+
+	using FrameString = eastl::basic_string<char, FrameAllocator>;
 }
\ No newline at end of file
@@ -1,95 +1,123 @@
 #include "Core/Memory/mem.h"
 #include "Core/assert.h"
 #include "Core/Thread/thread.h"
+#include "Core/Memory/memtrack.h"
 #include <mimalloc.h>
+#ifdef _WIN32
 #include <Windows.h>
-#if GLEX_REPORT_MEMORY_LEAKS
-#include <string>
+#else
+#include <sys/mman.h>
+#ifdef __linux__
+#include <linux/mman.h>
+#endif
 #endif
 
 using namespace glex;
 
-#if GLEX_REPORT_MEMORY_LEAKS
-void Mem::TraceAlloc(void* p)
+namespace
 {
-	s_addrXor ^= reinterpret_cast<uint64_t>(p);
-	s_addrSum += reinterpret_cast<uint64_t>(p);
-	s_allocTimes++;
-	if (s_traceMemoryAllocation)
-		s_traces[p] = std::stacktrace::current();
+	// Sits right before every block from mimalloc, so frees know what to take off the counters.
+	struct BlockHeader
+	{
+		uint64_t size;
+		MemoryTag tag;
+		bool isSampled;
+	};
+
+	constexpr uint32_t k_headerSize = 16;
+	static_assert(sizeof(BlockHeader) <= k_headerSize);
 }
 
-void Mem::TraceFree(void* p)
+// Blocks allocated with an offset may leave the header unaligned.
+static BlockHeader ReadHeader(void const* p)
 {
-	if (p == nullptr)
-		return;
-	s_addrXor ^= reinterpret_cast<uint64_t>(p);
-	s_addrSum -= reinterpret_cast<uint64_t>(p);
-	s_allocTimes--;
-	if (s_allocTimes < 0)
-		Logger::Error("Some pointers are freed more than once.");
-	if (s_traceMemoryAllocation)
-	{
-		auto iter = s_traces.find(p);
-		if (iter != s_traces.end())
-			s_traces.erase(iter);
-		else
-			s_doubleFrees[p].push_back(std::stacktrace::current());
-	}
+	BlockHeader header;
+	memcpy(&header, Mem::DownOffset(p, k_headerSize), sizeof(BlockHeader));
+	return header;
 }
-#endif
 
-void* Mem::Alloc(uint64_t size)
+static void* Track(void* block, uint64_t size, MemoryTag tag)
 {
-	void* p = mi_malloc(size);
-	if (p == nullptr)
-		OutOfMemory();
-#if GLEX_REPORT_MEMORY_LEAKS
-	TraceAlloc(p);
-#endif
+	if (block == nullptr)
+		Mem::OutOfMemory();
+	BlockHeader header = { size, MemoryTracker::Resolve(tag), false };
+	header.isSampled = MemoryTracker::RecordAlloc(header.tag, size);
+	memcpy(block, &header, sizeof(BlockHeader));
+	void* p = Mem::Offset(block, k_headerSize);
+	if (header.isSampled) GLEX_UNLIKELY
+		MemoryTracker::AddSample(p, header.tag, size);
 	return p;
 }
 
-void* Mem::Alloc(uint64_t size, uint32_t alignment)
+static void* Untrack(void* p)
 {
-	void* p = mi_malloc_aligned(size, alignment);
-	if (p == nullptr)
-		OutOfMemory();
-#if GLEX_REPORT_MEMORY_LEAKS
-	TraceAlloc(p);
-#endif
-	return p;
+	BlockHeader header = ReadHeader(p);
+	MemoryTracker::RecordFree(header.tag, header.size);
+	if (header.isSampled) GLEX_UNLIKELY
+		MemoryTracker::RemoveSample(p);
+	return Mem::DownOffset(p, k_headerSize);
 }
 
-void* Mem::Alloc(uint64_t size, uint32_t alignment, uint32_t offset)
+void* Mem::Alloc(uint64_t size, MemoryTag tag)
 {
-	void* p = mi_malloc_aligned_at(size, alignment, offset);
-	if (p == nullptr)
-		OutOfMemory();
-#if GLEX_REPORT_MEMORY_LEAKS
-	TraceAlloc(p);
+	return Track(mi_malloc(size + k_headerSize), size, tag);
+}
+
+void* Mem::Alloc(uint64_t size, uint32_t alignment, MemoryTag tag)
+{
+	if (alignment <= k_headerSize)
+		return Track(mi_malloc(size + k_headerSize), size, tag);
+	return Track(mi_malloc_aligned_at(size + k_headerSize, alignment, k_headerSize), size, tag);
+}
+
+void* Mem::Alloc(uint64_t size, uint32_t alignment, uint32_t offset, MemoryTag tag)
+{
+	return Track(mi_malloc_aligned_at(size + k_headerSize, alignment, offset + k_headerSize), size, tag);
+}
+
+void* Mem::SmallAlloc(uint64_t size, uint32_t alignment)
+{
+#if GLEX_USE_SLAB_ALLOCATOR
+	if (size <= SlabAllocator::k_maxSize && alignment <= SlabAllocator::k_alignment)
+	{
+		void* p = SlabAllocator::Allocate(size);
+		if (p != nullptr)
+		{
+			MemoryTracker::RecordAlloc(MemoryTag::SmallObjects, SlabAllocator::SizeOf(p));
+			return p;
+		}
+	}
 #endif
-	return p;
+	return Alloc(size, alignment);
 }
 
 void* Mem::Realloc(void* p, uint64_t size)
 {
-	void* np = mi_realloc(p, size);
-	if (np == nullptr)
-		OutOfMemory();
-#if GLEX_REPORT_MEMORY_LEAKS
-	TraceFree(p);
-	TraceAlloc(np);
-#endif
-	return np;
+	if (p == nullptr)
+		return Alloc(size);
+	if (SlabAllocator::Owns(p))
+	{
+		void* np = Alloc(size);
+		memcpy(np, p, Min(size, static_cast<uint64_t>(SlabAllocator::SizeOf(p))));
+		Free(p);
+		return np;
+	}
+	// The sample, if any, is dropped. The block may move.
+	MemoryTag tag = ReadHeader(p).tag;
+	return Track(mi_realloc(Untrack(p), size + k_headerSize), size, tag);
 }
 
 void Mem::Free(void* addr)
 {
-	mi_free(addr);
-#if GLEX_REPORT_MEMORY_LEAKS
-	TraceFree(addr);
-#endif
+	if (addr == nullptr)
+		return;
+	if (SlabAllocator::Owns(addr))
+	{
+		MemoryTracker::RecordFree(MemoryTag::SmallObjects, SlabAllocator::SizeOf(addr));
+		SlabAllocator::Free(addr);
+	}
+	else
+		mi_free(Untrack(addr));
 }
 
 #if GLEX_REPORT_MEMORY_LEAKS
@@ -101,52 +129,8 @@ void Mem::Report()
 			fn();
 		s_freeMemoryCallbacks.reset();
 	}
-	if (s_addrXor != 0 || s_addrSum != 0 || s_allocTimes != 0)
-		Logger::Error("There're memory leaks. %ld pointers are not freed.", s_allocTimes);
-	else if (s_newTimes != 0)
-		Logger::Error("%d New/Delete mismatches.", s_newTimes);
-	else if (!s_traceMemoryAllocation || s_traces.empty() && s_doubleFrees.empty())
+	if (!MemoryTracker::ReportLiveAllocations())
 		Logger::Debug("No memory leaks detected. ( ^)o(^ )");
-
-	// This is useless.	
-	if (s_traceMemoryAllocation)
-	{
-		if (!s_traces.empty())
-		{
-			Logger::Debug("\n    LEAKED POINTERS");
-			for (auto& [key, st] : s_traces)
-			{
-				Logger::Debug(R"(+-----------------------------+
-| Pointer: 0x%p |
-+-----------------------------+)", key);
-				Logger::Debug(std::to_string(st).c_str());
-				Logger::Debug("--------------------------------------------------------------");
-			}
-			for (auto& [key, st] : s_newTraces)
-			{
-				Logger::Debug(R"(+-----------------------------+
-| Pointer: 0x%p |
-+-----------------------------+)", key);
-				Logger::Debug(std::to_string(st).c_str());
-				Logger::Debug("--------------------------------------------------------------");
-			}
-		}
-		if (!s_doubleFrees.empty())
-		{
-			Logger::Debug("\n    DOUBLE-FREED POINTERS");
-			for (auto& [key, list] : s_doubleFrees)
-			{
-				Logger::Debug(R"(+-----------------------------+
-| Pointer: 0x%p |
-+-----------------------------+)", key);
-				for (auto& st : list)
-				{
-					Logger::Debug(std::to_string(st).c_str());
-					Logger::Debug("--------------------------------------------------------------");
-				}
-			}
-		}
-	}
 }
 
 void Mem::RegisterFreeMemory(FunctionPtr<void()> fn)
@@ -157,9 +141,12 @@ void Mem::RegisterFreeMemory(FunctionPtr<void()> fn)
 }
 #endif
 
-void* Mem::AllocPages(uint64_t size)
+#ifdef _WIN32
+
+void* Mem::AllocPages(uint64_t size, PageKind kind)
 {
-	GLEX_DEBUG_ASSERT(size != 0 && IsAligned(size, k_pageSize)) {}
+	// Large pages can't be committed lazily on Windows, so every kind gets normal pages here.
+	GLEX_DEBUG_ASSERT(size != 0 && IsAligned(size, CommitGranularity(kind))) {}
 	void* p = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE);
 	if (p == nullptr)
 		OutOfMemory();
@@ -178,16 +165,92 @@ void Mem::DecommitPages(void* addr, uint64_t size)
 {
 	GLEX_DEBUG_ASSERT(IsAligned(addr, k_pageSize)) {}
 	GLEX_DEBUG_ASSERT(size != 0 && IsAligned(size, k_pageSize)) {}
-	BOOL ret = VirtualFree(addr, size, MEM_DECOMMIT);
+	[[maybe_unused]] BOOL ret = VirtualFree(addr, size, MEM_DECOMMIT);
 	GLEX_DEBUG_ASSERT(ret);
 }
 
-void Mem::FreePages(void* addr)
+void Mem::FreePages(void* addr, uint64_t size)
 {
-	BOOL ret = VirtualFree(addr, 0, MEM_RELEASE);
+	[[maybe_unused]] BOOL ret = VirtualFree(addr, 0, MEM_RELEASE);
 	GLEX_DEBUG_ASSERT(ret);
 }
 
+#else
+
+static void* MapReserved(uint64_t size, int flags)
+{
+	void* p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+	return p == MAP_FAILED ? nullptr : p;
+}
+
+void* Mem::AllocPages(uint64_t size, PageKind kind)
+{
+	// Huge pages are left to the kernel's defaults outside Linux.
+	GLEX_DEBUG_ASSERT(size != 0 && IsAligned(size, CommitGranularity(kind))) {}
+#ifdef __linux__
+	if (kind == PageKind::Huge)
+	{
+		// Takes the whole range from the pool now, so running out fails here instead of faulting later.
+		void* p = MapReserved(size, MAP_HUGETLB | MAP_HUGE_2MB);
+		if (p != nullptr)
+			return p;
+		static bool warned = false;
+		if (!warned)
+		{
+			Logger::Warn("No huge pages available, falling back to transparent huge pages. Check /proc/sys/vm/nr_hugepages.");
+			warned = true;
+		}
+		kind = PageKind::Transparent;
+	}
+	if (kind == PageKind::Transparent)
+	{
+		// Over-reserve so the range starts on a huge page boundary, the kernel only promotes aligned 2MB blocks.
+		uint64_t reservedSize = size + k_hugePageSize;
+		uint8_t* reserved = static_cast<uint8_t*>(MapReserved(reservedSize, MAP_NORESERVE));
+		if (reserved == nullptr)
+			OutOfMemory();
+		uint8_t* p = static_cast<uint8_t*>(Align(reserved, k_hugePageSize));
+		if (p != reserved)
+			munmap(reserved, p - reserved);
+		if (p + size != reserved + reservedSize)
+			munmap(p + size, reserved + reservedSize - (p + size));
+		madvise(p, size, MADV_HUGEPAGE);
+		return p;
+	}
+#endif
+	// Nothing is charged against overcommit until pages are made writable.
+	void* p = MapReserved(size, MAP_NORESERVE);
+	if (p == nullptr)
+		OutOfMemory();
+	return p;
+}
+
+void Mem::CommitPages(void* addr, uint64_t size)
+{
+	GLEX_DEBUG_ASSERT(IsAligned(addr, k_pageSize)) {}
+	GLEX_DEBUG_ASSERT(size != 0 && IsAligned(size, k_pageSize)) {}
+	if (mprotect(addr, size, PROT_READ | PROT_WRITE) != 0)
+		OutOfMemory();
+}
+
+void Mem::DecommitPages(void* addr, uint64_t size)
+{
+	GLEX_DEBUG_ASSERT(IsAligned(addr, k_pageSize)) {}
+	GLEX_DEBUG_ASSERT(size != 0 && IsAligned(size, k_pageSize)) {}
+	// Pages come back zeroed when committed again, same as on Windows.
+	[[maybe_unused]] int ret = madvise(addr, size, MADV_DONTNEED);
+	ret |= mprotect(addr, size, PROT_NONE);
+	GLEX_DEBUG_ASSERT(ret == 0);
+}
+
+void Mem::FreePages(void* addr, uint64_t size)
+{
+	[[maybe_unused]] int ret = munmap(addr, size);
+	GLEX_DEBUG_ASSERT(ret == 0);
+}
+
+#endif
+
 void Mem::OutOfMemory()
 {
 	Logger::Fatal("Out of memory!");
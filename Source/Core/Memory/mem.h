@@ -5,30 +5,28 @@
 #pragma once
 #include "Core/commdefs.h"
 #include "config.h"
+#include "Core/Memory/slab.h"
+#include "Core/Memory/memtrack.h"
 #if GLEX_REPORT_MEMORY_LEAKS
 #include <vector>
 #include <optional>
-#include <stacktrace>
-#include <unordered_map>
 #endif
 
 namespace glex
 {
+	// Backing for reserved ranges. Huge pages cut TLB misses on large arenas.
+	enum class PageKind : uint8_t
+	{
+		Normal,
+		Transparent,	// Normal pages the kernel may promote to 2MB ones. Linux only.
+		Huge,			// Explicit 2MB pages from the system pool, falling back to Transparent. Linux only.
+	};
+
 	class Mem : private StaticClass
 	{
 #if GLEX_REPORT_MEMORY_LEAKS
 	private:
 		inline static std::optional<std::vector<FunctionPtr<void()>>> s_freeMemoryCallbacks;
-		inline static std::unordered_map<void*, std::stacktrace> s_traces, s_newTraces;
-		inline static std::unordered_map<void*, std::vector<std::stacktrace>> s_doubleFrees;
-		inline static uint64_t s_addrXor;
-		inline static uint64_t s_addrSum;
-		inline static int64_t s_allocTimes;
-		inline static int64_t s_newTimes;
-		static bool s_traceMemoryAllocation;
-
-		static void TraceAlloc(void* p);
-		static void TraceFree(void* p);
 
 	public:
 		static void Report();
@@ -38,6 +36,7 @@ namespace glex
 
 	public:
 		constexpr static uint32_t k_pageSize = 4096;
+		constexpr static uint32_t k_hugePageSize = 2 * 1024 * 1024;
 
 		inline constexpr static bool IsAligned(uint32_t size, uint32_t alignment)
 		{
@@ -104,73 +103,61 @@ namespace glex
 			return reinterpret_cast<uint64_t>(end) - reinterpret_cast<uint64_t>(start);
 		}
 
-		static void* Alloc(uint64_t size);
-		static void* Alloc(uint64_t size, uint32_t alignment);
-		static void* Alloc(uint64_t size, uint32_t alignment, uint32_t offset);
+		// Blocks are counted against the tag, see MemoryTracker.
+		static void* Alloc(uint64_t size, MemoryTag tag = MemoryTag::Default);
+		static void* Alloc(uint64_t size, uint32_t alignment, MemoryTag tag = MemoryTag::Default);
+		static void* Alloc(uint64_t size, uint32_t alignment, uint32_t offset, MemoryTag tag = MemoryTag::Default);
+		// From the slab allocator if it's small enough, Free handles either.
+		static void* SmallAlloc(uint64_t size, uint32_t alignment);
 		static void* Realloc(void* p, uint64_t size);
 		static void Free(void* addr);
-		static void* AllocPages(uint64_t size);
+		// Reserves address space. Sizes and offsets of the range must be multiples of CommitGranularity.
+		static void* AllocPages(uint64_t size, PageKind kind = PageKind::Normal);
 		static void CommitPages(void* addr, uint64_t size);
 		static void DecommitPages(void* addr, uint64_t size);
-		static void FreePages(void* addr);
+		static void FreePages(void* addr, uint64_t size);
+
+		inline constexpr static uint32_t CommitGranularity(PageKind kind)
+		{
+			return kind == PageKind::Normal ? k_pageSize : k_hugePageSize;
+		}
 		static void OutOfMemory();
 
 		template <typename T>
-		static T* Alloc()
+		static T* Alloc(MemoryTag tag = MemoryTag::Default)
 		{
-			return static_cast<T*>(Alloc(sizeof(T), alignof(T)));
+			return static_cast<T*>(Alloc(sizeof(T), alignof(T), tag));
 		}
 
 		template <typename T>
-		static T* Alloc(uint64_t count)
+		static T* Alloc(uint64_t count, MemoryTag tag = MemoryTag::Default)
 		{
-			return static_cast<T*>(Alloc(sizeof(T) * count, alignof(T)));
+			return static_cast<T*>(Alloc(sizeof(T) * count, alignof(T), tag));
 		}
 
 		template <typename T, typename... Args>
 		static T* New(Args&&... args)
 		{
-#if GLEX_REPORT_MEMORY_LEAKS
-			s_newTimes++;
-#endif
-			T* p = Alloc<T>();
+			T* p;
+			if constexpr (std::is_base_of_v<SlabAllocated, T>)
+				p = static_cast<T*>(SmallAlloc(sizeof(T), alignof(T)));
+			else
+				p = Alloc<T>();
 			new(p) T(std::forward<Args>(args)...);
-#if GLEX_REPORT_MEMORY_LEAKS
-			if (s_traceMemoryAllocation)
-				s_newTraces[p] = std::stacktrace::current();
-#endif
 			return p;
 		}
 
 		template <typename T, typename... Args>
 		static T* SizedNew(uint64_t sizeOverride, Args&&... args)
 		{
-#if GLEX_REPORT_MEMORY_LEAKS
-			s_newTimes++;
-#endif
 			T* p = static_cast<T*>(Alloc(sizeOverride, alignof(T)));
 			new(p) T(std::forward<Args>(args)...);
-#if GLEX_REPORT_MEMORY_LEAKS
-			if (s_traceMemoryAllocation)
-				s_newTraces[p] = std::stacktrace::current();
-#endif
 			return p;
 		}
 
 		template <typename T>
 		static void Delete(T* p)
 		{
-#if GLEX_REPORT_MEMORY_LEAKS
-			if (p != nullptr)
-			{
-				s_newTimes--;
-				auto iter = s_newTraces.find(p);
-				if (iter != s_newTraces.end())
-					s_newTraces.erase(iter);
-				else
-					s_doubleFrees[p].push_back(std::stacktrace::current());
-			}
-#endif
 			p->~T();
 			Mem::Free(p);
 		}
@@ -0,0 +1,353 @@
+#include "Core/Memory/memtrack.h"
+#include "Core/Memory/mem.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/lock.h"
+#include "Core/log.h"
+#include <memory>
+#include <stacktrace>
+#include <string>
+
+using namespace glex;
+
+namespace
+{
+	constexpr char const* k_tagNames[] = { "Default", "General", "SmallObjects", "Containers", "Threading", "Renderer", "GUI", "Physics", "Scripting", "Resources" };
+	static_assert(sizeof(k_tagNames) / sizeof(char const*) == MemoryTracker::k_numTags);
+
+	// Written by the owner thread only, read by anyone.
+	struct ThreadCounters
+	{
+		MemoryUsage usage[MemoryTracker::k_numTags] = {};
+		uint64_t numAllocations = 0;
+		ThreadCounters* prev = nullptr;
+		ThreadCounters* next = nullptr;
+	};
+
+	struct CounterHolder
+	{
+		ThreadCounters* counters = nullptr;
+		~CounterHolder();
+	};
+
+	// Keys are addresses. An odd key means the entry is being written or read by someone.
+	struct Sample
+	{
+		uint64_t key;
+		uint64_t size;
+		uint32_t sequence;
+		MemoryTag tag;
+		std::stacktrace trace;
+	};
+
+	constexpr uint64_t k_emptyKey = 0;
+	constexpr uint64_t k_removedKey = 2;
+
+	Mutex s_registryLock;
+	ThreadCounters* s_threads = nullptr;
+	// Exited threads and frees after a thread's counters are gone end up here, updated atomically.
+	MemoryUsage s_retired[MemoryTracker::k_numTags];
+	uint64_t s_retiredAllocations = 0;
+	uint64_t s_budgets[MemoryTracker::k_numTags];
+	bool s_overBudget[MemoryTracker::k_numTags];
+
+	uint64_t s_sampleInterval = 0;
+	uint32_t s_sampleSequence = 0;
+	Sample* s_samples = nullptr;
+}
+
+static thread_local CounterHolder t_counters;
+static thread_local bool t_countersGone = false;
+static thread_local int64_t t_bytesUntilSample = 0;
+
+CounterHolder::~CounterHolder()
+{
+	if (counters == nullptr)
+		return;
+	ScopedLock lock(s_registryLock);
+	for (uint32_t i = 0; i < MemoryTracker::k_numTags; i++)
+	{
+		Atomic::Add(&s_retired[i].bytes, counters->usage[i].bytes);
+		Atomic::Add(&s_retired[i].count, counters->usage[i].count);
+	}
+	Atomic::Add(&s_retiredAllocations, counters->numAllocations);
+	if (counters->prev != nullptr)
+		counters->prev->next = counters->next;
+	else
+		s_threads = counters->next;
+	if (counters->next != nullptr)
+		counters->next->prev = counters->prev;
+	// Not from Mem, which would count it.
+	delete counters;
+	counters = nullptr;
+	t_countersGone = true;
+}
+
+static ThreadCounters* GetThreadCounters()
+{
+	CounterHolder& holder = t_counters;
+	if (holder.counters != nullptr) GLEX_LIKELY
+		return holder.counters;
+	if (t_countersGone)
+		return nullptr;
+	ThreadCounters* counters = new ThreadCounters;
+	ScopedLock lock(s_registryLock);
+	counters->next = s_threads;
+	if (s_threads != nullptr)
+		s_threads->prev = counters;
+	s_threads = counters;
+	holder.counters = counters;
+	return counters;
+}
+
+static void Record(MemoryTag tag, int64_t bytes, int64_t count)
+{
+	uint32_t index = static_cast<uint32_t>(tag);
+	ThreadCounters* counters = GetThreadCounters();
+	if (counters != nullptr) GLEX_LIKELY
+	{
+		MemoryUsage& usage = counters->usage[index];
+		Atomic::Store(&usage.bytes, usage.bytes + bytes);
+		Atomic::Store(&usage.count, usage.count + count);
+	}
+	else
+	{
+		Atomic::Add(&s_retired[index].bytes, bytes);
+		Atomic::Add(&s_retired[index].count, count);
+	}
+}
+
+bool MemoryTracker::RecordAlloc(MemoryTag tag, uint64_t size)
+{
+	Record(tag, size, 1);
+	ThreadCounters* counters = GetThreadCounters();
+	if (counters != nullptr) GLEX_LIKELY
+		Atomic::Store(&counters->numAllocations, counters->numAllocations + 1);
+	else
+		Atomic::Add(&s_retiredAllocations, static_cast<uint64_t>(1));
+	uint64_t interval = Atomic::Load(&s_sampleInterval);
+	if (interval == 0) GLEX_LIKELY
+		return false;
+	t_bytesUntilSample -= size;
+	if (t_bytesUntilSample > 0)
+		return false;
+	t_bytesUntilSample = interval;
+	return true;
+}
+
+void MemoryTracker::RecordFree(MemoryTag tag, uint64_t size)
+{
+	Record(tag, -static_cast<int64_t>(size), -1);
+}
+
+char const* MemoryTracker::TagName(MemoryTag tag)
+{
+	return k_tagNames[static_cast<uint32_t>(tag)];
+}
+
+static void SumUsage(MemoryUsage* usage)
+{
+	ScopedLock lock(s_registryLock);
+	for (uint32_t i = 0; i < MemoryTracker::k_numTags; i++)
+	{
+		usage[i].bytes = Atomic::Load(&s_retired[i].bytes);
+		usage[i].count = Atomic::Load(&s_retired[i].count);
+	}
+	for (ThreadCounters* counters = s_threads; counters != nullptr; counters = counters->next)
+	{
+		for (uint32_t i = 0; i < MemoryTracker::k_numTags; i++)
+		{
+			usage[i].bytes += Atomic::Load(&counters->usage[i].bytes);
+			usage[i].count += Atomic::Load(&counters->usage[i].count);
+		}
+	}
+}
+
+MemoryUsage MemoryTracker::GetUsage(MemoryTag tag)
+{
+	MemoryUsage usage[k_numTags];
+	SumUsage(usage);
+	return usage[static_cast<uint32_t>(Resolve(tag))];
+}
+
+uint64_t MemoryTracker::GetAllocationCount()
+{
+	ScopedLock lock(s_registryLock);
+	uint64_t count = Atomic::Load(&s_retiredAllocations);
+	for (ThreadCounters* counters = s_threads; counters != nullptr; counters = counters->next)
+		count += Atomic::Load(&counters->numAllocations);
+	return count;
+}
+
+void MemoryTracker::SetBudget(MemoryTag tag, uint64_t bytes)
+{
+	s_budgets[static_cast<uint32_t>(Resolve(tag))] = bytes;
+}
+
+uint64_t MemoryTracker::GetBudget(MemoryTag tag)
+{
+	return s_budgets[static_cast<uint32_t>(Resolve(tag))];
+}
+
+bool MemoryTracker::CheckBudgets()
+{
+	MemoryUsage usage[k_numTags];
+	SumUsage(usage);
+	bool anyOver = false;
+	for (uint32_t i = 0; i < k_numTags; i++)
+	{
+		if (s_budgets[i] == 0)
+			continue;
+		bool over = usage[i].bytes > static_cast<int64_t>(s_budgets[i]);
+		if (over && !s_overBudget[i])
+			Logger::Warn("%s is over its memory budget: %.2f MB of %.2f MB.", k_tagNames[i], usage[i].bytes / 1048576.0, s_budgets[i] / 1048576.0);
+		s_overBudget[i] = over;
+		anyOver |= over;
+	}
+	return anyOver;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————————————
+		Sampling.
+ ————————————————————————————————————————————————————————————————————————————————————————————————————————————*/
+
+static uint32_t SampleIndex(uint64_t key)
+{
+	return static_cast<uint32_t>((key >> 4) * 0x9e3779b97f4a7c15ULL >> 32) & (MemoryTracker::k_maxSamples - 1);
+}
+
+void MemoryTracker::SetSampleInterval(uint64_t bytes)
+{
+	if (bytes != 0 && s_samples == nullptr)
+	{
+		// Pages aren't counted, so the table doesn't show up in its own numbers.
+		uint64_t size = Mem::Align(static_cast<uint64_t>(sizeof(Sample)) * k_maxSamples, Mem::k_pageSize);
+		Sample* samples = static_cast<Sample*>(Mem::AllocPages(size));
+		Mem::CommitPages(samples, size);
+		std::uninitialized_value_construct_n(samples, k_maxSamples);
+		if (Atomic::CompareAndExchange(&s_samples, static_cast<Sample*>(nullptr), samples) != nullptr)
+		{
+			std::destroy_n(samples, k_maxSamples);
+			Mem::FreePages(samples, size);
+		}
+	}
+	Atomic::Store(&s_sampleInterval, bytes);
+}
+
+void MemoryTracker::AddSample(void* p, MemoryTag tag, uint64_t size)
+{
+	Sample* samples = Atomic::Load(&s_samples);
+	uint64_t key = reinterpret_cast<uint64_t>(p);
+	uint32_t index = SampleIndex(key);
+	for (uint32_t i = 0; i < k_maxSamples; i++, index = (index + 1) & (k_maxSamples - 1))
+	{
+		Sample& sample = samples[index];
+		uint64_t oldKey = Atomic::Load(&sample.key);
+		if (oldKey != k_emptyKey && oldKey != k_removedKey)
+			continue;
+		if (Atomic::CompareAndExchange(&sample.key, oldKey, key | 1) != oldKey)
+			continue;
+		sample.size = size;
+		sample.tag = tag;
+		sample.sequence = Atomic::Increment(&s_sampleSequence);
+		// Every slot always holds a trace, assigning frees the frames of the one that was there.
+		sample.trace = std::stacktrace::current(2);
+		Atomic::Store(&sample.key, key);
+		return;
+	}
+	// Full, the sample is lost. The caller knows it was sampled, RemoveSample just won't find it.
+}
+
+void MemoryTracker::RemoveSample(void* p)
+{
+	Sample* samples = Atomic::Load(&s_samples);
+	uint64_t key = reinterpret_cast<uint64_t>(p);
+	uint32_t index = SampleIndex(key);
+	for (uint32_t i = 0; i < k_maxSamples; i++, index = (index + 1) & (k_maxSamples - 1))
+	{
+		Sample& sample = samples[index];
+		for (;;)
+		{
+			uint64_t oldKey = Atomic::Load(&sample.key);
+			if (oldKey == k_emptyKey)
+				return;
+			if (oldKey == (key | 1))
+			{
+				// Somebody is reading it.
+				Atomic::Pause();
+				continue;
+			}
+			if (oldKey != key)
+				break;
+			if (Atomic::CompareAndExchange(&sample.key, key, key | 1) != key)
+				continue;
+			sample.trace = std::stacktrace();
+			Atomic::Store(&sample.key, k_removedKey);
+			return;
+		}
+	}
+}
+
+// Calls fn on live samples with a sequence number in [begin, end), holding each one while it runs.
+template <typename Fn>
+static uint32_t ForEachLiveSample(uint32_t begin, uint32_t end, Fn&& fn)
+{
+	Sample* samples = Atomic::Load(&s_samples);
+	if (samples == nullptr)
+		return 0;
+	uint32_t numSamples = 0;
+	for (uint32_t i = 0; i < MemoryTracker::k_maxSamples; i++)
+	{
+		Sample& sample = samples[i];
+		uint64_t key = Atomic::Load(&sample.key);
+		if (key == k_emptyKey || key == k_removedKey || (key & 1) != 0)
+			continue;
+		if (Atomic::CompareAndExchange(&sample.key, key, key | 1) != key)
+			continue;
+		if (sample.sequence - begin < end - begin)
+		{
+			fn(reinterpret_cast<void*>(key), sample);
+			numSamples++;
+		}
+		Atomic::Store(&sample.key, key);
+	}
+	return numSamples;
+}
+
+static void LogSample(void* p, Sample const& sample)
+{
+	Logger::Info("0x%p, %llu bytes, %s:\n%s", p, static_cast<unsigned long long>(sample.size), k_tagNames[static_cast<uint32_t>(sample.tag)], std::to_string(sample.trace).c_str());
+}
+
+void MemoryTracker::TakeSnapshot(MemorySnapshot& snapshot)
+{
+	snapshot.sampleSequence = Atomic::Load(&s_sampleSequence);
+	SumUsage(snapshot.usage);
+}
+
+void MemoryTracker::ReportDiff(MemorySnapshot const& before, MemorySnapshot const& after)
+{
+	for (uint32_t i = 0; i < k_numTags; i++)
+	{
+		int64_t bytes = after.usage[i].bytes - before.usage[i].bytes;
+		int64_t count = after.usage[i].count - before.usage[i].count;
+		if (bytes != 0 || count != 0)
+			Logger::Info("%s: %+lld bytes in %+lld allocations.", k_tagNames[i], static_cast<long long>(bytes), static_cast<long long>(count));
+	}
+	ForEachLiveSample(before.sampleSequence + 1, after.sampleSequence + 1, LogSample);
+}
+
+bool MemoryTracker::ReportLiveAllocations()
+{
+	MemoryUsage usage[k_numTags];
+	SumUsage(usage);
+	bool anyLive = false;
+	for (uint32_t i = 0; i < k_numTags; i++)
+	{
+		if (usage[i].count == 0)
+			continue;
+		Logger::Error("%s: %lld allocations, %lld bytes are not freed.", k_tagNames[i], static_cast<long long>(usage[i].count), static_cast<long long>(usage[i].bytes));
+		anyLive = true;
+	}
+	ForEachLiveSample(0, UINT32_MAX, LogSample);
+	return anyLive;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+/**
+ * Tagged memory accounting.
+ * Every allocation through Mem is counted against a tag in counters owned by the allocating thread,
+ * so it costs a couple of stores and stays on in every build. Totals are summed when asked for.
+ * Optionally one allocation every N bytes gets its stack captured, to tell where leaked bytes came from.
+ */
+#pragma once
+#include "Core/commdefs.h"
+
+namespace glex
+{
+	enum class MemoryTag : uint8_t
+	{
+		Default,		// Innermost ScopedMemoryTag of the calling thread, General if there's none.
+		General,
+		SmallObjects,	// Everything from the slab allocator, it has no room to remember tags.
+		Containers,
+		Threading,
+		Renderer,
+		GUI,
+		Physics,
+		Scripting,
+		Resources,
+		Count
+	};
+
+	struct MemoryUsage
+	{
+		int64_t bytes;
+		int64_t count;
+	};
+
+	struct MemorySnapshot
+	{
+		MemoryUsage usage[static_cast<uint32_t>(MemoryTag::Count)];
+		uint32_t sampleSequence;
+	};
+
+	class MemoryTracker : private StaticClass
+	{
+	private:
+		friend class ScopedMemoryTag;
+
+		inline static thread_local MemoryTag t_currentTag = MemoryTag::General;
+
+	public:
+		constexpr static uint32_t k_numTags = static_cast<uint32_t>(MemoryTag::Count);
+		// Samples beyond this are dropped.
+		constexpr static uint32_t k_maxSamples = 16384;
+
+		static MemoryTag Resolve(MemoryTag tag) { return tag == MemoryTag::Default ? t_currentTag : tag; }
+		static char const* TagName(MemoryTag tag);
+		static MemoryUsage GetUsage(MemoryTag tag);
+		// Allocations made so far by every thread with any tag, freed or not. Benchmarks divide it by the work done.
+		static uint64_t GetAllocationCount();
+
+		// Zero means no budget.
+		static void SetBudget(MemoryTag tag, uint64_t bytes);
+		static uint64_t GetBudget(MemoryTag tag);
+		// Warns about tags that went over budget since the last check. True if any tag is over.
+		static bool CheckBudgets();
+
+		// Captures the stack of one allocation every that many bytes per thread. Zero turns it off.
+		static void SetSampleInterval(uint64_t bytes);
+		static void TakeSnapshot(MemorySnapshot& snapshot);
+		// Logs what changed per tag, then the sampled allocations made in between that are still alive.
+		static void ReportDiff(MemorySnapshot const& before, MemorySnapshot const& after);
+		// Logs every tag that has live allocations and all live samples. Used for the leak report at exit.
+		static bool ReportLiveAllocations();
+
+#if GLEX_INTERNAL
+		// Hooks for Mem. True if the allocation should be sampled.
+		static bool RecordAlloc(MemoryTag tag, uint64_t size);
+		static void RecordFree(MemoryTag tag, uint64_t size);
+		static void AddSample(void* p, MemoryTag tag, uint64_t size);
+		static void RemoveSample(void* p);
+#endif
+	};
+
+	// Allocations with the default tag made by this thread in the scope are counted against the given one.
+	class ScopedMemoryTag : private Unmoveable
+	{
+	private:
+		MemoryTag m_previous;
+
+	public:
+		ScopedMemoryTag(MemoryTag tag) : m_previous(MemoryTracker::t_currentTag) { MemoryTracker::t_currentTag = MemoryTracker::Resolve(tag); }
+		~ScopedMemoryTag() { MemoryTracker::t_currentTag = m_previous; }
+	};
+}
\ No newline at end of file
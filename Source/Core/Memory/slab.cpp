@@ -0,0 +1,387 @@
+#include "Core/Memory/slab.h"
+#include "Core/Memory/mem.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/lock.h"
+
+using namespace glex;
+
+namespace
+{
+	constexpr uint32_t k_sizeClasses[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+	constexpr uint32_t k_numSizeClasses = sizeof(k_sizeClasses) / sizeof(uint32_t);
+	constexpr uint32_t k_magazineSize = 32;
+	constexpr uint32_t k_headerSize = 128;
+
+	struct ThreadCache;
+
+	struct FreeObject
+	{
+		FreeObject* next;
+	};
+
+	struct alignas(64) Slab
+	{
+		// Owner only.
+		FreeObject* localFree;
+		uint8_t* bump;				// Objects from here on have never been handed out.
+		Slab* prev;
+		Slab* next;
+		uint32_t sizeClass;
+		uint32_t numUsed;			// Objects out of the slab, magazines included.
+		bool isFull;
+		ThreadCache* owner;			// Null while orphaned.
+		// Pushed by other threads.
+		alignas(64) FreeObject* remoteFree;
+
+		uint8_t* End() { return reinterpret_cast<uint8_t*>(this) + SlabAllocator::k_slabSize; }
+		bool HasSpace() const { return localFree != nullptr || bump + k_sizeClasses[sizeClass] <= const_cast<Slab*>(this)->End(); }
+
+		void* Take()
+		{
+			if (localFree != nullptr)
+			{
+				FreeObject* object = localFree;
+				localFree = object->next;
+				numUsed++;
+				return object;
+			}
+			if (bump + k_sizeClasses[sizeClass] <= End())
+			{
+				void* object = bump;
+				bump += k_sizeClasses[sizeClass];
+				numUsed++;
+				return object;
+			}
+			return nullptr;
+		}
+
+		void Put(void* p)
+		{
+			FreeObject* object = static_cast<FreeObject*>(p);
+			object->next = localFree;
+			localFree = object;
+			numUsed--;
+		}
+
+		void DrainRemote()
+		{
+			if (Atomic::Load(&remoteFree) == nullptr)
+				return;
+			FreeObject* object = Atomic::Exchange(&remoteFree, nullptr);
+			while (object != nullptr)
+			{
+				FreeObject* next = object->next;
+				Put(object);
+				object = next;
+			}
+		}
+	};
+
+	static_assert(sizeof(Slab) <= k_headerSize);
+
+	struct SlabList
+	{
+		Slab* head = nullptr;
+
+		void PushFront(Slab* slab)
+		{
+			slab->prev = nullptr;
+			slab->next = head;
+			if (head != nullptr)
+				head->prev = slab;
+			head = slab;
+		}
+
+		void Remove(Slab* slab)
+		{
+			if (slab->prev != nullptr)
+				slab->prev->next = slab->next;
+			else
+				head = slab->next;
+			if (slab->next != nullptr)
+				slab->next->prev = slab->prev;
+		}
+	};
+
+	struct ThreadCache
+	{
+		struct Magazine
+		{
+			uint32_t count = 0;
+			void* objects[k_magazineSize];
+		};
+
+		Magazine magazines[k_numSizeClasses];
+		SlabList partialSlabs[k_numSizeClasses];	// Allocating from the first one.
+		SlabList fullSlabs[k_numSizeClasses];
+		bool isDead = false;
+
+		~ThreadCache();
+		void* Refill(uint32_t sizeClass);
+		void Flush(uint32_t sizeClass, uint32_t count);
+		void ReturnObject(void* p);
+		void ReleaseIfEmpty(Slab* slab);
+		void Trim();
+	};
+}
+
+namespace glex
+{
+	// Carves, recycles and adopts slabs. Locked, but only once per slab rather than per object.
+	class SlabPool : private StaticClass
+	{
+	private:
+		inline static Mutex s_lock;
+		inline static uint8_t* s_cursor = nullptr;
+		inline static Slab* s_freeSlabs = nullptr;		// Decommitted except the header page.
+		inline static SlabList s_orphans[k_numSizeClasses];
+
+	public:
+		static Slab* Acquire(ThreadCache* owner, uint32_t sizeClass);
+		static void Release(Slab* slab);
+		static void Orphan(Slab* slab);
+	};
+}
+
+static thread_local ThreadCache t_cache;
+
+static uint32_t SizeClassOf(uint32_t size)
+{
+	uint32_t sizeClass = 0;
+	while (k_sizeClasses[sizeClass] < size)
+		sizeClass++;
+	return sizeClass;
+}
+
+static Slab* SlabOf(void const* p)
+{
+	return reinterpret_cast<Slab*>(reinterpret_cast<uint64_t>(p) & ~static_cast<uint64_t>(SlabAllocator::k_slabSize - 1));
+}
+
+Slab* SlabPool::Acquire(ThreadCache* owner, uint32_t sizeClass)
+{
+	ScopedLock lock(s_lock);
+	// Orphans first, their objects may have been freed by now.
+	Slab* slab = s_orphans[sizeClass].head;
+	if (slab != nullptr)
+	{
+		s_orphans[sizeClass].Remove(slab);
+		Atomic::Store(&slab->owner, owner);
+		slab->isFull = false;
+		slab->DrainRemote();
+		return slab;
+	}
+	slab = s_freeSlabs;
+	if (slab != nullptr)
+	{
+		s_freeSlabs = slab->next;
+		Mem::CommitPages(Mem::Offset(slab, Mem::k_pageSize), SlabAllocator::k_slabSize - Mem::k_pageSize);
+	}
+	else
+	{
+		if (SlabAllocator::s_begin == nullptr)
+		{
+			void* reserved = Mem::AllocPages(SlabAllocator::k_reservedSize + SlabAllocator::k_slabSize);
+			s_cursor = static_cast<uint8_t*>(Mem::Align(reserved, SlabAllocator::k_slabSize));
+			SlabAllocator::s_end = s_cursor + SlabAllocator::k_reservedSize;
+			SlabAllocator::s_begin = s_cursor;
+		}
+		if (s_cursor == SlabAllocator::s_end)
+			return nullptr;
+		slab = reinterpret_cast<Slab*>(s_cursor);
+		s_cursor += SlabAllocator::k_slabSize;
+		Mem::CommitPages(slab, SlabAllocator::k_slabSize);
+	}
+	slab->localFree = nullptr;
+	slab->bump = reinterpret_cast<uint8_t*>(slab) + k_headerSize;
+	slab->sizeClass = sizeClass;
+	slab->numUsed = 0;
+	slab->isFull = false;
+	slab->owner = owner;
+	slab->remoteFree = nullptr;
+	return slab;
+}
+
+void SlabPool::Release(Slab* slab)
+{
+	// The header page stays so the slab can be linked without committing the rest.
+	Mem::DecommitPages(Mem::Offset(slab, Mem::k_pageSize), SlabAllocator::k_slabSize - Mem::k_pageSize);
+	ScopedLock lock(s_lock);
+	slab->next = s_freeSlabs;
+	s_freeSlabs = slab;
+}
+
+void SlabPool::Orphan(Slab* slab)
+{
+	ScopedLock lock(s_lock);
+	Atomic::Store(&slab->owner, static_cast<ThreadCache*>(nullptr));
+	s_orphans[slab->sizeClass].PushFront(slab);
+}
+
+ThreadCache::~ThreadCache()
+{
+	for (uint32_t i = 0; i < k_numSizeClasses; i++)
+	{
+		Flush(i, magazines[i].count);
+		for (SlabList* list : { &partialSlabs[i], &fullSlabs[i] })
+		{
+			while (Slab* slab = list->head)
+			{
+				list->Remove(slab);
+				slab->DrainRemote();
+				if (slab->numUsed == 0)
+					SlabPool::Release(slab);
+				else
+					SlabPool::Orphan(slab);
+			}
+		}
+	}
+	// Thread locals destroyed after us may still free. Those go to the remote lists and we won't allocate again.
+	isDead = true;
+}
+
+void* ThreadCache::Refill(uint32_t sizeClass)
+{
+	SlabList& partial = partialSlabs[sizeClass];
+	for (;;)
+	{
+		Slab* slab = partial.head;
+		if (slab == nullptr)
+		{
+			// Full slabs may have got remote frees, look there before taking a new one.
+			for (Slab* full = fullSlabs[sizeClass].head; full != nullptr; full = full->next)
+			{
+				full->DrainRemote();
+				if (full->HasSpace())
+				{
+					slab = full;
+					break;
+				}
+			}
+			if (slab != nullptr)
+				fullSlabs[sizeClass].Remove(slab);
+			else if ((slab = SlabPool::Acquire(this, sizeClass)) == nullptr)
+				return nullptr;
+			slab->isFull = false;
+			partial.PushFront(slab);
+		}
+		slab->DrainRemote();
+		// Keep one for the caller, fill half of the magazine with the rest.
+		void* object = slab->Take();
+		if (object != nullptr)
+		{
+			Magazine& magazine = magazines[sizeClass];
+			while (magazine.count < k_magazineSize / 2)
+			{
+				void* extra = slab->Take();
+				if (extra == nullptr)
+					break;
+				magazine.objects[magazine.count++] = extra;
+			}
+			return object;
+		}
+		partial.Remove(slab);
+		slab->isFull = true;
+		fullSlabs[sizeClass].PushFront(slab);
+	}
+}
+
+void ThreadCache::Flush(uint32_t sizeClass, uint32_t count)
+{
+	// Oldest first, the newest ones are still hot.
+	Magazine& magazine = magazines[sizeClass];
+	for (uint32_t i = 0; i < count; i++)
+		ReturnObject(magazine.objects[i]);
+	for (uint32_t i = count; i < magazine.count; i++)
+		magazine.objects[i - count] = magazine.objects[i];
+	magazine.count -= count;
+}
+
+void ThreadCache::ReturnObject(void* p)
+{
+	Slab* slab = SlabOf(p);
+	slab->Put(p);
+	if (slab->isFull)
+	{
+		fullSlabs[slab->sizeClass].Remove(slab);
+		slab->isFull = false;
+		partialSlabs[slab->sizeClass].PushFront(slab);
+	}
+	ReleaseIfEmpty(slab);
+}
+
+void ThreadCache::ReleaseIfEmpty(Slab* slab)
+{
+	// The slab being allocated from is kept around, so alloc/free pairs don't keep committing pages.
+	SlabList& partial = partialSlabs[slab->sizeClass];
+	if (slab->numUsed != 0 || slab == partial.head)
+		return;
+	partial.Remove(slab);
+	SlabPool::Release(slab);
+}
+
+void ThreadCache::Trim()
+{
+	for (uint32_t i = 0; i < k_numSizeClasses; i++)
+	{
+		Flush(i, magazines[i].count);
+		SlabList& partial = partialSlabs[i];
+		Slab* slab = partial.head;
+		while (slab != nullptr)
+		{
+			Slab* next = slab->next;
+			slab->DrainRemote();
+			if (slab->numUsed == 0)
+			{
+				partial.Remove(slab);
+				SlabPool::Release(slab);
+			}
+			slab = next;
+		}
+	}
+}
+
+void* SlabAllocator::Allocate(uint32_t size)
+{
+	ThreadCache& cache = t_cache;
+	if (cache.isDead) GLEX_UNLIKELY
+		return nullptr;
+	uint32_t sizeClass = SizeClassOf(size);
+	ThreadCache::Magazine& magazine = cache.magazines[sizeClass];
+	if (magazine.count != 0)
+		return magazine.objects[--magazine.count];
+	return cache.Refill(sizeClass);
+}
+
+void SlabAllocator::Free(void* p)
+{
+	Slab* slab = SlabOf(p);
+	ThreadCache& cache = t_cache;
+	if (Atomic::Load(&slab->owner) != &cache)
+	{
+		FreeObject* object = static_cast<FreeObject*>(p);
+		FreeObject* head = Atomic::Load(&slab->remoteFree);
+		for (;;)
+		{
+			object->next = head;
+			FreeObject* oldHead = Atomic::CompareAndExchange(&slab->remoteFree, head, object);
+			if (oldHead == head)
+				return;
+			head = oldHead;
+		}
+	}
+	ThreadCache::Magazine& magazine = cache.magazines[slab->sizeClass];
+	if (magazine.count == k_magazineSize)
+		cache.Flush(slab->sizeClass, k_magazineSize / 2);
+	magazine.objects[magazine.count++] = p;
+}
+
+uint32_t SlabAllocator::SizeOf(void const* p)
+{
+	return k_sizeClasses[SlabOf(p)->sizeClass];
+}
+
+void SlabAllocator::Trim()
+{
+	t_cache.Trim();
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+/**
+ * Size-class slab allocator for small objects.
+ * Slabs are carved from one reserved address range, so Mem::Free can tell slab objects apart by address.
+ * Every thread owns the slabs it allocates from and keeps a magazine of free objects per size class.
+ * Frees from other threads go to the slab's remote list for the owner to pick up. Empty slabs give their pages back.
+ */
+#pragma once
+#include "Core/commdefs.h"
+
+namespace glex
+{
+	class SlabAllocator : private StaticClass
+	{
+	public:
+		constexpr static uint32_t k_maxSize = 256;
+		constexpr static uint32_t k_alignment = 16;
+		constexpr static uint32_t k_slabSize = 64 * 1024;
+		constexpr static uint64_t k_reservedSize = 4ULL << 30;
+
+	private:
+		friend class SlabPool;
+
+		inline static uint8_t* s_begin = nullptr;
+		inline static uint8_t* s_end = nullptr;
+
+	public:
+		static bool Owns(void const* p) { return p >= s_begin && p < s_end; }
+		// Null if the reserved range has run out.
+		static void* Allocate(uint32_t size);
+		static void Free(void* p);
+		// Size class the object was allocated from.
+		static uint32_t SizeOf(void const* p);
+		// Hands the calling thread's cached objects and empty slabs back.
+		static void Trim();
+	};
+
+	// Derive from this to have Mem::New allocate the type from the slab allocator.
+	struct SlabAllocated {};
+}
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Core/Memory/mem.h"
 #include "Core/Thread/atomic.h"
 #include "Core/commdefs.h"
+#include "Core/Utils/hash.h"
 #include <EASTL/functional.h>
 
 namespace glex
@@ -168,7 +169,7 @@ namespace glex
 	SharedPtr<T> MakeShared(Args&&... args)
 	{
 		constexpr uint32_t align = CONTROL_BLOCK_SIZE_AND_ALIGNMENT<T>;
-		uint32_t* controlBlock = static_cast<uint32_t*>(Mem::Alloc(sizeof(T) + align, align));
+		uint32_t* controlBlock = static_cast<uint32_t*>(Mem::SmallAlloc(sizeof(T) + align, align));
 		*controlBlock = 1;
 		T* pointer = Mem::Offset<T>(controlBlock, align);
 		new (pointer) T(std::forward<Args>(args)...);
@@ -275,6 +276,26 @@ namespace glex
 			}
 			return SharedPtr<T>();
 		}
+
+		// Null instead if the last reference is already gone, e.g. while the object is being destroyed.
+		// The control block must still be there, whoever destroys the object has to wait for the caller.
+		SharedPtr<T> TryPin()
+		{
+			if (m_pointer != nullptr)
+			{
+				constexpr uint32_t controlBlockSize = CONTROL_BLOCK_SIZE_AND_ALIGNMENT<T>;
+				uint32_t* controlBlock = Mem::DownOffset<uint32_t>(m_pointer, controlBlockSize);
+				uint32_t count = Atomic::Load(controlBlock);
+				while (count != 0)
+				{
+					uint32_t previous = Atomic::CompareAndExchange(controlBlock, count, count + 1);
+					if (previous == count)
+						return SharedPtr<T>(controlBlock, m_pointer);
+					count = previous;
+				}
+			}
+			return SharedPtr<T>();
+		}
 	};
 
 	template <typename T, typename R>
@@ -292,7 +313,7 @@ namespace eastl
 	public:
 		size_t operator()(glex::WeakPtr<T> ptr) const
 		{
-			return eastl::hash<T*>()(ptr.Get());
+			return glex::HashInt(reinterpret_cast<uint64_t>(ptr.Get()));
 		}
 	};
 
@@ -302,7 +323,7 @@ namespace eastl
 	public:
 		size_t operator()(glex::WeakPtr<T> ptr) const
 		{
-			return eastl::hash<T*>()(ptr.Get());
+			return glex::HashInt(reinterpret_cast<uint64_t>(ptr.Get()));
 		}
 	};
 }
\ No newline at end of file
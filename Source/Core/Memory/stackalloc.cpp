@@ -3,9 +3,10 @@
 
 using namespace glex;
 
-StackAllocator::StackAllocator(uint32_t size)
+StackAllocator::StackAllocator(uint32_t size, PageKind kind) : m_commitGranularity(Mem::CommitGranularity(kind))
 {
-	m_initPagesPtr = Mem::AllocPages(Mem::Align(size, Mem::k_pageSize));
+	size = Mem::Align(size, m_commitGranularity);
+	m_initPagesPtr = Mem::AllocPages(size, kind);
 	m_endPagesPtr = Mem::Offset(m_initPagesPtr, size);
 	m_endCommitedPtr = m_initPagesPtr;
 	m_stackPtr = m_initPagesPtr;
@@ -13,7 +14,7 @@ StackAllocator::StackAllocator(uint32_t size)
 
 StackAllocator::~StackAllocator()
 {
-	Mem::FreePages(m_initPagesPtr);
+	Mem::FreePages(m_initPagesPtr, Mem::Diff(m_initPagesPtr, m_endPagesPtr));
 }
 
 std::pair<void*, StackAllocator::Bookmark> StackAllocator::Allocate(uint32_t size, uint32_t alignemnt)
@@ -25,7 +26,7 @@ std::pair<void*, StackAllocator::Bookmark> StackAllocator::Allocate(uint32_t siz
 		Mem::OutOfMemory();
 	if (m_endCommitedPtr < end)
 	{
-		uint32_t commitSize = Mem::Align(Mem::Diff(m_endCommitedPtr, end), Mem::k_pageSize);
+		uint32_t commitSize = Mem::Align(Mem::Diff(m_endCommitedPtr, end), m_commitGranularity);
 		Mem::CommitPages(m_endCommitedPtr, commitSize);
 		m_endCommitedPtr = Mem::Offset(m_endCommitedPtr, commitSize);
 	}
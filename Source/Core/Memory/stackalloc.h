@@ -1,5 +1,5 @@
 #pragma once
-#include "Core/commdefs.h"
+#include "Core/Memory/mem.h"
 #include <utility>
 
 namespace glex
@@ -11,6 +11,7 @@ namespace glex
 		void* m_endPagesPtr;
 		void* m_endCommitedPtr;
 		void* m_stackPtr;
+		uint32_t m_commitGranularity;
 
 	public:
 		class Bookmark
@@ -24,7 +25,7 @@ namespace glex
 			~Bookmark() { m_owner.m_stackPtr = m_previous; }
 		};
 
-		StackAllocator(uint32_t size);
+		StackAllocator(uint32_t size, PageKind kind = PageKind::Normal);
 		~StackAllocator();
 		std::pair<void*, Bookmark> Allocate(uint32_t size, uint32_t alignment);
 	};
@@ -3,7 +3,13 @@
 #include "Core/Thread/event.h"
 #include "Core/log.h"
 #include "config.h"
+#ifdef _WIN32
 #include <Windows.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace glex;
 
@@ -19,6 +25,8 @@ std::pair<TemporaryBuffer<void>, uint64_t> FileSync::ReadAllContent(char const*
 	return { nullptr, 0 };
 }
 
+#ifdef _WIN32
+
 FileSync::FileSync(char const* path, FileAccess access, FileOpen openMode, FileFlags flags)
 {
 	DWORD desiredAccess, shareMode;
@@ -45,27 +53,109 @@ FileSync::~FileSync()
 	CloseHandle(reinterpret_cast<HANDLE>(m_handle));
 }
 
-FileSync::FileSync(FileSync&& rhs) : m_handle(rhs.m_handle), m_fileSize(rhs.m_fileSize)
+bool FileSync::Seek(int64_t move, FilePosition from)
 {
-	rhs.m_handle = -1;
+	return SetFilePointerEx(reinterpret_cast<HANDLE>(m_handle), static_cast<LARGE_INTEGER>(move), nullptr, static_cast<uint32_t>(from));
 }
 
-FileSync& FileSync::operator=(FileSync&& rhs)
+uint32_t FileSync::Read(void* buffer, uint32_t read)
 {
-	std::swap(m_handle, rhs.m_handle);
-	m_fileSize = rhs.m_fileSize;
+	DWORD actualRead;
+	ReadFile(reinterpret_cast<HANDLE>(m_handle), buffer, read, &actualRead, nullptr);
+	return actualRead;
+}
+
+uint32_t FileSync::Write(void const* data, uint32_t size)
+{
+	DWORD written;
+	WriteFile(reinterpret_cast<HANDLE>(m_handle), data, size, &written, nullptr);
+	return written;
+}
+
+#elif defined(__linux__)
+
+// Flags are Win32 hints with no counterpart here.
+FileSync::FileSync(char const* path, FileAccess access, FileOpen openMode, FileFlags flags) : m_fileSize(0)
+{
+	int32_t oflag;
+	switch (access)
+	{
+		case FileAccess::Write: oflag = O_WRONLY; break;
+		case FileAccess::ReadWrite: oflag = O_RDWR; break;
+		default: oflag = O_RDONLY; break;
+	}
+	switch (openMode)
+	{
+		case FileOpen::CreateNew: oflag |= O_CREAT | O_EXCL; break;
+		case FileOpen::CreateOrOverwrite: oflag |= O_CREAT | O_TRUNC; break;
+		case FileOpen::OpenOrCreate: oflag |= O_CREAT; break;
+		case FileOpen::OverwriteExisting: oflag |= O_TRUNC; break;
+		default: break;
+	}
+	int32_t fd = open(path, oflag | O_CLOEXEC, 0644);
+	m_handle = static_cast<uint64_t>(static_cast<int64_t>(fd));
+	if (fd == -1)
+		return;
+	struct stat status;
+	if (fstat(fd, &status) != 0)
+	{
+		close(fd);
+		m_handle = -1;
+		return;
+	}
+	m_fileSize = status.st_size;
+}
+
+FileSync::~FileSync()
+{
+	if (m_handle != -1)
+		close(static_cast<int32_t>(m_handle));
 }
 
 bool FileSync::Seek(int64_t move, FilePosition from)
 {
-	return SetFilePointerEx(reinterpret_cast<HANDLE>(m_handle), static_cast<LARGE_INTEGER>(move), nullptr, static_cast<uint32_t>(from));
+	int32_t whence = from == FilePosition::Begin ? SEEK_SET : from == FilePosition::Current ? SEEK_CUR : SEEK_END;
+	return lseek(static_cast<int32_t>(m_handle), move, whence) != -1;
 }
 
 uint32_t FileSync::Read(void* buffer, uint32_t read)
 {
-	DWORD actualRead;
-	ReadFile(reinterpret_cast<HANDLE>(m_handle), buffer, read, &actualRead, nullptr);
-	return actualRead;
+	uint32_t total = 0;
+	while (total < read)
+	{
+		ssize_t actualRead = ::read(static_cast<int32_t>(m_handle), static_cast<uint8_t*>(buffer) + total, read - total);
+		if (actualRead <= 0)
+			break;
+		total += actualRead;
+	}
+	return total;
+}
+
+uint32_t FileSync::Write(void const* data, uint32_t size)
+{
+	uint32_t total = 0;
+	while (total < size)
+	{
+		ssize_t written = ::write(static_cast<int32_t>(m_handle), static_cast<uint8_t const*>(data) + total, size - total);
+		if (written <= 0)
+			break;
+		total += written;
+	}
+	return total;
+}
+
+#endif
+
+FileSync::FileSync(FileSync&& rhs) : m_handle(rhs.m_handle), m_fileSize(rhs.m_fileSize)
+{
+	rhs.m_handle = -1;
+}
+
+FileSync& FileSync::operator=(FileSync&& rhs)
+{
+	std::swap(m_handle, rhs.m_handle);
+	m_fileSize = rhs.m_fileSize;
+	return *this;
 }
 
 uint32_t FileSync::ReadString(char* buffer, uint32_t maxLength)
@@ -122,13 +212,6 @@ uint32_t FileSync::ReadStringOverlapped(uint32_t& offset, char* buffer, uint32_t
 	return length;
 } */
 
-uint32_t FileSync::Write(void const* data, uint32_t size)
-{
-	DWORD written;
-	WriteFile(reinterpret_cast<HANDLE>(m_handle), data, size, &written, nullptr);
-	return written;
-}
-
 bool FileSync::WriteString(StringView string)
 {
 	return Write(string.length()) && Write(string.data(), string.length()) == string.length();
@@ -1,14 +1,22 @@
 #include "Core/Platform/platform.h"
 #include "Core/Utils/string.h"
-#include "Core/Platform/window.h"
 #include "Core/log.h"
 #include "Core/Utils/raii.h"
 #include "Core/Utils/temp_buffer.h"
 #include "Core/Thread/thread.h"
+#ifdef _WIN32
+#include "Core/Platform/window.h"
 #include <Core/Platform/shell.hpp>
 #include <commdlg.h>
 #include <shellapi.h>
+#elif defined(__linux__)
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
 using namespace glex;
+
+#ifdef _WIN32
 #undef Yield
 
 bool Platform::IsDebuggerPresent()
@@ -461,10 +469,72 @@ ASCII_COMPATIBLE:
 
 uint32_t Platform::GetProcessorCount()
 {
-	return GetCurrentProcessorNumber();
+	return GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
 }
 
 float Platform::GetDoubleClickTime()
 {
 	return ::GetDoubleClickTime();
-}
\ No newline at end of file
+}
+
+#elif defined(__linux__)
+
+// Only what runs headless, the benchmarks and tools built from Core. Dialogs, the shell and the file helpers are Win32 only.
+bool Platform::IsDebuggerPresent()
+{
+	FILE* file = fopen("/proc/self/status", "r");
+	if (file == nullptr)
+		return false;
+	char line[256];
+	int32_t tracer = 0;
+	while (fgets(line, sizeof(line), file) != nullptr)
+	{
+		if (sscanf(line, "TracerPid: %d", &tracer) == 1)
+			break;
+	}
+	fclose(file);
+	return tracer != 0;
+}
+
+void Platform::Terminate()
+{
+	_exit(EXIT_FAILURE);
+}
+
+static char const* s_mbPrefixes[] = { "", "Info: ", "Warning: ", "Error: ", "" };
+void Platform::MessageBox(MessageBoxIcon icon, char const* title, char const* message)
+{
+	fprintf(stderr, "%s%s: %s\n", s_mbPrefixes[*icon], title, message);
+}
+
+// Nobody is there to answer.
+bool Platform::ConfirmMessageBox(MessageBoxIcon icon, char const* title, char const* message)
+{
+	MessageBox(icon, title, message);
+	return false;
+}
+
+Nullable<String> Platform::GetWorkingDirectory()
+{
+	char buffer[Limits::PATH_LENGTH + 1];
+	if (getcwd(buffer, sizeof(buffer)) == nullptr)
+		return nullptr;
+	return String(buffer);
+}
+
+bool Platform::SetWorkingDirectory(char const* dir)
+{
+	return chdir(dir) == 0;
+}
+
+uint32_t Platform::GetProcessorCount()
+{
+	return sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+float Platform::GetDoubleClickTime()
+{
+	return 500.0f;
+}
+
+#endif
\ No newline at end of file
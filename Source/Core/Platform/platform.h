@@ -18,7 +18,11 @@ namespace glex
 	class Platform : private StaticClass
 	{
 	public:
+#if defined(_MSC_VER) && !defined(__clang__)
 		static void DebugBreak() { __debugbreak(); }
+#else
+		static void DebugBreak() { __builtin_trap(); }
+#endif
 		static bool IsDebuggerPresent();
 		static void Terminate();
 		static void MessageBox(MessageBoxIcon icon, char const* title, char const* message);
@@ -1,5 +1,7 @@
 #include "Core/Platform/time.h"
+#include "Core/Thread/thread.h"
 #include <GLFW/glfw3.h>
+#include <chrono>
 using namespace glex;
 
 void Time::Startup()
@@ -13,4 +15,18 @@ void Time::Update()
 	double time = glfwGetTime() * 1000.0;
 	s_deltaTime = time - s_time;
 	s_time = time;
+}
+
+uint64_t Time::TicksPerSecond()
+{
+	static uint64_t const ticksPerSecond = []()
+	{
+		using Clock = std::chrono::steady_clock;
+		uint64_t ticks = Ticks();
+		Clock::time_point time = Clock::now();
+		Thread::Sleep(10);
+		uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - time).count();
+		return (Ticks() - ticks) * 1000000000 / nanoseconds;
+	}();
+	return ticksPerSecond;
 }
\ No newline at end of file
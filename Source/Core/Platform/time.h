@@ -1,5 +1,10 @@
 #pragma once
 #include "Core/commdefs.h"
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
 
 namespace glex
 {
@@ -20,6 +25,15 @@ namespace glex
 			return s_deltaTime;
 		}
 
+		// TSC ticks, cheap enough to stamp every log line and profiler scope.
+		static uint64_t Ticks()
+		{
+			return __rdtsc();
+		}
+
+		// Measured against the system clock on the first call, which takes 10 ms.
+		static uint64_t TicksPerSecond();
+
 #ifdef GLEX_INTERNAL
 		static void Startup();
 		static void Update();
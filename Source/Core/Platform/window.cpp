@@ -5,6 +5,7 @@
 #include "Core/Platform/platform.h"
 #include "Core/GL/context.h"
 #include "Core/log.h"
+#include "Core/Utils/profiler.h"
 #include <GLFW/glfw3.h>
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
@@ -314,6 +315,7 @@ uint64_t Window::GetWin32Handle()
 
 void Window::HandleEvents()
 {
+	GLEX_PROFILE_SCOPE("Window::HandleEvents");
 	Input::Update();
 	glfwPollEvents();
 	Time::Update();
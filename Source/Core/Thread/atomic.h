@@ -1,8 +1,13 @@
 #pragma once
 #include "Core/commdefs.h"
+#if defined(_MSC_VER) && !defined(__clang__)
 #include <intrin.h>
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #include <concepts>
 #include <atomic>
+#include <string.h>
 
 namespace glex
 {
@@ -13,62 +18,187 @@ namespace glex
 		template <concepts::SizeIs<4> T> requires std::is_integral_v<T>
 		static T Increment(T* p)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedIncrement(reinterpret_cast<long*>(p));
+#else
+			return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST);
+#endif
 		}
 
 		// New value is returned.
 		template <concepts::SizeIs<4> T> requires std::is_integral_v<T>
 		static T Decrement(T* p)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedDecrement(reinterpret_cast<long*>(p));
+#else
+			return __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST);
+#endif
 		}
 
 		template <concepts::SizeIs<4> T> requires std::is_integral_v<T>
 		static T Add(T* p, T v)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedExchangeAdd(reinterpret_cast<long*>(p), v);
+#else
+			return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+#endif
+		}
+
+		template <concepts::SizeIs<8> T> requires std::is_integral_v<T>
+		static T Add(T* p, T v)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return _InterlockedExchangeAdd64(reinterpret_cast<long long*>(p), v);
+#else
+			return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+#endif
+		}
+
+		template <concepts::SizeIs<4> T> requires std::is_integral_v<T>
+		static T And(T* p, T v)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return _InterlockedAnd(reinterpret_cast<long*>(p), v);
+#else
+			return __atomic_fetch_and(p, v, __ATOMIC_SEQ_CST);
+#endif
+		}
+
+		template <concepts::SizeIs<4> T> requires std::is_integral_v<T>
+		static T Or(T* p, T v)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return _InterlockedOr(reinterpret_cast<long*>(p), v);
+#else
+			return __atomic_fetch_or(p, v, __ATOMIC_SEQ_CST);
+#endif
 		}
 
 		template <concepts::SizeIs<8> T> requires std::is_integral_v<T>
 		static T And(T* p, T v)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedAnd64(reinterpret_cast<long long*>(p), v);
+#else
+			return __atomic_fetch_and(p, v, __ATOMIC_SEQ_CST);
+#endif
+		}
+
+		template <concepts::SizeIs<8> T> requires std::is_integral_v<T>
+		static T Or(T* p, T v)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return _InterlockedOr64(reinterpret_cast<long long*>(p), v);
+#else
+			return __atomic_fetch_or(p, v, __ATOMIC_SEQ_CST);
+#endif
 		}
 
 		template <typename T, std::convertible_to<T*> K>
 		static T* Exchange(T** p, K v)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return static_cast<T*>(_InterlockedExchangePointer(p, v));
+#else
+			return __atomic_exchange_n(p, static_cast<T*>(v), __ATOMIC_SEQ_CST);
+#endif
 		}
 
 		template <concepts::SizeIs<1> T>
 		static T Exchange(T* p, T v)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedExchange8(reinterpret_cast<char*>(p), v);
+#else
+			T old;
+			__atomic_exchange(p, &v, &old, __ATOMIC_SEQ_CST);
+			return old;
+#endif
 		}
 
 		template <concepts::SizeIs<4> T>
 		static T Exchange(T* p, T v)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedExchange(reinterpret_cast<long*>(p), v);
+#else
+			T old;
+			__atomic_exchange(p, &v, &old, __ATOMIC_SEQ_CST);
+			return old;
+#endif
+		}
+
+		template <concepts::SizeIs<8> T> requires (!std::is_pointer_v<T>)
+		static T Exchange(T* p, T v)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return _InterlockedExchange64(reinterpret_cast<long long*>(p), v);
+#else
+			T old;
+			__atomic_exchange(p, &v, &old, __ATOMIC_SEQ_CST);
+			return old;
+#endif
 		}
 
 		template <concepts::SizeIs<1> T>
 		static T CompareAndExchange(T* p, T cmp, T chg)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedCompareExchange8(reinterpret_cast<char*>(p), chg, cmp);
+#else
+			__atomic_compare_exchange(p, &cmp, &chg, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+			return cmp;
+#endif
+		}
+
+		template <concepts::SizeIs<4> T>
+		static T CompareAndExchange(T* p, T cmp, T chg)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			return _InterlockedCompareExchange(reinterpret_cast<long*>(p), chg, cmp);
+#else
+			__atomic_compare_exchange(p, &cmp, &chg, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+			return cmp;
+#endif
 		}
 
 		template <concepts::SizeIs<8> T>
 		static T CompareAndExchange(T* p, T cmp, T chg) requires (!std::is_pointer_v<T>)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return _InterlockedCompareExchange64(reinterpret_cast<long long*>(p), chg, cmp);
+#else
+			__atomic_compare_exchange(p, &cmp, &chg, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+			return cmp;
+#endif
 		}
 
 		template <typename T, std::convertible_to<T*> K>
 		static T* CompareAndExchange(T** p, K cmp, K chg)
 		{
+#if defined(_MSC_VER) && !defined(__clang__)
 			return reinterpret_cast<T*>(_InterlockedCompareExchangePointer(reinterpret_cast<void* volatile*>(p), chg, cmp));
+#else
+			T* expected = cmp;
+			__atomic_compare_exchange_n(p, &expected, static_cast<T*>(chg), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+			return expected;
+#endif
+		}
+
+		// p must be 16-byte aligned. cmp receives the old value.
+		// GCC goes through libatomic for this, link with -latomic.
+		template <concepts::SizeIs<16> T> requires std::is_trivially_copyable_v<T>
+		static bool CompareAndExchange128(T* p, T& cmp, T chg)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			long long words[2];
+			memcpy(words, &chg, sizeof(T));
+			return _InterlockedCompareExchange128(reinterpret_cast<long long*>(p), words[1], words[0], reinterpret_cast<long long*>(&cmp));
+#else
+			return __atomic_compare_exchange(p, &cmp, &chg, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
 		}
 
 		template <typename T>
@@ -77,6 +207,12 @@ namespace glex
 			return *static_cast<T const volatile*>(p);
 		}
 
+		template <typename T>
+		static void Store(T* p, std::type_identity_t<T> v)
+		{
+			*static_cast<T volatile*>(p) = v;
+		}
+
 		static void ReadBarrier()
 		{
 			std::atomic_thread_fence(std::memory_order_acquire);
@@ -91,5 +227,21 @@ namespace glex
 		{
 			std::atomic_thread_fence(std::memory_order_acq_rel);
 		}
+
+		// Spin-wait hint.
+		static void Pause()
+		{
+#if defined(_M_X64) || defined(__x86_64__)
+			_mm_pause();
+#elif defined(__aarch64__)
+			__asm__ __volatile__("yield");
+#endif
+		}
+
+		// Also orders a store before a later load, which acquire/release barriers don't.
+		static void FullBarrier()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "Core/Thread/coroutine.h"
+#include "Core/Container/list.h"
+#include "Core/log.h"
+#include "Core/Utils/profiler.h"
+
+using namespace glex;
+using namespace glex::inner;
+
+// Pushed from any thread, newest first.
+static IntrusiveLockFreeList<MainThreadAwaiter> s_mainThreadQueue;
+
+void inner::UnhandledCoroutineException()
+{
+	Logger::Fatal("Unhandled exception in coroutine.");
+}
+
+void MainThreadAwaiter::Enqueue()
+{
+	s_mainThreadQueue.Push(this);
+}
+
+static void DrainMainThreadQueue(bool abort)
+{
+	// Reverse into FIFO order. Coroutines queued while we're resuming wait for the next round.
+	MainThreadAwaiter* awaiter = s_mainThreadQueue.PopAll();
+	MainThreadAwaiter* ordered = nullptr;
+	while (awaiter != nullptr)
+	{
+		MainThreadAwaiter* next = awaiter->next;
+		awaiter->next = ordered;
+		ordered = awaiter;
+		awaiter = next;
+	}
+	while (ordered != nullptr)
+	{
+		// Resuming may destroy the awaiter.
+		MainThreadAwaiter* next = ordered->next;
+		ResumeCoroutine(ordered->owner, ordered->handle, abort);
+		ordered = next;
+	}
+}
+
+void Coroutine::Tick()
+{
+	GLEX_PROFILE_SCOPE("Coroutine::Tick");
+	DrainMainThreadQueue(false);
+}
+
+void Coroutine::Shutdown()
+{
+	DrainMainThreadQueue(true);
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+/**
+ * Coroutine support for tasks.
+ * A function returning Task<T> may co_await other tasks and the schedulers in Coroutine.
+ * Coroutines start right away on the calling thread, their frames come from the task block allocator.
+ * When a coroutine finishes, the one awaiting it is resumed by symmetric transfer, so deep chains don't grow the stack.
+ */
+#pragma once
+#include "Core/Thread/task.h"
+#include <coroutine>
+
+namespace glex
+{
+	namespace inner
+	{
+		// Coroutines must not throw. Works in builds with exceptions turned off.
+		void UnhandledCoroutineException();
+
+		template <typename P>
+		FutureBase* OwnerOf(std::coroutine_handle<P> handle)
+		{
+			if constexpr (std::is_base_of_v<FutureBase, P>)
+				return &handle.promise();
+			else
+				return nullptr;
+		}
+
+		// A cancelled task, or one awaiting an aborted task, finishes without a value instead of resuming.
+		inline void ResumeCoroutine(FutureBase* owner, std::coroutine_handle<> handle, bool abort)
+		{
+			if (owner != nullptr && (abort || owner->IsCancelRequested()))
+			{
+				owner->SetAborted();
+				owner->RemoveRef();
+			}
+			else
+				handle.resume();
+		}
+
+		template <typename Ret>
+		class PromiseBase : public Future<Ret>
+		{
+		private:
+			struct FinalAwaiter
+			{
+				bool await_ready() const noexcept { return false; }
+				template <typename P> std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept { return handle.promise().Finish(); }
+				void await_resume() const noexcept {}
+			};
+
+			std::coroutine_handle<> Finish()
+			{
+				Continuation* continuation = this->TakeContinuations();
+				std::coroutine_handle<> next = std::noop_coroutine();
+				void* address = continuation != nullptr && continuation->next == nullptr ? continuation->TransferAddress() : nullptr;
+				if (address != nullptr)
+					next = std::coroutine_handle<>::from_address(address);
+				else
+				{
+					while (continuation != nullptr)
+					{
+						Continuation* nextContinuation = continuation->next;
+						this->Dispatch(continuation);
+						continuation = nextContinuation;
+					}
+				}
+				// The frame may be gone after this.
+				this->RemoveRef();
+				return next;
+			}
+
+		public:
+			// One reference for the task, one for the coroutine until it finishes.
+			PromiseBase() { this->AddRef(); }
+			static void* operator new(size_t size) { return TaskBlockAllocator::Allocate(size); }
+			static void operator delete(void* p, size_t size) { TaskBlockAllocator::Free(p, size); }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			FinalAwaiter final_suspend() noexcept { return {}; }
+			void unhandled_exception() { UnhandledCoroutineException(); }
+		};
+
+		template <typename Ret>
+		class Promise : public PromiseBase<Ret>
+		{
+		public:
+			Task<Ret> get_return_object() { return Task<Ret>(this); }
+			template <typename R> void return_value(R&& value) { this->StoreValue(std::forward<R>(value)); }
+			virtual void Destroy() override { std::coroutine_handle<Promise>::from_promise(*this).destroy(); }
+		};
+
+		template <>
+		class Promise<void> : public PromiseBase<void>
+		{
+		public:
+			Task<void> get_return_object() { return Task<void>(this); }
+			void return_void() {}
+			virtual void Destroy() override { std::coroutine_handle<Promise>::from_promise(*this).destroy(); }
+		};
+
+		template <typename Ret>
+		class TaskAwaiter : public Continuation, private Unmoveable
+		{
+		private:
+			Future<Ret>* m_future;
+			FutureBase* m_owner = nullptr;
+			std::coroutine_handle<> m_handle;
+
+		public:
+			TaskAwaiter(Task<Ret> const& task) : m_future(task.m_future) { m_future->AddRef(); }
+			~TaskAwaiter() { m_future->RemoveRef(); }
+			bool await_ready() const { return m_future->IsDone() && m_future->HasValue(); }
+
+			template <typename P>
+			bool await_suspend(std::coroutine_handle<P> handle)
+			{
+				m_owner = OwnerOf(handle);
+				m_handle = handle;
+				if (m_future->TryAddContinuation(this))
+					return true;
+				if (m_owner == nullptr || m_future->HasValue())
+					return false;
+				// Already aborted. We may be destroyed here, so don't touch anything.
+				ResumeCoroutine(m_owner, m_handle, true);
+				return true;
+			}
+
+			// Coroutines not returning a task have to check HasValue themselves.
+			decltype(auto) await_resume() const { return m_future->Value(); }
+			virtual void OnCompleted() override { ResumeCoroutine(m_owner, m_handle, !m_future->HasValue()); }
+
+			virtual void* TransferAddress() override
+			{
+				if (m_owner != nullptr && (!m_future->HasValue() || m_owner->IsCancelRequested()))
+					return nullptr;
+				return m_handle.address();
+			}
+		};
+
+		class WorkerAwaiter : public QueuedWork, private Unmoveable
+		{
+		private:
+			FutureBase* m_owner = nullptr;
+			std::coroutine_handle<> m_handle;
+
+		public:
+			// Lives in the coroutine frame.
+			WorkerAwaiter() { m_releaseAfterRun = false; }
+			bool await_ready() const { return false; }
+
+			template <typename P>
+			void await_suspend(std::coroutine_handle<P> handle)
+			{
+				m_owner = OwnerOf(handle);
+				m_handle = handle;
+				Async::SubmitWork(this);
+			}
+
+			void await_resume() const {}
+			virtual void DoWork() override { ResumeCoroutine(m_owner, m_handle, false); }
+			virtual void Abort() override { ResumeCoroutine(m_owner, m_handle, true); }
+		};
+
+		class MainThreadAwaiter : private Unmoveable
+		{
+		public:
+			MainThreadAwaiter* next = nullptr;
+			FutureBase* owner = nullptr;
+			std::coroutine_handle<> handle;
+
+			bool await_ready() const { return false; }
+
+			template <typename P>
+			void await_suspend(std::coroutine_handle<P> handle)
+			{
+				this->owner = OwnerOf(handle);
+				this->handle = handle;
+				Enqueue();
+			}
+
+			void await_resume() const {}
+			void Enqueue();
+		};
+	}
+
+	template <typename Ret>
+	inner::TaskAwaiter<Ret> operator co_await(Task<Ret> const& task) { return inner::TaskAwaiter<Ret>(task); }
+
+	class Coroutine : private StaticClass
+	{
+	public:
+		// co_await Coroutine::ResumeOnWorker() continues on a pool worker.
+		static inner::WorkerAwaiter ResumeOnWorker() { return {}; }
+		// co_await Coroutine::ResumeOnMainThread() continues on the main thread in the next engine tick.
+		static inner::MainThreadAwaiter ResumeOnMainThread() { return {}; }
+
+#if GLEX_INTERNAL
+		// Resumes coroutines waiting for the main thread.
+		static void Tick();
+		// Cancels whatever is still waiting. Call before the thread pool is gone.
+		static void Shutdown();
+#endif
+	};
+}
+
+template <typename Ret, typename... Args>
+struct std::coroutine_traits<glex::Task<Ret>, Args...>
+{
+	using promise_type = glex::inner::Promise<Ret>;
+};
\ No newline at end of file
@@ -1,60 +1,80 @@
 #include "Core/Thread/event.h"
-#include "Core/Container/list.h"
-#include "Core/log.h"
-#include <Windows.h>
 
 using namespace glex;
 
-static LockFreeList<Event*> s_manualResetList, s_autoResetList;
-
-Event* Event::Get(bool manualReset)
+void Event::WaitSlow()
 {
-	Event* event;
-	if ((manualReset ? s_manualResetList : s_autoResetList).Pop(event))
+	for (uint32_t i = 0; i < Futex::k_defaultSpinCount; i++)
 	{
-		event->Reset();
-		return event;
+		Atomic::Pause();
+		if (TryWait())
+			return;
+	}
+	Atomic::Add(&m_state, k_waiter);
+	for (;;)
+	{
+		uint32_t state = Atomic::Load(&m_state);
+		if ((state & k_signaled) == 0)
+		{
+			Futex::Wait(&m_state, state);
+			continue;
+		}
+		// Leave and take the signal in one go.
+		uint32_t newState = (m_manualReset ? state : state & ~k_signaled) - k_waiter;
+		if (Atomic::CompareAndExchange(&m_state, state, newState) == state)
+			return;
 	}
-	return Mem::New<Event>(manualReset);
-}
-
-void Event::Release(Event* event)
-{
-	(event->IsManualReset() ? s_manualResetList : s_autoResetList).Push(event);
-}
-
-void Event::Clear()
-{
-	Event* out;
-	while (s_manualResetList.Pop(out))
-		Mem::Delete(out);
-	while (s_autoResetList.Pop(out))
-		Mem::Delete(out);
-}
-
-Event::Event(bool manualReset) : m_manualReset(manualReset)
-{
-	m_handle = reinterpret_cast<uint64_t>(CreateEventW(nullptr, manualReset, FALSE, nullptr));
-	if (m_handle == NULL)
-		Logger::Fatal("Cannot create event.");
-}
-
-Event::~Event()
-{
-	CloseHandle(reinterpret_cast<HANDLE>(m_handle));
 }
 
-void Event::Wait()
+void Event::Set()
 {
-	WaitForSingleObject(reinterpret_cast<HANDLE>(m_handle), INFINITE);
+	uint32_t state = Atomic::Load(&m_state);
+	for (;;)
+	{
+		if ((state & k_signaled) != 0)
+			return;
+		uint32_t oldState = Atomic::CompareAndExchange(&m_state, state, state | k_signaled);
+		if (oldState == state)
+			break;
+		state = oldState;
+	}
+	if (state >= k_waiter)
+	{
+		if (m_manualReset)
+			Futex::WakeAll(&m_state);
+		else
+			Futex::WakeOne(&m_state);
+	}
 }
 
-void Event::Set()
+void Semaphore::AcquireSlow()
 {
-	SetEvent(reinterpret_cast<HANDLE>(m_handle));
+	for (uint32_t i = 0; i < Futex::k_defaultSpinCount; i++)
+	{
+		Atomic::Pause();
+		if (TryAcquire())
+			return;
+	}
+	for (;;)
+	{
+		// Announce first, releasers check the waiter count after bumping the count.
+		Atomic::Increment(&m_numWaiters);
+		if (Atomic::Load(&m_count) == 0)
+			Futex::Wait(&m_count, 0);
+		Atomic::Decrement(&m_numWaiters);
+		if (TryAcquire())
+			return;
+	}
 }
 
-void Event::Reset()
+void Semaphore::Release(uint32_t count)
 {
-	ResetEvent(reinterpret_cast<HANDLE>(m_handle));
+	Atomic::Add(&m_count, count);
+	if (Atomic::Load(&m_numWaiters) != 0)
+	{
+		if (count == 1)
+			Futex::WakeOne(&m_count);
+		else
+			Futex::WakeAll(&m_count);
+	}
 }
\ No newline at end of file
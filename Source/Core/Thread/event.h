@@ -1,33 +1,76 @@
 #pragma once
 #include "Core/commdefs.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/futex.h"
 
 namespace glex
 {
-
-	class Event : Unmoveable
+	// One word. Setting or waiting on a signaled event never enters the kernel.
+	class Event : private Unmoveable
 	{
 	private:
-		uint64_t m_handle;
+		constexpr static uint32_t k_signaled = 1;
+		constexpr static uint32_t k_waiter = 2;
+
+		uint32_t m_state;	// Signaled bit and number of sleeping waiters above it.
 		bool m_manualReset;
 
+		void WaitSlow();
+
 	public:
-		// Used for event pooling.
-		static Event* Get(bool manualReset);
-		static void Release(Event* event);
-
-#if GLEX_INTERNAL
-		static void Clear();
-#endif
-		Event(bool manualReset);
-		~Event();
-		Event(Event&& rhs) : m_handle(rhs.m_handle), m_manualReset(rhs.m_manualReset) { rhs.m_handle = 0; };
-		Event& operator=(Event&& rhs) { m_handle = rhs.m_handle; rhs.m_handle = 0; return *this; }
-		bool operator==(nullptr_t rhs) const { return m_handle == 0; }
-		uint64_t Handle() const { return m_handle; }
+		Event(bool manualReset) : m_state(0), m_manualReset(manualReset) {}
 		bool IsManualReset() const { return m_manualReset; }
-		void Wait();
+		bool IsSet() const { return (Atomic::Load(&m_state) & k_signaled) != 0; }
+
+		// Auto-reset events are reset if this succeeds.
+		bool TryWait()
+		{
+			uint32_t state = Atomic::Load(&m_state);
+			while ((state & k_signaled) != 0)
+			{
+				if (m_manualReset)
+				{
+					Atomic::ReadBarrier();
+					return true;
+				}
+				uint32_t oldState = Atomic::CompareAndExchange(&m_state, state, state & ~k_signaled);
+				if (oldState == state)
+					return true;
+				state = oldState;
+			}
+			return false;
+		}
+
+		void Wait() { if (!TryWait()) WaitSlow(); }
 		void Set();
-		void Reset();
+		void Reset() { Atomic::And(&m_state, ~k_signaled); }
 	};
 
+	class Semaphore : private Unmoveable
+	{
+	private:
+		uint32_t m_count;
+		uint32_t m_numWaiters;
+
+		void AcquireSlow();
+
+	public:
+		Semaphore(uint32_t count = 0) : m_count(count), m_numWaiters(0) {}
+
+		bool TryAcquire()
+		{
+			uint32_t count = Atomic::Load(&m_count);
+			while (count != 0)
+			{
+				uint32_t oldCount = Atomic::CompareAndExchange(&m_count, count, count - 1);
+				if (oldCount == count)
+					return true;
+				count = oldCount;
+			}
+			return false;
+		}
+
+		void Acquire() { if (!TryAcquire()) AcquireSlow(); }
+		void Release(uint32_t count = 1);
+	};
 }
\ No newline at end of file
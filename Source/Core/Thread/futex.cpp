@@ -0,0 +1,48 @@
+#include "Core/Thread/futex.h"
+#ifdef _WIN32
+#include <Windows.h>
+#pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#endif
+
+using namespace glex;
+
+#ifdef _WIN32
+
+void Futex::Wait(uint32_t* address, uint32_t expected)
+{
+	WaitOnAddress(address, &expected, sizeof(uint32_t), INFINITE);
+}
+
+void Futex::WakeOne(uint32_t* address)
+{
+	WakeByAddressSingle(address);
+}
+
+void Futex::WakeAll(uint32_t* address)
+{
+	WakeByAddressAll(address);
+}
+
+#elif defined(__linux__)
+
+void Futex::Wait(uint32_t* address, uint32_t expected)
+{
+	syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+void Futex::WakeOne(uint32_t* address)
+{
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+void Futex::WakeAll(uint32_t* address)
+{
+	syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+/**
+ * Parks threads on a 32-bit word.
+ * Backed by WaitOnAddress on Windows and futex on Linux. Sync primitives are built on top of it,
+ * so they only enter the kernel when someone actually has to sleep.
+ */
+#pragma once
+#include "Core/commdefs.h"
+#include "Core/Thread/atomic.h"
+
+namespace glex
+{
+	class Futex : private StaticClass
+	{
+	public:
+		// Spins before parking. Tuned for a context switch costing a few microseconds.
+		constexpr static uint32_t k_defaultSpinCount = 128;
+
+		// Sleeps if *address still equals expected. May return spuriously.
+		static void Wait(uint32_t* address, uint32_t expected);
+		static void WakeOne(uint32_t* address);
+		static void WakeAll(uint32_t* address);
+	};
+	/**
+	 * Lets threads sleep until a lock-free condition may have changed.
+	 * Waiters call PrepareWait, recheck the condition, then Wait or CancelWait.
+	 * Notifiers change the condition first, then Notify. It's a fence and a load if nobody waits.
+	 */
+	class EventCount : private Unmoveable
+	{
+	private:
+		uint32_t m_epoch;
+		uint32_t m_numWaiters;
+
+	public:
+		EventCount() : m_epoch(0), m_numWaiters(0) {}
+
+		uint32_t PrepareWait()
+		{
+			Atomic::Increment(&m_numWaiters);
+			uint32_t epoch = Atomic::Load(&m_epoch);
+			Atomic::ReadBarrier();
+			return epoch;
+		}
+
+		void CancelWait() { Atomic::Decrement(&m_numWaiters); }
+
+		void Wait(uint32_t epoch)
+		{
+			Futex::Wait(&m_epoch, epoch);
+			Atomic::Decrement(&m_numWaiters);
+		}
+
+		void Notify()
+		{
+			Atomic::FullBarrier();
+			if (Atomic::Load(&m_numWaiters) != 0)
+			{
+				Atomic::Increment(&m_epoch);
+				Futex::WakeAll(&m_epoch);
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -1,24 +1,72 @@
-#include "lock.h"
-#include <Windows.h>
+#include "Core/Thread/lock.h"
 
 using namespace glex;
 
-Mutex::Mutex(uint32_t spinCount)
+void Mutex::LockSlow()
 {
-	InitializeCriticalSectionAndSpinCount(&m_criticalSection.As<CRITICAL_SECTION>(), spinCount);
+	for (uint32_t i = 0; i < m_spinCount; i++)
+	{
+		Atomic::Pause();
+		uint32_t state = Atomic::Load(&m_state);
+		if (state == k_unlocked && Atomic::CompareAndExchange(&m_state, k_unlocked, k_locked) == k_unlocked)
+			return;
+		// Others are sleeping already, spinning won't get us ahead of them.
+		if (state == k_contended)
+			break;
+	}
+	// We can't tell if there're other sleepers, so we take it as contended and wake one on unlock.
+	while (Atomic::Exchange(&m_state, k_contended) != k_unlocked)
+		Futex::Wait(&m_state, k_contended);
 }
 
-Mutex::~Mutex()
+void RWLock::Park(uint32_t blockingMask)
 {
-	DeleteCriticalSection(&m_criticalSection.As<CRITICAL_SECTION>());
+	// Releasers change the state before checking sleepers, so either we see the new state or they see us.
+	Atomic::Increment(&m_numSleepers);
+	uint32_t epoch = Atomic::Load(&m_epoch);
+	Atomic::ReadBarrier();
+	if ((Atomic::Load(&m_state) & blockingMask) != 0)
+		Futex::Wait(&m_epoch, epoch);
+	Atomic::Decrement(&m_numSleepers);
 }
 
-void Mutex::Lock()
+void RWLock::WakeSlow()
 {
-	EnterCriticalSection(&m_criticalSection.As<CRITICAL_SECTION>());
+	Atomic::Increment(&m_epoch);
+	Futex::WakeAll(&m_epoch);
 }
 
-void Mutex::Unlock()
+void RWLock::LockSharedSlow()
 {
-	LeaveCriticalSection(&m_criticalSection.As<CRITICAL_SECTION>());
+	for (uint32_t i = 0; i < Futex::k_defaultSpinCount; i++)
+	{
+		Atomic::Pause();
+		if (TryLockShared())
+			return;
+	}
+	while (!TryLockShared())
+		Park(k_writer | k_writerWaitingMask);
+}
+
+void RWLock::LockSlow()
+{
+	for (uint32_t i = 0; i < Futex::k_defaultSpinCount; i++)
+	{
+		Atomic::Pause();
+		if (TryLock())
+			return;
+	}
+	// Stops new readers from coming in.
+	Atomic::Add(&m_state, k_writerWaiting);
+	for (;;)
+	{
+		uint32_t state = Atomic::Load(&m_state);
+		if ((state & (k_writer | k_readerMask)) != 0)
+		{
+			Park(k_writer | k_readerMask);
+			continue;
+		}
+		if (Atomic::CompareAndExchange(&m_state, state, (state - k_writerWaiting) | k_writer) == state)
+			return;
+	}
 }
\ No newline at end of file
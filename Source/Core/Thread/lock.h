@@ -1,6 +1,7 @@
 #pragma once
 #include "Core/commdefs.h"
-#include "Core/Container/dummy.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/futex.h"
 
 namespace glex
 {
@@ -15,16 +16,82 @@ namespace glex
 		~ScopedLock() { m_lock->Unlock(); }
 	};
 
+	template <typename T>
+	class ScopedSharedLock : Unmoveable
+	{
+	private:
+		T* m_lock;
+
+	public:
+		ScopedSharedLock(T& lock) : m_lock(&lock) { m_lock->LockShared(); }
+		~ScopedSharedLock() { m_lock->UnlockShared(); }
+	};
+
+	// Spins for a while, then parks. Uncontended lock and unlock are a single atomic each.
+	// Unlike the critical section it replaced it isn't recursive, locking it again on the same thread deadlocks.
 	class Mutex : private Unmoveable
 	{
 	private:
-		// We use this to avoid including Windows.h.
-		Dummy<40, 8> m_criticalSection;
+		constexpr static uint32_t k_unlocked = 0;
+		constexpr static uint32_t k_locked = 1;
+		constexpr static uint32_t k_contended = 2;	// Someone may be sleeping.
+
+		uint32_t m_state;
+		uint32_t m_spinCount;
+
+		void LockSlow();
 
 	public:
-		Mutex(uint32_t spinCount);
-		~Mutex();
-		void Lock();
-		void Unlock();
+		constexpr Mutex(uint32_t spinCount = Futex::k_defaultSpinCount) : m_state(k_unlocked), m_spinCount(spinCount) {}
+		bool TryLock() { return Atomic::Load(&m_state) == k_unlocked && Atomic::CompareAndExchange(&m_state, k_unlocked, k_locked) == k_unlocked; }
+		void Lock() { if (Atomic::CompareAndExchange(&m_state, k_unlocked, k_locked) != k_unlocked) LockSlow(); }
+		void Unlock() { if (Atomic::Exchange(&m_state, k_unlocked) == k_contended) Futex::WakeOne(&m_state); }
+	};
+
+	// Writer-preferring. Readers back off as soon as a writer is waiting.
+	class RWLock : private Unmoveable
+	{
+	private:
+		constexpr static uint32_t k_readerMask = 0xffff;
+		constexpr static uint32_t k_writerWaiting = 1 << 16;
+		constexpr static uint32_t k_writerWaitingMask = 0x7fff0000;
+		constexpr static uint32_t k_writer = 1u << 31;
+
+		uint32_t m_state;
+		uint32_t m_epoch;		// Sleepers park on this, bumped by every release that may let them in.
+		uint32_t m_numSleepers;
+
+		void LockSharedSlow();
+		void LockSlow();
+		void Park(uint32_t blockingMask);
+		void Wake() { if (Atomic::Load(&m_numSleepers) != 0) WakeSlow(); }
+		void WakeSlow();
+
+	public:
+		RWLock() : m_state(0), m_epoch(0), m_numSleepers(0) {}
+
+		bool TryLockShared()
+		{
+			uint32_t state = Atomic::Load(&m_state);
+			return (state & (k_writer | k_writerWaitingMask)) == 0 && Atomic::CompareAndExchange(&m_state, state, state + 1) == state;
+		}
+
+		void LockShared() { if (!TryLockShared()) LockSharedSlow(); }
+
+		void UnlockShared()
+		{
+			uint32_t state = Atomic::Decrement(&m_state);
+			if ((state & k_readerMask) == 0 && (state & k_writerWaitingMask) != 0)
+				Wake();
+		}
+
+		bool TryLock() { return Atomic::CompareAndExchange(&m_state, 0u, k_writer) == 0; }
+		void Lock() { if (!TryLock()) LockSlow(); }
+
+		void Unlock()
+		{
+			Atomic::And(&m_state, ~k_writer);
+			Wake();
+		}
 	};
 }
\ No newline at end of file
@@ -1,79 +1,232 @@
 #include "Core/Thread/pool.h"
 #include "Core/log.h"
-#include <Windows.h>
+#include "Core/Utils/profiler.h"
 
 using namespace glex;
 
-void ThreadPool::ThreadMain(ThreadPool::PooledThreadContext& context)
+// Queue owned by the calling thread, null if it's neither a worker nor the pool creator.
+static thread_local void* t_currentContext = nullptr;
+
+void ThreadPool::ThreadMain(ThreadPool* pool, QueueContext* context)
 {
-	for (;;)
+	constexpr uint32_t k_spinRounds = 64;
+	t_currentContext = context;
+	char name[32];
+	snprintf(name, sizeof(name), "Worker %u", context->index);
+	GLEX_PROFILE_THREAD(name);
+	uint64_t bit = 1ULL << context->index;
+	uint32_t spins = 0;
+	while (!Atomic::Load(&pool->m_isShuttingDown))
 	{
-		context.hasWorkEvent->Wait();
-		if (context.work == nullptr)
-			break;
-		Mutex& lock = context.owner->m_lock;
-		auto& workQueue = context.owner->m_workQueue;
-		for (;;)
+		QueuedWork* work = pool->FindWork(context);
+		if (work != nullptr)
+		{
+			pool->Execute(work);
+			spins = 0;
+			continue;
+		}
+		if (++spins < k_spinRounds)
 		{
-			context.work->DoWork();
-			Mem::Delete(context.work);
-			lock.Lock();
-			if (workQueue.empty())
-				break;
-			context.work = std::move(workQueue.front());
-			workQueue.pop_front();
-			lock.Unlock();
+			Thread::Yield();
+			continue;
 		}
-		if (context.owner->m_isShuttingDown)
-			break;
-		context.work = nullptr;
-		context.owner->m_freeList.emplace_back(&context);
-		lock.Unlock();
+		// Announce we're going to sleep, then look again so a concurrent submit can't be missed.
+		Atomic::Or(&pool->m_sleepMask, bit);
+		Atomic::FullBarrier();
+		if (pool->HasWork() || Atomic::Load(&pool->m_isShuttingDown))
+			Atomic::And(&pool->m_sleepMask, ~bit);
+		else
+			context->wakeEvent.Wait();
+		spins = 0;
 	}
+	t_currentContext = nullptr;
 }
 
-ThreadPool::ThreadPool(uint32_t numThreads) : m_lock(512), m_isShuttingDown(false)
+ThreadPool::ThreadPool(uint32_t numThreads) : m_injectionLock(512), m_numInjected(0), m_sleepMask(0), m_isShuttingDown(false)
 {
+	if (numThreads > k_maxThreads)
+	{
+		Logger::Warn("Thread pool size is limited to %d.", k_maxThreads);
+		numThreads = k_maxThreads;
+	}
+	m_contexts.reserve(numThreads + 1);
+	for (uint32_t i = 0; i <= numThreads; i++)
+		m_contexts.emplace_back(MakeUnique<QueueContext>(i));
+	t_currentContext = m_contexts.back().Get();
 	m_threads.reserve(numThreads);
-	m_freeList.reserve(numThreads);
 	for (uint32_t i = 0; i < numThreads; i++)
 	{
-		PooledThreadContext& context = m_threads.emplace_back([&context = m_threads[i]]() { ThreadMain(context); }, ThreadPriority::Low, this);
-		m_freeList.emplace_back(&context);
-		if (!m_threads[i].thread.IsValid())
+		Thread& thread = m_threads.emplace_back([this, context = m_contexts[i].Get()]() { ThreadMain(this, context); }, ThreadPriority::Low);
+		if (!thread.IsValid())
 			Logger::Fatal("Cannot create thread for thread pool.");
-		context.thread.Resume();
+		thread.Resume();
 	}
 }
 
 ThreadPool::~ThreadPool()
 {
-	m_isShuttingDown = true;
-	m_lock.Lock();
-	for (QueuedWork* work : m_workQueue)
+	Atomic::Store(&m_isShuttingDown, true);
+	Atomic::FullBarrier();
+	for (uint32_t i = 0; i < m_threads.size(); i++)
+		m_contexts[i]->wakeEvent.Set();
+	for (Thread& thread : m_threads)
+		thread.Wait();
+	m_threads.clear();
+	t_currentContext = nullptr;
+
+	// Nobody is running now. Abort what's left.
+	QueuedWork* work;
+	for (UniquePtr<QueueContext>& context : m_contexts)
 	{
-		work->Abort();
-		Mem::Delete(work);
+		while (context->queue.Pop(work))
+			Execute(work, true);
+	}
+	for (QueuedWork* work : m_injectionQueue)
+		Execute(work, true);
+	m_injectionQueue.clear();
+}
+
+QueuedWork* ThreadPool::FindWork(QueueContext* context)
+{
+	QueuedWork* work;
+	if (context != nullptr && context->queue.Pop(work))
+		return work;
+	if (Atomic::Load(&m_numInjected) != 0)
+	{
+		ScopedLock lock(m_injectionLock);
+		if (!m_injectionQueue.empty())
+		{
+			work = m_injectionQueue.front();
+			m_injectionQueue.pop_front();
+			Atomic::Decrement(&m_numInjected);
+			return work;
+		}
+	}
+	// Start from a random victim so thieves don't gang up on the same queue.
+	uint32_t numQueues = m_contexts.size();
+	uint32_t start = 0;
+	if (context != nullptr)
+	{
+		context->seed ^= context->seed << 13;
+		context->seed ^= context->seed >> 17;
+		context->seed ^= context->seed << 5;
+		start = context->seed;
 	}
-	m_workQueue.clear();
-	m_lock.Unlock();
-	for (auto& context : m_threads)
+	for (uint32_t i = 0; i < numQueues; i++)
 	{
-		context.hasWorkEvent->Set();
-		context.thread.Wait();
+		QueueContext* victim = m_contexts[(start + i) % numQueues].Get();
+		if (victim != context && victim->queue.Steal(work))
+			return work;
 	}
+	return nullptr;
 }
 
-void ThreadPool::SubmitWork(QueuedWork* fn)
+bool ThreadPool::HasWork() const
 {
-	ScopedLock lock(m_lock);
-	if (m_freeList.size() != 0)
+	if (Atomic::Load(&m_numInjected) != 0)
+		return true;
+	for (UniquePtr<QueueContext> const& context : m_contexts)
 	{
-		PooledThreadContext& context = *m_freeList.back();
-		m_freeList.pop_back();
-		context.work = std::move(fn);
-		context.hasWorkEvent->Set();
+		if (context->queue.Size() != 0)
+			return true;
 	}
+	return false;
+}
+
+void ThreadPool::Execute(QueuedWork* work, bool abort)
+{
+	// Release before signaling, the counter's owner may free the work as soon as it sees zero.
+	JobCounter* counter = work->m_counter;
+	bool release = work->m_releaseAfterRun;
+	if (abort)
+		work->Abort();
 	else
-		m_workQueue.push_back(std::move(fn));
+	{
+		GLEX_PROFILE_SCOPE("Job");
+		work->DoWork();
+	}
+	if (release)
+		work->Release();
+	if (counter != nullptr)
+		Atomic::Decrement(&counter->m_count);
+}
+
+void ThreadPool::WakeOne()
+{
+	uint64_t mask = Atomic::Load(&m_sleepMask);
+	while (mask != 0)
+	{
+		uint32_t index = std::countr_zero(mask);
+		uint64_t newMask = mask & ~(1ULL << index);
+		uint64_t oldMask = Atomic::CompareAndExchange(&m_sleepMask, mask, newMask);
+		if (oldMask == mask)
+		{
+			m_contexts[index]->wakeEvent.Set();
+			return;
+		}
+		mask = oldMask;
+	}
+}
+
+void ThreadPool::SubmitWork(QueuedWork* work, JobCounter* counter)
+{
+	work->m_counter = counter;
+	if (counter != nullptr)
+		Atomic::Increment(&counter->m_count);
+	QueueContext* context = static_cast<QueueContext*>(t_currentContext);
+	if (context != nullptr)
+		context->queue.Push(work);
+	else
+	{
+		ScopedLock lock(m_injectionLock);
+		m_injectionQueue.push_back(work);
+		Atomic::Increment(&m_numInjected);
+	}
+	// Pairs with the barrier in ThreadMain before going to sleep.
+	Atomic::FullBarrier();
+	WakeOne();
+}
+
+bool ThreadPool::TryRunOne()
+{
+	QueuedWork* work = FindWork(static_cast<QueueContext*>(t_currentContext));
+	if (work == nullptr)
+		return false;
+	Execute(work);
+	return true;
+}
+
+Event* ThreadPool::GetWakeEvent() const
+{
+	QueueContext* context = static_cast<QueueContext*>(t_currentContext);
+	if (context == nullptr || context->index >= m_threads.size())
+		return nullptr;
+	return &context->wakeEvent;
+}
+
+void ThreadPool::Sleep(Event& event)
+{
+	QueueContext* context = static_cast<QueueContext*>(t_currentContext);
+	if (context == nullptr || context->index >= m_threads.size())
+	{
+		event.Wait();
+		return;
+	}
+	GLEX_DEBUG_ASSERT(&event == &context->wakeEvent);
+	// Same as going idle in ThreadMain, except that someone else may set the event too.
+	uint64_t bit = 1ULL << context->index;
+	Atomic::Or(&m_sleepMask, bit);
+	Atomic::FullBarrier();
+	if (!HasWork())
+		context->wakeEvent.Wait();
+	Atomic::And(&m_sleepMask, ~bit);
+}
+
+void ThreadPool::Wait(JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (!TryRunOne())
+			Thread::Yield();
+	}
 }
\ No newline at end of file
@@ -1,55 +1,148 @@
 #pragma once
 #include <Core/commdefs.h>
 #include "Core/Container/basic.h"
-#include "Core/Container/dummy.h"
+#include "Core/Container/steal_queue.h"
+#include "Core/Memory/smart_ptr.h"
 #include "Core/Thread/thread.h"
 #include "Core/Thread/event.h"
 #include "Core/Thread/lock.h"
+#include <bit>
 
 namespace glex
 {
+	// Number of unfinished works submitted with it. Waiting on it runs other works instead of blocking.
+	class JobCounter : private Unmoveable
+	{
+		friend class ThreadPool;
+
+	private:
+		uint32_t m_count = 0;
+
+	public:
+		bool IsDone() const { return Atomic::Load(&m_count) == 0; }
+	};
+
 	class QueuedWork
 	{
+		friend class ThreadPool;
+
+	private:
+		JobCounter* m_counter = nullptr;
+
+	protected:
+		// Cleared by works that may be gone once DoWork or Abort returns, e.g. ones living in a coroutine frame.
+		// The pool won't touch them afterwards.
+		bool m_releaseAfterRun = true;
+
 	public:
 		virtual void DoWork() {};
 		virtual void Abort() {};
+		// Called when the pool is done with the work. Override it if the work isn't allocated by Mem::New.
+		virtual void Release() { Mem::Delete(this); }
 		virtual ~QueuedWork() {}
 	};
 
+	/**
+	 * Every worker and the thread that creates the pool own a work-stealing queue.
+	 * Works submitted by them don't touch any lock. Idle workers steal from random victims.
+	 * Other threads submit into a locked injection queue.
+	 */
 	class ThreadPool : private Unmoveable
 	{
+	public:
+		constexpr static uint32_t k_maxThreads = 64;	// One bit per worker in the sleep mask.
+
 	private:
-		struct PooledThreadContext
+		struct alignas(64) QueueContext
+		{
+			WorkStealingQueue<QueuedWork*> queue;
+			Event wakeEvent;
+			uint32_t index;
+			uint32_t seed;
+
+			QueueContext(uint32_t index) : wakeEvent(false), index(index), seed(index * 0x9e3779b9 + 1) {}
+		};
+
+		template <typename Fn>
+		struct ParallelForShared
 		{
-			Thread thread;
-			Event* hasWorkEvent;
-			ThreadPool* owner;
-			QueuedWork* work;
-
-			template <typename Fn>
-			PooledThreadContext(Fn&& proc, ThreadPriority priority, ThreadPool* pool) :
-				thread(std::forward<Fn>(proc), priority), hasWorkEvent(Event::Get(false)), owner(pool), work(nullptr) {}
-			~PooledThreadContext() { Event::Release(hasWorkEvent); }
-			// Will not be called.
-			PooledThreadContext(PooledThreadContext&& rhs) :
-				thread(std::move(rhs.thread)), hasWorkEvent(rhs.hasWorkEvent), owner(rhs.owner), work(rhs.work)
+			Fn& function;
+			// 64-bit, so threads that keep adding after the end can't wrap it around into the range again.
+			uint64_t cursor;
+			uint64_t end;
+			uint64_t grain;
+
+			void Run()
 			{
-				rhs.hasWorkEvent = nullptr;
+				for (;;)
+				{
+					uint64_t begin = Atomic::Add(&cursor, grain);
+					if (begin >= end)
+						break;
+					uint64_t chunkEnd = Min(begin + grain, end);
+					for (uint64_t i = begin; i < chunkEnd; i++)
+						function(static_cast<uint32_t>(i));
+				}
 			}
 		};
 
-		Vector<PooledThreadContext> m_threads;
-		Vector<PooledThreadContext*> m_freeList;
-		Deque<QueuedWork*> m_workQueue;
-		Mutex m_lock;
+		template <typename Fn>
+		class ParallelForWork : public QueuedWork
+		{
+		private:
+			ParallelForShared<Fn>* m_shared;
+
+		public:
+			ParallelForWork(ParallelForShared<Fn>* shared) : m_shared(shared) {}
+			virtual void DoWork() override { m_shared->Run(); }
+			virtual void Release() override {}	// Lives on the caller's stack.
+		};
+
+		Vector<Thread> m_threads;
+		Vector<UniquePtr<QueueContext>> m_contexts;	// Workers first, creator thread last.
+		Deque<QueuedWork*> m_injectionQueue;
+		Mutex m_injectionLock;
+		uint32_t m_numInjected;
+		uint64_t m_sleepMask;
 		bool m_isShuttingDown;
 
-		static void ThreadMain(PooledThreadContext& context);
+		static void ThreadMain(ThreadPool* pool, QueueContext* context);
+		QueuedWork* FindWork(QueueContext* context);
+		bool HasWork() const;
+		void Execute(QueuedWork* work, bool abort = false);
+		void WakeOne();
 
 	public:
 		ThreadPool(uint32_t numThreads);
 		~ThreadPool();
-		uint32_t FreeThreadCount() const { return m_freeList.size(); }
-		void SubmitWork(QueuedWork* work);
+		uint32_t ThreadCount() const { return m_threads.size(); }
+		uint32_t FreeThreadCount() const { return std::popcount(Atomic::Load(&m_sleepMask)); }
+		void SubmitWork(QueuedWork* work, JobCounter* counter = nullptr);
+		void Wait(JobCounter& counter);
+		// Runs one pending work on the calling thread. Returns false if there's nothing to do.
+		bool TryRunOne();
+		// The event a worker sleeps on when it's idle, null if the calling thread isn't a worker.
+		Event* GetWakeEvent() const;
+		// Sleeps until the event is set or, on workers, until there may be new works to run. May return spuriously.
+		// Workers must pass GetWakeEvent(), submits wake them up through it.
+		void Sleep(Event& event);
+
+		// Calls fn(i) for every i in [begin, end). Indices are handed out grain by grain and the caller takes part.
+		template <typename Fn>
+		void ParallelFor(uint32_t begin, uint32_t end, uint32_t grain, Fn&& fn)
+		{
+			if (begin >= end)
+				return;
+			grain = Max(grain, 1u);
+			ParallelForShared<std::remove_reference_t<Fn>> shared { fn, begin, end, grain };
+			uint32_t numChunks = (end - begin - 1) / grain + 1;
+			uint32_t numHelpers = Min(numChunks - 1, ThreadCount());
+			InlineVector<ParallelForWork<std::remove_reference_t<Fn>>, k_maxThreads> helpers;
+			JobCounter counter;
+			for (uint32_t i = 0; i < numHelpers; i++)
+				SubmitWork(&helpers.emplace_back(&shared), &counter);
+			shared.Run();
+			Wait(counter);
+		}
 	};
 }
\ No newline at end of file
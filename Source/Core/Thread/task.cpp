@@ -2,6 +2,227 @@
 #include "Core/log.h"
 
 using namespace glex;
+using namespace glex::inner;
+
+namespace
+{
+	struct BlockCache
+	{
+		struct FreeList
+		{
+			void* head = nullptr;
+			uint32_t count = 0;
+		};
+
+		FreeList lists[TaskBlockAllocator::k_numSizeClasses];
+
+		~BlockCache()
+		{
+			Clear();
+		}
+
+		void Clear()
+		{
+			for (FreeList& list : lists)
+			{
+				while (list.head != nullptr)
+				{
+					void* next = *static_cast<void**>(list.head);
+					Mem::Free(list.head);
+					list.head = next;
+				}
+				list.count = 0;
+			}
+		}
+	};
+
+	uint32_t SizeClassOf(uint32_t size)
+	{
+		uint32_t sizeClass = 0;
+		while ((TaskBlockAllocator::k_minBlockSize << sizeClass) < size)
+			sizeClass++;
+		return sizeClass;
+	}
+
+	// Continuations completed while another one is running on this thread are queued
+	// instead of nesting, so long chains don't eat up the stack.
+	struct DispatchQueue
+	{
+		Continuation* head = nullptr;
+		Continuation* tail = nullptr;
+		bool isDispatching = false;
+	};
+
+	// Lives on the stack of a thread waiting for a future, which may return as soon as isDone is set.
+	struct WaitContinuation : public Continuation
+	{
+		Event* wakeEvent;
+		uint32_t isDone = 0;
+
+		WaitContinuation(Event* wakeEvent) : wakeEvent(wakeEvent) {}
+
+		virtual void OnCompleted() override
+		{
+			wakeEvent->Set();
+			Atomic::Store(&isDone, 1u);
+		}
+	};
+}
+
+static thread_local BlockCache t_blockCache;
+static thread_local DispatchQueue t_dispatchQueue;
+
+void* TaskBlockAllocator::Allocate(uint32_t size)
+{
+	if (size > k_maxBlockSize)
+		return Mem::Alloc(size, k_blockAlignment, MemoryTag::Threading);
+	uint32_t sizeClass = SizeClassOf(size);
+	BlockCache::FreeList& list = t_blockCache.lists[sizeClass];
+	if (list.head == nullptr)
+		return Mem::Alloc(k_minBlockSize << sizeClass, k_blockAlignment, MemoryTag::Threading);
+	void* block = list.head;
+	list.head = *static_cast<void**>(block);
+	list.count--;
+	return block;
+}
+
+void TaskBlockAllocator::Free(void* p, uint32_t size)
+{
+	if (size > k_maxBlockSize)
+	{
+		Mem::Free(p);
+		return;
+	}
+	BlockCache::FreeList& list = t_blockCache.lists[SizeClassOf(size)];
+	if (list.count >= k_maxCachedBlocks)
+	{
+		Mem::Free(p);
+		return;
+	}
+	*static_cast<void**>(p) = list.head;
+	list.head = p;
+	list.count++;
+}
+
+void TaskBlockAllocator::Trim()
+{
+	t_blockCache.Clear();
+}
+
+// Runs the oldest continuation Dispatch queued on this thread, false if there's none.
+static bool RunQueuedContinuation()
+{
+	DispatchQueue& queue = t_dispatchQueue;
+	Continuation* next = queue.head;
+	if (next == nullptr)
+		return false;
+	queue.head = next->next;
+	if (queue.head == nullptr)
+		queue.tail = nullptr;
+	next->OnCompleted();
+	return true;
+}
+
+void FutureBase::Dispatch(Continuation* continuation)
+{
+	DispatchQueue& queue = t_dispatchQueue;
+	continuation->next = nullptr;
+	if (queue.isDispatching)
+	{
+		if (queue.tail != nullptr)
+			queue.tail->next = continuation;
+		else
+			queue.head = continuation;
+		queue.tail = continuation;
+		return;
+	}
+	queue.isDispatching = true;
+	continuation->OnCompleted();
+	while (RunQueuedContinuation());
+	queue.isDispatching = false;
+}
+
+void FutureBase::Complete()
+{
+	// Exchange is a full barrier, the value is published before anyone sees us completed.
+	Continuation* continuation = TakeContinuations();
+	while (continuation != nullptr)
+	{
+		Continuation* next = continuation->next;
+		Dispatch(continuation);
+		continuation = next;
+	}
+}
+
+void FutureBase::AddContinuation(Continuation* continuation)
+{
+	if (!TryAddContinuation(continuation))
+		Dispatch(continuation);
+}
+
+bool FutureBase::TryAddContinuation(Continuation* continuation)
+{
+	Continuation* head = Atomic::Load(&m_continuations);
+	for (;;)
+	{
+		if (head == k_completed)
+		{
+			Atomic::ReadBarrier();
+			return false;
+		}
+		continuation->next = head;
+		Continuation* oldHead = Atomic::CompareAndExchange(&m_continuations, head, continuation);
+		if (oldHead == head)
+			return true;
+		head = oldHead;
+	}
+}
+
+void FutureBase::Destroy()
+{
+	uint32_t size = m_size;
+	this->~FutureBase();
+	TaskBlockAllocator::Free(this, size);
+}
+
+void FutureBase::RemoveRef()
+{
+	if (Atomic::Decrement(&m_refCount) == 0)
+		Destroy();
+}
+
+void FutureBase::Wait() const
+{
+	if (IsDone())
+	{
+		Atomic::ReadBarrier();
+		return;
+	}
+	// Workers sleep on their own event, so new works wake them up as well and can't be starved by waiters.
+	Event localEvent(false);
+	Event* wakeEvent = Async::GetWakeEvent();
+	WaitContinuation waiter(wakeEvent != nullptr ? wakeEvent : &localEvent);
+	bool isWaiting = false;
+	for (;;)
+	{
+		// Once we're a continuation, it has to be done with us before we can leave.
+		if (isWaiting ? Atomic::Load(&waiter.isDone) != 0 : IsDone())
+			break;
+		// Waiting inside a continuation, what we wait for may be queued on this very thread behind it.
+		if (RunQueuedContinuation() || Async::TryRunOne())
+			continue;
+		if (!isWaiting)
+		{
+			// Nothing to help with, have the completion wake us up. Look for work once more before sleeping.
+			if (!const_cast<FutureBase*>(this)->TryAddContinuation(&waiter))
+				break;
+			isWaiting = true;
+			continue;
+		}
+		Async::Sleep(*waiter.wakeEvent);
+	}
+	Atomic::ReadBarrier();
+}
 
 void Async::Startup(uint32_t numThreads)
 {
@@ -13,4 +234,5 @@ void Async::Startup(uint32_t numThreads)
 void Async::Shutdown()
 {
 	s_threadPool.Destroy();
+	TaskBlockAllocator::Trim();
 }
\ No newline at end of file
@@ -1,121 +1,376 @@
+/**
+ * Tasks and their continuations.
+ * A task's shared state is the queued work itself and is allocated from per-thread recycled blocks,
+ * so Async::Run doesn't touch the heap once warmed up.
+ * Continuations run on the thread that completes the task. Nobody blocks unless it calls Await.
+ */
 #pragma once
 #include "Core/Memory/mem.h"
-#include "Core/Memory/smart_ptr.h"
-#include "Core/Thread/event.h"
+#include "Core/Thread/atomic.h"
 #include "Core/Thread/pool.h"
 #include "Core/Container/optional.h"
+#include "Core/assert.h"
+#include <array>
 
 namespace glex
 {
+	class Async;
+
 	template <typename Ret>
-	class Future
+	class Task;
+
+	namespace inner
 	{
+		template <typename Ret>
+		class Promise;
+
+		template <typename Ret>
+		class TaskAwaiter;
+
+		// Blocks of a few size classes cached per thread. Task states, queued lambdas and coroutine frames come from here.
+		// Bigger requests go straight to Mem.
+		class TaskBlockAllocator : private StaticClass
+		{
+		public:
+			constexpr static uint32_t k_minBlockSize = 64;
+			constexpr static uint32_t k_numSizeClasses = 5;	// 64 to 1024 bytes.
+			constexpr static uint32_t k_maxBlockSize = k_minBlockSize << (k_numSizeClasses - 1);
+			constexpr static uint32_t k_blockAlignment = 16;
+			constexpr static uint32_t k_maxCachedBlocks = 128;
+
+			static void* Allocate(uint32_t size);
+			static void Free(void* p, uint32_t size);
+			// Frees blocks cached by the calling thread.
+			static void Trim();
+		};
+
+		class Continuation
+		{
+		public:
+			Continuation* next = nullptr;
+			virtual void OnCompleted() = 0;
+			// A suspended coroutine that can be resumed by symmetric transfer instead of OnCompleted.
+			virtual void* TransferAddress() { return nullptr; }
+		};
+
+		class FutureBase : public QueuedWork
+		{
+		private:
+			inline static Continuation* const k_completed = reinterpret_cast<Continuation*>(UINT64_MAX);
+			Continuation* m_continuations;	// k_completed once completed.
+			uint32_t m_refCount;
+			uint32_t m_size;
+			uint8_t m_cancelRequested;
+			bool m_aborted;
+
+		protected:
+			static void Dispatch(Continuation* continuation);
+			FutureBase(uint32_t refCount) : m_continuations(nullptr), m_refCount(refCount), m_size(0), m_cancelRequested(0), m_aborted(false) {}
+			void Complete();
+			// Marks us completed and hands the continuations over to the caller.
+			Continuation* TakeContinuations() { return Atomic::Exchange(&m_continuations, k_completed); }
+			// Called when the last reference goes away.
+			virtual void Destroy();
+
+		public:
+			template <typename State, typename... Args>
+			static State* Create(uint32_t refCount, Args&&... args)
+			{
+				static_assert(alignof(State) <= TaskBlockAllocator::k_blockAlignment);
+				State* state = static_cast<State*>(TaskBlockAllocator::Allocate(sizeof(State)));
+				new(state) State(std::forward<Args>(args)...);
+				FutureBase* base = state;
+				base->m_refCount = refCount;
+				base->m_size = sizeof(State);
+				return state;
+			}
+
+			FutureBase() : FutureBase(1) {}
+			bool IsDone() const { return Atomic::Load(&m_continuations) == k_completed; }
+			// Cancellation is cooperative. Works that haven't started and coroutines at their next resumption complete without a value.
+			void RequestCancel() { Atomic::Store(&m_cancelRequested, 1); }
+			bool IsCancelRequested() const { return Atomic::Load(&m_cancelRequested) != 0; }
+			// Aborted works and cancelled tasks complete without a value.
+			void SetAborted() { m_aborted = true; Complete(); }
+			bool IsAborted() const { return m_aborted; }
+			void Wait() const;
+			void AddRef() { Atomic::Increment(&m_refCount); }
+			void RemoveRef();
+			// Runs the continuation right away if it's already completed.
+			void AddContinuation(Continuation* continuation);
+			// Returns false instead if it's already completed.
+			bool TryAddContinuation(Continuation* continuation);
+			// Queued works hold a reference, the pool gives it back here.
+			virtual void Release() override { RemoveRef(); }
+		};
+
+		template <typename Fn, typename Ret>
+		struct ThenResult
+		{
+			using Type = std::invoke_result_t<Fn&, Ret const&>;
+		};
+
+		template <typename Fn>
+		struct ThenResult<Fn, void>
+		{
+			using Type = std::invoke_result_t<Fn&>;
+		};
+	}
+
+	template <typename Ret>
+	class Future : public inner::FutureBase
+	{
+	private:
+		Optional<Ret> m_value;
+		bool m_hasValue = false;
+
 	protected:
-		Event* m_event;
-		Ret m_value;
+		template <typename R>
+		void StoreValue(R&& value)
+		{
+			m_value.Emplace(std::forward<R>(value));
+			m_hasValue = true;
+		}
 
 	public:
-		Future() : m_event(Event::Get(true)) {}
-		virtual ~Future() { Event::Release(m_event); }
-		Ret& Await() { m_event->Wait(); return m_value; }
+		~Future() { if (m_hasValue) m_value.Destroy(); }
+		bool HasValue() const { return m_hasValue; }
+		Ret const& Value() const
+		{
+			GLEX_DEBUG_ASSERT_MSG(m_hasValue, "The task was aborted or cancelled.") {}
+			return *m_value;
+		}
 
 		template <typename R>
 		void SetValue(R&& value)
 		{
-			m_value = std::forward<R>(value);
-			m_event->Set();
+			StoreValue(std::forward<R>(value));
+			Complete();
 		}
 	};
 
 	template <>
-	class Future<void>
-	{
-	protected:
-		Event* m_event;
-
-	public:
-		Future() : m_event(Event::Get(true)) {};
-		virtual ~Future() { Event::Release(m_event); }
-		void Await() { m_event->Wait(); }
-		void SetValue() { m_event->Set(); }
-	};
-
-	template <typename Ret>
-	class Task
+	class Future<void> : public inner::FutureBase
 	{
-	private:
-		SharedPtr<Future<Ret>> m_future;
-
 	public:
-		Task(SharedPtr<Future<Ret>> const& future) : m_future(future) {}
-		Ret const& Await() const { return m_future->Await(); }
+		bool HasValue() const { return !IsAborted(); }
+		void Value() const {}
+		void SetValue() { Complete(); }
 	};
 
-	class Async : private StaticClass
+	namespace inner
 	{
-	private:
-		inline static Optional<ThreadPool> s_threadPool;
+		template <typename Ret, typename Fn>
+		void InvokeInto(Future<Ret>* future, Fn&& call)
+		{
+			if constexpr (std::is_void_v<Ret>)
+			{
+				call();
+				future->SetValue();
+			}
+			else
+				future->SetValue(call());
+		}
 
-		template <typename Ret, typename Func, bool TRIVIAL>
-		class WorkInternal : public QueuedWork
+		template <typename Ret, typename Fn>
+		class RunFuture : public Future<Ret>
 		{
 		private:
-			SharedPtr<Future<Ret>> m_future;
-			Func m_function;
+			Fn m_function;
 
 		public:
 			template <typename R>
-			WorkInternal(SharedPtr<Future<Ret>> const& future, R&& func) : m_future(future), m_function(std::forward<R>(func)) {}
-			virtual void DoWork() override { m_future->SetValue(m_function()); }
+			RunFuture(R&& fn) : m_function(std::forward<R>(fn)) {}
+			virtual void DoWork() override
+			{
+				if (this->IsCancelRequested())
+					this->SetAborted();
+				else
+					InvokeInto(this, m_function);
+			}
+
+			virtual void Abort() override { this->SetAborted(); }
 		};
 
-		template <typename Func>
-		class WorkInternal<void, Func, false> : public QueuedWork
+		template <typename Ret, typename Fn, typename Antecedent>
+		class ThenFuture : public Future<Ret>, public Continuation
 		{
 		private:
-			SharedPtr<Future<void>> m_future;
-			Func m_function;
+			Future<Antecedent>* m_antecedent;
+			Fn m_function;
 
 		public:
 			template <typename R>
-			WorkInternal(SharedPtr<Future<void>> const& future, R&& func) : m_future(future), m_function(std::forward<R>(func)) {}
-			virtual void DoWork() override { m_function(); m_future->SetValue(); }
+			ThenFuture(Future<Antecedent>* antecedent, R&& fn) : m_antecedent(antecedent), m_function(std::forward<R>(fn)) { antecedent->AddRef(); }
+
+			virtual void OnCompleted() override
+			{
+				if (!m_antecedent->HasValue() || this->IsCancelRequested())
+					this->SetAborted();
+				else if constexpr (std::is_void_v<Antecedent>)
+					InvokeInto(this, m_function);
+				else
+					InvokeInto(this, [this]() { return m_function(m_antecedent->Value()); });
+				m_antecedent->RemoveRef();
+				this->RemoveRef();	// The antecedent's link.
+			}
 		};
 
-		template <typename Ret, typename Func>
-		class WorkInternal<Ret, Func, true> : public QueuedWork
+		template <uint32_t N>
+		class WhenAllFuture : public Future<void>
 		{
 		private:
-			SharedPtr<Future<Ret>> m_future;
+			struct Link : public Continuation
+			{
+				WhenAllFuture* owner;
+				virtual void OnCompleted() override { owner->OnLinkCompleted(); }
+			};
+
+			std::array<Link, N> m_links;
+			uint32_t m_remaining;
+
+			void OnLinkCompleted()
+			{
+				if (Atomic::Decrement(&m_remaining) == 0)
+				{
+					SetValue();
+					RemoveRef();
+				}
+			}
 
 		public:
-			template <typename R>
-			WorkInternal(SharedPtr<Future<Ret>> const& future, R&& func) : m_future(future) {}
-			virtual void DoWork() override { m_future->SetValue(Func()()); }
+			WhenAllFuture() : m_remaining(N)
+			{
+				for (Link& link : m_links)
+					link.owner = this;
+			}
+
+			template <typename... Rets>
+			void Attach(Future<Rets>*... antecedents)
+			{
+				uint32_t i = 0;
+				(antecedents->AddContinuation(&m_links[i++]), ...);
+			}
 		};
 
-		template <typename Func>
-		class WorkInternal<void, Func, true> : public QueuedWork
+		// The value is the index of the first task that completed.
+		template <uint32_t N>
+		class WhenAnyFuture : public Future<uint32_t>
 		{
 		private:
-			SharedPtr<Future<void>> m_future;
+			struct Link : public Continuation
+			{
+				WhenAnyFuture* owner;
+				uint32_t index;
+				virtual void OnCompleted() override { owner->OnLinkCompleted(index); }
+			};
+
+			std::array<Link, N> m_links;
+			uint32_t m_remaining;
+			uint8_t m_claimed;
+
+			void OnLinkCompleted(uint32_t index)
+			{
+				if (Atomic::CompareAndExchange<uint8_t>(&m_claimed, 0, 1) == 0)
+					SetValue(index);
+				// Later links still touch us, so the reference goes away with the last one.
+				if (Atomic::Decrement(&m_remaining) == 0)
+					RemoveRef();
+			}
 
 		public:
-			template <typename R>
-			WorkInternal(SharedPtr<Future<void>> const& future, R&& func) : m_future(future) {}
-			virtual void DoWork() override { Func()(); m_future->SetValue(); }
+			WhenAnyFuture() : m_remaining(N), m_claimed(0)
+			{
+				for (uint32_t i = 0; i < N; i++)
+				{
+					m_links[i].owner = this;
+					m_links[i].index = i;
+				}
+			}
+
+			template <typename... Rets>
+			void Attach(Future<Rets>*... antecedents)
+			{
+				uint32_t i = 0;
+				(antecedents->AddContinuation(&m_links[i++]), ...);
+			}
 		};
+	}
+
+	template <typename Ret>
+	class Task
+	{
+		friend class Async;
 
-		/*template <typename Ret, typename Func, bool Trivial>
-		class AsyncQueuedWork : public QueuedWork
+		template <typename R>
+		friend class Task;
+
+		template <typename R>
+		friend class inner::Promise;
+
+		template <typename R>
+		friend class inner::TaskAwaiter;
+
+	private:
+		Future<Ret>* m_future;
+
+		// Takes over a reference.
+		Task(Future<Ret>* future) : m_future(future) {}
+
+	public:
+		Task() : m_future(nullptr) {}
+		~Task() { if (m_future != nullptr) m_future->RemoveRef(); }
+		Task(Task<Ret> const& rhs) : m_future(rhs.m_future) { if (m_future != nullptr) m_future->AddRef(); }
+		Task(Task<Ret>&& rhs) : m_future(rhs.m_future) { rhs.m_future = nullptr; }
+		Task<Ret>& operator=(Task<Ret> const& rhs) { Task<Ret> copy(rhs); std::swap(m_future, copy.m_future); return *this; }
+		Task<Ret>& operator=(Task<Ret>&& rhs) { std::swap(m_future, rhs.m_future); return *this; }
+		bool IsValid() const { return m_future != nullptr; }
+		bool IsDone() const { return m_future->IsDone(); }
+		bool HasValue() const { return m_future->HasValue(); }
+		void Cancel() const { m_future->RequestCancel(); }
+
+		// Runs other pending works while waiting. The task must not have been aborted or cancelled.
+		decltype(auto) Await() const
 		{
-		private:
-			SharedPtr<WorkInternal<Ret, Func, Trivial>> m_work;
+			m_future->Wait();
+			GLEX_DEBUG_ASSERT_MSG(m_future->HasValue(), "The task was aborted or cancelled.") {}
+			return m_future->Value();
+		}
 
-		public:
-			AsyncQueuedWork(SharedPtr<WorkInternal<Ret, Func, Trivial>> const& work) : m_work(work) {}
-			virtual void DoWork() override { m_work->DoWork(); }
-		};*/
+		// Like Await, false instead if the task was aborted or cancelled.
+		bool TryAwait() const requires std::is_void_v<Ret>
+		{
+			m_future->Wait();
+			return m_future->HasValue();
+		}
+
+		template <typename R = Ret> requires (!std::is_void_v<R>)
+		bool TryAwait(R& outValue) const
+		{
+			m_future->Wait();
+			if (!m_future->HasValue())
+				return false;
+			outValue = m_future->Value();
+			return true;
+		}
+
+		// fn receives the result (nothing for void tasks) on the thread that completes this task.
+		template <typename Fn>
+		auto Then(Fn&& fn) const -> Task<typename inner::ThenResult<std::remove_reference_t<Fn>, Ret>::Type>
+		{
+			using NewRet = typename inner::ThenResult<std::remove_reference_t<Fn>, Ret>::Type;
+			using StateType = inner::ThenFuture<NewRet, std::remove_cv_t<std::remove_reference_t<Fn>>, Ret>;
+			// One reference for the returned task, one for the link in our continuation list.
+			StateType* state = inner::FutureBase::Create<StateType>(2, m_future, std::forward<Fn>(fn));
+			m_future->AddContinuation(state);
+			return Task<NewRet>(state);
+		}
+	};
+
+	class Async : private StaticClass
+	{
+	private:
+		inline static Optional<ThreadPool> s_threadPool;
 
 		template <typename Fn>
 		class LambdaQueuedWork : public QueuedWork
@@ -127,27 +382,67 @@ namespace glex
 			LambdaQueuedWork(Fn const& obj) : m_object(obj) {}
 			LambdaQueuedWork(Fn&& obj) : m_object(std::move(obj)) {}
 			virtual void DoWork() override { m_object(); }
+
+			virtual void Release() override
+			{
+				this->~LambdaQueuedWork();
+				inner::TaskBlockAllocator::Free(this, sizeof(LambdaQueuedWork));
+			}
 		};
 
 	public:
 		static void Startup(uint32_t numThreads);
 		static void Shutdown();
+		static uint32_t ThreadCount() { return s_threadPool->ThreadCount(); }
 		static uint32_t FreeThreadCount() { return s_threadPool->FreeThreadCount(); }
-		static void SubmitWork(QueuedWork* work) { s_threadPool->SubmitWork(work); }
-		template <typename Fn> static void SubmitWork(Fn&& fn) { s_threadPool->SubmitWork(Mem::New<LambdaQueuedWork<std::remove_cv_t<std::remove_reference_t<Fn>>>>(std::forward<Fn>(fn))); }
+		static bool TryRunOne() { return s_threadPool->TryRunOne(); }
+		static Event* GetWakeEvent() { return s_threadPool->GetWakeEvent(); }
+		static void Sleep(Event& event) { s_threadPool->Sleep(event); }
+		static void SubmitWork(QueuedWork* work, JobCounter* counter = nullptr) { s_threadPool->SubmitWork(work, counter); }
+		static void Wait(JobCounter& counter) { s_threadPool->Wait(counter); }
+		template <typename Fn> static void ParallelFor(uint32_t begin, uint32_t end, uint32_t grain, Fn&& fn) { s_threadPool->ParallelFor(begin, end, grain, std::forward<Fn>(fn)); }
+
+		template <typename Fn> requires std::is_invocable_v<Fn&>
+		static void SubmitWork(Fn&& fn, JobCounter* counter = nullptr)
+		{
+			using WorkType = LambdaQueuedWork<std::remove_cv_t<std::remove_reference_t<Fn>>>;
+			static_assert(alignof(WorkType) <= inner::TaskBlockAllocator::k_blockAlignment);
+			WorkType* work = static_cast<WorkType*>(inner::TaskBlockAllocator::Allocate(sizeof(WorkType)));
+			new(work) WorkType(std::forward<Fn>(fn));
+			s_threadPool->SubmitWork(work, counter);
+		}
 
 		template <typename Fn>
 		static auto Run(Fn&& fn) -> Task<decltype(fn())>
 		{
 			using Ret = decltype(fn());
-			using Func = std::remove_reference_t<Fn>;
-			constexpr bool TRIVIAL = concepts::TrivialEmpty<void()>;
-			using WorkType = WorkInternal<Ret, Func, TRIVIAL>;
-
-			SharedPtr<Future<Ret>> future = MakeShared<Future<Ret>>();
-			WorkType* work = Mem::New<WorkType>(future, std::forward<Fn>(fn));
-			s_threadPool->SubmitWork(work);
-			return Task<Ret>(future);
+			using StateType = inner::RunFuture<Ret, std::remove_cv_t<std::remove_reference_t<Fn>>>;
+			// One reference for the task, one for the pool.
+			StateType* state = inner::FutureBase::Create<StateType>(2, std::forward<Fn>(fn));
+			s_threadPool->SubmitWork(state);
+			return Task<Ret>(state);
+		}
+
+		// Completes when every task has completed.
+		template <typename... Rets>
+		static Task<void> WhenAll(Task<Rets> const&... tasks)
+		{
+			static_assert(sizeof...(Rets) > 0);
+			using StateType = inner::WhenAllFuture<sizeof...(Rets)>;
+			StateType* state = inner::FutureBase::Create<StateType>(2);
+			state->Attach(tasks.m_future...);
+			return Task<void>(state);
+		}
+
+		// Completes with the index of the first task that completes.
+		template <typename... Rets>
+		static Task<uint32_t> WhenAny(Task<Rets> const&... tasks)
+		{
+			static_assert(sizeof...(Rets) > 0);
+			using StateType = inner::WhenAnyFuture<sizeof...(Rets)>;
+			StateType* state = inner::FutureBase::Create<StateType>(2);
+			state->Attach(tasks.m_future...);
+			return Task<uint32_t>(state);
 		}
 	};
 }
\ No newline at end of file
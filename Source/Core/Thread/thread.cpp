@@ -1,11 +1,27 @@
 #include "thread.h"
+#ifdef _WIN32
 #include <Windows.h>
 #undef Yield
+#elif defined(__linux__)
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/futex.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 using namespace glex;
 
 Thread Thread::s_mainThread;
 
+void Thread::FillMainThread()
+{
+	s_mainThread.m_id = GetThreadID();
+}
+
+#ifdef _WIN32
+
 static DWORD __stdcall ThreadProc(LPVOID param)
 {
 	Thread* thread = static_cast<Thread*>(param);
@@ -28,11 +44,6 @@ void Thread::Yield()
 	SwitchToThread();
 }
 
-void Thread::FillMainThread()
-{
-	s_mainThread.m_id = GetThreadID();
-}
-
 void Thread::CreateInternal(ThreadPriority priority)
 {
 	m_handle = reinterpret_cast<uint64_t>(CreateThread(nullptr, 0, ThreadProc, this, CREATE_SUSPENDED, reinterpret_cast<LPDWORD>(&m_id)));
@@ -46,6 +57,20 @@ Thread::~Thread()
 	CloseHandle(reinterpret_cast<HANDLE>(m_handle));
 }
 
+Thread::Thread(Thread&& rhs) : m_handle(rhs.m_handle), m_id(rhs.m_id), m_threadProc(std::move(rhs.m_threadProc))
+{
+	rhs.m_handle = 0;
+}
+
+Thread& Thread::operator=(Thread&& rhs)
+{
+	m_handle = rhs.m_handle;
+	m_id = rhs.m_id;
+	m_threadProc = std::move(rhs.m_threadProc);
+	rhs.m_handle = 0;
+	return *this;
+}
+
 void Thread::Suspend()
 {
 	SuspendThread(reinterpret_cast<HANDLE>(m_handle));
@@ -59,4 +84,108 @@ void Thread::Resume()
 void Thread::Wait()
 {
 	WaitForSingleObject(reinterpret_cast<HANDLE>(m_handle), INFINITE);
-}
\ No newline at end of file
+}
+
+#elif defined(__linux__)
+
+namespace
+{
+	constexpr uint32_t k_suspended = 0;
+	constexpr uint32_t k_running = 1;
+	constexpr uint32_t k_cancelled = 2;	// Destroyed before it was ever resumed.
+	constexpr uint32_t k_joined = 3;
+}
+
+void* Thread::Run(void* param)
+{
+	Thread* thread = static_cast<Thread*>(param);
+	Atomic::Store(&thread->m_id, GetThreadID());
+	Futex::WakeAll(&thread->m_id);
+	uint32_t state;
+	while ((state = Atomic::Load(&thread->m_state)) == k_suspended)
+		Futex::Wait(&thread->m_state, k_suspended);
+	if (state != k_cancelled)
+		thread->m_threadProc();
+	return nullptr;
+}
+
+uint32_t Thread::GetThreadID()
+{
+	return static_cast<uint32_t>(syscall(SYS_gettid));
+}
+
+void Thread::Sleep(uint32_t ms)
+{
+	usleep(ms * 1000);
+}
+
+void Thread::Yield()
+{
+	sched_yield();
+}
+
+// Priorities are left to the scheduler, raising them takes privileges on Linux.
+void Thread::CreateInternal(ThreadPriority priority)
+{
+	m_id = 0;
+	m_state = k_suspended;
+	pthread_t thread;
+	if (pthread_create(&thread, nullptr, Run, this) != 0)
+	{
+		m_handle = 0;
+		return;
+	}
+	m_handle = static_cast<uint64_t>(thread);
+	// The ID is only known on the new thread.
+	while (Atomic::Load(&m_id) == 0)
+		Futex::Wait(&m_id, 0);
+}
+
+Thread::~Thread()
+{
+	if (m_handle == 0)
+		return;
+	pthread_t thread = static_cast<pthread_t>(m_handle);
+	if (Atomic::CompareAndExchange(&m_state, k_suspended, k_cancelled) == k_suspended)
+	{
+		Futex::WakeAll(&m_state);
+		pthread_join(thread, nullptr);
+	}
+	else if (Atomic::Load(&m_state) != k_joined)
+		pthread_detach(thread);
+}
+
+Thread::Thread(Thread&& rhs) : m_handle(rhs.m_handle), m_id(rhs.m_id), m_state(rhs.m_state), m_threadProc(std::move(rhs.m_threadProc))
+{
+	rhs.m_handle = 0;
+}
+
+Thread& Thread::operator=(Thread&& rhs)
+{
+	m_handle = rhs.m_handle;
+	m_id = rhs.m_id;
+	m_state = rhs.m_state;
+	m_threadProc = std::move(rhs.m_threadProc);
+	rhs.m_handle = 0;
+	return *this;
+}
+
+void Thread::Suspend()
+{
+}
+
+void Thread::Resume()
+{
+	if (Atomic::CompareAndExchange(&m_state, k_suspended, k_running) == k_suspended)
+		Futex::WakeAll(&m_state);
+}
+
+void Thread::Wait()
+{
+	if (Atomic::Load(&m_state) == k_joined)
+		return;
+	pthread_join(static_cast<pthread_t>(m_handle), nullptr);
+	Atomic::Store(&m_state, k_joined);
+}
+
+#endif
\ No newline at end of file
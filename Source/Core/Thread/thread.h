@@ -29,9 +29,15 @@ namespace glex
 	private:
 		uint64_t m_handle;
 		uint32_t m_id;
+#ifndef _WIN32
+		uint32_t m_state;	// Pthreads can't be created suspended, they wait on this until resumed.
+#endif
 		Function<void()> m_threadProc;
 
 		void CreateInternal(ThreadPriority priority);
+#ifndef _WIN32
+		static void* Run(void* param);
+#endif
 
 	public:
 		template <typename Fn>
@@ -41,11 +47,12 @@ namespace glex
 		}
 
 		~Thread();
-		Thread(Thread&& rhs) : m_handle(rhs.m_handle), m_id(rhs.m_id), m_threadProc(std::move(rhs.m_threadProc)) { rhs.m_handle = 0; }
-		Thread& operator=(Thread&& rhs) { m_handle = rhs.m_handle; m_id = rhs.m_id; m_threadProc = std::move(rhs.m_threadProc); rhs.m_handle = 0; return *this; }
+		Thread(Thread&& rhs);
+		Thread& operator=(Thread&& rhs);
 		bool IsValid() const { return m_handle != 0; }
 		uint32_t ID() const { return m_id; }
 		Function<void()> const& GetThreadProc() const { return m_threadProc; }
+		// Pthreads can only be held before they're first resumed, it does nothing on a running one.
 		void Suspend();
 		void Resume();
 		void Wait();
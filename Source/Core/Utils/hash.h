@@ -0,0 +1,157 @@
+/**
+ * 64-bit hashing, wyhash for byte ranges plus a multiply-fold mixer for integers and combining.
+ * Everything is constexpr, so strings can be hashed at compile time with HashString or "name"_hash.
+ * Results are the same at compile time and run time, but not across versions of this file, don't store them.
+ */
+#pragma once
+#include "Core/commdefs.h"
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <EASTL/functional.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace glex
+{
+	namespace inner
+	{
+		constexpr uint64_t k_hashSecret[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+		// Full 128-bit product of a and b, low half to a, high half to b.
+		constexpr void HashMultiply(uint64_t& a, uint64_t& b)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			if (!std::is_constant_evaluated())
+			{
+				a = _umul128(a, b, &b);
+				return;
+			}
+			uint64_t aLow = a & 0xffffffff, aHigh = a >> 32, bLow = b & 0xffffffff, bHigh = b >> 32;
+			uint64_t low = aLow * bLow, mid1 = aHigh * bLow, mid2 = aLow * bHigh, high = aHigh * bHigh;
+			uint64_t mid = (low >> 32) + (mid1 & 0xffffffff) + (mid2 & 0xffffffff);
+			a = (mid << 32) | (low & 0xffffffff);
+			b = high + (mid1 >> 32) + (mid2 >> 32) + (mid >> 32);
+#else
+			unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+			a = static_cast<uint64_t>(product);
+			b = static_cast<uint64_t>(product >> 64);
+#endif
+		}
+
+		constexpr uint64_t HashMix(uint64_t a, uint64_t b)
+		{
+			HashMultiply(a, b);
+			return a ^ b;
+		}
+
+		template <typename T>
+		constexpr T HashRead(char const* p)
+		{
+			if (std::is_constant_evaluated())
+			{
+				T value = 0;
+				for (uint32_t i = 0; i < sizeof(T); i++)
+					value |= static_cast<T>(static_cast<uint8_t>(p[i])) << (i * 8);
+				return value;
+			}
+			T value;
+			memcpy(&value, p, sizeof(T));
+			return value;
+		}
+	}
+
+	constexpr uint64_t HashBytes(char const* data, size_t size, uint64_t seed = 0)
+	{
+		using namespace inner;
+		char const* p = data;
+		seed ^= HashMix(seed ^ k_hashSecret[0], k_hashSecret[1]);
+		uint64_t a, b;
+		if (size <= 16) GLEX_LIKELY
+		{
+			if (size >= 4)
+			{
+				size_t offset = (size >> 3) << 2;
+				a = (static_cast<uint64_t>(HashRead<uint32_t>(p)) << 32) | HashRead<uint32_t>(p + offset);
+				b = (static_cast<uint64_t>(HashRead<uint32_t>(p + size - 4)) << 32) | HashRead<uint32_t>(p + size - 4 - offset);
+			}
+			else if (size > 0)
+			{
+				a = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) | (static_cast<uint64_t>(static_cast<uint8_t>(p[size >> 1])) << 8) | static_cast<uint8_t>(p[size - 1]);
+				b = 0;
+			}
+			else
+				a = b = 0;
+		}
+		else
+		{
+			size_t left = size;
+			if (left >= 48)
+			{
+				// Three independent lanes so the multiplies overlap.
+				uint64_t seed1 = seed, seed2 = seed;
+				do
+				{
+					seed = HashMix(HashRead<uint64_t>(p) ^ k_hashSecret[1], HashRead<uint64_t>(p + 8) ^ seed);
+					seed1 = HashMix(HashRead<uint64_t>(p + 16) ^ k_hashSecret[2], HashRead<uint64_t>(p + 24) ^ seed1);
+					seed2 = HashMix(HashRead<uint64_t>(p + 32) ^ k_hashSecret[3], HashRead<uint64_t>(p + 40) ^ seed2);
+					p += 48;
+					left -= 48;
+				}
+				while (left >= 48);
+				seed ^= seed1 ^ seed2;
+			}
+			while (left > 16)
+			{
+				seed = HashMix(HashRead<uint64_t>(p) ^ k_hashSecret[1], HashRead<uint64_t>(p + 8) ^ seed);
+				p += 16;
+				left -= 16;
+			}
+			a = HashRead<uint64_t>(p + left - 16);
+			b = HashRead<uint64_t>(p + left - 8);
+		}
+		a ^= k_hashSecret[1];
+		b ^= seed;
+		HashMultiply(a, b);
+		return HashMix(a ^ k_hashSecret[0] ^ size, b ^ k_hashSecret[1]);
+	}
+
+	inline uint64_t HashBytes(void const* data, size_t size, uint64_t seed = 0)
+	{
+		return HashBytes(static_cast<char const*>(data), size, seed);
+	}
+
+	constexpr uint64_t HashString(char const* string)
+	{
+		return HashBytes(string, std::char_traits<char>::length(string));
+	}
+
+	// For integers and pointers, every bit of the input affects every bit of the result.
+	constexpr uint64_t HashInt(uint64_t value)
+	{
+		uint64_t a = value ^ inner::k_hashSecret[0], b = inner::k_hashSecret[1];
+		inner::HashMultiply(a, b);
+		return inner::HashMix(a ^ inner::k_hashSecret[0], b ^ inner::k_hashSecret[1]);
+	}
+
+	// Order matters, combining a then b differs from b then a.
+	constexpr uint64_t HashCombine(uint64_t seed, uint64_t value)
+	{
+		return inner::HashMix(seed ^ inner::k_hashSecret[2], value ^ inner::k_hashSecret[1]);
+	}
+
+	// Combines the eastl::hash of every argument, for keys made of several fields.
+	template <typename... Ts>
+	uint64_t HashValues(Ts const&... values)
+	{
+		uint64_t hash = inner::k_hashSecret[3];
+		((hash = HashCombine(hash, eastl::hash<Ts>()(values))), ...);
+		return hash;
+	}
+
+	consteval uint64_t operator""_hash(char const* string, size_t size)
+	{
+		return HashBytes(string, size);
+	}
+}
\ No newline at end of file
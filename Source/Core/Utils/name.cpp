@@ -0,0 +1,108 @@
+#include "Core/Utils/name.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/thread.h"
+#include "Core/assert.h"
+#include "Core/log.h"
+
+using namespace glex;
+
+namespace
+{
+	constexpr uint32_t k_numSlots = Name::k_maxNames * 2;
+	// Offset of a name whose string didn't fit.
+	constexpr uint32_t k_noString = UINT32_MAX;
+
+	// A slot is taken by a CAS on its ID, then its string offset is published. Zero means empty or not yet published.
+	uint64_t s_ids[k_numSlots];
+	uint32_t s_offsets[k_numSlots];
+	char s_strings[Name::k_maxStringBytes];
+	// Offset zero holds the empty string.
+	uint32_t s_stringBytes = 1;
+	uint32_t s_numNames = 0;
+	uint8_t s_reportedFull = 0;
+}
+
+static uint32_t WaitForOffset(uint32_t index)
+{
+	uint32_t offset;
+	while ((offset = Atomic::Load(&s_offsets[index])) == 0)
+		Thread::Yield();
+	return offset;
+}
+
+static void ReportFull(char const* string, size_t size)
+{
+	if (Atomic::Exchange(&s_reportedFull, static_cast<uint8_t>(1)) == 0)
+		Logger::Error("Out of room for names (%u names, %u bytes at most), %.*s and later names have no string.",
+			Name::k_maxNames, Name::k_maxStringBytes, static_cast<int>(size), string);
+}
+
+uint64_t Name::Intern(char const* string, size_t size)
+{
+	uint64_t id = Id(string, size);
+	if (id == 0)
+		return 0;
+	uint32_t index = static_cast<uint32_t>(id) & (k_numSlots - 1);
+	for (uint32_t i = 0; i < k_numSlots;)
+	{
+		uint64_t slotId = Atomic::Load(&s_ids[index]);
+		if (slotId == 0)
+		{
+			// Keeps at least half the slots empty, so probing stays short and always ends.
+			if (Atomic::Load(&s_numNames) >= k_maxNames)
+			{
+				ReportFull(string, size);
+				return id;
+			}
+			// On failure somebody took the slot, look at it again.
+			if (Atomic::CompareAndExchange(&s_ids[index], static_cast<uint64_t>(0), id) != 0)
+				continue;
+			Atomic::Increment(&s_numNames);
+			uint32_t offset = Atomic::Add(&s_stringBytes, static_cast<uint32_t>(size + 1));
+			if (offset + size + 1 > k_maxStringBytes)
+			{
+				ReportFull(string, size);
+				offset = k_noString;
+			}
+			else
+			{
+				memcpy(s_strings + offset, string, size);
+				s_strings[offset + size] = '\0';
+			}
+			Atomic::Store(&s_offsets[index], offset);
+			return id;
+		}
+		if (slotId == id)
+		{
+#if GLEX_DEBUG || GLEX_TEST
+			uint32_t offset = WaitForOffset(index);
+			GLEX_DEBUG_ASSERT_MSG(offset == k_noString || (memcmp(s_strings + offset, string, size) == 0 && s_strings[offset + size] == '\0'),
+				"Two names have the same 64-bit ID.");
+#endif
+			return id;
+		}
+		index = (index + 1) & (k_numSlots - 1);
+		i++;
+	}
+	ReportFull(string, size);
+	return id;
+}
+
+char const* Name::ToString() const
+{
+	if (m_id == 0)
+		return "";
+	uint32_t index = static_cast<uint32_t>(m_id) & (k_numSlots - 1);
+	for (uint32_t i = 0; i < k_numSlots; i++, index = (index + 1) & (k_numSlots - 1))
+	{
+		uint64_t slotId = Atomic::Load(&s_ids[index]);
+		if (slotId == 0)
+			break;
+		if (slotId == m_id)
+		{
+			uint32_t offset = WaitForOffset(index);
+			return offset != k_noString ? s_strings + offset : "<unknown name>";
+		}
+	}
+	return "<unknown name>";
+}
\ No newline at end of file
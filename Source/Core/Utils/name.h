@@ -0,0 +1,61 @@
+/**
+ * Interned strings. A Name is the 64-bit hash of its string, so comparing and hashing names is an integer
+ * operation, and "albedo"_name is resolved at compile time.
+ * Strings are interned into a global lock-free table that lives until exit, so names are for identifiers
+ * the code and its assets define, not for user data such as resource paths. Once the table is full, new
+ * names still compare correctly but have no string.
+ */
+#pragma once
+#include "Core/Container/basic.h"
+#include "Core/Utils/hash.h"
+
+namespace glex
+{
+	class Name
+	{
+	private:
+		uint64_t m_id;
+
+		static uint64_t Intern(char const* string, size_t size);
+
+	public:
+		// Names take up to that many bytes in total, IDs are spread over twice as many slots as names.
+		constexpr static uint32_t k_maxNames = 32768;
+		constexpr static uint32_t k_maxStringBytes = 4_mib;
+
+		static constexpr uint64_t Id(char const* string, size_t size)
+		{
+			if (size == 0)
+				return 0;
+			uint64_t id = HashBytes(string, size);
+			return id != 0 ? id : 1;
+		}
+
+		constexpr Name() : m_id(0) {}
+		// Implicit, so code passing strings keeps working. Hot paths should keep a Name or use "..."_name.
+		Name(char const* string) : m_id(Intern(string, strlen(string))) {}
+		Name(StringView string) : m_id(Intern(string.data(), string.size())) {}
+		static constexpr Name FromId(uint64_t id) { Name name; name.m_id = id; return name; }
+
+		constexpr uint64_t GetId() const { return m_id; }
+		constexpr bool IsNone() const { return m_id == 0; }
+		// "" for the empty name. A name whose string was never interned, or didn't fit, gives "<unknown name>".
+		char const* ToString() const;
+		constexpr bool operator==(Name const& rhs) const = default;
+	};
+
+	consteval Name operator""_name(char const* string, size_t size)
+	{
+		return Name::FromId(Name::Id(string, size));
+	}
+}
+
+template <>
+class eastl::hash<glex::Name>
+{
+public:
+	size_t operator()(glex::Name name) const
+	{
+		return static_cast<size_t>(name.GetId());
+	}
+};
\ No newline at end of file
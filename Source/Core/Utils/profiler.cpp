@@ -0,0 +1,295 @@
+#include "Core/Utils/profiler.h"
+#include "Core/Thread/thread.h"
+#include "Core/Thread/lock.h"
+#include "Core/Platform/filesync.h"
+#include "Core/Container/basic.h"
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+using namespace glex;
+using namespace glex::inner;
+
+namespace
+{
+	struct ThreadHolder
+	{
+		ProfileThread* thread = nullptr;
+		~ThreadHolder();
+	};
+
+	struct ThreadCapture
+	{
+		uint32_t threadId;
+		char name[32];
+		Vector<ProfileSpan> spans;
+	};
+
+	Mutex s_registryLock;
+	ProfileThread* s_threads = nullptr;
+	uint32_t s_numRetired = 0;
+
+	// Start of each frame, written by the main thread.
+	uint64_t s_frames[Profiler::k_maxFrames];
+	uint64_t s_frameCount = 0;
+	uint64_t const s_startTicks = Time::Ticks();
+
+	// Never retired. The ID is one no thread gets.
+	ProfileThread* s_gpuTrack = nullptr;
+	constexpr uint32_t k_gpuTrackId = UINT32_MAX;
+}
+
+static thread_local ThreadHolder t_holder;
+
+// The spans stay around for exports until they fall out of the frame window.
+ThreadHolder::~ThreadHolder()
+{
+	if (thread == nullptr)
+		return;
+	Atomic::Store(&thread->retired, 1u);
+	Atomic::Increment(&s_numRetired);
+	thread = nullptr;
+}
+
+static void FreeThread(ProfileThread* thread)
+{
+	if (thread->prev != nullptr)
+		thread->prev->next = thread->next;
+	else
+		s_threads = thread->next;
+	if (thread->next != nullptr)
+		thread->next->prev = thread->prev;
+	Mem::Free(thread->spans);
+	Mem::Delete(thread);
+}
+
+ProfileThread* Profiler::RegisterThread()
+{
+	ProfileThread* thread = Mem::New<ProfileThread>();
+	thread->threadId = Thread::GetThreadID();
+	thread->spans = Mem::Alloc<ProfileSpan>(k_spansPerThread, MemoryTag::General);
+	snprintf(thread->name, sizeof(thread->name), "Thread %u", thread->threadId);
+	ScopedLock lock(s_registryLock);
+	thread->next = s_threads;
+	if (s_threads != nullptr)
+		s_threads->prev = thread;
+	s_threads = thread;
+	t_holder.thread = thread;
+	t_thread = thread;
+	return thread;
+}
+
+void Profiler::SetThreadName(char const* name)
+{
+	ProfileThread* thread = t_thread != nullptr ? t_thread : RegisterThread();
+	ScopedLock lock(s_registryLock);
+	snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+static uint64_t WindowStart(uint32_t numFrames)
+{
+	uint64_t frameCount = Atomic::Load(&s_frameCount);
+	uint64_t numKept = Min(frameCount, static_cast<uint64_t>(Profiler::k_maxFrames));
+	if (numFrames == 0 || numFrames >= numKept)
+		return numKept == 0 ? 0 : s_frames[(frameCount - numKept) % Profiler::k_maxFrames];
+	return s_frames[(frameCount - numFrames) % Profiler::k_maxFrames];
+}
+
+void Profiler::MarkFrame()
+{
+	uint64_t frameCount = s_frameCount;
+	s_frames[frameCount % k_maxFrames] = Time::Ticks();
+	Atomic::Store(&s_frameCount, frameCount + 1);
+	if (Atomic::Load(&s_numRetired) == 0)
+		return;
+	// Exited threads go once their newest span is older than every frame kept.
+	uint64_t windowStart = WindowStart(0);
+	ScopedLock lock(s_registryLock);
+	for (ProfileThread* thread = s_threads; thread != nullptr;)
+	{
+		ProfileThread* next = thread->next;
+		if (Atomic::Load(&thread->retired))
+		{
+			uint64_t head = Atomic::Load(&thread->head);
+			if (head == 0 || thread->spans[(head - 1) & (k_spansPerThread - 1)].end < windowStart)
+			{
+				FreeThread(thread);
+				Atomic::Decrement(&s_numRetired);
+			}
+		}
+		thread = next;
+	}
+}
+
+uint64_t Profiler::FrameCount()
+{
+	return Atomic::Load(&s_frameCount);
+}
+
+void Profiler::AddGpuSpan(char const* name, uint64_t begin, uint64_t end)
+{
+	if (s_gpuTrack == nullptr) GLEX_UNLIKELY
+	{
+		ProfileThread* track = Mem::New<ProfileThread>();
+		track->threadId = k_gpuTrackId;
+		track->spans = Mem::Alloc<ProfileSpan>(k_spansPerThread, MemoryTag::General);
+		snprintf(track->name, sizeof(track->name), "GPU");
+		ScopedLock lock(s_registryLock);
+		track->next = s_threads;
+		if (s_threads != nullptr)
+			s_threads->prev = track;
+		s_threads = track;
+		s_gpuTrack = track;
+	}
+	uint64_t head = s_gpuTrack->head;
+	ProfileSpan& span = s_gpuTrack->spans[head & (k_spansPerThread - 1)];
+	span.begin = begin;
+	span.end = end;
+	span.name = name;
+	Atomic::Store(&s_gpuTrack->head, head + 1);
+}
+
+// Copies the spans of every thread ending after the window start. Slots the owner may have overwritten while
+// they were copied are thrown away.
+static void Capture(uint64_t windowStart, Vector<ThreadCapture>& captures)
+{
+	constexpr uint64_t k_capacity = Profiler::k_spansPerThread;
+	ScopedLock lock(s_registryLock);
+	for (ProfileThread* thread = s_threads; thread != nullptr; thread = thread->next)
+	{
+		ThreadCapture& capture = captures.emplace_back();
+		capture.threadId = thread->threadId;
+		memcpy(capture.name, thread->name, sizeof(capture.name));
+		uint64_t head = Atomic::Load(&thread->head);
+		uint64_t first = head > k_capacity ? head - k_capacity : 0;
+		for (uint64_t i = first; i < head; i++)
+			capture.spans.push_back(thread->spans[i & (k_capacity - 1)]);
+		Atomic::FullBarrier();
+		uint64_t newHead = Atomic::Load(&thread->head);
+		uint64_t numTorn = newHead > first + k_capacity - 1 ? Min(newHead - (first + k_capacity - 1), head - first) : 0;
+		capture.spans.erase(capture.spans.begin(), capture.spans.begin() + numTorn);
+		capture.spans.erase(eastl::remove_if(capture.spans.begin(), capture.spans.end(), [windowStart](ProfileSpan const& span) { return span.end < windowStart; }), capture.spans.end());
+		// Parents before children.
+		eastl::sort(capture.spans.begin(), capture.spans.end(), [](ProfileSpan const& lhs, ProfileSpan const& rhs)
+		{
+			return lhs.begin != rhs.begin ? lhs.begin < rhs.begin : lhs.end > rhs.end;
+		});
+	}
+}
+
+static bool WriteFile(char const* path, String const& content)
+{
+	FileSync file(path, FileAccess::Write, FileOpen::CreateOrOverwrite);
+	if (file == nullptr)
+		return false;
+	// WriteString would put a length in front.
+	return file.Write(content.data(), content.size()) == content.size();
+}
+
+template <typename... Args>
+static void Append(String& out, char const* format, Args... args)
+{
+	char buffer[256];
+	int32_t length = snprintf(buffer, sizeof(buffer), format, args...);
+	if (length > 0)
+		out.append(buffer, Min(static_cast<uint32_t>(length), static_cast<uint32_t>(sizeof(buffer) - 1)));
+}
+
+static void AppendJsonString(String& out, char const* string)
+{
+	out.push_back('"');
+	for (char const* p = string; *p != '\0'; p++)
+	{
+		if (*p == '"' || *p == '\\')
+			out.push_back('\\');
+		if (static_cast<uint8_t>(*p) >= 0x20)
+			out.push_back(*p);
+	}
+	out.push_back('"');
+}
+
+bool Profiler::ExportChromeTrace(char const* path, uint32_t numFrames)
+{
+	uint64_t windowStart = WindowStart(numFrames);
+	Vector<ThreadCapture> captures;
+	Capture(windowStart, captures);
+	double microsecondsPerTick = 1e6 / Time::TicksPerSecond();
+	String out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (ThreadCapture const& capture : captures)
+	{
+		Append(out, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", capture.threadId);
+		AppendJsonString(out, capture.name);
+		out.append("}},\n");
+	}
+	uint64_t frameCount = Atomic::Load(&s_frameCount);
+	for (uint64_t frame = frameCount > k_maxFrames ? frameCount - k_maxFrames : 0; frame < frameCount; frame++)
+	{
+		uint64_t ticks = s_frames[frame % k_maxFrames];
+		if (ticks >= windowStart)
+			Append(out, "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"Frame %llu\",\"pid\":0,\"tid\":0,\"ts\":%.3f},\n", frame, (ticks - s_startTicks) * microsecondsPerTick);
+	}
+	for (ThreadCapture const& capture : captures)
+	{
+		for (ProfileSpan const& span : capture.spans)
+		{
+			out.append("{\"ph\":\"X\",\"name\":");
+			AppendJsonString(out, span.name);
+			Append(out, ",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", capture.threadId, (span.begin - s_startTicks) * microsecondsPerTick, (span.end - span.begin) * microsecondsPerTick);
+		}
+	}
+	// No trailing comma in JSON.
+	if (out.back() == '\n' && out[out.size() - 2] == ',')
+		out.erase(out.size() - 2, 1);
+	out.append("]}\n");
+	return WriteFile(path, out);
+}
+
+bool Profiler::ExportFlameGraph(char const* path, uint32_t numFrames)
+{
+	Vector<ThreadCapture> captures;
+	Capture(WindowStart(numFrames), captures);
+	// Self time of every path in ticks: a span adds its duration to its own path and takes it off its parent's.
+	HashMap<String, int64_t, StringHasher> selfTimes;
+	Vector<ProfileSpan const*> stack;
+	Vector<uint32_t> pathLengths;
+	String stackPath;
+	for (ThreadCapture const& capture : captures)
+	{
+		stack.clear();
+		pathLengths.clear();
+		stackPath = capture.name;
+		for (char& c : stackPath)
+		{
+			if (c == ';' || c == ' ')
+				c = '_';
+		}
+		uint32_t rootLength = stackPath.size();
+		for (ProfileSpan const& span : capture.spans)
+		{
+			while (!stack.empty() && stack.back()->end <= span.begin)
+			{
+				stack.pop_back();
+				pathLengths.pop_back();
+			}
+			int64_t duration = span.end - span.begin;
+			if (!stack.empty())
+				selfTimes[stackPath.substr(0, pathLengths.back())] -= duration;
+			stackPath.resize(stack.empty() ? rootLength : pathLengths.back());
+			stackPath.push_back(';');
+			stackPath.append(span.name);
+			stack.push_back(&span);
+			pathLengths.push_back(stackPath.size());
+			selfTimes[stackPath] += duration;
+		}
+	}
+	double microsecondsPerTick = 1e6 / Time::TicksPerSecond();
+	String out;
+	for (auto const& [line, ticks] : selfTimes)
+	{
+		uint64_t microseconds = static_cast<uint64_t>(Max(ticks, static_cast<int64_t>(0)) * microsecondsPerTick);
+		if (microseconds == 0)
+			continue;
+		out.append(line);
+		Append(out, " %llu\n", microseconds);
+	}
+	return WriteFile(path, out);
+}
\ No newline at end of file
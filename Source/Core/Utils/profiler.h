@@ -0,0 +1,120 @@
+/**
+ * Hierarchical CPU profiler. GLEX_PROFILE_SCOPE measures the enclosing scope with TSC timestamps and writes
+ * one span into a ring owned by the calling thread when the scope ends, no locks involved.
+ * Frame markers keep the start of the last k_maxFrames frames, exports cover spans from a number of recent frames
+ * as long as their threads' rings haven't wrapped around past them.
+ * Names must be literals, only the pointers are kept.
+ * GPU spans go into a track of their own, which exports show next to the threads.
+ */
+#pragma once
+#include "config.h"
+#include "Core/commdefs.h"
+#include "Core/Platform/time.h"
+#include "Core/Thread/atomic.h"
+
+namespace glex
+{
+	namespace inner
+	{
+		struct ProfileSpan
+		{
+			uint64_t begin;
+			uint64_t end;
+			char const* name;
+		};
+
+		// Spans are written by the owner only, head is published after each one.
+		struct ProfileThread
+		{
+			uint64_t head = 0;
+			uint32_t threadId;
+			uint32_t retired = 0;
+			ProfileSpan* spans;
+			ProfileThread* prev = nullptr;
+			ProfileThread* next = nullptr;
+			char name[32];
+		};
+	}
+
+	class Profiler : private StaticClass
+	{
+	public:
+		constexpr static uint32_t k_spansPerThread = 32768;	// 768 KB per thread.
+		constexpr static uint32_t k_maxFrames = 128;
+
+	private:
+		inline static bool s_enabled = true;
+		inline static thread_local inner::ProfileThread* t_thread = nullptr;
+
+		static inner::ProfileThread* RegisterThread();
+
+	public:
+		static bool IsEnabled() { return Atomic::Load(&s_enabled); }
+		static void SetEnabled(bool enabled) { Atomic::Store(&s_enabled, enabled); }
+		// Shows up in exports instead of the thread ID.
+		static void SetThreadName(char const* name);
+		// Called once per frame by the main thread.
+		static void MarkFrame();
+		static uint64_t FrameCount();
+		// In TSC ticks, converted from GPU timestamps by the caller. Called by the render thread only.
+		static void AddGpuSpan(char const* name, uint64_t begin, uint64_t end);
+
+		// Spans of the last numFrames frames and the current one, zero means all frames kept. False if the file can't be written.
+		static bool ExportChromeTrace(char const* path, uint32_t numFrames = 0);
+		// Collapsed stacks, one line per call path with its self time in microseconds.
+		static bool ExportFlameGraph(char const* path, uint32_t numFrames = 0);
+
+		// Registers the thread on its first scope.
+		static void Enter()
+		{
+			if (t_thread == nullptr) GLEX_UNLIKELY
+				RegisterThread();
+		}
+
+		static void Leave(char const* name, uint64_t begin)
+		{
+			inner::ProfileThread* thread = t_thread;
+			uint64_t head = thread->head;
+			inner::ProfileSpan& span = thread->spans[head & (k_spansPerThread - 1)];
+			span.begin = begin;
+			span.end = Time::Ticks();
+			span.name = name;
+			Atomic::Store(&thread->head, head + 1);
+		}
+	};
+
+	class ProfileScope : private Uncopyable
+	{
+	private:
+		char const* m_name;
+		uint64_t m_begin = 0;
+
+	public:
+		ProfileScope(char const* name) : m_name(name)
+		{
+			if (Profiler::IsEnabled())
+			{
+				Profiler::Enter();
+				m_begin = Time::Ticks();
+			}
+		}
+
+		~ProfileScope()
+		{
+			if (m_begin != 0)
+				Profiler::Leave(m_name, m_begin);
+		}
+	};
+}
+
+#if GLEX_ENABLE_PROFILER
+#define GLEX_PROFILE_CONCAT_INNER(a, b) a##b
+#define GLEX_PROFILE_CONCAT(a, b) GLEX_PROFILE_CONCAT_INNER(a, b)
+#define GLEX_PROFILE_SCOPE(name) ::glex::ProfileScope GLEX_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define GLEX_PROFILE_FRAME() ::glex::Profiler::MarkFrame()
+#define GLEX_PROFILE_THREAD(name) ::glex::Profiler::SetThreadName(name)
+#else
+#define GLEX_PROFILE_SCOPE(name)
+#define GLEX_PROFILE_FRAME()
+#define GLEX_PROFILE_THREAD(name)
+#endif
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "Core/Utils/string.h"
 #include <algorithm>
-#include <Windows.h>
+#include <stdarg.h>
+#include <math.h>
+#include <float.h>
+#include <ctype.h>
+#include <wchar.h>
 
 using namespace glex;
 
@@ -58,13 +62,18 @@ char* StringUtils::FormatAutoExpand(char* buffer, uint32_t size, char const* for
 
 char* StringUtils::FormatAutoExpand(char* buffer, uint32_t size, char const* format, va_list ap)
 {
+	// The first pass consumes the arguments, the second one needs its own copy.
+	va_list retryAp;
+	va_copy(retryAp, ap);
 	int32_t length = vsnprintf(buffer, size, format, ap);
-	if (length < 0)
-		return nullptr;
-	if (length < size)
-		return buffer;
+	if (length < 0 || length < size)
+	{
+		va_end(retryAp);
+		return length < 0 ? nullptr : buffer;
+	}
 	char* largerBuffer = Mem::Alloc<char>(length + 1);
-	length = vsnprintf(largerBuffer, length + 1, format, ap);
+	length = vsnprintf(largerBuffer, length + 1, format, retryAp);
+	va_end(retryAp);
 	if (length >= 0)
 		return largerBuffer;
 	Mem::Free(largerBuffer);
@@ -95,7 +104,7 @@ Utf8Code StringUtils::CodeOfUtf8(char const* utf8Char)
 		char b1 = utf8Char[1];
 		char b2 = utf8Char[2];
 		char b3 = utf8Char[3];
-		return { static_cast<uint32_t>(b0 & 0x70) << 18 | (b1 & 0x3f) << 12 | (b2 & 0x3f) << 6 | (b3 & 0x3f), 4 };
+		return { static_cast<uint32_t>(b0 & 0x07) << 18 | (b1 & 0x3f) << 12 | (b2 & 0x3f) << 6 | (b3 & 0x3f), 4 };
 	}
 	return { 0, 0 };
 }
@@ -147,9 +156,9 @@ Utf8Char StringUtils::Utf8OfCode(uint32_t code)
 			static_cast<char>(0x80 | code >> 6 & 0x3f),
 			static_cast<char>(0x80 | code & 0x3f), 0 }, 3 };
 	}
-	if (code < 0x200000)
+	if (code < 0x110000)
 	{
-		return { { static_cast<char>(0xe0 | code >> 18),
+		return { { static_cast<char>(0xf0 | code >> 18),
 			static_cast<char>(0x80 | code >> 12 & 0x3f),
 			static_cast<char>(0x80 | code >> 6 & 0x3f),
 			static_cast<char>(0x80 | code & 0x3f) }, 4 };
@@ -157,115 +166,127 @@ Utf8Char StringUtils::Utf8OfCode(uint32_t code)
 	return { 0, 0 };
 }
 
-static uint32_t LengthOfUtf8Char(char const* utf8Char)
+bool StringUtils::IsValidUtf8(char const* string)
 {
-	char b0 = utf8Char[0];
-	if ((b0 & 0x80) == 0)    // ASCII.
-		return 1;
-	if ((b0 & 0xe0) == 0xc0) // 2 bytes.
-	{
-		char const& b1 = utf8Char[1];
-		if ((b1 & 0xc0) != 0x80)
-			return 0;
-		return 2;
-	}
-	if ((b0 & 0xf0) == 0xe0) // 3 bytes.
-	{
-		char const& b1 = utf8Char[1];
-		char const& b2 = utf8Char[2];
-		if ((b1 & 0xc0) != 0x80 || (b2 & 0xc0) != 0x80)
-			return 0;
-		return 3;
-	}
-	if ((b0 & 0xf8) == 0xf0) // 4 bytes.
-	{
-		char const& b1 = utf8Char[1];
-		char const& b2 = utf8Char[2];
-		char const& b3 = utf8Char[3];
-		if ((b1 & 0xc0) != 0x80 || (b2 & 0xc0) != 0x80 || (b3 & 0xc0) != 0x80)
-			return 0;
-		return 4;
-	}
-	return 0;
+	return IsValidUtf8(string, strlen(string));
 }
 
-bool StringUtils::IsValidUtf8(char const* string)
+/*
+		CODE CONVERTER
+*/
+// Units of the UTF-16 form, UINT32_MAX if the string is invalid.
+static uint32_t Utf16LengthOf(char const* string, uint32_t length)
+{
+	return StringUtils::IsValidUtf8(string, length) ? StringUtils::Utf16LengthOfUtf8(string, length) : UINT32_MAX;
+}
+
+// Bytes of the UTF-8 form. Unpaired surrogates are left to the conversion.
+static uint32_t Utf8LengthOf(wchar_t const* string, uint32_t length)
 {
-	while (*string != 0)
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < length; i++)
 	{
-		uint32_t charLength = LengthOfUtf8Char(string);
-		if (charLength == 0)
-			return false;
-		string += charLength;
+		uint32_t code = string[i];
+		if (code < 0x80)
+			result += 1;
+		else if (code < 0x800)
+			result += 2;
+		else if (code - 0xd800 < 0x400) // High surrogate, the pair takes 4.
+			result += 1;
+		else
+			result += 3;
 	}
-	return true;
+	return result;
+}
+
+// wcslen assumes the C library's wchar_t, which isn't ours when building with -fshort-wchar.
+static uint32_t WideLengthOf(wchar_t const* string)
+{
+	wchar_t const* end = string;
+	while (*end != 0)
+		end++;
+	return end - string;
 }
 
-/*
-		CODE CONVERTER
-*/
 Nullable<WideString> StringUtils::Utf16Of(char const* str)
 {
-	int count = MultiByteToWideChar(CP_UTF8, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS, str, -1, nullptr, 0);
-	if (count == 0)
+	uint32_t length = strlen(str);
+	WideString result(length, 0);
+	uint32_t count = ConvertUtf8ToUtf16(str, length, result.data());
+	if (count == UINT32_MAX)
 		return nullptr;
-	WideString result(count - 1, 0);
-	int ret = MultiByteToWideChar(CP_UTF8, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS, str, -1, result.data(), count);
-	return ret != 0 ? result : nullptr;
+	result.resize(count);
+	return result;
 }
 
 Nullable<String> StringUtils::Utf8Of(wchar_t const* str)
 {
-	int count = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, str, -1, nullptr, 0, nullptr, nullptr);
-	if (count == 0)
+	uint32_t length = WideLengthOf(str);
+	String result(length * 3, 0);
+	uint32_t count = ConvertUtf16ToUtf8(str, length, result.data());
+	if (count == UINT32_MAX)
 		return nullptr;
-	String result(count - 1, 0);
-	int ret = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, str, -1, result.data(), count, nullptr, nullptr);
-	return ret != 0 ? result : nullptr;
+	result.resize(count);
+	return result;
 }
 
 wchar_t const* StringUtils::Utf16Of(wchar_t* buffer, uint32_t size, char const* string)
 {
-	int ret = MultiByteToWideChar(CP_UTF8, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS, string, -1, buffer, size);
-	return ret != 0 ? buffer : nullptr;
+	// Never more units than bytes, the exact length only matters when the buffer is short.
+	uint32_t length = strlen(string);
+	if (length >= size && Utf16LengthOf(string, length) >= size)
+		return nullptr;
+	uint32_t count = ConvertUtf8ToUtf16(string, length, buffer);
+	if (count == UINT32_MAX)
+		return nullptr;
+	buffer[count] = 0;
+	return buffer;
 }
 
 char const* StringUtils::Utf8Of(char* buffer, uint32_t size, wchar_t const* string)
 {
-	int ret = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, string, -1, buffer, size, nullptr, nullptr);
-	return ret != 0 ? buffer : nullptr;
+	uint32_t length = WideLengthOf(string);
+	if (length * 3 >= size && Utf8LengthOf(string, length) >= size)
+		return nullptr;
+	uint32_t count = ConvertUtf16ToUtf8(string, length, buffer);
+	if (count == UINT32_MAX)
+		return nullptr;
+	buffer[count] = 0;
+	return buffer;
 }
 
 wchar_t* StringUtils::Utf16OfAutoExpand(wchar_t* buffer, uint32_t size, char const* string)
 {
-	int count = MultiByteToWideChar(CP_UTF8, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS, string, -1, nullptr, 0);
-	if (count <= size)
+	uint32_t length = strlen(string);
+	uint32_t count = length < size ? length : Utf16LengthOf(string, length);
+	if (count == UINT32_MAX)
+		return nullptr;
+	wchar_t* result = count < size ? buffer : Mem::Alloc<wchar_t>(count + 1);
+	count = ConvertUtf8ToUtf16(string, length, result);
+	if (count == UINT32_MAX)
 	{
-		int ret = MultiByteToWideChar(CP_UTF8, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS, string, -1, buffer, size);
-		return ret != 0 ? buffer : nullptr;
+		if (result != buffer)
+			Mem::Free(result);
+		return nullptr;
 	}
-	wchar_t* largerBuffer = Mem::Alloc<wchar_t>(count);
-	int ret = MultiByteToWideChar(CP_UTF8, MB_PRECOMPOSED | MB_ERR_INVALID_CHARS, string, -1, largerBuffer, count);
-	if (ret != 0)
-		return largerBuffer;
-	Mem::Free(largerBuffer);
-	return nullptr;
+	result[count] = 0;
+	return result;
 }
 
 char* StringUtils::Utf8OfAutoExpand(char* buffer, uint32_t size, wchar_t const* string)
 {
-	int count = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, string, -1, nullptr, 0, nullptr, nullptr);
-	if (count <= size)
+	uint32_t length = WideLengthOf(string);
+	uint32_t count = length * 3 < size ? length * 3 : Utf8LengthOf(string, length);
+	char* result = count < size ? buffer : Mem::Alloc<char>(count + 1);
+	count = ConvertUtf16ToUtf8(string, length, result);
+	if (count == UINT32_MAX)
 	{
-		int ret = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, string, -1, buffer, size, nullptr, nullptr);
-		return ret != 0 ? buffer : nullptr;
+		if (result != buffer)
+			Mem::Free(result);
+		return nullptr;
 	}
-	char* largerBuffer = Mem::Alloc<char>(count);
-	int ret = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, string, -1, largerBuffer, count, nullptr, nullptr);
-	if (ret != 0)
-		return largerBuffer;
-	Mem::Free(largerBuffer);
-	return nullptr;
+	result[count] = 0;
+	return result;
 }
 
 /*
@@ -2,6 +2,7 @@
 #include "Core/commdefs.h"
 #include "Core/Container/basic.h"
 #include "Core/Container/nullable.h"
+#include <stdarg.h>
 
 namespace glex
 {
@@ -33,8 +34,9 @@ namespace glex
 		{
 			va_list ap;
 			va_start(ap, format);
-			Format(buffer, SIZE, ap);
+			char const* result = Format(buffer, SIZE, format, ap);
 			va_end(ap);
+			return result;
 		}
 
 		template <uint32_t SIZE>
@@ -42,8 +44,9 @@ namespace glex
 		{
 			va_list ap;
 			va_start(ap, format);
-			FormatAutoExpand(buffer, SIZE, ap);
+			char* result = FormatAutoExpand(buffer, SIZE, format, ap);
 			va_end(ap);
+			return result;
 		}
 
 		// UTF-8 reader
@@ -52,6 +55,14 @@ namespace glex
 		static Utf8Char Utf8OfCode(uint32_t code);
 		static bool IsValidUtf8(char const* string);
 
+		// Bulk UTF-8, vectorized where the CPU allows.
+		static bool IsValidUtf8(char const* string, uint32_t length);
+		static uint32_t CountUtf8(char const* string, uint32_t length); // Code points. String must be valid.
+		static uint32_t Utf16LengthOfUtf8(char const* string, uint32_t length); // String must be valid.
+		static uint32_t DecodeUtf8(char const* string, uint32_t length, uint32_t* outCodes); // Stops at the first invalid character. Return value: number of codes.
+		static uint32_t ConvertUtf8ToUtf16(char const* string, uint32_t length, wchar_t* outString); // Not null-terminated. Output needs Utf16LengthOfUtf8 units, length always does. Return value: length. UINT32_MAX on error.
+		static uint32_t ConvertUtf16ToUtf8(wchar_t const* string, uint32_t length, char* outString); // Not null-terminated. Output needs 3 * length bytes. Return value: length. UINT32_MAX on error.
+
 		// Code coverter
 		static Nullable<WideString> Utf16Of(char const* string);
 		static Nullable<String> Utf8Of(wchar_t const* string);
@@ -75,13 +86,13 @@ namespace glex
 		template <uint32_t SIZE>
 		static wchar_t* Utf16OfAutoExpand(wchar_t(&buffer)[SIZE], char const* string)
 		{
-			return Utf16OfAutoExpand(buffer, size, string);
+			return Utf16OfAutoExpand(buffer, SIZE, string);
 		}
 
 		template <uint32_t SIZE>
 		static char* Utf8OfAutoExpand(char(&buffer)[SIZE], wchar_t const* string)
 		{
-			return Utf8OfAutoExpand(buffer, size, string);
+			return Utf8OfAutoExpand(buffer, SIZE, string);
 		}
 
 		// Value parser
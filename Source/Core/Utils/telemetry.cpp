@@ -0,0 +1,246 @@
+#include "Core/Utils/telemetry.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Thread/lock.h"
+#include "Core/log.h"
+#include <math.h>
+#include <bit>
+
+using namespace glex;
+
+namespace
+{
+	// Values under 64 ns get a bucket each, every power of two above is split into 32.
+	constexpr uint32_t k_subBucketBits = 5;
+	constexpr uint32_t k_numBuckets = 1024;
+	constexpr uint64_t k_maxValue = (static_cast<uint64_t>(1) << 36) - 1;	// About 68 seconds.
+	constexpr uint32_t k_maxPrefix = 256;
+	constexpr uint32_t k_numCounters = static_cast<uint32_t>(TelemetryCounter::Count);
+
+	// Nanoseconds.
+	struct Histogram
+	{
+		uint32_t counts[k_numBuckets];
+		uint64_t count;
+		uint64_t sum;
+	};
+
+	// The recent histogram holds the samples in the ring, the oldest one is taken out when a new one comes in.
+	struct CounterState
+	{
+		Histogram recent;
+		Histogram session;
+		uint64_t sessionMax;
+		uint64_t samples[Telemetry::k_windowSize];
+	};
+
+	constexpr char const* s_counterNames[k_numCounters] =
+	{
+		"frame",
+		"cpu",
+		"gpu_wait",
+		"fence_wait",
+		"present_wait",
+		"upload",
+		"script_update",
+		"gui_batch",
+		"command_record"
+	};
+
+	// Guards everything below.
+	Mutex s_lock;
+	CounterState s_counters[k_numCounters];
+	double s_hitchThreshold = 0.0;
+	char s_hitchPrefix[k_maxPrefix] = "hitch";
+	uint64_t s_lastHitch = 0;
+	uint32_t s_numHitches = 0;
+
+	// Main thread only.
+	uint64_t s_frameStart = 0;
+}
+
+static uint32_t BucketOf(uint64_t value)
+{
+	value = Min(value, k_maxValue);
+	if (value < 2 << k_subBucketBits)
+		return value;
+	uint32_t shift = std::bit_width(value) - 1 - k_subBucketBits;
+	return (shift << k_subBucketBits) + (value >> shift);
+}
+
+// Middle of the bucket.
+static uint64_t BucketValue(uint32_t bucket)
+{
+	if (bucket < 2 << k_subBucketBits)
+		return bucket;
+	uint32_t shift = (bucket >> k_subBucketBits) - 1;
+	uint64_t lower = static_cast<uint64_t>((bucket & ((1 << k_subBucketBits) - 1)) + (1 << k_subBucketBits)) << shift;
+	return lower + ((static_cast<uint64_t>(1) << shift) - 1) / 2;
+}
+
+static void Record(CounterState& state, uint64_t value)
+{
+	value = Min(value, k_maxValue);
+	uint64_t& slot = state.samples[state.session.count % Telemetry::k_windowSize];
+	if (state.recent.count == Telemetry::k_windowSize)
+	{
+		state.recent.counts[BucketOf(slot)]--;
+		state.recent.sum -= slot;
+		state.recent.count--;
+	}
+	slot = value;
+	uint32_t bucket = BucketOf(value);
+	for (Histogram* histogram : { &state.recent, &state.session })
+	{
+		histogram->counts[bucket]++;
+		histogram->count++;
+		histogram->sum += value;
+	}
+	state.sessionMax = Max(state.sessionMax, value);
+}
+
+static uint64_t MaxOf(CounterState const& state, TelemetryRange range)
+{
+	if (range == TelemetryRange::Session)
+		return state.sessionMax;
+	uint64_t max = 0;
+	for (uint32_t i = 0; i < state.recent.count; i++)
+		max = Max(max, state.samples[i]);
+	return max;
+}
+
+// Milliseconds, the value of the bucket holding the sample at that rank.
+static double PercentileOf(Histogram const& histogram, double percentile, uint64_t max)
+{
+	if (histogram.count == 0)
+		return 0.0;
+	percentile = Min(Max(percentile, 0.0), 100.0);
+	uint64_t rank = Max(static_cast<uint64_t>(ceil(percentile / 100.0 * histogram.count)), static_cast<uint64_t>(1));
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < k_numBuckets; i++)
+	{
+		seen += histogram.counts[i];
+		if (seen >= rank)
+			return Min(BucketValue(i), max) * 1e-6;
+	}
+	return max * 1e-6;
+}
+
+void Telemetry::EndFrame()
+{
+	uint64_t now = Time::Ticks();
+	uint64_t ticks[k_numCounters];
+	for (uint32_t i = 0; i < k_numCounters; i++)
+		ticks[i] = Atomic::Exchange(&s_frameTicks[i], static_cast<uint64_t>(0));
+	if (s_frameStart == 0)
+	{
+		s_frameStart = now;
+		return;
+	}
+	uint32_t const frame = static_cast<uint32_t>(TelemetryCounter::Frame);
+	uint32_t const cpu = static_cast<uint32_t>(TelemetryCounter::Cpu);
+	uint32_t const gpuWait = static_cast<uint32_t>(TelemetryCounter::GpuWait);
+	ticks[frame] = now - s_frameStart;
+	ticks[gpuWait] = ticks[static_cast<uint32_t>(TelemetryCounter::FenceWait)] + ticks[static_cast<uint32_t>(TelemetryCounter::PresentWait)];
+	ticks[cpu] = ticks[frame] - Min(ticks[gpuWait], ticks[frame]);
+	s_frameStart = now;
+
+	double nanosecondsPerTick = 1e9 / Time::TicksPerSecond();
+	double milliseconds = ticks[frame] * nanosecondsPerTick * 1e-6;
+	bool isHitch;
+	{
+		ScopedLock lock(s_lock);
+		// Counters nobody added to this frame get no sample, the breakdown always does.
+		for (uint32_t i = 0; i < k_numCounters; i++)
+		{
+			if (ticks[i] != 0 || i == cpu || i == gpuWait)
+				Record(s_counters[i], static_cast<uint64_t>(ticks[i] * nanosecondsPerTick));
+		}
+		// One capture a second at most, so a stall lasting several frames doesn't keep writing files.
+		isHitch = s_hitchThreshold > 0.0 && milliseconds > s_hitchThreshold && now - s_lastHitch >= Time::TicksPerSecond();
+		if (isHitch)
+		{
+			s_lastHitch = now;
+			s_numHitches++;
+		}
+	}
+	if (!isHitch)
+		return;
+#if GLEX_ENABLE_PROFILER
+	uint64_t frameIndex = Profiler::FrameCount() - 1;
+	char path[k_maxPrefix + 32];
+	{
+		ScopedLock lock(s_lock);
+		snprintf(path, sizeof(path), "%s_%llu.json", s_hitchPrefix, static_cast<unsigned long long>(frameIndex));
+	}
+	if (Profiler::ExportChromeTrace(path, k_hitchFrames))
+		Logger::Warn("Frame %llu took %.2f ms, profile written to %s.", static_cast<unsigned long long>(frameIndex), milliseconds, path);
+	else
+		Logger::Error("Frame %llu took %.2f ms, cannot write profile to %s.", static_cast<unsigned long long>(frameIndex), milliseconds, path);
+	// The export isn't part of the next frame.
+	s_frameStart = Time::Ticks();
+#else
+	Logger::Warn("Frame took %.2f ms.", milliseconds);
+#endif
+}
+
+char const* Telemetry::GetCounterName(TelemetryCounter counter)
+{
+	return s_counterNames[static_cast<uint32_t>(counter)];
+}
+
+bool Telemetry::FindCounter(char const* name, TelemetryCounter& outCounter)
+{
+	for (uint32_t i = 0; i < k_numCounters; i++)
+	{
+		if (strcmp(s_counterNames[i], name) == 0)
+		{
+			outCounter = static_cast<TelemetryCounter>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+double Telemetry::Percentile(TelemetryCounter counter, double percentile, TelemetryRange range)
+{
+	ScopedLock lock(s_lock);
+	CounterState const& state = s_counters[static_cast<uint32_t>(counter)];
+	return PercentileOf(range == TelemetryRange::Recent ? state.recent : state.session, percentile, MaxOf(state, range));
+}
+
+TelemetryStats Telemetry::GetStats(TelemetryCounter counter, TelemetryRange range)
+{
+	ScopedLock lock(s_lock);
+	CounterState const& state = s_counters[static_cast<uint32_t>(counter)];
+	Histogram const& histogram = range == TelemetryRange::Recent ? state.recent : state.session;
+	uint64_t max = MaxOf(state, range);
+	TelemetryStats stats;
+	stats.count = histogram.count;
+	stats.mean = histogram.count == 0 ? 0.0 : static_cast<double>(histogram.sum) / histogram.count * 1e-6;
+	stats.p50 = PercentileOf(histogram, 50.0, max);
+	stats.p95 = PercentileOf(histogram, 95.0, max);
+	stats.p99 = PercentileOf(histogram, 99.0, max);
+	stats.max = max * 1e-6;
+	return stats;
+}
+
+void Telemetry::Reset()
+{
+	ScopedLock lock(s_lock);
+	memset(s_counters, 0, sizeof(s_counters));
+	s_numHitches = 0;
+}
+
+void Telemetry::SetHitchThreshold(double milliseconds, char const* pathPrefix)
+{
+	ScopedLock lock(s_lock);
+	s_hitchThreshold = milliseconds;
+	if (pathPrefix != nullptr)
+		snprintf(s_hitchPrefix, sizeof(s_hitchPrefix), "%s", pathPrefix);
+}
+
+uint32_t Telemetry::HitchCount()
+{
+	ScopedLock lock(s_lock);
+	return s_numHitches;
+}
\ No newline at end of file
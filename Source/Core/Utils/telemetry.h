@@ -0,0 +1,84 @@
+/**
+ * Frame-time telemetry. Every counter keeps log-linear histograms of its per-frame time, one over the last
+ * k_windowSize frames and one over the whole session, so percentiles cost neither sorting nor stored samples.
+ * Time added to a counter during a frame is summed up and becomes one sample at EndFrame.
+ * A frame longer than the hitch threshold has the profiler's last frames exported next to the working directory.
+ */
+#pragma once
+#include "Core/commdefs.h"
+#include "Core/Platform/time.h"
+#include "Core/Thread/atomic.h"
+
+namespace glex
+{
+	enum class TelemetryCounter : uint32_t
+	{
+		Frame,
+		Cpu,			// Frame minus GpuWait.
+		GpuWait,		// FenceWait plus PresentWait.
+		FenceWait,
+		PresentWait,
+		Upload,
+		ScriptUpdate,
+		GuiBatch,
+		CommandRecord,	// Draws recorded into secondary command buffers, on any thread.
+		Count
+	};
+
+	enum class TelemetryRange : uint8_t
+	{
+		Recent,
+		Session
+	};
+
+	// Milliseconds, percentiles are accurate to about 3%.
+	struct TelemetryStats
+	{
+		uint64_t count;
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	class Telemetry : private StaticClass
+	{
+	public:
+		constexpr static uint32_t k_windowSize = 1024;
+		constexpr static uint32_t k_hitchFrames = 4;		// Frames going into a hitch capture, the hitch itself included.
+
+	private:
+		inline static uint64_t s_frameTicks[static_cast<uint32_t>(TelemetryCounter::Count)];
+
+	public:
+		// Any thread.
+		static void Add(TelemetryCounter counter, uint64_t ticks) { Atomic::Add(&s_frameTicks[static_cast<uint32_t>(counter)], ticks); }
+		// Called once per frame by the main thread, before the profiler marks the next one.
+		static void EndFrame();
+
+		static char const* GetCounterName(TelemetryCounter counter);
+		// Takes the names GetCounterName returns, false if there's no such counter.
+		static bool FindCounter(char const* name, TelemetryCounter& outCounter);
+		// Zero if the counter has no samples.
+		static double Percentile(TelemetryCounter counter, double percentile, TelemetryRange range = TelemetryRange::Recent);
+		static TelemetryStats GetStats(TelemetryCounter counter, TelemetryRange range = TelemetryRange::Recent);
+		static void Reset();
+
+		// Milliseconds, zero turns hitch capture off. Captures are named prefix_<frame>.json, the prefix starts as "hitch"
+		// and null keeps it.
+		static void SetHitchThreshold(double milliseconds, char const* pathPrefix = nullptr);
+		static uint32_t HitchCount();
+	};
+
+	class TelemetryScope : private Uncopyable
+	{
+	private:
+		TelemetryCounter m_counter;
+		uint64_t m_begin;
+
+	public:
+		TelemetryScope(TelemetryCounter counter) : m_counter(counter), m_begin(Time::Ticks()) {}
+		~TelemetryScope() { Telemetry::Add(m_counter, Time::Ticks() - m_begin); }
+	};
+}
\ No newline at end of file
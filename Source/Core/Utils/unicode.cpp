@@ -0,0 +1,761 @@
+/**
+ * Bulk UTF-8 kernels behind StringUtils. Validation uses the lookup algorithm of Keiser and Lemire: three table
+ * lookups on the nibbles of each byte and the one before flag every two-byte pattern that can't appear, a saturating
+ * subtraction finds the third and fourth bytes. Decoding and transcoding take whole blocks at once when they're
+ * ASCII or runs of two or three byte characters, anything else goes one character at a time.
+ * The SSE4.1 and AVX2 kernels are always built on x64 and picked at runtime. MSVC takes intrinsics of any instruction
+ * set, GCC and Clang get target attributes on the vector code and on the kernel entry points, which the generic
+ * kernels are force inlined into.
+ */
+#include "Core/Utils/string.h"
+#include <bit>
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#define GLEX_UTF_SSE4 1
+#define GLEX_UTF_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define GLEX_UTF_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GLEX_UTF_INLINE __forceinline
+#define GLEX_UTF_TARGET_SSE4
+#define GLEX_UTF_TARGET_AVX2
+#else
+#define GLEX_UTF_INLINE inline __attribute__((always_inline))
+#define GLEX_UTF_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define GLEX_UTF_TARGET_AVX2 __attribute__((target("avx2")))
+// The generic kernels see vector types without the instruction set enabled. They're only ever inlined into
+// functions that have it, so the ABI of the calls it warns about never comes into play.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+using namespace glex;
+
+static_assert(sizeof(wchar_t) == 2, "UTF-16 strings are wchar_t.");
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		SCALAR
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Length of the longest valid prefix, it never ends inside a character.
+static uint32_t ValidPrefix(uint8_t const* p, uint32_t length)
+{
+	uint32_t i = 0;
+	while (i < length)
+	{
+		uint8_t b0 = p[i];
+		if (b0 < 0x80)
+		{
+			i++;
+			continue;
+		}
+		// Second byte ranges rule out overlong forms, surrogates and anything above U+10FFFF.
+		uint32_t charLength;
+		uint8_t lower = 0x80, upper = 0xbf;
+		if (b0 >= 0xc2 && b0 <= 0xdf)
+			charLength = 2;
+		else if (b0 >= 0xe0 && b0 <= 0xef)
+		{
+			charLength = 3;
+			if (b0 == 0xe0)
+				lower = 0xa0;
+			else if (b0 == 0xed)
+				upper = 0x9f;
+		}
+		else if (b0 >= 0xf0 && b0 <= 0xf4)
+		{
+			charLength = 4;
+			if (b0 == 0xf0)
+				lower = 0x90;
+			else if (b0 == 0xf4)
+				upper = 0x8f;
+		}
+		else
+			return i;
+		if (length - i < charLength || p[i + 1] < lower || p[i + 1] > upper)
+			return i;
+		for (uint32_t j = 2; j < charLength; j++)
+		{
+			if ((p[i + j] & 0xc0) != 0x80)
+				return i;
+		}
+		i += charLength;
+	}
+	return i;
+}
+
+// The character at p[i] has to be valid, i is moved past it.
+static uint32_t CodeAt(uint8_t const* p, uint32_t& i)
+{
+	uint32_t b0 = p[i];
+	if (b0 < 0x80)
+	{
+		i += 1;
+		return b0;
+	}
+	if (b0 < 0xe0)
+	{
+		uint32_t code = (b0 & 0x1f) << 6 | (p[i + 1] & 0x3f);
+		i += 2;
+		return code;
+	}
+	if (b0 < 0xf0)
+	{
+		uint32_t code = (b0 & 0x0f) << 12 | (p[i + 1] & 0x3f) << 6 | (p[i + 2] & 0x3f);
+		i += 3;
+		return code;
+	}
+	uint32_t code = (b0 & 0x07) << 18 | (p[i + 1] & 0x3f) << 12 | (p[i + 2] & 0x3f) << 6 | (p[i + 3] & 0x3f);
+	i += 4;
+	return code;
+}
+
+// Number of units written.
+static uint32_t PutCode(uint32_t code, uint32_t* out)
+{
+	*out = code;
+	return 1;
+}
+
+static uint32_t PutCode(uint32_t code, uint16_t* out)
+{
+	if (code < 0x10000)
+	{
+		*out = code;
+		return 1;
+	}
+	code -= 0x10000;
+	out[0] = 0xd800 | code >> 10;
+	out[1] = 0xdc00 | (code & 0x3ff);
+	return 2;
+}
+
+// The character at p[i] is written as UTF-8, i is moved past it. Zero for an unpaired surrogate.
+static uint32_t PutUtf8At(uint16_t const* p, uint32_t length, uint32_t& i, uint8_t* out)
+{
+	uint32_t code = p[i++];
+	if (code < 0x80)
+	{
+		out[0] = code;
+		return 1;
+	}
+	if (code < 0x800)
+	{
+		out[0] = 0xc0 | code >> 6;
+		out[1] = 0x80 | (code & 0x3f);
+		return 2;
+	}
+	if (code - 0xd800 < 0x800)
+	{
+		if (code >= 0xdc00 || i == length || p[i] - 0xdc00u >= 0x400)
+			return 0;
+		code = 0x10000 + ((code - 0xd800) << 10) + (p[i++] - 0xdc00);
+		out[0] = 0xf0 | code >> 18;
+		out[1] = 0x80 | (code >> 12 & 0x3f);
+		out[2] = 0x80 | (code >> 6 & 0x3f);
+		out[3] = 0x80 | (code & 0x3f);
+		return 4;
+	}
+	out[0] = 0xe0 | code >> 12;
+	out[1] = 0x80 | (code >> 6 & 0x3f);
+	out[2] = 0x80 | (code & 0x3f);
+	return 3;
+}
+
+// Bytes that start a character, plus those starting a surrogate pair for UTF-16.
+template <bool UTF16>
+static uint32_t CountScalar(uint8_t const* p, uint32_t length)
+{
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < length; i++)
+	{
+		count += static_cast<int8_t>(p[i]) > -65;
+		if constexpr (UTF16)
+			count += p[i] >= 0xf0;
+	}
+	return count;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		INSTRUCTION SETS
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+namespace
+{
+	struct Scalar
+	{
+		constexpr static uint32_t k_width = 0;
+	};
+
+#ifdef GLEX_UTF_SSE4
+	struct Sse4
+	{
+		using Vector = __m128i;
+		constexpr static uint32_t k_width = 16;
+
+		GLEX_UTF_TARGET_SSE4 static Vector Load(void const* p) { return _mm_loadu_si128(static_cast<__m128i const*>(p)); }
+		GLEX_UTF_TARGET_SSE4 static Vector Table(uint8_t const* table) { return Load(table); }
+		GLEX_UTF_TARGET_SSE4 static Vector Zero() { return _mm_setzero_si128(); }
+		GLEX_UTF_TARGET_SSE4 static Vector Set(uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); }
+		GLEX_UTF_TARGET_SSE4 static Vector And(Vector lhs, Vector rhs) { return _mm_and_si128(lhs, rhs); }
+		GLEX_UTF_TARGET_SSE4 static Vector Or(Vector lhs, Vector rhs) { return _mm_or_si128(lhs, rhs); }
+		GLEX_UTF_TARGET_SSE4 static Vector Xor(Vector lhs, Vector rhs) { return _mm_xor_si128(lhs, rhs); }
+		GLEX_UTF_TARGET_SSE4 static Vector SaturatingSub(Vector lhs, Vector rhs) { return _mm_subs_epu8(lhs, rhs); }
+		GLEX_UTF_TARGET_SSE4 static Vector High(Vector v) { return _mm_and_si128(_mm_srli_epi16(v, 4), Set(0x0f)); }
+		GLEX_UTF_TARGET_SSE4 static Vector Low(Vector v) { return _mm_and_si128(v, Set(0x0f)); }
+		GLEX_UTF_TARGET_SSE4 static Vector Lookup(Vector table, Vector index) { return _mm_shuffle_epi8(table, index); }
+		GLEX_UTF_TARGET_SSE4 static bool IsAscii(Vector v) { return _mm_movemask_epi8(v) == 0; }
+		GLEX_UTF_TARGET_SSE4 static bool IsZero(Vector v) { return _mm_testz_si128(v, v) != 0; }
+
+		// Input shifted right by N bytes with the end of the previous block coming in.
+		template <int N>
+		GLEX_UTF_TARGET_SSE4 static Vector Prev(Vector input, Vector prev) { return _mm_alignr_epi8(input, prev, 16 - N); }
+
+		GLEX_UTF_TARGET_SSE4 static uint32_t CountLeads(Vector v) { return std::popcount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, _mm_set1_epi8(-65))))); }
+		GLEX_UTF_TARGET_SSE4 static uint32_t CountFourByteLeads(Vector v) { return std::popcount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, Set(0xf0)), v)))); }
+
+		GLEX_UTF_TARGET_SSE4 static void Widen(uint8_t const* p, uint16_t* out)
+		{
+			Vector v = Load(p);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu8_epi16(v));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_cvtepu8_epi16(_mm_srli_si128(v, 8)));
+		}
+
+		GLEX_UTF_TARGET_SSE4 static void Widen(uint8_t const* p, uint32_t* out)
+		{
+			Vector v = Load(p);
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_cvtepu8_epi32(v));
+				v = _mm_srli_si128(v, 4);
+			}
+		}
+
+		// False if any unit isn't ASCII, nothing is written then.
+		GLEX_UTF_TARGET_SSE4 static bool Narrow(uint16_t const* p, uint8_t* out)
+		{
+			Vector lo = Load(p);
+			Vector hi = Load(p + 8);
+			if (!_mm_testz_si128(_mm_or_si128(lo, hi), _mm_set1_epi16(static_cast<short>(0xff80))))
+				return false;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+			return true;
+		}
+
+		// Eight two-byte characters out of 16 bytes, false if they aren't.
+		template <typename Char>
+		GLEX_UTF_TARGET_SSE4 static bool DecodeTwoByteRun(uint8_t const* p, Char* out)
+		{
+			Vector v = Load(p);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(0xe0)), _mm_set1_epi16(0xc0))) != 0xffff)
+				return false;
+			Vector codes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x1f)), 6), _mm_and_si128(_mm_srli_epi16(v, 8), _mm_set1_epi16(0x3f)));
+			if constexpr (sizeof(Char) == 2)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), codes);
+			else
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu16_epi32(codes));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu16_epi32(_mm_srli_si128(codes, 8)));
+			}
+			return true;
+		}
+
+		// Four three-byte characters out of 12 bytes, 16 are read.
+		template <typename Char>
+		GLEX_UTF_TARGET_SSE4 static bool DecodeThreeByteRun(uint8_t const* p, Char* out)
+		{
+			// Each character into its own lane, last byte lowest.
+			Vector v = _mm_shuffle_epi8(Load(p), _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(0xf00000)), _mm_set1_epi32(0xe00000))) != 0xffff)
+				return false;
+			Vector codes = _mm_or_si128(_mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0x3f)), _mm_and_si128(_mm_srli_epi32(v, 2), _mm_set1_epi32(0xfc0))), _mm_and_si128(_mm_srli_epi32(v, 4), _mm_set1_epi32(0xf000)));
+			if constexpr (sizeof(Char) == 2)
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi32(codes, codes));
+			else
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), codes);
+			return true;
+		}
+	};
+#endif
+
+#ifdef GLEX_UTF_AVX2
+	// Runs of multi-byte characters are rare enough to stay on 16 bytes.
+	struct Avx2 : Sse4
+	{
+		using Vector = __m256i;
+		constexpr static uint32_t k_width = 32;
+
+		GLEX_UTF_TARGET_AVX2 static Vector Load(void const* p) { return _mm256_loadu_si256(static_cast<__m256i const*>(p)); }
+		GLEX_UTF_TARGET_AVX2 static Vector Table(uint8_t const* table) { return _mm256_broadcastsi128_si256(Sse4::Load(table)); }
+		GLEX_UTF_TARGET_AVX2 static Vector Zero() { return _mm256_setzero_si256(); }
+		GLEX_UTF_TARGET_AVX2 static Vector Set(uint8_t value) { return _mm256_set1_epi8(static_cast<char>(value)); }
+		GLEX_UTF_TARGET_AVX2 static Vector And(Vector lhs, Vector rhs) { return _mm256_and_si256(lhs, rhs); }
+		GLEX_UTF_TARGET_AVX2 static Vector Or(Vector lhs, Vector rhs) { return _mm256_or_si256(lhs, rhs); }
+		GLEX_UTF_TARGET_AVX2 static Vector Xor(Vector lhs, Vector rhs) { return _mm256_xor_si256(lhs, rhs); }
+		GLEX_UTF_TARGET_AVX2 static Vector SaturatingSub(Vector lhs, Vector rhs) { return _mm256_subs_epu8(lhs, rhs); }
+		GLEX_UTF_TARGET_AVX2 static Vector High(Vector v) { return _mm256_and_si256(_mm256_srli_epi16(v, 4), Set(0x0f)); }
+		GLEX_UTF_TARGET_AVX2 static Vector Low(Vector v) { return _mm256_and_si256(v, Set(0x0f)); }
+		GLEX_UTF_TARGET_AVX2 static Vector Lookup(Vector table, Vector index) { return _mm256_shuffle_epi8(table, index); }
+		GLEX_UTF_TARGET_AVX2 static bool IsAscii(Vector v) { return _mm256_movemask_epi8(v) == 0; }
+		GLEX_UTF_TARGET_AVX2 static bool IsZero(Vector v) { return _mm256_testz_si256(v, v) != 0; }
+
+		// alignr works within lanes, the permute brings the previous high lane next to the current low one.
+		template <int N>
+		GLEX_UTF_TARGET_AVX2 static Vector Prev(Vector input, Vector prev) { return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N); }
+
+		GLEX_UTF_TARGET_AVX2 static uint32_t CountLeads(Vector v) { return std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-65))))); }
+		GLEX_UTF_TARGET_AVX2 static uint32_t CountFourByteLeads(Vector v) { return std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, Set(0xf0)), v)))); }
+
+		GLEX_UTF_TARGET_AVX2 static void Widen(uint8_t const* p, uint16_t* out)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi16(Sse4::Load(p)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi16(Sse4::Load(p + 16)));
+		}
+
+		GLEX_UTF_TARGET_AVX2 static void Widen(uint8_t const* p, uint32_t* out)
+		{
+			for (uint32_t i = 0; i < 4; i++)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 8), _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p + i * 8))));
+		}
+
+		GLEX_UTF_TARGET_AVX2 static bool Narrow(uint16_t const* p, uint8_t* out)
+		{
+			Vector lo = Load(p);
+			Vector hi = Load(p + 16);
+			if (!_mm256_testz_si256(_mm256_or_si256(lo, hi), _mm256_set1_epi16(static_cast<short>(0xff80))))
+				return false;
+			// packus interleaves the lanes.
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8));
+			return true;
+		}
+	};
+#endif
+
+#ifdef GLEX_UTF_NEON
+	struct Neon
+	{
+		using Vector = uint8x16_t;
+		constexpr static uint32_t k_width = 16;
+
+		static Vector Load(void const* p) { return vld1q_u8(static_cast<uint8_t const*>(p)); }
+		static Vector Table(uint8_t const* table) { return Load(table); }
+		static Vector Zero() { return vdupq_n_u8(0); }
+		static Vector Set(uint8_t value) { return vdupq_n_u8(value); }
+		static Vector And(Vector lhs, Vector rhs) { return vandq_u8(lhs, rhs); }
+		static Vector Or(Vector lhs, Vector rhs) { return vorrq_u8(lhs, rhs); }
+		static Vector Xor(Vector lhs, Vector rhs) { return veorq_u8(lhs, rhs); }
+		static Vector SaturatingSub(Vector lhs, Vector rhs) { return vqsubq_u8(lhs, rhs); }
+		static Vector High(Vector v) { return vshrq_n_u8(v, 4); }
+		static Vector Low(Vector v) { return vandq_u8(v, Set(0x0f)); }
+		static Vector Lookup(Vector table, Vector index) { return vqtbl1q_u8(table, index); }
+		static bool IsAscii(Vector v) { return vmaxvq_u8(v) < 0x80; }
+		static bool IsZero(Vector v) { return vmaxvq_u8(v) == 0; }
+
+		template <int N>
+		static Vector Prev(Vector input, Vector prev) { return vextq_u8(prev, input, 16 - N); }
+
+		static uint32_t CountLeads(Vector v) { return vaddvq_u8(vshrq_n_u8(vcgtq_s8(vreinterpretq_s8_u8(v), vdupq_n_s8(-65)), 7)); }
+		static uint32_t CountFourByteLeads(Vector v) { return vaddvq_u8(vshrq_n_u8(vcgeq_u8(v, Set(0xf0)), 7)); }
+
+		static void Widen(uint8_t const* p, uint16_t* out)
+		{
+			Vector v = Load(p);
+			vst1q_u16(out, vmovl_u8(vget_low_u8(v)));
+			vst1q_u16(out + 8, vmovl_high_u8(v));
+		}
+
+		static void Widen(uint8_t const* p, uint32_t* out)
+		{
+			Vector v = Load(p);
+			uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+			uint16x8_t hi = vmovl_high_u8(v);
+			vst1q_u32(out, vmovl_u16(vget_low_u16(lo)));
+			vst1q_u32(out + 4, vmovl_high_u16(lo));
+			vst1q_u32(out + 8, vmovl_u16(vget_low_u16(hi)));
+			vst1q_u32(out + 12, vmovl_high_u16(hi));
+		}
+
+		static bool Narrow(uint16_t const* p, uint8_t* out)
+		{
+			uint16x8_t lo = vld1q_u16(p);
+			uint16x8_t hi = vld1q_u16(p + 8);
+			if (vmaxvq_u16(vorrq_u16(lo, hi)) >= 0x80)
+				return false;
+			vst1q_u8(out, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+			return true;
+		}
+
+		template <typename Char>
+		static bool DecodeTwoByteRun(uint8_t const* p, Char* out)
+		{
+			uint16x8_t v = vreinterpretq_u16_u8(Load(p));
+			if (vminvq_u16(vceqq_u16(vandq_u16(v, vdupq_n_u16(0xe0)), vdupq_n_u16(0xc0))) == 0)
+				return false;
+			uint16x8_t codes = vorrq_u16(vshlq_n_u16(vandq_u16(v, vdupq_n_u16(0x1f)), 6), vandq_u16(vshrq_n_u16(v, 8), vdupq_n_u16(0x3f)));
+			if constexpr (sizeof(Char) == 2)
+				vst1q_u16(reinterpret_cast<uint16_t*>(out), codes);
+			else
+			{
+				vst1q_u32(reinterpret_cast<uint32_t*>(out), vmovl_u16(vget_low_u16(codes)));
+				vst1q_u32(reinterpret_cast<uint32_t*>(out) + 4, vmovl_high_u16(codes));
+			}
+			return true;
+		}
+
+		template <typename Char>
+		static bool DecodeThreeByteRun(uint8_t const* p, Char* out)
+		{
+			constexpr uint8_t k_shuffle[16] = { 2, 1, 0, 0xff, 5, 4, 3, 0xff, 8, 7, 6, 0xff, 11, 10, 9, 0xff };
+			uint32x4_t v = vreinterpretq_u32_u8(vqtbl1q_u8(Load(p), Load(k_shuffle)));
+			if (vminvq_u32(vceqq_u32(vandq_u32(v, vdupq_n_u32(0xf00000)), vdupq_n_u32(0xe00000))) == 0)
+				return false;
+			uint32x4_t codes = vorrq_u32(vorrq_u32(vandq_u32(v, vdupq_n_u32(0x3f)), vandq_u32(vshrq_n_u32(v, 2), vdupq_n_u32(0xfc0))), vandq_u32(vshrq_n_u32(v, 4), vdupq_n_u32(0xf000)));
+			if constexpr (sizeof(Char) == 2)
+				vst1_u16(reinterpret_cast<uint16_t*>(out), vmovn_u32(codes));
+			else
+				vst1q_u32(reinterpret_cast<uint32_t*>(out), codes);
+			return true;
+		}
+	};
+#endif
+
+	// Special case flags of the lookup tables. Two flags meaning the same thing in different spots share a bit.
+	constexpr uint8_t k_tooShort = 1 << 0;		// Lead byte or ASCII where a continuation should be.
+	constexpr uint8_t k_tooLong = 1 << 1;		// Continuation after ASCII.
+	constexpr uint8_t k_overlong3 = 1 << 2;
+	constexpr uint8_t k_tooLarge = 1 << 3;
+	constexpr uint8_t k_surrogate = 1 << 4;
+	constexpr uint8_t k_overlong2 = 1 << 5;
+	constexpr uint8_t k_tooLarge1000 = 1 << 6;
+	constexpr uint8_t k_overlong4 = 1 << 6;
+	constexpr uint8_t k_twoConts = 1 << 7;		// Continuation after continuation, fine for the third and fourth byte.
+	constexpr uint8_t k_carry = k_tooShort | k_tooLong | k_twoConts;
+
+	// Indexed by the high nibble of the previous byte.
+	constexpr uint8_t k_byte1High[16] =
+	{
+		k_tooLong, k_tooLong, k_tooLong, k_tooLong, k_tooLong, k_tooLong, k_tooLong, k_tooLong,
+		k_twoConts, k_twoConts, k_twoConts, k_twoConts,
+		k_tooShort | k_overlong2,
+		k_tooShort,
+		k_tooShort | k_overlong3 | k_surrogate,
+		k_tooShort | k_tooLarge | k_tooLarge1000 | k_overlong4
+	};
+
+	// Indexed by the low nibble of the previous byte.
+	constexpr uint8_t k_byte1Low[16] =
+	{
+		k_carry | k_overlong3 | k_overlong2 | k_overlong4,
+		k_carry | k_overlong2,
+		k_carry,
+		k_carry,
+		k_carry | k_tooLarge,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000 | k_surrogate,
+		k_carry | k_tooLarge | k_tooLarge1000,
+		k_carry | k_tooLarge | k_tooLarge1000
+	};
+
+	// Indexed by the high nibble of the current byte.
+	constexpr uint8_t k_byte2High[16] =
+	{
+		k_tooShort, k_tooShort, k_tooShort, k_tooShort, k_tooShort, k_tooShort, k_tooShort, k_tooShort,
+		k_tooLong | k_overlong2 | k_twoConts | k_overlong3 | k_tooLarge1000 | k_overlong4,
+		k_tooLong | k_overlong2 | k_twoConts | k_overlong3 | k_tooLarge,
+		k_tooLong | k_overlong2 | k_twoConts | k_surrogate | k_tooLarge,
+		k_tooLong | k_overlong2 | k_twoConts | k_surrogate | k_tooLarge,
+		k_tooShort, k_tooShort, k_tooShort, k_tooShort
+	};
+
+	// A block ending with these bytes or more is cut off inside a character. Aligned to the end of the block.
+	constexpr uint8_t k_incompleteTail[32] =
+	{
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1
+	};
+
+	template <typename Isa>
+	struct Utf8Validator
+	{
+		using Vector = typename Isa::Vector;
+
+		Vector byte1High;
+		Vector byte1Low;
+		Vector byte2High;
+		Vector error;
+		Vector prev;
+		Vector prevIncomplete;
+
+		GLEX_UTF_INLINE Utf8Validator() :
+			byte1High(Isa::Table(k_byte1High)),
+			byte1Low(Isa::Table(k_byte1Low)),
+			byte2High(Isa::Table(k_byte2High)),
+			error(Isa::Zero()),
+			prev(Isa::Zero()),
+			prevIncomplete(Isa::Zero())
+		{}
+
+		GLEX_UTF_INLINE void Check(Vector input)
+		{
+			if (Isa::IsAscii(input))
+				error = Isa::Or(error, prevIncomplete);
+			else
+			{
+				Vector prev1 = Isa::template Prev<1>(input, prev);
+				Vector special = Isa::And(Isa::And(Isa::Lookup(byte1High, Isa::High(prev1)), Isa::Lookup(byte1Low, Isa::Low(prev1))), Isa::Lookup(byte2High, Isa::High(input)));
+				// Only bytes two and three after a three or four byte lead may follow another continuation.
+				Vector isThird = Isa::SaturatingSub(Isa::template Prev<2>(input, prev), Isa::Set(0xe0 - 0x80));
+				Vector isFourth = Isa::SaturatingSub(Isa::template Prev<3>(input, prev), Isa::Set(0xf0 - 0x80));
+				Vector mustBeContinuation = Isa::And(Isa::Or(isThird, isFourth), Isa::Set(0x80));
+				error = Isa::Or(error, Isa::Xor(mustBeContinuation, special));
+				prevIncomplete = Isa::SaturatingSub(input, Isa::Load(k_incompleteTail + 32 - Isa::k_width));
+			}
+			prev = input;
+		}
+	};
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		KERNELS
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Forced inline, the instruction set is enabled on the entry points GLEX_UTF_KERNELS defines around them.
+template <typename Isa>
+GLEX_UTF_INLINE static bool Validate(uint8_t const* p, uint32_t length)
+{
+	if constexpr (Isa::k_width == 0)
+		return ValidPrefix(p, length) == length;
+	else
+	{
+		Utf8Validator<Isa> validator;
+		uint32_t i = 0;
+		for (; i + Isa::k_width <= length; i += Isa::k_width)
+			validator.Check(Isa::Load(p + i));
+		// The zeros after the rest catch a character cut off at the end.
+		uint8_t tail[Isa::k_width] = {};
+		memcpy(tail, p + i, length - i);
+		validator.Check(Isa::Load(tail));
+		return Isa::IsZero(Isa::Or(validator.error, validator.prevIncomplete));
+	}
+}
+
+template <typename Isa, bool UTF16>
+GLEX_UTF_INLINE static uint32_t Count(uint8_t const* p, uint32_t length)
+{
+	uint32_t count = 0;
+	uint32_t i = 0;
+	if constexpr (Isa::k_width != 0)
+	{
+		for (; i + Isa::k_width <= length; i += Isa::k_width)
+		{
+			typename Isa::Vector v = Isa::Load(p + i);
+			count += Isa::CountLeads(v);
+			if constexpr (UTF16)
+				count += Isa::CountFourByteLeads(v);
+		}
+	}
+	return count + CountScalar<UTF16>(p + i, length - i);
+}
+
+// Input has to be valid.
+template <typename Isa, typename Char>
+GLEX_UTF_INLINE static uint32_t Decode(uint8_t const* p, uint32_t length, Char* out)
+{
+	uint32_t i = 0;
+	uint32_t count = 0;
+	if constexpr (Isa::k_width != 0)
+	{
+		while (i + Isa::k_width <= length)
+		{
+			if (Isa::IsAscii(Isa::Load(p + i)))
+			{
+				Isa::Widen(p + i, out + count);
+				i += Isa::k_width;
+				count += Isa::k_width;
+				continue;
+			}
+			// Text in a single non-Latin script, like Cyrillic or CJK.
+			if (p[i] >= 0xe0 && p[i] < 0xf0 && Isa::DecodeThreeByteRun(p + i, out + count))
+			{
+				i += 12;
+				count += 4;
+				continue;
+			}
+			if (p[i] >= 0xc0 && p[i] < 0xe0 && Isa::DecodeTwoByteRun(p + i, out + count))
+			{
+				i += 16;
+				count += 8;
+				continue;
+			}
+			for (uint32_t end = i + 16; i < end;)
+				count += PutCode(CodeAt(p, i), out + count);
+		}
+	}
+	while (i < length)
+		count += PutCode(CodeAt(p, i), out + count);
+	return count;
+}
+
+template <typename Isa>
+GLEX_UTF_INLINE static uint32_t EncodeUtf8(uint16_t const* p, uint32_t length, uint8_t* out)
+{
+	uint32_t i = 0;
+	uint32_t count = 0;
+	if constexpr (Isa::k_width != 0)
+	{
+		while (i + Isa::k_width <= length)
+		{
+			if (Isa::Narrow(p + i, out + count))
+			{
+				i += Isa::k_width;
+				count += Isa::k_width;
+				continue;
+			}
+			for (uint32_t end = i + Isa::k_width; i < end;)
+			{
+				uint32_t written = PutUtf8At(p, length, i, out + count);
+				if (written == 0)
+					return UINT32_MAX;
+				count += written;
+			}
+		}
+	}
+	while (i < length)
+	{
+		uint32_t written = PutUtf8At(p, length, i, out + count);
+		if (written == 0)
+			return UINT32_MAX;
+		count += written;
+	}
+	return count;
+}
+
+namespace
+{
+	struct UtfKernels
+	{
+		bool (*validate)(uint8_t const*, uint32_t);
+		uint32_t (*countCodes)(uint8_t const*, uint32_t);
+		uint32_t (*countUtf16)(uint8_t const*, uint32_t);
+		uint32_t (*decode)(uint8_t const*, uint32_t, uint32_t*);
+		uint32_t (*decodeUtf16)(uint8_t const*, uint32_t, uint16_t*);
+		uint32_t (*encodeUtf8)(uint16_t const*, uint32_t, uint8_t*);
+	};
+
+}
+
+// Entry points of one instruction set, the generic kernels are compiled for it inside them.
+#define GLEX_UTF_KERNELS(Isa, TARGET) \
+	TARGET static bool Validate##Isa(uint8_t const* p, uint32_t length) { return Validate<Isa>(p, length); } \
+	TARGET static uint32_t CountCodes##Isa(uint8_t const* p, uint32_t length) { return Count<Isa, false>(p, length); } \
+	TARGET static uint32_t CountUtf16##Isa(uint8_t const* p, uint32_t length) { return Count<Isa, true>(p, length); } \
+	TARGET static uint32_t Decode##Isa(uint8_t const* p, uint32_t length, uint32_t* out) { return Decode<Isa>(p, length, out); } \
+	TARGET static uint32_t DecodeUtf16##Isa(uint8_t const* p, uint32_t length, uint16_t* out) { return Decode<Isa>(p, length, out); } \
+	TARGET static uint32_t EncodeUtf8##Isa(uint16_t const* p, uint32_t length, uint8_t* out) { return EncodeUtf8<Isa>(p, length, out); } \
+	constexpr UtfKernels k_kernels##Isa = { &Validate##Isa, &CountCodes##Isa, &CountUtf16##Isa, &Decode##Isa, &DecodeUtf16##Isa, &EncodeUtf8##Isa };
+
+GLEX_UTF_KERNELS(Scalar, )
+#ifdef GLEX_UTF_SSE4
+GLEX_UTF_KERNELS(Sse4, GLEX_UTF_TARGET_SSE4)
+#endif
+#ifdef GLEX_UTF_AVX2
+GLEX_UTF_KERNELS(Avx2, GLEX_UTF_TARGET_AVX2)
+#endif
+#ifdef GLEX_UTF_NEON
+GLEX_UTF_KERNELS(Neon, )
+#endif
+
+#if defined(GLEX_UTF_SSE4) || defined(GLEX_UTF_AVX2)
+// 0 without SSE4.1, 1 with it, 2 with AVX2 and the OS saving YMM registers.
+static uint32_t CpuLevel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int32_t info[4];
+	__cpuid(info, 1);
+	if ((info[2] & 1 << 19) == 0)
+		return 0;
+	bool hasAvx = (info[2] & 1 << 27) != 0 && (info[2] & 1 << 28) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return hasAvx && (info[1] & 1 << 5) != 0 ? 2 : 1;
+#else
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("sse4.1"))
+		return 0;
+	return __builtin_cpu_supports("avx2") ? 2 : 1;
+#endif
+}
+#endif
+
+static UtfKernels const& Kernels()
+{
+	static UtfKernels const* const kernels = []()
+	{
+#if defined(GLEX_UTF_SSE4) || defined(GLEX_UTF_AVX2)
+		uint32_t level = CpuLevel();
+#endif
+#ifdef GLEX_UTF_AVX2
+		if (level >= 2)
+			return &k_kernelsAvx2;
+#endif
+#ifdef GLEX_UTF_SSE4
+		if (level >= 1)
+			return &k_kernelsSse4;
+#endif
+#ifdef GLEX_UTF_NEON
+		return &k_kernelsNeon;
+#else
+		return &k_kernelsScalar;
+#endif
+	}();
+	return *kernels;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+		BULK CONVERSION
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+bool StringUtils::IsValidUtf8(char const* string, uint32_t length)
+{
+	return Kernels().validate(reinterpret_cast<uint8_t const*>(string), length);
+}
+
+uint32_t StringUtils::CountUtf8(char const* string, uint32_t length)
+{
+	return Kernels().countCodes(reinterpret_cast<uint8_t const*>(string), length);
+}
+
+uint32_t StringUtils::Utf16LengthOfUtf8(char const* string, uint32_t length)
+{
+	return Kernels().countUtf16(reinterpret_cast<uint8_t const*>(string), length);
+}
+
+uint32_t StringUtils::DecodeUtf8(char const* string, uint32_t length, uint32_t* outCodes)
+{
+	UtfKernels const& kernels = Kernels();
+	uint8_t const* p = reinterpret_cast<uint8_t const*>(string);
+	if (!kernels.validate(p, length))
+		length = ValidPrefix(p, length);
+	return kernels.decode(p, length, outCodes);
+}
+
+uint32_t StringUtils::ConvertUtf8ToUtf16(char const* string, uint32_t length, wchar_t* outString)
+{
+	UtfKernels const& kernels = Kernels();
+	uint8_t const* p = reinterpret_cast<uint8_t const*>(string);
+	if (!kernels.validate(p, length))
+		return UINT32_MAX;
+	return kernels.decodeUtf16(p, length, reinterpret_cast<uint16_t*>(outString));
+}
+
+uint32_t StringUtils::ConvertUtf16ToUtf8(wchar_t const* string, uint32_t length, char* outString)
+{
+	return Kernels().encodeUtf8(reinterpret_cast<uint16_t const*>(string), length, reinterpret_cast<uint8_t*>(outString));
+}
\ No newline at end of file
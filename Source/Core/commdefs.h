@@ -1,5 +1,7 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
+#include <array>
 #include <type_traits>
 #include <glm/glm.hpp>
 
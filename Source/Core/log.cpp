@@ -1,9 +1,136 @@
 #include "Core/log.h"
 #include "Utils/string.h"
+#include "Core/Thread/thread.h"
+#include "Core/Thread/atomic.h"
+#include "Core/Thread/lock.h"
+#include "Core/Platform/time.h"
+#include "Core/Utils/profiler.h"
+#include <EASTL/sort.h>
 #pragma comment(lib, "legacy_stdio_definitions.lib")
 
 using namespace glex;
+using namespace glex::inner;
 
+namespace
+{
+	constexpr uint64_t k_ringSize = 256 * 1024;
+	constexpr uint32_t k_maxRecordSize = k_ringSize / 4;	// Bigger ones are written synchronously.
+	constexpr uint32_t k_syncBufferSize = 1024;
+	constexpr uint32_t k_rateSlots = 64;
+	constexpr char const* k_levelNames[] = { "Trace", "Debug", "Info", "Warning", "Error", "Fatal" };
+
+	// Head is written by the owner thread, tail by the logging thread. Both only grow, offsets wrap around.
+	struct LogRing
+	{
+		alignas(64) uint64_t head = 0;
+		alignas(64) uint64_t tail = 0;
+		uint64_t drainEnd = 0;
+		bool drainFinal = false;	// The owner had exited before the drain read the counters.
+		uint32_t dropped = 0;
+		uint32_t suppressed = 0;
+		uint32_t retired = 0;
+		LogRing* prev = nullptr;
+		LogRing* next = nullptr;
+		char* buffer;
+	};
+
+	struct RingHolder
+	{
+		LogRing* ring = nullptr;
+		~RingHolder();
+	};
+
+	struct RateSlot
+	{
+		char const* format;
+		uint64_t second;
+		uint32_t count;
+	};
+
+	// Lines of one thread with the same timestamp keep their order by sequence.
+	struct PendingRecord
+	{
+		uint64_t timestamp;
+		uint32_t sequence;
+		LogRecord const* record;
+
+		bool operator<(PendingRecord const& rhs) const { return timestamp != rhs.timestamp ? timestamp < rhs.timestamp : sequence < rhs.sequence; }
+	};
+
+	struct LogArg
+	{
+		LogArgType type;
+		uint64_t bits;
+		char const* string;
+	};
+
+	// Sinks are written under this lock, by the logging thread while it runs.
+	Mutex s_sinkLock;
+	Function<void(LogLevel, char const*)> s_logCallback;
+	FILE* s_file = nullptr;
+
+	Mutex s_ringLock;
+	LogRing* s_rings = nullptr;
+	Vector<PendingRecord> s_pending;
+
+	Thread* s_thread = nullptr;
+	uint32_t s_running = 0;
+	uint32_t s_flushRequests = 0;
+	uint32_t s_flushesDone = 0;
+	uint32_t s_rateLimit = 0;
+}
+
+static uint64_t const s_startTicks = Time::Ticks();
+static thread_local RingHolder t_ring;
+static thread_local bool t_ringGone = false;
+static thread_local bool t_loggingThread = false;
+static thread_local LogRecord* t_syncRecord = nullptr;
+static thread_local uint64_t t_pendingHead = 0;
+static thread_local RateSlot t_rateSlots[k_rateSlots];
+alignas(8) static thread_local char t_syncBuffer[k_syncBufferSize];
+
+// The logging thread frees the ring once it's drained.
+RingHolder::~RingHolder()
+{
+	t_ringGone = true;
+	if (ring != nullptr)
+		Atomic::Store(&ring->retired, 1u);
+	ring = nullptr;
+}
+
+static LogRing* GetThreadRing()
+{
+	RingHolder& holder = t_ring;
+	if (holder.ring != nullptr) GLEX_LIKELY
+		return holder.ring;
+	if (t_ringGone)
+		return nullptr;
+	LogRing* ring = Mem::New<LogRing>();
+	ring->buffer = Mem::Alloc<char>(k_ringSize, MemoryTag::General);
+	ScopedLock lock(s_ringLock);
+	ring->next = s_rings;
+	if (s_rings != nullptr)
+		s_rings->prev = ring;
+	s_rings = ring;
+	holder.ring = ring;
+	return ring;
+}
+
+static void FreeRing(LogRing* ring)
+{
+	if (ring->prev != nullptr)
+		ring->prev->next = ring->next;
+	else
+		s_rings = ring->next;
+	if (ring->next != nullptr)
+		ring->next->prev = ring->prev;
+	Mem::Free(ring->buffer);
+	Mem::Delete(ring);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+			FORMATTING
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
 uint32_t Logger::FormatSequence(char* buffer, ConsoleColor backgroundColor, ConsoleColor foregroundColor)
 {
 	uint32_t pointer = 0;
@@ -26,50 +153,521 @@ uint32_t Logger::FormatSequence(char* buffer, ConsoleColor backgroundColor, Cons
 	return pointer;
 }
 
-void Logger::Trace(char const* format, ...)
+static bool ReadArg(char const*& p, char const* end, LogArg& arg)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	VLog<LogLevel::Trace>(format, arglist);
-	va_end(arglist);
+	if (p >= end)
+		return false;
+	arg.type = static_cast<LogArgType>(*p++);
+	if (arg.type == LogArgType::String)
+	{
+		uint32_t size;
+		memcpy(&size, p, 4);
+		arg.string = p + 4;
+		arg.bits = size;
+		p += 5 + size;
+	}
+	else
+	{
+		memcpy(&arg.bits, p, 8);
+		p += 8;
+	}
+	return true;
 }
 
-void Logger::Debug(char const* format, ...)
+template <typename T>
+static void AppendFormatted(String& out, char const* spec, T value)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	VLog<LogLevel::Debug>(format, arglist);
-	va_end(arglist);
+	int32_t length = snprintf(nullptr, 0, spec, value);
+	if (length <= 0)
+		return;
+	size_t old = out.size();
+	out.resize(old + length);
+	snprintf(out.data() + old, length + 1, spec, value);
 }
 
-void Logger::Info(char const* format, ...)
+static void AppendArg(String& out, LogArg const& arg)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	VLog<LogLevel::Info>(format, arglist);
-	va_end(arglist);
+	switch (arg.type)
+	{
+		case LogArgType::Int: AppendFormatted(out, "%lld", static_cast<long long>(arg.bits)); break;
+		case LogArgType::UInt: AppendFormatted(out, "%llu", static_cast<unsigned long long>(arg.bits)); break;
+		case LogArgType::Double: { double value; memcpy(&value, &arg.bits, 8); AppendFormatted(out, "%g", value); break; }
+		case LogArgType::Pointer: AppendFormatted(out, "%p", reinterpret_cast<void*>(arg.bits)); break;
+		case LogArgType::String: out.append(arg.string, arg.bits); break;
+	}
 }
 
-void Logger::Warn(char const* format, ...)
+static int64_t ArgAsInt(LogArg const& arg)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	VLog<LogLevel::Warning>(format, arglist);
-	va_end(arglist);
+	if (arg.type != LogArgType::Double)
+		return static_cast<int64_t>(arg.bits);
+	double value;
+	memcpy(&value, &arg.bits, 8);
+	return static_cast<int64_t>(value);
 }
 
-void Logger::Error(char const* format, ...)
+static double ArgAsDouble(LogArg const& arg)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	VLog<LogLevel::Error>(format, arglist);
-	va_end(arglist);
+	double value;
+	memcpy(&value, &arg.bits, 8);
+	if (arg.type == LogArgType::Int)
+		return static_cast<double>(static_cast<int64_t>(arg.bits));
+	if (arg.type == LogArgType::UInt)
+		return static_cast<double>(arg.bits);
+	return value;
 }
 
-void Logger::Fatal(char const* format, ...)
+// Each conversion is handed to snprintf by itself, with the length modifier replaced by the width the argument was stored with.
+static void FormatRecord(LogRecord const* record, String& out)
 {
-	va_list arglist;
-	va_start(arglist, format);
-	VLog<LogLevel::Fatal>(format, arglist);
-	va_end(arglist);
+	char const* args = reinterpret_cast<char const*>(record + 1);
+	char const* argsEnd = reinterpret_cast<char const*>(record) + record->size;
+	char const* f = record->format;
+	LogArg arg;
+	while (*f != '\0')
+	{
+		char const* literal = f;
+		while (*f != '\0' && *f != '%')
+			f++;
+		out.append(literal, f);
+		if (*f == '\0')
+			break;
+		char const* start = f++;
+		if (*f == '%')
+		{
+			out.push_back('%');
+			f++;
+			continue;
+		}
+		char spec[48];
+		uint32_t n = 0;
+		spec[n++] = '%';
+		while (*f != '\0' && strchr("-+ #0", *f) != nullptr && n < 8)
+			spec[n++] = *f++;
+		for (uint32_t part = 0; part < 2; part++)
+		{
+			if (part == 1)
+			{
+				if (*f != '.')
+					break;
+				spec[n++] = *f++;
+			}
+			if (*f == '*')
+			{
+				f++;
+				int32_t value = ReadArg(args, argsEnd, arg) ? static_cast<int32_t>(ArgAsInt(arg)) : 0;
+				n += snprintf(spec + n, 12, "%d", value);
+			}
+			else
+			{
+				while (*f >= '0' && *f <= '9' && n < 32)
+					spec[n++] = *f++;
+			}
+		}
+		// Unsigned conversions of signed arguments are cut to the width printf would have read.
+		uint32_t bits = 32;
+		if (f[0] == 'h')
+			bits = f[1] == 'h' ? 8 : 16;
+		else if ((f[0] == 'l' && (f[1] == 'l' || sizeof(long) == 8)) || f[0] == 'z' || f[0] == 'j' || f[0] == 't' || (f[0] == 'I' && f[1] != '3'))
+			bits = 64;
+		while (*f != '\0' && strchr("hlLzjtqwI", *f) != nullptr)
+		{
+			if (*f++ == 'I' && (*f == '3' || *f == '6'))
+				f += 2;
+		}
+		char conversion = *f;
+		if (conversion == '\0')
+		{
+			out.append(start, f);
+			break;
+		}
+		f++;
+		if (conversion == 'n')
+			continue;
+		if (!ReadArg(args, argsEnd, arg))
+		{
+			out.append("<missing>");
+			continue;
+		}
+		spec[n] = '\0';
+		switch (conversion)
+		{
+			case 'd':
+			case 'i':
+				if (arg.type == LogArgType::String)
+					AppendArg(out, arg);
+				else
+				{
+					strcpy(spec + n, "lld");
+					AppendFormatted(out, spec, static_cast<long long>(ArgAsInt(arg)));
+				}
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				if (arg.type == LogArgType::String)
+					AppendArg(out, arg);
+				else
+				{
+					uint64_t value = ArgAsInt(arg);
+					if (arg.type == LogArgType::Int && bits < 64)
+						value &= (static_cast<uint64_t>(1) << bits) - 1;
+					spec[n] = 'l';
+					spec[n + 1] = 'l';
+					spec[n + 2] = conversion;
+					spec[n + 3] = '\0';
+					AppendFormatted(out, spec, static_cast<unsigned long long>(value));
+				}
+				break;
+			case 'c':
+				spec[n] = 'c';
+				spec[n + 1] = '\0';
+				AppendFormatted(out, spec, static_cast<int32_t>(ArgAsInt(arg)));
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				if (arg.type == LogArgType::String)
+					AppendArg(out, arg);
+				else
+				{
+					spec[n] = conversion;
+					spec[n + 1] = '\0';
+					AppendFormatted(out, spec, ArgAsDouble(arg));
+				}
+				break;
+			case 's':
+				if (arg.type != LogArgType::String)
+					AppendArg(out, arg);
+				else
+				{
+					strcpy(spec + n, "s");
+					AppendFormatted(out, spec, arg.string);
+				}
+				break;
+			case 'p':
+				AppendFormatted(out, "%p", reinterpret_cast<void*>(arg.type == LogArgType::String ? reinterpret_cast<uintptr_t>(arg.string) : arg.bits));
+				break;
+			default:
+				out.append(start, f);
+				break;
+		}
+	}
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+			SINKS
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+// Under s_sinkLock.
+static void Emit(LogLevel level, uint64_t timestamp, char const* text)
+{
+	double seconds = timestamp > s_startTicks ? static_cast<double>(timestamp - s_startTicks) / Time::TicksPerSecond() : 0.0;
+	if (s_file != nullptr)
+	{
+		fprintf(s_file, "[%10.4f] [%s] %s\n", seconds, k_levelNames[*level], text);
+		if (level >= LogLevel::Error)
+			fflush(s_file);
+	}
+	if (s_logCallback != nullptr)
+	{
+		s_logCallback(level, text);
+		return;
+	}
+	ConsoleColor backgroundColor = ConsoleColor::Black;
+	ConsoleColor foregroundColor = ConsoleColor::White;
+	if (level == LogLevel::Debug)
+		foregroundColor = ConsoleColor::LightBlue;
+	else if (level == LogLevel::Info)
+		foregroundColor = ConsoleColor::Green;
+	else if (level == LogLevel::Warning)
+		foregroundColor = ConsoleColor::Yellow;
+	else if (level == LogLevel::Error)
+		foregroundColor = ConsoleColor::Red;
+	else if (level == LogLevel::Fatal)
+		backgroundColor = ConsoleColor::Red;
+	char sequence[16];
+	sequence[Logger::FormatSequence(sequence, backgroundColor, foregroundColor)] = '\0';
+	printf("%s[%10.4f] %s\n", sequence, seconds, text);
+}
+
+static void EmitRecord(LogRecord const* record, String& text)
+{
+	text.clear();
+	FormatRecord(record, text);
+	Emit(record->level, record->timestamp, text.c_str());
+}
+
+static void EmitSync(LogLevel level, uint64_t timestamp, char const* text)
+{
+	// The logging thread already holds the lock when a callback logs.
+	if (t_loggingThread)
+	{
+		Emit(level, timestamp, text);
+		return;
+	}
+	ScopedLock lock(s_sinkLock);
+	Emit(level, timestamp, text);
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+			LOGGING THREAD
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+static uint64_t AlignRecord(uint64_t size)
+{
+	return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Records of all threads are written in timestamp order. The ring lock isn't held while writing,
+// a callback that logs may need it for its own ring.
+static void Drain()
+{
+	uint32_t dropped = 0;
+	uint32_t suppressed = 0;
+	s_pending.clear();
+	{
+		ScopedLock lock(s_ringLock);
+		for (LogRing* ring = s_rings; ring != nullptr; ring = ring->next)
+		{
+			ring->drainFinal = Atomic::Load(&ring->retired);
+			ring->drainEnd = Atomic::Load(&ring->head);
+			for (uint64_t pos = ring->tail; pos < ring->drainEnd;)
+			{
+				uint64_t offset = pos & (k_ringSize - 1);
+				if (k_ringSize - offset < sizeof(LogRecord))
+				{
+					pos += k_ringSize - offset;
+					continue;
+				}
+				LogRecord const* record = reinterpret_cast<LogRecord const*>(ring->buffer + offset);
+				if (record->format != nullptr)
+					s_pending.push_back({ record->timestamp, static_cast<uint32_t>(s_pending.size()), record });
+				pos += AlignRecord(record->size);
+			}
+			dropped += Atomic::Exchange(&ring->dropped, 0u);
+			suppressed += Atomic::Exchange(&ring->suppressed, 0u);
+		}
+	}
+	eastl::sort(s_pending.begin(), s_pending.end());
+
+	{
+		ScopedLock lock(s_sinkLock);
+		String text;
+		for (PendingRecord const& pending : s_pending)
+			EmitRecord(pending.record, text);
+		char notice[96];
+		if (dropped != 0)
+		{
+			snprintf(notice, sizeof(notice), "%u log lines were dropped, the log ring was full.", dropped);
+			Emit(LogLevel::Warning, Time::Ticks(), notice);
+		}
+		if (suppressed != 0)
+		{
+			snprintf(notice, sizeof(notice), "%u log lines were suppressed by the rate limit.", suppressed);
+			Emit(LogLevel::Warning, Time::Ticks(), notice);
+		}
+		if (s_file != nullptr)
+			fflush(s_file);
+	}
+
+	// Rings registered meanwhile have nothing drained, their drain end is still zero.
+	ScopedLock lock(s_ringLock);
+	for (LogRing* ring = s_rings; ring != nullptr;)
+	{
+		LogRing* next = ring->next;
+		Atomic::Store(&ring->tail, ring->drainEnd);
+		if (ring->drainFinal && ring->drainEnd == Atomic::Load(&ring->head))
+			FreeRing(ring);
+		ring = next;
+	}
+}
+
+static void LoggingThread()
+{
+	t_loggingThread = true;
+	GLEX_PROFILE_THREAD("Logging");
+	while (Atomic::Load(&s_running))
+	{
+		uint32_t requests = Atomic::Load(&s_flushRequests);
+		Drain();
+		Atomic::Store(&s_flushesDone, requests);
+		if (Atomic::Load(&s_flushRequests) == requests)
+			Thread::Sleep(1);
+	}
+}
+
+void Logger::Startup()
+{
+	if (s_thread != nullptr)
+		return;
+	// Calibrated here instead of on the first line written.
+	Time::TicksPerSecond();
+	Atomic::Store(&s_running, 1u);
+	s_thread = Mem::New<Thread>(LoggingThread, ThreadPriority::Low);
+	s_thread->Resume();
+}
+
+void Logger::Shutdown()
+{
+	if (s_thread == nullptr)
+		return;
+	Atomic::Store(&s_running, 0u);
+	s_thread->Wait();
+	Mem::Delete(s_thread);
+	s_thread = nullptr;
+	Drain();
+}
+
+void Logger::Flush()
+{
+	if (!Atomic::Load(&s_running) || t_loggingThread)
+	{
+		ScopedLock lock(s_sinkLock);
+		if (s_file != nullptr)
+			fflush(s_file);
+		return;
+	}
+	uint32_t request = Atomic::Increment(&s_flushRequests);
+	while (static_cast<int32_t>(Atomic::Load(&s_flushesDone) - request) < 0 && Atomic::Load(&s_running))
+		Thread::Yield();
+}
+
+void Logger::SetLogCallback(Function<void(LogLevel, char const*)>&& callback)
+{
+	Flush();
+	ScopedLock lock(s_sinkLock);
+	s_logCallback = std::move(callback);
+}
+
+void Logger::SetRateLimit(uint32_t linesPerSecond)
+{
+	Atomic::Store(&s_rateLimit, linesPerSecond);
+}
+
+bool Logger::SetLogFile(char const* path)
+{
+	Flush();
+	ScopedLock lock(s_sinkLock);
+	if (s_file != nullptr)
+		fclose(s_file);
+	s_file = nullptr;
+	if (path == nullptr)
+		return true;
+#pragma warning(suppress: 4996)
+	s_file = fopen(path, "a");
+	return s_file != nullptr;
+}
+
+/*————————————————————————————————————————————————————————————————————————————————————————————————————
+			PRODUCERS
+————————————————————————————————————————————————————————————————————————————————————————————————————*/
+static bool RateLimited(char const* format, uint64_t timestamp)
+{
+	uint32_t limit = Atomic::Load(&s_rateLimit);
+	if (limit == 0)
+		return false;
+	RateSlot& slot = t_rateSlots[(reinterpret_cast<uintptr_t>(format) >> 3) & (k_rateSlots - 1)];
+	uint64_t second = timestamp / Time::TicksPerSecond();
+	if (slot.format != format || slot.second != second)
+	{
+		slot.format = format;
+		slot.second = second;
+		slot.count = 0;
+	}
+	return ++slot.count > limit;
+}
+
+static LogRecord* BeginSync(uint32_t size)
+{
+	LogRecord* record = size <= k_syncBufferSize ? reinterpret_cast<LogRecord*>(t_syncBuffer) : static_cast<LogRecord*>(Mem::Alloc(size, MemoryTag::General));
+	t_syncRecord = record;
+	return record;
+}
+
+LogRecord* Logger::BeginRecord(LogLevel level, char const* format, uint32_t size)
+{
+	uint64_t timestamp = Time::Ticks();
+	LogRecord* record = nullptr;
+	LogRing* ring = nullptr;
+	if (level == LogLevel::Fatal || size > k_maxRecordSize || !Atomic::Load(&s_running) || (ring = GetThreadRing()) == nullptr)
+	{
+		// Whatever is queued goes out first.
+		if (level == LogLevel::Fatal || size > k_maxRecordSize)
+			Flush();
+		record = BeginSync(size);
+	}
+	else
+	{
+		if (RateLimited(format, timestamp))
+		{
+			Atomic::Increment(&ring->suppressed);
+			return nullptr;
+		}
+		uint64_t pos = ring->head;
+		uint64_t offset = pos & (k_ringSize - 1);
+		uint64_t skip = k_ringSize - offset < sizeof(LogRecord) || k_ringSize - offset < size ? k_ringSize - offset : 0;
+		uint64_t needed = skip + AlignRecord(size);
+		while (k_ringSize - (pos - Atomic::Load(&ring->tail)) < needed)
+		{
+			if (level < LogLevel::Warning || t_loggingThread)
+			{
+				Atomic::Increment(&ring->dropped);
+				return nullptr;
+			}
+			if (!Atomic::Load(&s_running))
+			{
+				record = BeginSync(size);
+				break;
+			}
+			Thread::Yield();
+		}
+		if (record == nullptr)
+		{
+			// The tail end of the ring is too short, it's skipped with a padding record if a header fits.
+			if (skip >= sizeof(LogRecord))
+			{
+				LogRecord* padding = reinterpret_cast<LogRecord*>(ring->buffer + offset);
+				padding->size = static_cast<uint32_t>(skip);
+				padding->format = nullptr;
+			}
+			record = reinterpret_cast<LogRecord*>(ring->buffer + ((pos + skip) & (k_ringSize - 1)));
+			t_pendingHead = pos + needed;
+		}
+	}
+	record->size = size;
+	record->level = level;
+	record->format = format;
+	record->timestamp = timestamp;
+	return record;
+}
+
+void Logger::EndRecord(LogRecord* record)
+{
+	if (record != t_syncRecord)
+	{
+		Atomic::Store(&t_ring.ring->head, t_pendingHead);
+		return;
+	}
+	t_syncRecord = nullptr;
+	String text;
+	FormatRecord(record, text);
+	EmitSync(record->level, record->timestamp, text.c_str());
+	LogLevel level = record->level;
+	if (record != reinterpret_cast<LogRecord*>(t_syncBuffer))
+		Mem::Free(record);
+	if (level == LogLevel::Fatal)
+	{
+		if (Platform::IsDebuggerPresent())
+			Platform::DebugBreak();
+		else
+		{
+			Platform::MessageBox(MessageBoxIcon::Error, "Fatal error", text.c_str());
+			Platform::Terminate();
+		}
+	}
 }
\ No newline at end of file
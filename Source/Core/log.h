@@ -1,9 +1,18 @@
+/**
+ * Asynchronous logging. A log call copies the format pointer and its arguments into a ring owned by the calling
+ * thread, the logging thread formats them, stamps the time and writes them to the sinks.
+ * Format strings have to be literals since they're read after the call returns, string arguments are copied.
+ * Levels under GLEX_MIN_LOG_LEVEL are compiled out. When a ring is full lines under Warning are dropped and counted,
+ * the rest wait for room. Before Startup and after Shutdown lines are written on the calling thread.
+ */
 #pragma once
 #include "config.h"
 #include "Platform/platform.h"
 #include "Core/Container/function.h"
 #include "Core/Utils/string.h"
-#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
 
 namespace glex
 {
@@ -38,92 +47,158 @@ namespace glex
 		LightWhite
 	};
 
-	class Logger : private StaticClass
+	constexpr LogLevel k_minLogLevel = static_cast<LogLevel>(GLEX_MIN_LOG_LEVEL);
+
+	namespace inner
 	{
-	private:
-		inline static Function<void(LogLevel, char const*)> s_logCallback;
-		static uint32_t FormatSequence(char* buffer, ConsoleColor backgroundColor, ConsoleColor foregroundColor);
+		enum class LogArgType : uint8_t
+		{
+			Int,
+			UInt,
+			Double,
+			Pointer,
+			String
+		};
 
-	public:
-		template <typename Fn>
-		static void RedirectLog(Fn&& fn)
+		// Only literals convert, anything else has to go through "%s".
+		struct LogFormat
+		{
+			char const* string;
+
+			template <size_t N>
+			consteval LogFormat(char const (&format)[N]) : string(format) {}
+		};
+
+		// Records start 8-byte aligned, size covers the header and the arguments.
+		struct LogRecord
 		{
-			s_logCallback = std::forward<Fn>(fn);
+			uint32_t size;
+			LogLevel level;
+			char const* format;
+			uint64_t timestamp;
+		};
+
+		template <typename T>
+		consteval LogArgType GetLogArgType()
+		{
+			if constexpr (std::is_same_v<T, char*> || std::is_same_v<T, char const*> || std::is_same_v<T, String> || std::is_same_v<T, StringView>)
+				return LogArgType::String;
+			else if constexpr (std::is_floating_point_v<T>)
+				return LogArgType::Double;
+			else if constexpr (std::is_enum_v<T>)
+				return std::is_signed_v<std::underlying_type_t<T>> ? LogArgType::Int : LogArgType::UInt;
+			else if constexpr (std::is_integral_v<T>)
+				return std::is_signed_v<T> ? LogArgType::Int : LogArgType::UInt;
+			else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>)
+				return LogArgType::Pointer;
+			else
+				static_assert(sizeof(T) == 0, "Can't log arguments of this type.");
 		}
 
-		template <typename Obj>
-		static void RedirectLog(Obj* obj, MemberFunctionPtr<Obj, void(LogLevel, char const*)> fn)
+		inline StringView LogStringOf(char const* string) { return string != nullptr ? StringView(string) : StringView("(null)"); }
+		inline StringView LogStringOf(String const& string) { return StringView(string.data(), string.size()); }
+		inline StringView LogStringOf(StringView string) { return string; }
+
+		// Tag byte, then 8 bytes of value, or for strings 4 bytes of length and the characters with a terminator.
+		template <typename T>
+		uint32_t LogArgSize(T const& arg)
 		{
-			s_logCallback.BindMember(obj, fn);
+			if constexpr (GetLogArgType<std::decay_t<T>>() == LogArgType::String)
+				return 6 + LogStringOf(arg).size();
+			else
+				return 9;
 		}
 
-		template <LogLevel LEVEL>
-		static void VLog(char const* format, va_list arglist)
+		template <typename T>
+		void WriteLogArg(char*& p, T const& arg)
 		{
-			char buffer[Limits::LOG_BUFFER_SIZE];
-			char* actualBuffer;
-			uint32_t pointer = 0;
-			if (s_logCallback == nullptr)
+			using Decayed = std::decay_t<T>;
+			constexpr LogArgType type = GetLogArgType<Decayed>();
+			*p++ = static_cast<char>(type);
+			if constexpr (type == LogArgType::String)
 			{
-				ConsoleColor backgroundColor = ConsoleColor::Black;
-				ConsoleColor foregroundColor = ConsoleColor::White;
-				if constexpr (LEVEL == LogLevel::Debug)
-					foregroundColor = ConsoleColor::LightBlue;
-				if constexpr (LEVEL == LogLevel::Info)
-					foregroundColor = ConsoleColor::Green;
-				else if constexpr (LEVEL == LogLevel::Warning)
-					foregroundColor = ConsoleColor::Yellow;
-				else if constexpr (LEVEL == LogLevel::Error)
-					foregroundColor = ConsoleColor::Red;
-				else if constexpr (LEVEL == LogLevel::Fatal)
-					backgroundColor = ConsoleColor::Red;
-				pointer = FormatSequence(buffer, backgroundColor, foregroundColor);
-				int32_t length = vsnprintf(buffer + pointer, Limits::LOG_BUFFER_SIZE - pointer, format, ap);
-				if (length < 0)
-					actualBuffer = nullptr;
-				else if (length < Limits::LOG_BUFFER_SIZE - pointer)
-					actualBuffer = buffer;
-				else
-				{
-					actualBuffer = Mem::Alloc<char>(pointer + length + 1);
-					memcpy(actualBuffer, buffer, pointer);
-					length = vsnprintf(actualBuffer + pointer, length + 1, format, ap);
-					if (length < 0)
-					{
-						Mem::Free(actualBuffer);
-						actualBuffer = nullptr;
-					}
-				}
-				if (actualBuffer != nullptr)
-					puts(actualBuffer);
+				StringView string = LogStringOf(arg);
+				uint32_t size = string.size();
+				memcpy(p, &size, 4);
+				memcpy(p + 4, string.data(), size);
+				p[4 + size] = '\0';
+				p += 5 + size;
 			}
 			else
 			{
-				actualBuffer = StringUtils::FormatAutoExpand(buffer, format, arglist);
-				if (actualBuffer != nullptr)
-					s_logCallback(LEVEL, actualBuffer);
+				uint64_t bits;
+				if constexpr (type == LogArgType::Double)
+				{
+					double value = arg;
+					memcpy(&bits, &value, 8);
+				}
+				else if constexpr (type == LogArgType::Pointer)
+					bits = reinterpret_cast<uintptr_t>(static_cast<void const*>(arg));
+				else if constexpr (type == LogArgType::Int)
+					bits = static_cast<int64_t>(arg);
+				else
+					bits = static_cast<uint64_t>(arg);
+				memcpy(p, &bits, 8);
+				p += 8;
 			}
+		}
+	}
+
+	class Logger : private StaticClass
+	{
+	private:
+		static void SetLogCallback(Function<void(LogLevel, char const*)>&& callback);
 
-			if constexpr (LEVEL == LogLevel::Fatal)
+		// Null when the line is dropped or rate limited. Arguments go right after the record.
+		static inner::LogRecord* BeginRecord(LogLevel level, char const* format, uint32_t size);
+		static void EndRecord(inner::LogRecord* record);
+
+		template <LogLevel LEVEL, typename... Args>
+		static void Log(inner::LogFormat format, Args const&... args)
+		{
+			if constexpr (LEVEL >= k_minLogLevel)
 			{
-				if (Platform::IsDebuggerPresent())
-					Platform::DebugBreak();
-				else
-				{
-					Platform::MessageBox(MessageBoxIcon::Error, "Fatal error", actualBuffer);
-					Platform::Terminate();
-				}
+				uint32_t size = (static_cast<uint32_t>(sizeof(inner::LogRecord)) + ... + inner::LogArgSize(args));
+				inner::LogRecord* record = BeginRecord(LEVEL, format.string, size);
+				if (record == nullptr)
+					return;
+				char* p = reinterpret_cast<char*>(record + 1);
+				(inner::WriteLogArg(p, args), ...);
+				EndRecord(record);
 			}
+		}
 
-			if (actualBuffer != buffer)
-				Mem::Free(actualBuffer);
+	public:
+		// Writes the ANSI escape sequence for the colors, returns its length.
+		static uint32_t FormatSequence(char* buffer, ConsoleColor backgroundColor, ConsoleColor foregroundColor);
+		static void Startup();
+		static void Shutdown();
+		// Waits until everything logged before the call is written.
+		static void Flush();
+		// Lines after the first few of a format within a second are counted and skipped instead, zero turns it off.
+		static void SetRateLimit(uint32_t linesPerSecond);
+		// Every line is also appended to the file. Null closes it.
+		static bool SetLogFile(char const* path);
+
+		// The callback is invoked on the logging thread, it replaces the console.
+		template <typename Fn>
+		static void RedirectLog(Fn&& fn)
+		{
+			SetLogCallback(Function<void(LogLevel, char const*)>(std::forward<Fn>(fn)));
+		}
+
+		template <typename Obj>
+		static void RedirectLog(Obj* obj, MemberFunctionPtr<Obj, void(LogLevel, char const*)> fn)
+		{
+			SetLogCallback(Function<void(LogLevel, char const*)>(obj, fn));
 		}
 
-		static void Trace(char const* format, ...);
-		static void Debug(char const* format, ...);
-		static void Info(char const* format, ...);
-		static void Warn(char const* format, ...);
-		static void Error(char const* format, ...);
-		static void Fatal(char const* format, ...);
+		template <typename... Args> static void Trace(inner::LogFormat format, Args const&... args) { Log<LogLevel::Trace>(format, args...); }
+		template <typename... Args> static void Debug(inner::LogFormat format, Args const&... args) { Log<LogLevel::Debug>(format, args...); }
+		template <typename... Args> static void Info(inner::LogFormat format, Args const&... args) { Log<LogLevel::Info>(format, args...); }
+		template <typename... Args> static void Warn(inner::LogFormat format, Args const&... args) { Log<LogLevel::Warning>(format, args...); }
+		template <typename... Args> static void Error(inner::LogFormat format, Args const&... args) { Log<LogLevel::Error>(format, args...); }
+		// Doesn't return unless a debugger is attached.
+		template <typename... Args> static void Fatal(inner::LogFormat format, Args const&... args) { Log<LogLevel::Fatal>(format, args...); }
 	};
 }
\ No newline at end of file
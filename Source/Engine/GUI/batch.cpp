@@ -4,6 +4,7 @@
 #include "Core/Platform/input.h"
 #include "Core/Platform/window.h"
 #include "Core/Platform/time.h"
+#include "Core/Utils/profiler.h"
 #include "game.h"
 #include <EASTL/sort.h>
 
@@ -12,6 +13,7 @@ using namespace glex::gl;
 
 bool BatchRenderer::Startup(uint32_t initialQuadBudget)
 {
+	ScopedMemoryTag tag(MemoryTag::GUI);
 	PhysicalDevice const& cardInfo = Context::DeviceInfo();
 	uint32_t textureCount = Min(cardInfo.MaxSamplerCount(), cardInfo.MaxTextureCount(), Limits::NUM_BATCH_TEXTURES);
 	gl::DescriptorBinding textureBinding;
@@ -67,6 +69,8 @@ void BatchRenderer::Shutdown()
 
 void BatchRenderer::Tick()
 {
+	GLEX_PROFILE_SCOPE("BatchRenderer::Tick");
+	ScopedMemoryTag tag(MemoryTag::GUI);
 	// Reset those stuff, or they'll be drawn thousands of times.
 	s_textureDescriptorAllocator->Reset();
 	s_emptySet = VK_NULL_HANDLE;
@@ -82,8 +86,18 @@ void BatchRenderer::Tick()
 
 void BatchRenderer::Flush()
 {
+	GLEX_PROFILE_SCOPE("BatchRenderer::Flush");
 	gl::CommandBuffer commandBuffer = Renderer::CurrentCommandBuffer();
 	WeakPtr<MaterialInstance> currentMaterial = Renderer::GetCurrentMaterialInstance();
+	if (currentMaterial == nullptr)
+	{
+		// Its pipeline state is still compiling.
+		for (uint32_t i = 0; i < s_numTextures; i++)
+			s_textures[i] = nullptr;
+		s_vertexBegin = s_vertexEnd;
+		s_indexBegin = s_indexEnd;
+		return;
+	}
 	if (s_textures[0] != nullptr)
 	{
 		gl::DescriptorSet descriptorSet = s_textureDescriptorAllocator->AllocateDescriptorSet(s_textureSetLayout);
@@ -438,8 +452,30 @@ void BatchRenderer::PaintPopup(WeakPtr<Control> control, glm::vec2 pos)
 	s_drawList.clear();
 }
 
+#if GLEX_INTERNAL
+uint32_t BatchRenderer::BuildDrawList(WeakPtr<Control> root)
+{
+	s_drawList.clear();
+	s_drawList.push_back({ root, 0, 0, UINT_MAX });
+	for (uint32_t i = 0; i < s_drawList.size(); i++)
+	{
+		if (s_drawList[i].control->GetVisibility() != Visibility::Visible)
+		{
+			s_drawList[i].childIndex = UINT_MAX;
+			continue;
+		}
+		uint32_t childBegin = AddChildrenToDrawList(s_drawList[i].control);
+		s_drawList[i].childIndex = childBegin;
+	}
+	uint32_t size = s_drawList.size();
+	s_drawList.clear();
+	return size;
+}
+#endif
+
 void BatchRenderer::EndUIPass()
 {
+	GLEX_PROFILE_SCOPE("BatchRenderer::EndUIPass");
 	if (s_indexEnd != s_indexBegin)
 		Flush();
 
@@ -87,5 +87,9 @@ namespace glex::ui
 		static void DrawQuad(glm::vec4 const& border, WeakPtr<Texture> texture, glm::vec4 const& uv, glm::vec4 const& color);
 		static void SetFocus(WeakPtr<Control> control);
 		static WeakPtr<Control> GetFocus() { return s_activeControl; }
+#if GLEX_INTERNAL
+		// Sorts and groups the whole visible tree the way painting does, without drawing. Returns the number of elements.
+		static uint32_t BuildDrawList(WeakPtr<Control> root);
+#endif
 	};
 }
\ No newline at end of file
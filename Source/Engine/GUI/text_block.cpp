@@ -4,59 +4,59 @@
 
 using namespace glex::ui;
 
+void TextBlock::DecodeText()
+{
+	m_codes.resize(m_text.size());
+	m_codes.resize(StringUtils::DecodeUtf8(m_text.c_str(), m_text.size(), m_codes.data()));
+}
+
 // Advance until we hit a space to non-latin character.
-char const* TextBlock::FindNextWrappable(char const* p)
+uint32_t TextBlock::FindNextWrappable(uint32_t index)
 {
-	for (;;)
+	while (index < m_codes.size())
 	{
-		Utf8Code code = StringUtils::CodeOfUtf8(p);
-		if (code.code == 0 || code.length == 0)
-			return p;
-		p += code.length;
-		if (code.code == ' ' || !IsLatin(code.code))
-			return p;
+		uint32_t code = m_codes[index++];
+		if (code == ' ' || !IsLatin(code))
+			break;
 	}
+	return index;
 }
 
-float TextBlock::MeasureWidth(char const* begin, char const* end)
+float TextBlock::MeasureWidth(uint32_t begin, uint32_t end)
 {
 	float width = 0.0f;
-	while (begin < end)
+	for (uint32_t i = begin; i < end; i++)
 	{
-		Utf8Code code = StringUtils::CodeOfUtf8(begin);
-		BitmapGlyph const* glyph = m_font->GetGlyph(code.code);
+		BitmapGlyph const* glyph = m_font->GetGlyph(m_codes[i]);
 		if (glyph != nullptr)
 			width += glyph->xadvance;
-		begin += code.length;
 	}
 	return width * m_textSize;
 }
 
 glm::vec2 TextBlock::OnMeasure(glm::vec2 availableSize)
 {
-	if (m_font == nullptr || m_text.empty())
+	if (m_font == nullptr || m_codes.empty())
 		return glm::vec2(0, 0);
 	float lineHeight = m_font->LineHeight() * m_textSize;
 	// If width is set to 'auto' we don't wrap the text anyway.
 	if (m_wrap)
 	{
 		float width = 0.0f, height = lineHeight, cursor = 0.0f;
-		char const* p = m_text.c_str();
-		while (*p != 0)
+		uint32_t i = 0;
+		while (i < m_codes.size())
 		{
 			// Special chars.
-			if (*p == '\n')
+			if (m_codes[i] == '\n')
 			{
 				cursor = 0.0f;
 				height += lineHeight;
-				p++;
+				i++;
 				continue;
 			}
 
-			char const* n = FindNextWrappable(p);
-			if (p == n) // Invalid UTF-8 char.
-				break;
-			float wordWidth = MeasureWidth(p, n);
+			uint32_t n = FindNextWrappable(i);
+			float wordWidth = MeasureWidth(i, n);
 			// Wrap a word.
 			if (cursor != 0.0f && cursor + wordWidth > availableSize.x)
 			{
@@ -66,31 +66,17 @@ glm::vec2 TextBlock::OnMeasure(glm::vec2 availableSize)
 			cursor += wordWidth;
 			if (cursor > width)
 				width = cursor;
-			p = n;
+			i = n;
 		}
 		return glm::vec2(width, height);
 	}
 	else
-	{
-		float width = 0.0f;
-		char const* p = m_text.c_str();
-		while (*p != 0)
-		{
-			Utf8Code code = StringUtils::CodeOfUtf8(p);
-			if (code.length == 0)
-				break;
-			BitmapGlyph const* glyph = m_font->GetGlyph(code.code);
-			if (glyph != nullptr)
-				width += glyph->xadvance;
-			p += code.length;
-		}
-		return glm::vec2(width * m_textSize, lineHeight);
-	}
+		return glm::vec2(MeasureWidth(0, m_codes.size()), lineHeight);
 }
 
 void TextBlock::OnPaint(glm::vec2 pos, glm::vec2 size)
 {
-	if (m_font == nullptr || m_text.empty())
+	if (m_font == nullptr || m_codes.empty())
 		return;
 
 	if (m_wrap)
@@ -98,31 +84,28 @@ void TextBlock::OnPaint(glm::vec2 pos, glm::vec2 size)
 		glm::vec2 cursor = pos;
 		float lineHeight = m_font->LineHeight() * m_textSize;
 		float xend = pos.x + size.x;
-		char const* p = m_text.c_str();
-		while (*p != 0)
+		uint32_t i = 0;
+		while (i < m_codes.size())
 		{
 			// Special chars.
-			if (*p == '\n')
+			if (m_codes[i] == '\n')
 			{
 				cursor.x = pos.x;
 				cursor.y += lineHeight;
-				p++;
+				i++;
 				continue;
 			}
 
-			char const* n = FindNextWrappable(p);
-			if (p == n)
-				break;
-			float wordWidth = MeasureWidth(p, n);
+			uint32_t n = FindNextWrappable(i);
+			float wordWidth = MeasureWidth(i, n);
 			if (cursor.x != 0.0f && cursor.x + wordWidth > xend)
 			{
 				cursor.x = pos.x;
 				cursor.y += lineHeight;
 			}
-			while (p < n)
+			for (; i < n; i++)
 			{
-				Utf8Code code = StringUtils::CodeOfUtf8(p);
-				BitmapGlyph const* glyph = m_font->GetGlyph(code.code);
+				BitmapGlyph const* glyph = m_font->GetGlyph(m_codes[i]);
 				if (glyph != nullptr)
 				{
 					glm::vec2 corner = cursor + glyph->offset * m_textSize;
@@ -130,26 +113,20 @@ void TextBlock::OnPaint(glm::vec2 pos, glm::vec2 size)
 						m_font->GetTexture(glyph->page), glyph->uv, glm::vec4(m_color, 1.0f));
 					cursor.x += glyph->xadvance * m_textSize;
 				}
-				p += code.length;
 			}
 		}
 	}
 	else
 	{
-		char const* p = m_text.c_str();
-		while (*p != 0)
+		for (uint32_t code : m_codes)
 		{
-			Utf8Code code = StringUtils::CodeOfUtf8(p);
-			if (code.length == 0)
-				break;
-			BitmapGlyph const* glyph = m_font->GetGlyph(code.code);
+			BitmapGlyph const* glyph = m_font->GetGlyph(code);
 			if (glyph != nullptr)
 			{
 				BatchRenderer::DrawQuad(glm::vec4(pos + glyph->offset * m_textSize, glyph->size * m_textSize),
 					m_font->GetTexture(glyph->page), glyph->uv, glm::vec4(m_color, 1.0f));
 				pos.x += glyph->xadvance * m_textSize;
 			}
-			p += code.length;
 		}
 	}
 }
\ No newline at end of file
@@ -21,14 +21,11 @@ void TextBoxRenderProxy::OnPaint(glm::vec2 pos, glm::vec2 size)
 	if (m_font == nullptr)
 		return;
 	glm::vec2 relativePos = glm::vec2(-m_offset, 0.0f);
-	char const* p = m_text.c_str();
-	uint32_t charCount = 0;
-	while (*p != 0)
+	InlineVector<uint32_t, 256> codes(m_text.size());
+	codes.resize(StringUtils::DecodeUtf8(m_text.c_str(), m_text.size(), codes.data()));
+	for (uint32_t code : codes)
 	{
-		Utf8Code code = StringUtils::CodeOfUtf8(p);
-		if (code.length == 0)
-			break;
-		BitmapGlyph const* glyph = m_font->GetGlyph(code.code);
+		BitmapGlyph const* glyph = m_font->GetGlyph(code);
 		if (glyph != nullptr)
 		{
 			glm::vec4 border = glm::vec4(relativePos + glyph->offset * m_textSize, glyph->size * m_textSize);
@@ -42,8 +39,6 @@ void TextBoxRenderProxy::OnPaint(glm::vec2 pos, glm::vec2 size)
 			}
 			relativePos.x += glyph->xadvance * m_textSize;
 		}
-		charCount++;
-		p += code.length;
 	}
 }
 
@@ -15,7 +15,7 @@ namespace glex::px
 	public:
 		virtual void* allocate(size_t size, char const* typeName, char const* filename, int line) override
 		{
-			return Mem::Alloc(size, 16);
+			return Mem::Alloc(size, 16, MemoryTag::Physics);
 		}
 
 		virtual void deallocate(void* ptr) override
@@ -66,7 +66,7 @@ namespace glex::px
 
 		virtual uint32_t getWorkerCount() const
 		{
-			return Async::FreeThreadCount();
+			return Async::ThreadCount();
 		}
 	};
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "Core/log.h"
 #include "Core/Utils/raii.h"
 #include "Core/Utils/string.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Thread/task.h"
 #include "Core/assert.h"
 
 using namespace glex;
@@ -342,7 +344,33 @@ void DescriptorLayoutCache::FreeDescriptorLayout(gl::DescriptorLayout layout)
 /*————————————————————————————————————————————————————————————————————————————————————————————————————————————
 		Pipeline state.
  ————————————————————————————————————————————————————————————————————————————————————————————————————————————*/
-gl::PipelineState PipelineStateCache::GetPipelineState(WeakPtr<Shader> shader, gl::MetaMaterialInfo metaMaterial, gl::RenderPass renderPass, uint32_t subpass)
+class PipelineStateCache::CompileWork : public QueuedWork
+{
+private:
+	PipelineStateCache* m_cache;
+	PipelineStateHandle m_handle;
+	gl::PipelineInfo m_info;
+
+public:
+	CompileWork(PipelineStateCache* cache, PipelineStateHandle handle, gl::PipelineInfo const& info) : m_cache(cache), m_handle(handle), m_info(info) {}
+
+	virtual void DoWork() override
+	{
+		GLEX_PROFILE_SCOPE("Compile pipeline state");
+		gl::PipelineState pipelineState;
+		if (!pipelineState.Create(m_info))
+			Logger::Error("Cannot create pipeline state.");
+		m_cache->Finish(m_handle, pipelineState);
+	}
+
+	// The pool is shutting down.
+	virtual void Abort() override
+	{
+		m_cache->Finish(m_handle, gl::PipelineState());
+	}
+};
+
+PipelineStateHandle PipelineStateCache::AcquirePipelineState(WeakPtr<Shader> shader, gl::MetaMaterialInfo metaMaterial, gl::RenderPass renderPass, uint32_t subpass)
 {
 	PipelineStateKey key;
 	key.renderPass = renderPass;
@@ -350,11 +378,18 @@ gl::PipelineState PipelineStateCache::GetPipelineState(WeakPtr<Shader> shader, g
 	key.shader = shader;
 	key.metaMaterial = metaMaterial;
 
-	gl::PipelineState& ret = m_pipelineStates[key];
-	if (ret.GetHandle() != VK_NULL_HANDLE)
+	PipelineStateHandle handle;
 	{
-		m_refCounts[ret.GetHandle()].second++;
-		return ret;
+		ScopedLock lock(m_lock);
+		auto iter = m_pipelineStates.find(key);
+		if (iter != m_pipelineStates.end())
+		{
+			// Whether it's done or not, it's compiled only once.
+			m_entries.Get(iter->second)->refCount++;
+			return iter->second;
+		}
+		handle = m_entries.Insert(PipelineStateEntry { gl::PipelineState(), key, 1, Status::Compiling, shader.Pin() });
+		m_pipelineStates[key] = handle;
 	}
 	gl::PipelineInfo info;
 	info.vertexLayout = shader->GetVertexLayout();
@@ -365,27 +400,119 @@ gl::PipelineState PipelineStateCache::GetPipelineState(WeakPtr<Shader> shader, g
 	info.vertexShader = shader->GetVertexShader();
 	info.geometryShader = shader->GetGeometryShader();
 	info.fragmentShader = shader->GetFragmentShader();
-	if (!ret.Create(info))
+	CompileWork* work = Mem::New<CompileWork>(this, handle, info);
+	if (Async::ThreadCount() != 0)
+		Async::SubmitWork(work);
+	else
 	{
-		m_pipelineStates.erase(key);
-		return gl::PipelineState();
+		// Nobody else would run it.
+		work->DoWork();
+		work->Release();
 	}
+	return handle;
+}
 
-	m_refCounts[ret.GetHandle()] = { key, 1 };
-	return ret;
+void PipelineStateCache::Finish(PipelineStateHandle handle, gl::PipelineState pipelineState)
+{
+	{
+		ScopedLock lock(m_lock);
+		PipelineStateEntry* entry = m_entries.Get(handle);
+		entry->pipelineState = pipelineState;
+		entry->status = pipelineState.GetHandle() != VK_NULL_HANDLE ? Status::Ready : Status::Failed;
+		// Whoever holds a failed one gets a null state. The next acquire compiles it again.
+		if (entry->status == Status::Failed)
+			m_pipelineStates.erase(entry->key);
+		m_finished.push_back(handle);
+	}
+	m_compiled.Notify();
 }
 
-void PipelineStateCache::FreePipelineState(gl::PipelineState pipelineState)
+void PipelineStateCache::RemoveEntry(PipelineStateHandle handle)
 {
-	auto& [key, refCount] = m_refCounts[pipelineState.GetHandle()];
-	GLEX_DEBUG_ASSERT(refCount != 0) {}
-	if (--refCount == 0)
+	PipelineStateEntry* entry = m_entries.Get(handle);
+	gl::PipelineState pipelineState = entry->pipelineState;
+	// A failed entry has left the map already, its key may belong to a newer one by now.
+	auto iter = m_pipelineStates.find(entry->key);
+	if (iter != m_pipelineStates.end() && iter->second == handle)
+		m_pipelineStates.erase(iter);
+	m_entries.Remove(handle);
+	if (pipelineState.GetHandle() != VK_NULL_HANDLE)
 	{
-		m_refCounts.erase(pipelineState.GetHandle());
-		m_pipelineStates.erase(key);
 		Renderer::PendingDelete([=]() mutable
 		{
 			pipelineState.Destroy();
 		});
 	}
+}
+
+void PipelineStateCache::ReleasePipelineState(PipelineStateHandle handle)
+{
+	ScopedLock lock(m_lock);
+	PipelineStateEntry* entry = m_entries.Get(handle);
+	GLEX_DEBUG_ASSERT(entry != nullptr && entry->refCount != 0) {}
+	// One still holding its shader is removed by Tick once the compilation is done.
+	if (--entry->refCount == 0 && entry->compilingShader == nullptr)
+		RemoveEntry(handle);
+}
+
+gl::PipelineState PipelineStateCache::GetPipelineState(PipelineStateHandle handle) const
+{
+	ScopedLock lock(m_lock);
+	PipelineStateEntry const* entry = m_entries.Get(handle);
+	return entry != nullptr ? entry->pipelineState : gl::PipelineState();
+}
+
+bool PipelineStateCache::IsCompiling(PipelineStateHandle handle) const
+{
+	ScopedLock lock(m_lock);
+	PipelineStateEntry const* entry = m_entries.Get(handle);
+	return entry != nullptr && entry->status == Status::Compiling;
+}
+
+gl::PipelineState PipelineStateCache::WaitPipelineState(PipelineStateHandle handle)
+{
+	GLEX_PROFILE_SCOPE("Wait for pipeline state");
+	while (IsCompiling(handle))
+	{
+		if (Async::TryRunOne())
+			continue;
+		// Nothing left to run, so the compilation is running on another thread. Sleep until something finishes.
+		uint32_t epoch = m_compiled.PrepareWait();
+		if (IsCompiling(handle))
+			m_compiled.Wait(epoch);
+		else
+			m_compiled.CancelWait();
+	}
+	return GetPipelineState(handle);
+}
+
+void PipelineStateCache::Prewarm(SequenceView<PipelineStateDesc const> descs, Vector<PipelineStateHandle>& outHandles)
+{
+	outHandles.reserve(outHandles.size() + descs.Size());
+	for (PipelineStateDesc const& desc : descs)
+		outHandles.push_back(AcquirePipelineState(desc.shader, desc.metaMaterial, desc.renderPass, desc.subpass));
+}
+
+void PipelineStateCache::GetPipelineStateDescs(Vector<PipelineStateDesc>& outDescs) const
+{
+	ScopedLock lock(m_lock);
+	outDescs.reserve(outDescs.size() + m_pipelineStates.size());
+	for (auto const& [key, handle] : m_pipelineStates)
+		outDescs.push_back({ key.shader, key.metaMaterial, key.renderPass, key.subpass });
+}
+
+void PipelineStateCache::Tick()
+{
+	// The last reference to a shader destroys it, which must not happen under the lock.
+	Vector<SharedPtr<Shader>> shaders;
+	ScopedLock lock(m_lock);
+	shaders.reserve(m_finished.size());
+	for (PipelineStateHandle handle : m_finished)
+	{
+		PipelineStateEntry* entry = m_entries.Get(handle);
+		shaders.push_back(std::move(entry->compilingShader));
+		if (entry->refCount == 0)
+			RemoveEntry(handle);
+	}
+	m_finished.clear();
 }
\ No newline at end of file
@@ -10,6 +10,9 @@
 #include "Core/GL/descriptor.h"
 #include "Core/assert.h"
 #include "Core/Memory/smart_ptr.h"
+#include "Core/Container/handle_pool.h"
+#include "Core/Thread/lock.h"
+#include "Core/Thread/futex.h"
 #include "Engine/Renderer/shader.h"
 #include <array>
 
@@ -18,7 +21,7 @@ namespace glex::render
 	class ShaderModuleCache
 	{
 	private:
-		HashMap<char const*, gl::Shader, eastl::hash<char const*>, eastl::str_equal_to<char const*>> m_pathTable;
+		HashMap<char const*, gl::Shader, StringHasher, eastl::str_equal_to<char const*>> m_pathTable;
 		HashMap<VkShaderModule, std::pair<char*, uint32_t>> m_refCount;
 
 	public:
@@ -49,10 +52,10 @@ namespace glex::render
 	{
 	private:
 		// It's stupid to keep a name inside a class. But here we could use string since it's internal.
-		HashMap<char const*, gl::DescriptorSetLayout, eastl::hash<char const*>, eastl::str_equal_to<char const*>> m_setTable;
+		HashMap<char const*, gl::DescriptorSetLayout, StringHasher, eastl::str_equal_to<char const*>> m_setTable;
 		HashMap<VkDescriptorSetLayout, std::pair<char*, uint32_t>> m_setRefCount;
 
-		HashMap<char const*, DescriptorLayoutInternal, eastl::hash<char const*>, eastl::str_equal_to<char const*>> m_descTable;
+		HashMap<char const*, DescriptorLayoutInternal, StringHasher, eastl::str_equal_to<char const*>> m_descTable;
 		HashMap<VkPipelineLayout, std::pair<char*, uint32_t>> m_refCount;
 
 		gl::DescriptorSetLayout GetDescriptorSetLayoutInternal(char const* description, SequenceView<gl::DescriptorBinding const> bindings);
@@ -83,9 +86,31 @@ namespace glex::render
 #endif
 	};
 
+	using PipelineStateHandle = Handle<gl::PipelineState>;
+
+	// What a pipeline state is made of. Recorded in one session, created ahead of time in the next.
+	struct PipelineStateDesc
+	{
+		WeakPtr<Shader> shader;
+		gl::MetaMaterialInfo metaMaterial;
+		gl::RenderPass renderPass;
+		uint32_t subpass;
+	};
+
+	// Pipeline states are compiled on pool workers, a state asked for twice is compiled once.
+	// Acquiring and looking up are thread-safe. Releasing and Tick destroy things, so they stay on the render thread.
 	class PipelineStateCache
 	{
 	private:
+		class CompileWork;
+
+		enum class Status : uint8_t
+		{
+			Compiling,
+			Ready,
+			Failed
+		};
+
 		struct PipelineStateKey
 		{
 			gl::RenderPass renderPass;
@@ -100,30 +125,56 @@ namespace glex::render
 		public:
 			size_t operator()(PipelineStateKey const& key) const
 			{
-				uint64_t shader = reinterpret_cast<uint64_t>(key.shader.Get());
-				uint64_t metaMaterial = reinterpret_cast<uint32_t const&>(key.metaMaterial);
-				uint64_t subpass = key.subpass;
-				uint64_t renderPass = reinterpret_cast<uint64_t>(key.renderPass.GetHandle());
-				return shader * 307 + renderPass * 169 + (metaMaterial << 32) ^ subpass;
+				uint32_t metaMaterial = reinterpret_cast<uint32_t const&>(key.metaMaterial);
+				return HashValues(key.shader, key.renderPass.GetHandle(), metaMaterial, key.subpass);
 			}
 		};
 
-		HashMap<PipelineStateKey, gl::PipelineState, Hasher> m_pipelineStates;
-		HashMap<VkPipeline, std::pair<PipelineStateKey, uint32_t>> m_refCounts;
+		struct PipelineStateEntry
+		{
+			gl::PipelineState pipelineState;
+			PipelineStateKey key;
+			uint32_t refCount;
+			Status status;
+			SharedPtr<Shader> compilingShader; // Keeps the shader modules alive until the worker is done.
+		};
+
+		HashMap<PipelineStateKey, PipelineStateHandle, Hasher> m_pipelineStates;
+		HandlePool<PipelineStateEntry, gl::PipelineState> m_entries;
+		Vector<PipelineStateHandle> m_finished; // Compiled since the last tick, still holding their shaders.
+		mutable Mutex m_lock;
+		EventCount m_compiled; // Notified whenever a compilation finishes.
+
+		void Finish(PipelineStateHandle handle, gl::PipelineState pipelineState);
+		void RemoveEntry(PipelineStateHandle handle);
 
 	public:
-		gl::PipelineState GetPipelineState(WeakPtr<Shader> shader, gl::MetaMaterialInfo metaMaterial, gl::RenderPass renderPass, uint32_t subpass);
-		void FreePipelineState(gl::PipelineState pipelineState);
+		// Compiling starts in the background, the handle is never null. Every handle acquired has to be released.
+		PipelineStateHandle AcquirePipelineState(WeakPtr<Shader> shader, gl::MetaMaterialInfo metaMaterial, gl::RenderPass renderPass, uint32_t subpass);
+		void ReleasePipelineState(PipelineStateHandle handle);
+		// Null pipeline state while compiling, and for good if compiling failed or the handle has been released.
+		// A failed state leaves the cache, acquiring it again compiles it again.
+		gl::PipelineState GetPipelineState(PipelineStateHandle handle) const;
+		bool IsCompiling(PipelineStateHandle handle) const;
+		// Runs other works while waiting, sleeps once there's none. Null pipeline state if compiling failed.
+		gl::PipelineState WaitPipelineState(PipelineStateHandle handle);
+		// Starts compiling everything recorded, so nothing has to wait for it once it's needed.
+		// The handles keep the pipeline states alive and have to be released.
+		void Prewarm(SequenceView<PipelineStateDesc const> descs, Vector<PipelineStateHandle>& outHandles);
+		// Everything in the cache right now, to be recorded for the next session.
+		void GetPipelineStateDescs(Vector<PipelineStateDesc>& outDescs) const;
+		// Drops what finished compilations held on to. Called by the renderer every frame.
+		void Tick();
 
 #if GLEX_REPORT_MEMORY_LEAKS
 		void FreeMemory()
 		{
 			GLEX_DEBUG_ASSERT(m_pipelineStates.empty()) {}
-			GLEX_DEBUG_ASSERT(m_refCounts.empty()) {}
+			GLEX_DEBUG_ASSERT(m_entries.Size() == 0) {}
 			decltype(m_pipelineStates) x;
-			decltype(m_refCounts) y;
 			m_pipelineStates.swap(x);
-			m_refCounts.swap(y);
+			m_entries = decltype(m_entries)();
+			m_finished = decltype(m_finished)();
 		}
 #endif
 	};
@@ -1,6 +1,4 @@
 #include "frustum.h"
-#include "Context/time.h"
-#include "renderer.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 using namespace glex;
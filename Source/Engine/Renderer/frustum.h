@@ -1,5 +1,5 @@
 #pragma once
-#include "defs.h"
+#include "Core/commdefs.h"
 #include "config.h"
 #include <glm/glm.hpp>
 
@@ -13,7 +13,7 @@ private:
 
 	static void NormalizePlane(glm::vec4& plane)
 	{
-		plane *= 1.0f / glm::length(lval_cast<glm::vec3>(plane));
+		plane *= 1.0f / glm::length(glm::vec3(plane));
 	}
 
 	static bool IsInside(glm::vec4 const& plane, glm::vec4 const& boundingSphere)
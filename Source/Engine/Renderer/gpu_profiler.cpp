@@ -0,0 +1,142 @@
+#include "Engine/Renderer/gpu_profiler.h"
+#include "Core/GL/context.h"
+#include "Core/Platform/time.h"
+#include "Core/Utils/profiler.h"
+#include "Core/assert.h"
+
+using namespace glex;
+using namespace glex::render;
+
+GpuProfiler::GpuProfiler(uint32_t numFrames) : m_recording(nullptr), m_nanosecondsPerTimestamp(Context::DeviceInfo().timestampPeriod),
+m_supportsStatistics(Context::DeviceInfo().supportsPipelineStatistics)
+{
+	if (!Context::DeviceInfo().supportsTimestamps)
+	{
+		Logger::Warn("The graphics queue doesn't support timestamps, render passes won't be timed.");
+		return;
+	}
+	m_frames.resize(numFrames);
+	for (FrameQueries& frame : m_frames)
+	{
+		if (!frame.timestamps.Create(gl::QueryType::Timestamp, k_maxScopes * 2) ||
+			m_supportsStatistics && !frame.statistics.Create(gl::QueryType::PipelineStatistics, k_maxStatistics))
+			Logger::Fatal("Cannot create GPU profiler queries.");
+		frame.scopes.reserve(k_maxScopes);
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	// The device is idle by now.
+	for (FrameQueries& frame : m_frames)
+	{
+		frame.timestamps.Destroy();
+		if (m_supportsStatistics)
+			frame.statistics.Destroy();
+	}
+}
+
+void GpuProfiler::ReadBack(FrameQueries& frame)
+{
+	uint64_t timestamps[k_maxScopes * 2];
+	uint64_t statistics[k_maxStatistics * gl::QueryPool::NUM_PIPELINE_STATISTICS];
+	uint32_t numScopes = frame.scopes.size();
+	// Everything was submitted and the fence was waited, missing results mean the frame was never submitted.
+	if (!frame.timestamps.GetResults(0, numScopes * 2, 1, timestamps))
+		return;
+	if (frame.numStatistics != 0 && !frame.statistics.GetResults(0, frame.numStatistics, gl::QueryPool::NUM_PIPELINE_STATISTICS, statistics))
+		return;
+
+	// The GPU ran the frame some time after it was recorded, there is no common clock to line the two up.
+	// The first timestamp is put where the recording started, which keeps the GPU track next to its frame.
+	double ticksPerTimestamp = m_nanosecondsPerTimestamp * 1e-9 * Time::TicksPerSecond();
+	uint64_t firstTimestamp = timestamps[0];
+	m_results.clear();
+	for (uint32_t i = 0; i < numScopes; i++)
+	{
+		Scope const& scope = frame.scopes[i];
+		uint64_t begin = timestamps[i * 2], end = Max(timestamps[i * 2 + 1], begin);
+		GpuScopeResult& result = m_results.emplace_back();
+		result.name = scope.name;
+		result.depth = scope.depth;
+		result.milliseconds = (end - begin) * m_nanosecondsPerTimestamp * 1e-6;
+		if (scope.statisticsQuery != UINT_MAX)
+		{
+			uint64_t const* values = statistics + scope.statisticsQuery * gl::QueryPool::NUM_PIPELINE_STATISTICS;
+			result.primitives = values[0];
+			result.vertexInvocations = values[1];
+			result.fragmentInvocations = values[3];
+		}
+		else
+			result.primitives = result.vertexInvocations = result.fragmentInvocations = 0;
+		Profiler::AddGpuSpan(scope.name.ToString(),
+			frame.cpuTicks + static_cast<uint64_t>((begin - firstTimestamp) * ticksPerTimestamp),
+			frame.cpuTicks + static_cast<uint64_t>((end - firstTimestamp) * ticksPerTimestamp));
+	}
+}
+
+void GpuProfiler::BeginFrame(gl::CommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (m_frames.empty())
+		return;
+	GLEX_DEBUG_ASSERT(m_openScopes.empty()) {}
+	FrameQueries& frame = m_frames[frameIndex];
+	if (!frame.scopes.empty())
+		ReadBack(frame);
+	frame.scopes.clear();
+	frame.numStatistics = 0;
+	frame.cpuTicks = Time::Ticks();
+	commandBuffer.ResetQueries(frame.timestamps, 0, k_maxScopes * 2);
+	if (m_supportsStatistics)
+		commandBuffer.ResetQueries(frame.statistics, 0, k_maxStatistics);
+	m_recording = &frame;
+}
+
+void GpuProfiler::BeginScope(gl::CommandBuffer commandBuffer, Name name, bool countStatistics)
+{
+	if (m_recording == nullptr)
+		return;
+	FrameQueries& frame = *m_recording;
+	if (frame.scopes.size() == k_maxScopes)
+	{
+		m_openScopes.push_back(UINT_MAX);
+		return;
+	}
+	uint32_t index = frame.scopes.size();
+	Scope& scope = frame.scopes.emplace_back();
+	scope.name = name;
+	scope.depth = m_openScopes.size();
+	scope.statisticsQuery = UINT_MAX;
+	commandBuffer.WriteTimestamp(frame.timestamps, index * 2, gl::PipelineStage::None);
+	if (countStatistics && m_supportsStatistics && frame.numStatistics < k_maxStatistics)
+	{
+		scope.statisticsQuery = frame.numStatistics++;
+		commandBuffer.BeginQuery(frame.statistics, scope.statisticsQuery);
+	}
+	m_openScopes.push_back(index);
+}
+
+void GpuProfiler::EndScope(gl::CommandBuffer commandBuffer)
+{
+	if (m_recording == nullptr)
+		return;
+	GLEX_DEBUG_ASSERT(!m_openScopes.empty()) {}
+	uint32_t index = m_openScopes.back();
+	m_openScopes.pop_back();
+	if (index == UINT_MAX)
+		return;
+	Scope const& scope = m_recording->scopes[index];
+	if (scope.statisticsQuery != UINT_MAX)
+		commandBuffer.EndQuery(m_recording->statistics, scope.statisticsQuery);
+	commandBuffer.WriteTimestamp(m_recording->timestamps, index * 2 + 1, gl::PipelineStage::All);
+}
+
+GpuScopeResult const* GpuProfiler::FindResult(Name name) const
+{
+	for (GpuScopeResult const& result : m_results)
+	{
+		if (result.name == name)
+			return &result;
+	}
+	return nullptr;
+}
\ No newline at end of file
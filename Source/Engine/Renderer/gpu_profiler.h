@@ -0,0 +1,76 @@
+/**
+ * GPU time and pipeline statistics of render passes and their subpasses.
+ *
+ * Every frame in flight has its own query pools. They are read back when the frame comes around again, after
+ * its fence has been waited for, so reading never stalls. Results are renderAheadCount frames old.
+ * Only render passes count pipeline statistics, since a statistics query can't be nested in another.
+ */
+#pragma once
+#include "Core/Container/basic.h"
+#include "Core/Container/sequence.h"
+#include "Core/GL/command.h"
+#include "Core/GL/query.h"
+#include "Core/Utils/name.h"
+
+namespace glex
+{
+	struct GpuScopeResult
+	{
+		Name name;
+		uint32_t depth; // Subpasses are one deeper than their render pass.
+		double milliseconds;
+		// Zeros for subpasses, and if the device can't count them.
+		uint64_t primitives;
+		uint64_t vertexInvocations;
+		uint64_t fragmentInvocations;
+	};
+
+	namespace render
+	{
+		class GpuProfiler : private Unmoveable
+		{
+		public:
+			constexpr static uint32_t k_maxScopes = 128;
+			constexpr static uint32_t k_maxStatistics = 32;
+
+		private:
+			struct Scope
+			{
+				Name name;
+				uint32_t depth;
+				uint32_t statisticsQuery; // UINT_MAX without one.
+			};
+
+			struct FrameQueries
+			{
+				gl::QueryPool timestamps; // Begin and end of each scope.
+				gl::QueryPool statistics;
+				Vector<Scope> scopes;
+				uint32_t numStatistics = 0;
+				uint64_t cpuTicks = 0; // When recording started, the GPU track is lined up with it.
+			};
+
+			Vector<FrameQueries> m_frames;
+			FrameQueries* m_recording;
+			Vector<uint32_t> m_openScopes; // UINT_MAX for scopes past the limit.
+			Vector<GpuScopeResult> m_results;
+			double m_nanosecondsPerTimestamp;
+			bool m_supportsStatistics;
+
+			void ReadBack(FrameQueries& frame);
+
+		public:
+			GpuProfiler(uint32_t numFrames);
+			~GpuProfiler();
+			// Reads back what the frame recorded last time and resets its queries.
+			void BeginFrame(gl::CommandBuffer commandBuffer, uint32_t frameIndex);
+			// Statistics queries can't be begun inside a render pass.
+			void BeginScope(gl::CommandBuffer commandBuffer, Name name, bool countStatistics);
+			void EndScope(gl::CommandBuffer commandBuffer);
+			// Scopes of the newest frame read back, parents before their children.
+			SequenceView<GpuScopeResult const> GetResults() const { return m_results; }
+			// Null if there is no such scope in the results.
+			GpuScopeResult const* FindResult(Name name) const;
+		};
+	}
+}
\ No newline at end of file
@@ -29,21 +29,21 @@ MaterialInitializer::MaterialInitializer(SharedPtr<Shader> const& shader, void*
 MaterialInitializer::~MaterialInitializer()
 {
 	Mem::Free(m_uniformBufferData);
-	for (gl::PipelineState state : m_pipelineStates)
+	for (PipelineStateHandle handle : m_pipelineStates)
 	{
-		if (state.GetHandle() != VK_NULL_HANDLE)
-			Renderer::GetPipelineStateCache().FreePipelineState(state);
+		if (!handle.IsNull())
+			Renderer::GetPipelineStateCache().ReleasePipelineState(handle);
 	}
 }
 
-bool MaterialInitializer::SetFloat(char const* name, float value)
+bool MaterialInitializer::SetFloat(Name name, float value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::Float)
 		{
-			Logger::Error("property %s is not a float.", name);
+			Logger::Error("property %s is not a float.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<float>(m_uniformBufferData, prop.vector.offset) = value;
@@ -52,14 +52,14 @@ bool MaterialInitializer::SetFloat(char const* name, float value)
 	return false;
 }
 
-bool MaterialInitializer::SetVec2(char const* name, glm::vec2 value)
+bool MaterialInitializer::SetVec2(Name name, glm::vec2 value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::Vec2)
 		{
-			Logger::Error("property %s is not a vec2.", name);
+			Logger::Error("property %s is not a vec2.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::vec2>(m_uniformBufferData, prop.vector.offset) = value;
@@ -68,14 +68,14 @@ bool MaterialInitializer::SetVec2(char const* name, glm::vec2 value)
 	return false;
 }
 
-bool MaterialInitializer::SetVec3(char const* name, glm::vec3 value)
+bool MaterialInitializer::SetVec3(Name name, glm::vec3 value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::Vec3)
 		{
-			Logger::Error("property %s is not a vec3.", name);
+			Logger::Error("property %s is not a vec3.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::vec3>(m_uniformBufferData, prop.vector.offset) = value;
@@ -84,14 +84,14 @@ bool MaterialInitializer::SetVec3(char const* name, glm::vec3 value)
 	return false;
 }
 
-bool MaterialInitializer::SetVec4(char const* name, glm::vec4 const& value)
+bool MaterialInitializer::SetVec4(Name name, glm::vec4 const& value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::Vec4)
 		{
-			Logger::Error("property %s is not a vec4.", name);
+			Logger::Error("property %s is not a vec4.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::vec4>(m_uniformBufferData, prop.vector.offset) = value;
@@ -100,14 +100,14 @@ bool MaterialInitializer::SetVec4(char const* name, glm::vec4 const& value)
 	return false;
 }
 
-bool MaterialInitializer::SetInt(char const* name, int32_t value)
+bool MaterialInitializer::SetInt(Name name, int32_t value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::Int)
 		{
-			Logger::Error("property %s is not a int.", name);
+			Logger::Error("property %s is not a int.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<int32_t>(m_uniformBufferData, prop.vector.offset) = value;
@@ -116,14 +116,14 @@ bool MaterialInitializer::SetInt(char const* name, int32_t value)
 	return false;
 }
 
-bool MaterialInitializer::SetIVec2(char const* name, glm::ivec2 value)
+bool MaterialInitializer::SetIVec2(Name name, glm::ivec2 value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::IVec2)
 		{
-			Logger::Error("property %s is not a ivec2.", name);
+			Logger::Error("property %s is not a ivec2.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::ivec2>(m_uniformBufferData, prop.vector.offset) = value;
@@ -132,14 +132,14 @@ bool MaterialInitializer::SetIVec2(char const* name, glm::ivec2 value)
 	return false;
 }
 
-bool MaterialInitializer::SetIVec3(char const* name, glm::ivec3 value)
+bool MaterialInitializer::SetIVec3(Name name, glm::ivec3 value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::IVec3)
 		{
-			Logger::Error("property %s is not a ivec3.", name);
+			Logger::Error("property %s is not a ivec3.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::ivec3>(m_uniformBufferData, prop.vector.offset) = value;
@@ -148,14 +148,14 @@ bool MaterialInitializer::SetIVec3(char const* name, glm::ivec3 value)
 	return false;
 }
 
-bool MaterialInitializer::SetIVec4(char const* name, glm::ivec4 const& value)
+bool MaterialInitializer::SetIVec4(Name name, glm::ivec4 const& value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::IVec4)
 		{
-			Logger::Error("property %s is not a ivec4.", name);
+			Logger::Error("property %s is not a ivec4.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::ivec4>(m_uniformBufferData, prop.vector.offset) = value;
@@ -164,14 +164,14 @@ bool MaterialInitializer::SetIVec4(char const* name, glm::ivec4 const& value)
 	return false;
 }
 
-bool MaterialInitializer::SetUInt(char const* name, uint32_t value)
+bool MaterialInitializer::SetUInt(Name name, uint32_t value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::UInt)
 		{
-			Logger::Error("property %s is not a uint.", name);
+			Logger::Error("property %s is not a uint.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<uint32_t>(m_uniformBufferData, prop.vector.offset) = value;
@@ -180,14 +180,14 @@ bool MaterialInitializer::SetUInt(char const* name, uint32_t value)
 	return false;
 }
 
-bool MaterialInitializer::SetUVec2(char const* name, glm::uvec2 value)
+bool MaterialInitializer::SetUVec2(Name name, glm::uvec2 value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::UVec2)
 		{
-			Logger::Error("property %s is not a uvec2.", name);
+			Logger::Error("property %s is not a uvec2.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::uvec2>(m_uniformBufferData, prop.vector.offset) = value;
@@ -196,14 +196,14 @@ bool MaterialInitializer::SetUVec2(char const* name, glm::uvec2 value)
 	return false;
 }
 
-bool MaterialInitializer::SetUVec3(char const* name, glm::uvec3 value)
+bool MaterialInitializer::SetUVec3(Name name, glm::uvec3 value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::UVec3)
 		{
-			Logger::Error("property %s is not a uvec3.", name);
+			Logger::Error("property %s is not a uvec3.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::uvec3>(m_uniformBufferData, prop.vector.offset) = value;
@@ -212,14 +212,14 @@ bool MaterialInitializer::SetUVec3(char const* name, glm::uvec3 value)
 	return false;
 }
 
-bool MaterialInitializer::SetUVec4(char const* name, glm::uvec4 const& value)
+bool MaterialInitializer::SetUVec4(Name name, glm::uvec4 const& value)
 {
 	if (m_shader != nullptr)
 	{
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Vector || prop.vector.type != gl::DataType::UVec4)
 		{
-			Logger::Error("property %s is not a uvec4.", name);
+			Logger::Error("property %s is not a uvec4.", name.ToString());
 			return false;
 		}
 		*Mem::Offset<glm::uvec4>(m_uniformBufferData, prop.vector.offset) = value;
@@ -228,7 +228,7 @@ bool MaterialInitializer::SetUVec4(char const* name, glm::uvec4 const& value)
 	return false;
 }
 
-bool MaterialInitializer::SetTexture(char const* name, uint32_t index, SharedPtr<Texture> const& texture)
+bool MaterialInitializer::SetTexture(Name name, uint32_t index, SharedPtr<Texture> const& texture)
 {
 	if (m_shader != nullptr)
 	{
@@ -237,12 +237,12 @@ bool MaterialInitializer::SetTexture(char const* name, uint32_t index, SharedPtr
 		ShaderProperty prop = m_shader->GetProperty(name);
 		if (prop.type != ShaderPropertyType::Texture)
 		{
-			Logger::Error("Property %s is not a texture.", name);
+			Logger::Error("Property %s is not a texture.", name.ToString());
 			return false;
 		}
 		if (prop.texture.type != texture->GetImageView().Type())
 		{
-			Logger::Error("Type of property %s does not match input parameter.", name);
+			Logger::Error("Type of property %s does not match input parameter.", name.ToString());
 			return false;
 		}
 		for (auto& entry : m_textures)
@@ -265,13 +265,13 @@ bool MaterialInitializer::AddMaterialDomain(uint32_t materialDomain, SharedPtr<S
 {
 	m_pipelineStates.resize(glm::max(m_pipelineStates.size(), materialDomain + 1));
 	auto [renderPass, subpass, metaMaterial] = Renderer::GetRenderPipeline()->ResolveMaterialDomain(materialDomain);
-	gl::PipelineState state = Renderer::GetPipelineStateCache().GetPipelineState(shader, metaMaterial, renderPass.GetRenderPassObject(), subpass);
-	if (state.GetHandle() == VK_NULL_HANDLE)
+	PipelineStateHandle handle = Renderer::GetPipelineStateCache().AcquirePipelineState(shader, metaMaterial, renderPass.GetRenderPassObject(), subpass);
+	if (handle.IsNull())
 		return false;
-	gl::PipelineState& old = m_pipelineStates[materialDomain];
-	if (old.GetHandle() != VK_NULL_HANDLE)
-		Renderer::GetPipelineStateCache().FreePipelineState(old);
-	old = state;
+	PipelineStateHandle& old = m_pipelineStates[materialDomain];
+	if (!old.IsNull())
+		Renderer::GetPipelineStateCache().ReleasePipelineState(old);
+	old = handle;
 	return true;
 }
 
@@ -285,6 +285,7 @@ Material::Material(MaterialInitializer& init) : m_shader(std::move(init.m_shader
 		Vector<gl::Descriptor> descriptors;
 		gl::BufferDescriptor uniformBuffer;
 		Vector<gl::ImageSamplerDesciptor> imageSamplers;
+		UploadTicket uploadTicket;
 
 		if (m_shader->UniformBufferSize() != 0)
 		{
@@ -295,7 +296,7 @@ Material::Material(MaterialInitializer& init) : m_shader(std::move(init.m_shader
 				return;
 			}
 
-			Renderer::UploadBuffer(&m_uniformBuffer, 0, m_shader->UniformBufferSize(), init.m_uniformBufferData);
+			uploadTicket = Renderer::UploadBuffer(&m_uniformBuffer, 0, m_shader->UniformBufferSize(), init.m_uniformBufferData);
 			uniformBuffer.buffer = m_uniformBuffer->GetBufferObject();
 			uniformBuffer.offset = 0;
 			uniformBuffer.size = m_shader->UniformBufferSize();
@@ -319,6 +320,7 @@ Material::Material(MaterialInitializer& init) : m_shader(std::move(init.m_shader
 					descriptor.image.imageView = texture->GetImageView().GetImageViewObject();
 					descriptor.image.imageLayout = gl::ImageLayout::ShaderRead;
 					descriptor.sampler.sampler = texture->GetSampler();
+					uploadTicket |= texture->GetUploadTicket();
 				}
 				else
 					Logger::Warn("Texture at location %d, index %d is not set.", location, i);
@@ -332,6 +334,9 @@ Material::Material(MaterialInitializer& init) : m_shader(std::move(init.m_shader
 		}
 		m_descriptorSet = Renderer::AllocateStaticMaterialDescriptorSet(m_shader->GetMaterialLayout());
 		m_descriptorSet.BindDescriptors(descriptors);
+		// Materials are few and every draw would have to check them, so they wait here instead.
+		// The textures' uploads have been in flight since they loaded.
+		uploadTicket.Wait();
 	}
 	m_pipelineStates = std::move(init.m_pipelineStates);
 }
@@ -346,10 +351,15 @@ Material::~Material()
 			if (m_shader->UniformBufferSize())
 				m_uniformBuffer.Destroy();
 		}
-		for (gl::PipelineState state : m_pipelineStates)
+		for (PipelineStateHandle handle : m_pipelineStates)
 		{
-			if (state.GetHandle() != VK_NULL_HANDLE)
-				Renderer::GetPipelineStateCache().FreePipelineState(state);
+			if (!handle.IsNull())
+				Renderer::GetPipelineStateCache().ReleasePipelineState(handle);
 		}
 	}
+}
+
+gl::PipelineState Material::GetPipelineState(uint32_t materialDomain) const
+{
+	return Renderer::GetPipelineStateCache().GetPipelineState(m_pipelineStates[materialDomain]);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Engine/Renderer/shader.h"
 #include "Engine/Renderer/texture.h"
 #include "Engine/Renderer/buffer.h"
+#include "Engine/Renderer/cache.h"
 #include "Engine/resbase.h"
 #include "Core/Memory/smart_ptr.h"
 
@@ -15,26 +16,26 @@ namespace glex
 		SharedPtr<Shader> m_shader;
 		void* m_uniformBufferData;
 		Vector<std::pair<uint32_t, InlineVector<SharedPtr<Texture>, 2>>> m_textures;
-		Vector<gl::PipelineState> m_pipelineStates;
+		Vector<PipelineStateHandle> m_pipelineStates;
 
 	public:
 		MaterialInitializer(SharedPtr<Shader> const& shader); // For template only.
 		MaterialInitializer(SharedPtr<Shader> const& shader, void* data, uint32_t size);
 		~MaterialInitializer();
 		bool IsValid() const { return m_shader != nullptr; }
-		bool SetFloat(char const* name, float value);
-		bool SetVec2(char const* name, glm::vec2 value);
-		bool SetVec3(char const* name, glm::vec3 value);
-		bool SetVec4(char const* name, glm::vec4 const& value);
-		bool SetInt(char const* name, int32_t value);
-		bool SetIVec2(char const* name, glm::ivec2 value);
-		bool SetIVec3(char const* name, glm::ivec3 value);
-		bool SetIVec4(char const* name, glm::ivec4 const& value);
-		bool SetUInt(char const* name, uint32_t value);
-		bool SetUVec2(char const* name, glm::uvec2 value);
-		bool SetUVec3(char const* name, glm::uvec3 value);
-		bool SetUVec4(char const* name, glm::uvec4 const& value);
-		bool SetTexture(char const* name, uint32_t index, SharedPtr<Texture> const& texture);
+		bool SetFloat(Name name, float value);
+		bool SetVec2(Name name, glm::vec2 value);
+		bool SetVec3(Name name, glm::vec3 value);
+		bool SetVec4(Name name, glm::vec4 const& value);
+		bool SetInt(Name name, int32_t value);
+		bool SetIVec2(Name name, glm::ivec2 value);
+		bool SetIVec3(Name name, glm::ivec3 value);
+		bool SetIVec4(Name name, glm::ivec4 const& value);
+		bool SetUInt(Name name, uint32_t value);
+		bool SetUVec2(Name name, glm::uvec2 value);
+		bool SetUVec3(Name name, glm::uvec3 value);
+		bool SetUVec4(Name name, glm::uvec4 const& value);
+		bool SetTexture(Name name, uint32_t index, SharedPtr<Texture> const& texture);
 		bool AddMaterialDomain(uint32_t materialDomain, SharedPtr<Shader> shader);
 	};
 
@@ -48,7 +49,7 @@ namespace glex
 		SharedPtr<Shader> m_shader;        // For template only.
 		Optional<Buffer> m_uniformBuffer;
 		gl::DescriptorSet m_descriptorSet; // Can be null if we don't have any parameters.
-		Vector<gl::PipelineState> m_pipelineStates;
+		Vector<PipelineStateHandle> m_pipelineStates;
 
 		Material(MaterialInitializer& init);
 		bool IsValid() const { return m_shader != nullptr; }
@@ -56,6 +57,6 @@ namespace glex
 	public:
 		~Material();
 		gl::DescriptorSet GetDescriptorSet() const { return m_descriptorSet; }
-		gl::PipelineState GetPipelineState(uint32_t materialDomain) const { return m_pipelineStates[materialDomain]; }
+		gl::PipelineState GetPipelineState(uint32_t materialDomain) const;
 	};
 }
\ No newline at end of file
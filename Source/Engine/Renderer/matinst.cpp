@@ -3,7 +3,7 @@
 
 using namespace glex;
 
-MaterialInstance::MaterialInstance(SharedPtr<Material> const& material, uint32_t materialDomain, SharedPtr<Shader> const& rebindShader)
+MaterialInstance::MaterialInstance(SharedPtr<Material> const& material, uint32_t materialDomain, SharedPtr<Shader> const& rebindShader, SharedPtr<MaterialInstance> fallback) : m_fallback(std::move(fallback))
 {
 	// Validity check.
 	if (!material->IsValid())
@@ -18,30 +18,40 @@ MaterialInstance::MaterialInstance(SharedPtr<Material> const& material, uint32_t
 	m_material = material;
 
 	auto [renderPass, subpass, metaMaterial] = Renderer::GetRenderPipeline()->ResolveMaterialDomain(materialDomain);
-	m_pipelineObject = Renderer::GetPipelineStateCache().GetPipelineState(m_shader, metaMaterial, renderPass.GetRenderPassObject(), subpass);
+	m_pipelineHandle = Renderer::GetPipelineStateCache().AcquirePipelineState(m_shader, metaMaterial, renderPass.GetRenderPassObject(), subpass);
+	m_pipelineObject = Renderer::GetPipelineStateCache().GetPipelineState(m_pipelineHandle).GetHandle();
 	m_metaMaterial = metaMaterial;
-	if (m_pipelineObject.GetHandle() == VK_NULL_HANDLE)
-	{
-		m_material = nullptr;
-		m_shader = nullptr;
-	}
 }
 
 MaterialInstance::~MaterialInstance()
 {
-	if (m_pipelineObject.GetHandle() != VK_NULL_HANDLE)
-		Renderer::GetPipelineStateCache().FreePipelineState(m_pipelineObject);
+	if (!m_pipelineHandle.IsNull())
+		Renderer::GetPipelineStateCache().ReleasePipelineState(m_pipelineHandle);
 }
 
-void MaterialInstance::Bind()
+bool MaterialInstance::Bind()
 {
 	WeakPtr<MaterialInstance>& currentMaterialInstance = Renderer::GetCurrentMaterialInstance();
+	gl::PipelineState pipelineState = GetPipelineState();
+	if (pipelineState.GetHandle() == VK_NULL_HANDLE)
+	{
+		pipelineState = Renderer::GetPipelineStateCache().GetPipelineState(m_pipelineHandle);
+		if (pipelineState.GetHandle() == VK_NULL_HANDLE)
+		{
+			// Still compiling, or it never will be.
+			if (m_fallback != nullptr && m_fallback->Bind())
+				return true;
+			currentMaterialInstance = nullptr;
+			return false;
+		}
+		Atomic::Store(&m_pipelineObject, pipelineState.GetHandle());
+	}
 	gl::CommandBuffer commandBuffer = Renderer::CurrentCommandBuffer();
 	if (currentMaterialInstance != this)
 	{
-		if (currentMaterialInstance == nullptr || currentMaterialInstance->m_pipelineObject != m_pipelineObject)
+		if (currentMaterialInstance == nullptr || currentMaterialInstance->GetPipelineState() != pipelineState)
 		{
-			commandBuffer.BindPipelineState(m_pipelineObject);
+			commandBuffer.BindPipelineState(pipelineState);
 			if (currentMaterialInstance == nullptr)
 			{
 				gl::DescriptorSet globalSet = Renderer::GetRenderPipeline()->GetGlobalDescriptorSet();
@@ -53,4 +63,5 @@ void MaterialInstance::Bind()
 			commandBuffer.BindDescriptorSet(m_shader->GetDescriptorLayout(), Renderer::MATERIAL_DESCRIPOR_SET, m_material->GetDescriptorSet());
 		currentMaterialInstance = this;
 	}
+	return true;
 }
\ No newline at end of file
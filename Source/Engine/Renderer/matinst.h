@@ -7,6 +7,7 @@
  */
 #pragma once
 #include "Engine/Renderer/material.h"
+#include "Core/Thread/atomic.h"
 
 namespace glex
 {
@@ -15,15 +16,22 @@ namespace glex
 	private:
 		SharedPtr<Material> m_material;
 		SharedPtr<Shader> m_shader;
-		gl::PipelineState m_pipelineObject;
+		PipelineStateHandle m_pipelineHandle;
+		// Resolved once compiled, it lives as long as the handle. Threads recording draws may resolve it together, so it's only accessed atomically.
+		VkPipeline m_pipelineObject = VK_NULL_HANDLE;
 		gl::MetaMaterialInfo m_metaMaterial;
+		SharedPtr<MaterialInstance> m_fallback;
 
 	public:
-		MaterialInstance(SharedPtr<Material> const& material, uint32_t materialDomain, SharedPtr<Shader> const& rebindShader = nullptr);
+		// The pipeline state compiles in the background. Until it's done, the fallback is bound in its place.
+		// The fallback must be for the same render pass and subpass.
+		MaterialInstance(SharedPtr<Material> const& material, uint32_t materialDomain, SharedPtr<Shader> const& rebindShader = nullptr, SharedPtr<MaterialInstance> fallback = nullptr);
 		~MaterialInstance();
-		bool IsValid() const { return m_pipelineObject.GetHandle() != VK_NULL_HANDLE; }
-		void Bind();
+		bool IsValid() const { return !m_pipelineHandle.IsNull(); }
+		bool IsReady() const { return Atomic::Load(&m_pipelineObject) != VK_NULL_HANDLE; }
+		// False if neither this nor the fallback can be bound yet. Draws are skipped until another material is bound.
+		bool Bind();
 		SharedPtr<Shader> const& GetShader() { return m_shader; }
-		gl::PipelineState GetPipelineState() const { return m_pipelineObject; }
+		gl::PipelineState GetPipelineState() const { return Atomic::Load(&m_pipelineObject); }
 	};
 }
\ No newline at end of file
@@ -59,7 +59,7 @@ Mesh::Mesh(MeshInitializer init)
 		SharedPtr<Buffer> meshBuffer = MakeShared<Buffer>(gl::BufferUsage::Vertex | gl::BufferUsage::Index | gl::BufferUsage::TransferDest, actualSize, false);
 		if (!meshBuffer->IsValid())
 			goto ANOTHER_ERROR;
-		Renderer::UploadBuffer(meshBuffer, 0, actualSize, original);
+		m_uploadTicket = Renderer::UploadBuffer(meshBuffer, 0, actualSize, original);
 		m_vertexBuffer = meshBuffer;
 		m_vertexBufferOffset = 0;
 		m_indexBuffer = std::move(meshBuffer);
@@ -167,8 +167,8 @@ Mesh::Mesh(void const* vertexBuffer, uint32_t vertexBufferSize, void const* inde
 	SharedPtr<Buffer> meshBuffer = MakeShared<Buffer>(gl::BufferUsage::Vertex | gl::BufferUsage::Index | gl::BufferUsage::TransferDest, vertexBufferSize + indexBufferSize, false);
 	if (meshBuffer->IsValid())
 	{
-		Renderer::UploadBuffer(meshBuffer, 0, vertexBufferSize, vertexBuffer);
-		Renderer::UploadBuffer(meshBuffer, vertexBufferSize, indexBufferSize, indexBuffer);
+		m_uploadTicket = Renderer::UploadBuffer(meshBuffer, 0, vertexBufferSize, vertexBuffer);
+		m_uploadTicket |= Renderer::UploadBuffer(meshBuffer, vertexBufferSize, indexBufferSize, indexBuffer);
 		m_vertexBuffer = meshBuffer;
 		m_vertexBufferOffset = 0;
 		m_vertexBufferSize = vertexBufferSize;
@@ -189,6 +189,9 @@ Mesh::Mesh(void const* vertexBuffer, uint32_t vertexBufferSize, void const* inde
 
 void Mesh::Draw() const
 {
+	// Nothing is bound while the material's pipeline state compiles.
+	if (!IsReady() || Renderer::GetCurrentMaterialInstance() == nullptr)
+		return;
 	gl::CommandBuffer commandBuffer = Renderer::CurrentCommandBuffer();
 	commandBuffer.BindVertexBuffer(m_vertexBuffer->GetBufferObject(), m_vertexBufferOffset);
 	commandBuffer.BindIndexBuffer(m_indexBuffer->GetBufferObject(), m_indexBufferOffset);
@@ -4,6 +4,7 @@
  */
 #pragma once
 #include "Engine/Renderer/buffer.h"
+#include "Engine/Renderer/upload.h"
 #include "Core/Memory/smart_ptr.h"
 #include "Core/Container/sequence.h"
 #include "Core/GL/enums.h"
@@ -41,6 +42,7 @@ namespace glex
 		uint32_t m_numVertexAttributes;
 		gl::DataType m_vertexLayout[Limits::NUM_VERTEX_ATTRIBUTES];
 		SharedPtr<Skeleton> m_skeleton;
+		UploadTicket m_uploadTicket;
 
 		Mesh(MeshInitializer init);
 		Mesh(char const* meshFile, char const* meshName);
@@ -56,6 +58,9 @@ namespace glex
 		uint32_t IndexBufferOffset() const { return m_indexBufferOffset; }
 		uint32_t IndexBufferSize() const { return m_indexBufferSize; }
 		glm::vec4 const& BoundingSphere() const { return m_boundingSphere; }
+		// Until then drawing it does nothing.
+		bool IsReady() const { return m_uploadTicket.IsComplete(); }
+		UploadTicket GetUploadTicket() const { return m_uploadTicket; }
 		void Draw() const;
 
 		static SharedPtr<Mesh> MakeTutorialTriangle(float edge);
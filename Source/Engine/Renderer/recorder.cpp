@@ -0,0 +1,100 @@
+#include "Engine/Renderer/recorder.h"
+#include "Engine/Renderer/renderer.h"
+#include "Core/GL/context.h"
+#include "Core/Thread/task.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Utils/telemetry.h"
+#include "Core/assert.h"
+
+using namespace glex;
+using namespace glex::render;
+
+CommandRecorder::CommandRecorder(uint32_t numFrames) : m_currentFrame(0)
+{
+	uint32_t numThreads = Async::ThreadCount() + 1;
+	m_frames.resize(numFrames);
+	for (Vector<ThreadCommands>& threads : m_frames)
+	{
+		threads.resize(numThreads);
+		for (ThreadCommands& thread : threads)
+		{
+			if (!thread.commandPool.Create(Context::DeviceInfo().graphicsQueueIndex, true))
+				Logger::Fatal("Cannot create command pools for recording.");
+		}
+	}
+}
+
+CommandRecorder::~CommandRecorder()
+{
+	// The device is idle by now. Command buffers go with their pools.
+	for (Vector<ThreadCommands>& threads : m_frames)
+	{
+		for (ThreadCommands& thread : threads)
+			thread.commandPool.Destroy();
+	}
+}
+
+uint32_t CommandRecorder::ThreadIndex()
+{
+	if (t_threadIndex == UINT_MAX) GLEX_UNLIKELY
+		t_threadIndex = Atomic::Increment(&s_numThreads) - 1;
+	return t_threadIndex;
+}
+
+void CommandRecorder::BeginFrame(uint32_t frameIndex)
+{
+	m_currentFrame = frameIndex;
+	for (ThreadCommands& thread : m_frames[frameIndex])
+	{
+		if (thread.numUsed != 0)
+			thread.commandPool.Reset();
+		thread.numUsed = 0;
+	}
+}
+
+gl::CommandBuffer CommandRecorder::BeginRange(Inheritance const& inheritance)
+{
+	uint32_t threadIndex = ThreadIndex();
+	GLEX_ASSERT_MSG(threadIndex < m_frames[m_currentFrame].size(), "Only pool workers and the main thread can record.") {}
+	ThreadCommands& thread = m_frames[m_currentFrame][threadIndex];
+	if (thread.numUsed == thread.commandBuffers.size())
+	{
+		gl::CommandBuffer commandBuffer = thread.commandPool.AllocateCommandBuffer(true);
+		if (commandBuffer.GetHandle() == VK_NULL_HANDLE)
+			Logger::Fatal("Cannot allocate secondary command buffer.");
+		thread.commandBuffers.push_back(commandBuffer);
+	}
+	gl::CommandBuffer commandBuffer = thread.commandBuffers[thread.numUsed++];
+	commandBuffer.BeginSecondary(inheritance.renderPass, inheritance.subpass, inheritance.frameBuffer);
+	commandBuffer.SetViewport(glm::vec4(0.0f, 0.0f, inheritance.size.x, inheritance.size.y));
+	commandBuffer.SetScissor(glm::uvec4(0, 0, inheritance.size.x, inheritance.size.y));
+	// Nothing is bound in a new command buffer.
+	Renderer::t_recordingCommandBuffer = commandBuffer;
+	Renderer::t_currentMaterialInstance = nullptr;
+	return commandBuffer;
+}
+
+void CommandRecorder::EndRange(gl::CommandBuffer commandBuffer)
+{
+	commandBuffer.End();
+	Renderer::t_recordingCommandBuffer = gl::CommandBuffer();
+	Renderer::t_currentMaterialInstance = nullptr;
+}
+
+void CommandRecorder::Record(gl::CommandBuffer primary, Inheritance const& inheritance, uint32_t numDraws, Function<void(uint32_t, uint32_t)> const& fn)
+{
+	if (numDraws == 0)
+		return;
+	uint32_t numRanges = Min((numDraws - 1) / k_minDrawsPerRange + 1, (Async::ThreadCount() + 1) * k_rangesPerThread);
+	InlineVector<gl::CommandBuffer, k_maxRanges> commandBuffers(numRanges);
+	Async::ParallelFor(0, numRanges, 1, [&](uint32_t range)
+	{
+		GLEX_PROFILE_SCOPE("Record draws");
+		TelemetryScope telemetry(TelemetryCounter::CommandRecord);
+		gl::CommandBuffer commandBuffer = BeginRange(inheritance);
+		fn(static_cast<uint64_t>(range) * numDraws / numRanges, static_cast<uint64_t>(range + 1) * numDraws / numRanges);
+		EndRange(commandBuffer);
+		commandBuffers[range] = commandBuffer;
+	});
+	primary.ExecuteCommands({ commandBuffers.data(), commandBuffers.size() });
+}
\ No newline at end of file
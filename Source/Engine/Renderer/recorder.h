@@ -0,0 +1,61 @@
+/**
+ * Records the draws of a subpass into secondary command buffers on the pool workers.
+ *
+ * Every recording thread has a command pool per frame in flight, reset when its frame comes around again.
+ * A draw list is cut into contiguous ranges, each recorded into a secondary command buffer of its own, and the
+ * primary executes them in the order of the ranges, so draws end up in the order they were listed.
+ * While a range is recorded, Renderer::CurrentCommandBuffer() on that thread is its secondary.
+ */
+#pragma once
+#include "Core/Container/basic.h"
+#include "Core/Container/function.h"
+#include "Core/GL/command.h"
+#include "Core/Thread/pool.h"
+
+namespace glex::render
+{
+	class CommandRecorder : private Unmoveable
+	{
+	public:
+		constexpr static uint32_t k_minDrawsPerRange = 64;
+		constexpr static uint32_t k_rangesPerThread = 4; // Slow ranges don't hold everyone up.
+		constexpr static uint32_t k_maxRanges = (ThreadPool::k_maxThreads + 1) * k_rangesPerThread;
+
+		// The subpass the secondaries continue.
+		struct Inheritance
+		{
+			gl::RenderPass renderPass;
+			uint32_t subpass;
+			gl::FrameBuffer frameBuffer;
+			glm::uvec2 size;
+		};
+
+	private:
+		struct ThreadCommands
+		{
+			gl::CommandPool commandPool;
+			Vector<gl::CommandBuffer> commandBuffers;
+			uint32_t numUsed = 0;
+		};
+
+		// Pool workers and the main thread, numbered as they first record.
+		inline static thread_local uint32_t t_threadIndex = UINT_MAX;
+		inline static uint32_t s_numThreads = 0;
+
+		Vector<Vector<ThreadCommands>> m_frames; // Per frame, per thread.
+		uint32_t m_currentFrame;
+
+		static uint32_t ThreadIndex();
+		gl::CommandBuffer BeginRange(Inheritance const& inheritance);
+		void EndRange(gl::CommandBuffer commandBuffer);
+
+	public:
+		CommandRecorder(uint32_t numFrames);
+		~CommandRecorder();
+		// The frame has finished on the GPU.
+		void BeginFrame(uint32_t frameIndex);
+		// Calls fn(begin, end) for ranges covering [0, numDraws), on any thread of the pool, and executes their
+		// secondaries from the primary. The primary must be in a subpass begun with secondary contents.
+		void Record(gl::CommandBuffer primary, Inheritance const& inheritance, uint32_t numDraws, Function<void(uint32_t, uint32_t)> const& fn);
+	};
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Engine/GUI/batch.h"
 #include "Core/GL/enums.h"
 #include "Core/log.h"
+#include "Core/Utils/telemetry.h"
 #include "game.h"
 
 using namespace glex;
@@ -27,9 +28,9 @@ uint32_t RenderPass::Builder::GetOrAddAttachment(WeakPtr<ImageView> attachment)
 	return iter->second;
 }
 
-void RenderPass::Builder::PushSubpass()
+void RenderPass::Builder::PushSubpass(bool parallel)
 {
-	m_subpasses.emplace_back();
+	m_subpasses.emplace_back().parallel = parallel;
 }
 
 void RenderPass::Builder::Read(WeakPtr<ImageView> attachment)
@@ -313,6 +314,18 @@ bool RenderPass::EndRenderPassDefinition(Builder& builder)
 	m_renderPassObject = GetCachedOrCreateNewRenderPass(builder);
 	if (m_renderPassObject.GetHandle() != VK_NULL_HANDLE)
 	{
+		static uint32_t s_numDefined = 0;
+		if (m_name.IsNone())
+		{
+			char name[16];
+			snprintf(name, sizeof(name), "Pass %u", s_numDefined);
+			m_name = name;
+		}
+		s_numDefined++;
+		m_parallelSubpasses.clear();
+		for (SubpassInternal const& subpass : builder.GetSubpasses())
+			m_parallelSubpasses.push_back(subpass.parallel);
+		NameSubpasses();
 		m_renderAera = builder.GetRenderAera();
 		Vector<gl::ImageView> attachments(builder.GetAttachments().size());
 		for (uint32_t i = 0; i < builder.GetAttachments().size(); i++)
@@ -348,6 +361,27 @@ void RenderPass::Invalidate()
 	}
 }
 
+void RenderPass::NameSubpasses()
+{
+	m_subpassNames.clear();
+	// Timestamps can't be written into subpasses with secondary contents.
+	if (m_parallelSubpasses.size() < 2 || HasParallelSubpass())
+		return;
+	char const* passName = m_name.ToString();
+	char name[256];
+	for (uint32_t i = 0; i < m_parallelSubpasses.size(); i++)
+	{
+		snprintf(name, sizeof(name), "%s/%u", passName, i);
+		m_subpassNames.push_back(name);
+	}
+}
+
+void RenderPass::SetName(Name name)
+{
+	m_name = name;
+	NameSubpasses();
+}
+
 bool RenderPass::Recreate()
 {
 	GLEX_ASSERT(IsValid()) {}
@@ -383,21 +417,39 @@ void RenderPass::BeginRenderPass(SequenceView<gl::ClearValue const> clearValues)
 		}
 	}
 
-	commandBuffer.BeginRenderPass(m_renderPassObject, m_frameBuffer, m_renderAera, clearValues);
+	// Set before the render pass, a first subpass with secondary contents takes nothing else.
 	commandBuffer.SetViewport(glm::vec4(0.0f, 0.0f, m_renderAera.x, m_renderAera.y));
 	commandBuffer.SetScissor(glm::uvec4(0, 0, m_renderAera.x, m_renderAera.y));
+	// Statistics queries have to enclose the whole render pass. Secondaries can only run inside them if the device inherits queries.
+	render::GpuProfiler& profiler = Renderer::GetGpuProfiler();
+	profiler.BeginScope(commandBuffer, m_name, !HasParallelSubpass() || gl::Context::DeviceInfo().supportsInheritedQueries);
+	commandBuffer.BeginRenderPass(m_renderPassObject, m_frameBuffer, m_renderAera, clearValues, m_parallelSubpasses[0]);
+	m_currentSubpass = 0;
+	if (!m_subpassNames.empty())
+		profiler.BeginScope(commandBuffer, m_subpassNames[0], false);
 }
 
 void RenderPass::NextSubpass()
 {
 	gl::CommandBuffer commandBuffer = Renderer::CurrentCommandBuffer();
-	commandBuffer.NextSubpass();
+	render::GpuProfiler& profiler = Renderer::GetGpuProfiler();
+	m_currentSubpass++;
+	if (!m_subpassNames.empty())
+		profiler.EndScope(commandBuffer);
+	GLEX_DEBUG_ASSERT(m_currentSubpass < m_parallelSubpasses.size()) {}
+	commandBuffer.NextSubpass(m_parallelSubpasses[m_currentSubpass]);
+	if (m_currentSubpass < m_subpassNames.size())
+		profiler.BeginScope(commandBuffer, m_subpassNames[m_currentSubpass], false);
 }
 
 void RenderPass::EndRenderPass()
 {
 	gl::CommandBuffer commandBuffer = Renderer::CurrentCommandBuffer();
+	render::GpuProfiler& profiler = Renderer::GetGpuProfiler();
+	if (!m_subpassNames.empty())
+		profiler.EndScope(commandBuffer);
 	commandBuffer.EndRenderPass();
+	profiler.EndScope(commandBuffer);
 
 	for (AttachmentInformation const& attach : m_attachments)
 	{
@@ -413,6 +465,8 @@ void RenderPass::BindObjectData(void const* data, uint32_t size)
 	// Even though we got 256, we don't have a custom shader compiler so it's hard to use more.
 	uint32_t pushConstantsSize = glm::min<uint32_t>(size, 128);
 	uint32_t exceedSize = size - pushConstantsSize;
+	if (Renderer::GetCurrentMaterialInstance() == nullptr)
+		return;
 	gl::CommandBuffer commandBuffer = Renderer::CurrentCommandBuffer();
 	WeakPtr<Shader> shader = Renderer::GetCurrentMaterialInstance()->GetShader();
 	commandBuffer.PushConstants(shader->GetDescriptorLayout(), gl::ShaderStage::AllGraphics, 0, size, data);
@@ -420,8 +474,16 @@ void RenderPass::BindObjectData(void const* data, uint32_t size)
 		Logger::Error("Object data more than 128 bytes not supported yet!");
 }
 
+void RenderPass::DrawParallel(uint32_t numDraws, Function<void(uint32_t, uint32_t)> const& fn)
+{
+	GLEX_DEBUG_ASSERT(m_parallelSubpasses[m_currentSubpass]) {}
+	render::CommandRecorder::Inheritance inheritance = { m_renderPassObject, m_currentSubpass, m_frameBuffer, m_renderAera };
+	Renderer::GetCommandRecorder().Record(Renderer::CurrentCommandBuffer(), inheritance, numDraws, fn);
+}
+
 void RenderPass::DrawAllControls()
 {
+	TelemetryScope telemetry(TelemetryCounter::GuiBatch);
 	ui::BatchRenderer::BeginUIPass();
 	auto& controlStack = GameInstance::GetControlStack();
 	for (UniquePtr<ui::Control> const& control : controlStack)
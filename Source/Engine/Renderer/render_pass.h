@@ -7,6 +7,8 @@
 #include "Core/GL/command.h"
 #include "Core/Container/basic.h"
 #include "Core/assert.h"
+#include "Core/Utils/name.h"
+#include "Core/Container/function.h"
 #include "Engine/Renderer/image.h"
 #include "Engine/Renderer/mesh.h"
 #include "Engine/Renderer/matinst.h"
@@ -47,6 +49,7 @@ namespace glex
 			Vector<std::pair<uint32_t, gl::ImageLayout> const> colorOutputs;
 			std::pair<uint32_t, gl::ImageLayout> depthStencilOutputs = { UINT_MAX, gl::ImageLayout::Undefined };
 			Vector<uint32_t> passThroughs;
+			bool parallel = false;
 		};
 
 		class Builder
@@ -61,7 +64,8 @@ namespace glex
 			uint32_t GetOrAddAttachment(WeakPtr<ImageView> attachment);
 
 		public:
-			void PushSubpass();
+			// Draws of a parallel subpass are recorded with DrawParallel only.
+			void PushSubpass(bool parallel = false);
 			void Read(WeakPtr<ImageView> attachment);
 			void Write(WeakPtr<ImageView> attachment);
 			void Clear(WeakPtr<ImageView> attachment);
@@ -105,6 +109,14 @@ namespace glex
 		gl::FrameBuffer m_frameBuffer;
 		glm::vec2 m_renderAera;
 		Vector<AttachmentInformation> m_attachments;
+		Vector<bool> m_parallelSubpasses; // One per subpass.
+		uint32_t m_currentSubpass;
+		// GPU profiler scopes, subpasses get "pass/i" when there is more than one.
+		Name m_name;
+		Vector<Name> m_subpassNames;
+
+		void NameSubpasses();
+		bool HasParallelSubpass() const { return eastl::find(m_parallelSubpasses.begin(), m_parallelSubpasses.end(), true) != m_parallelSubpasses.end(); }
 
 	protected:
 		Builder BeginRenderPassDefinition()
@@ -117,16 +129,22 @@ namespace glex
 		void BeginRenderPass(SequenceView<gl::ClearValue const> clearValues);
 		void NextSubpass();
 		void EndRenderPass();
-		void BindMaterial(WeakPtr<MaterialInstance> material) { material->Bind(); }
+		// False if the material's pipeline state is still compiling. Draws are skipped until the next material.
+		bool BindMaterial(WeakPtr<MaterialInstance> material) { return material->Bind(); }
 		void BindObjectData(void const* data, uint32_t size);
 		void DrawMesh(WeakPtr<Mesh> mesh) { mesh->Draw(); }
 		void DrawAllControls();
+		// fn(begin, end) records the draws in [begin, end) of a list, on pool workers. They are executed in list order.
+		void DrawParallel(uint32_t numDraws, Function<void(uint32_t, uint32_t)> const& fn);
 
 	public:
 		~RenderPass();
 		bool IsValid() const { return m_frameBuffer.GetHandle() != VK_NULL_HANDLE; }
 		void Invalidate();
 		gl::RenderPass GetRenderPassObject() const { return m_renderPassObject; }
+		// "Pass N" in order of definition until named.
+		void SetName(Name name);
+		Name GetName() const { return m_name; }
 		bool Recreate();
 	};
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "Engine/Renderer/renderer.h"
 #include "Engine/GUI/batch.h"
 #include "Core/GL/context.h"
+#include "Core/Memory/framealloc.h"
+#include "Core/Platform/time.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Utils/telemetry.h"
 #include "game.h"
 #include <stb/stb_image.h>
 
@@ -36,12 +40,14 @@ renderFinishedSemaphore(rhs.renderFinishedSemaphore), inFlightFence(rhs.inFlight
 
 void Renderer::Startup(RendererStartupInfo const& info)
 {
+	ScopedMemoryTag tag(MemoryTag::Renderer);
 	// Context startup.
 	// TODO: validate render settings.
 	ContextStartupInfo contextInfo;
 	contextInfo.cardSelector = info.cardSelector;
 	contextInfo.useTripleBuffering = info.settings.useTripleBuffering;
 	contextInfo.enableVsync = info.settings.enableVsync;
+	contextInfo.pipelineCacheFile = info.pipelineCacheFile;
 	Context::Startup(contextInfo);
 	s_renderSettings = info.settings;
 	s_renderSettings.useTripleBuffering = s_renderSettings.useTripleBuffering && Context::DeviceInfo().SupportsTripleBuffering();
@@ -55,13 +61,13 @@ void Renderer::Startup(RendererStartupInfo const& info)
 	// Ourself startup.
 	s_frameResources.resize(s_renderSettings.renderAheadCount);
 	s_currentFrame = 0;
-	constexpr uint32_t intialStagingBufferSize = Limits::TEXTURE_SIZE * Limits::TEXTURE_SIZE * 4; // 256 MB.
-	s_stagingBuffer = MakeShared<Buffer>(gl::BufferUsage::TransferSource, intialStagingBufferSize, true);
-	if (!s_stagingBuffer->IsValid())
-		Logger::Fatal("Cannot create staging buffer. Is shared VRAM too small?");
-	if (!s_transferFence.Create(false))
-		Logger::Fatal("Cannot create transfer fence.");
-	s_stagingBufferData = s_stagingBuffer->GetMemoryObject().Map(0, intialStagingBufferSize);
+	FrameMemory::Startup(s_renderSettings.renderAheadCount);
+	constexpr uint32_t uploadStagingSize = Limits::TEXTURE_SIZE * Limits::TEXTURE_SIZE * 4; // 256 MB, the largest texture fits.
+	s_uploadQueue.Emplace(uploadStagingSize);
+	if (!s_uploadQueue->IsValid())
+		Logger::Fatal("Cannot create upload queue. Is shared VRAM too small?");
+	s_gpuProfiler.Emplace(s_renderSettings.renderAheadCount);
+	s_commandRecorder.Emplace(s_renderSettings.renderAheadCount);
 
 	// GUI.
 	if (!ui::BatchRenderer::Startup(info.quadBudget))
@@ -85,9 +91,11 @@ void Renderer::Shutdown()
 	Context::Wait();
 	s_renderPipeline->Shutdown();
 	s_renderPipeline->BaseShutdown();
-	s_stagingBuffer->GetMemoryObject().Unmap();
-	s_transferFence.Destroy();
-	s_stagingBuffer = nullptr;
+	s_uploadQueue.Destroy();
+	s_gpuProfiler.Destroy();
+	s_commandRecorder.Destroy();
+	// The pool is gone, every compilation has finished or been aborted.
+	s_pipelineStateCache.Tick();
 	s_staticMaterialDescriptorAllocator.Destroy();
 	ui::BatchRenderer::Shutdown();
 	for (FrameResource const& frameResource : s_frameResources)
@@ -116,26 +124,54 @@ void Renderer::FreeStaticMaterialDescriptorSet(gl::DescriptorSet set)
 	return s_staticMaterialDescriptorAllocator->FreeDescriptorSet(set);
 }
 
-void Renderer::Tick()
+void Renderer::BeginFrame()
 {
+	GLEX_PROFILE_SCOPE("Renderer::BeginFrame");
+	ScopedMemoryTag tag(MemoryTag::Renderer);
 	FrameResource& frame = s_frameResources[s_currentFrame];
-	frame.inFlightFence.Wait();
+	{
+		GLEX_PROFILE_SCOPE("Wait for frame fence");
+		TelemetryScope telemetry(TelemetryCounter::FenceWait);
+		frame.inFlightFence.Wait();
+	}
 	frame.inFlightFence.Reset();
+	// Frame memory from renderAheadCount frames ago can be reused now.
+	FrameMemory::BeginFrame();
 	for (auto& fn : frame.deletionQueue)
 		fn();
 	frame.deletionQueue.clear();
 	frame.stagingBuffer.Reset();
-	gl::Image swapChainImage = Context::AcquireSwapchainImage(frame.imageAvailableSemaphore);
+	s_commandRecorder->BeginFrame(s_currentFrame);
+}
+
+void Renderer::Tick()
+{
+	GLEX_PROFILE_SCOPE("Renderer::Tick");
+	ScopedMemoryTag tag(MemoryTag::Renderer);
+	FrameResource& frame = s_frameResources[s_currentFrame];
+	gl::Image swapChainImage;
+	{
+		GLEX_PROFILE_SCOPE("Acquire swapchain image");
+		TelemetryScope telemetry(TelemetryCounter::PresentWait);
+		swapChainImage = Context::AcquireSwapchainImage(frame.imageAvailableSemaphore);
+	}
 
 	// Reset state.
-	s_currentMaterialInstance = nullptr;
+	t_currentMaterialInstance = nullptr;
+	s_pipelineStateCache.Tick();
 
 	ui::BatchRenderer::Tick();
 
 	// Do nothing if no images are available.
 	frame.commandBuffer.Reset();
 	frame.commandBuffer.Begin();
-	WeakPtr<ImageView> renderResult = s_renderPipeline->Render(GameInstance::GetCurrentScene());
+	s_gpuProfiler->BeginFrame(frame.commandBuffer, s_currentFrame);
+	uint64_t uploadValue = s_uploadQueue->AcquireFinished(frame.commandBuffer);
+	WeakPtr<ImageView> renderResult;
+	{
+		GLEX_PROFILE_SCOPE("Pipeline::Render");
+		renderResult = s_renderPipeline->Render(GameInstance::GetCurrentScene());
+	}
 	WeakPtr<Image> sourceImage = renderResult->GetImage();
 	WeakPtr<Image> resultImage = renderResult->GetImage();
 	frame.commandBuffer.ImageMemoryBarrier(swapChainImage, 0, 1, gl::ImageAspect::Color, gl::PipelineStage::None, gl::Access::None, gl::ImageLayout::Undefined, gl::PipelineStage::Blit, gl::Access::TransferWrite, gl::ImageLayout::TransferDest);
@@ -148,9 +184,25 @@ void Renderer::Tick()
 	frame.commandBuffer.BlitImage(sourceImage->GetImageObject(), swapChainImage, sourceImage->Size(), Context::Size(), gl::ImageFilter::Nearest);
 	frame.commandBuffer.ImageMemoryBarrier(swapChainImage, 0, 1, gl::ImageAspect::Color, gl::PipelineStage::Blit, gl::Access::TransferWrite, gl::ImageLayout::TransferDest, gl::PipelineStage::None, gl::Access::None, gl::ImageLayout::ReadyToPresent);
 	frame.commandBuffer.End();
-	Context::SubmitCommand(Context::GetGraphicsQueue(), frame.commandBuffer, frame.imageAvailableSemaphore, gl::PipelineStage::All, frame.renderFinishedSemaphore, gl::PipelineStage::All, frame.inFlightFence);
-	Context::Present(frame.renderFinishedSemaphore);
+	gl::SemaphoreSubmit waitSemaphores[] =
+	{
+		{ frame.imageAvailableSemaphore.GetHandle(), 0, gl::PipelineStage::All },
+		{ s_uploadQueue->GetSemaphore().GetHandle(), uploadValue, gl::PipelineStage::All }
+	};
+	gl::SemaphoreSubmit signalSemaphore = { frame.renderFinishedSemaphore.GetHandle(), 0, gl::PipelineStage::All };
+	Context::SubmitCommand(Context::GetGraphicsQueue(), frame.commandBuffer, { waitSemaphores, 2 }, &signalSemaphore, frame.inFlightFence);
+	{
+		GLEX_PROFILE_SCOPE("Present");
+		TelemetryScope telemetry(TelemetryCounter::PresentWait);
+		Context::Present(frame.renderFinishedSemaphore);
+	}
 	s_currentFrame = (s_currentFrame + 1) % s_frameResources.size();
+	if (Time::Current() - s_lastPipelineCacheSave >= PIPELINE_CACHE_SAVE_INTERVAL)
+	{
+		GLEX_PROFILE_SCOPE("Save pipeline cache");
+		Context::SavePipelineCacheAsync();
+		s_lastPipelineCacheSave = Time::Current();
+	}
 }
 
 void Renderer::Resize()
@@ -266,100 +318,9 @@ void Renderer::AutomaticLayoutTransition(gl::CommandBuffer commandBuffer, WeakPt
 	commandBuffer.ImageMemoryBarrier(image->GetImageObject(), layer, numLayers, aspect, stageBefore, accessBefore, layoutBefore, stageAfter, accessAfter, layoutAfter);
 }
 
-void Renderer::UploadBuffer(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data)
-{
-	// External sync is needed.
-	gl::CommandPool transferPool = Context::GetTransferCommandPool();
-	gl::CommandBuffer commandBuffer = transferPool.AllocateCommandBuffer();
-	while (size != 0)
-	{
-		uint32_t copyedSize = glm::min(size, s_stagingBuffer->Size());
-		memcpy(s_stagingBufferData, data, copyedSize);
-		size -= copyedSize;
-		data = Mem::Offset(data, copyedSize);
-		s_stagingBuffer->GetMemoryObject().Flush(0, copyedSize);
-		commandBuffer.Reset();
-		commandBuffer.Begin();
-		commandBuffer.CopyBuffer(s_stagingBuffer->GetBufferObject(), buffer->GetBufferObject(), 0, offset, copyedSize);
-		commandBuffer.End();
-		Context::SubmitCommand(Context::GetTransferQueue(), commandBuffer, nullptr, gl::PipelineStage::None, nullptr, gl::PipelineStage::None, s_transferFence);
-		offset += copyedSize;
-		s_transferFence.Wait();
-		s_transferFence.Reset();
-	}
-	transferPool.FreeCommandBuffer(commandBuffer);
-}
-
-bool Renderer::UploadImage(WeakPtr<Image> image, uint32_t layer, glm::uvec2 size, uint32_t sizePerPixel, void const* data)
-{
-	if (size.x > Limits::TEXTURE_SIZE || size.y > Limits::TEXTURE_SIZE)
-	{
-		Logger::Error("Texture is too large.");
-		return false;
-	}
-	uint32_t totalSize;
-	if (sizePerPixel == 4)
-	{
-		GLEX_DEBUG_ASSERT(VulkanEnum::GetImageFormat(image->Format()) == VK_FORMAT_B8G8R8A8_UNORM) {}
-		// Convert RGBA to BGRA.
-		uint32_t pixels = size.x * size.y;
-		for (uint32_t i = 0; i < pixels; i++)
-		{
-			union
-			{
-				uint32_t rgba;
-				struct { uint8_t r, g, b, a; };
-			} color;
-			color.rgba = reinterpret_cast<uint32_t const*>(data)[i];
-			std::swap(color.r, color.b);
-			reinterpret_cast<uint32_t*>(s_stagingBufferData)[i] = color.rgba;
-		}
-		totalSize = pixels * 4;
-	}
-	else if (sizePerPixel == 3)
-	{
-		GLEX_DEBUG_ASSERT(VulkanEnum::GetImageFormat(image->Format()) == VK_FORMAT_B8G8R8A8_UNORM) {}
-		// Convert RGB to BGRA.
-		uint32_t pixels = size.x * size.y;
-		for (uint32_t i = 0; i < pixels; i++)
-		{
-			union
-			{
-				uint32_t rgba;
-				struct { uint8_t r, g, b, a; };
-			} color;
-			color.b = reinterpret_cast<uint8_t const*>(data)[i * 3];
-			color.g = reinterpret_cast<uint8_t const*>(data)[i * 3 + 1];
-			color.r = reinterpret_cast<uint8_t const*>(data)[i * 3 + 2];
-			color.a = 255;
-			reinterpret_cast<uint32_t*>(s_stagingBufferData)[i] = color.rgba;
-		}
-		totalSize = pixels * 4;
-	}
-	else
-	{
-		totalSize = size.x * size.y * sizePerPixel;
-		memcpy(s_stagingBufferData, data, totalSize);
-	}
-	s_stagingBuffer->GetMemoryObject().Flush(0, totalSize);
-
-	gl::CommandPool transferPool = Context::GetTransferCommandPool();
-	gl::CommandBuffer commandBuffer = transferPool.AllocateCommandBuffer();
-	commandBuffer.Reset();
-	commandBuffer.Begin();
-	commandBuffer.ImageMemoryBarrier(image->GetImageObject(), layer, 1, gl::ImageAspect::Color, gl::PipelineStage::None, gl::Access::None, gl::ImageLayout::Undefined, gl::PipelineStage::Copy, gl::Access::TransferWrite, gl::ImageLayout::TransferDest);
-	commandBuffer.CopyImage(s_stagingBuffer->GetBufferObject(), 0, image->GetImageObject(), layer, gl::ImageAspect::Color, size);
-	commandBuffer.ImageMemoryBarrier(image->GetImageObject(), layer, 1, gl::ImageAspect::Color, gl::PipelineStage::Copy, gl::Access::TransferWrite, gl::ImageLayout::TransferDest, gl::PipelineStage::FragmentShader, gl::Access::ShaderSampledRead, gl::ImageLayout::ShaderRead);
-	commandBuffer.End();
-	Context::SubmitCommand(Context::GetTransferQueue(), commandBuffer, nullptr, gl::PipelineStage::None, nullptr, gl::PipelineStage::None, s_transferFence);
-	s_transferFence.Wait();
-	s_transferFence.Reset();
-	transferPool.FreeCommandBuffer(commandBuffer);
-	return true;
-}
-
 bool Renderer::UploadBufferDynamic(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data, gl::PipelineStage waitStage, gl::Access waitAccess, gl::PipelineStage stageAfter, gl::Access accessAfter)
 {
+	TelemetryScope telemetry(TelemetryCounter::Upload);
 	FrameResource& frame = s_frameResources[s_currentFrame];
 	frame.commandBuffer.BufferMemoryBarrier(buffer->GetBufferObject(), offset, size, waitStage, waitAccess, gl::PipelineStage::Copy, gl::Access::TransferWrite);
 	bool result = frame.stagingBuffer.UploadBuffer(buffer, offset, size, data);
@@ -11,6 +11,9 @@
 #include "Engine/Renderer/pipeline.h"
 #include "Engine/Renderer/descmgr.h"
 #include "Engine/Renderer/staging_buffer.h"
+#include "Engine/Renderer/upload.h"
+#include "Engine/Renderer/gpu_profiler.h"
+#include "Engine/Renderer/recorder.h"
 #include "Engine/Renderer/matinst.h"
 
 namespace glex
@@ -44,14 +47,18 @@ namespace glex
 		RenderSettings settings;
 		uint32_t quadBudget = 2048;
 		Pipeline* pipeline = nullptr;
+		char const* pipelineCacheFile = "pipeline.cache"; // Compiled pipelines are not kept across runs if null.
 	};
 
 	class Renderer : private StaticClass
 	{
+		friend class render::CommandRecorder;
+
 	public:
 		constexpr static uint32_t GLOBAL_DESCRIPTOR_SET = 0;
 		constexpr static uint32_t MATERIAL_DESCRIPOR_SET = 1;
 		constexpr static uint32_t OBJECT_DESCRIPTOR_SET = 2;
+		constexpr static double PIPELINE_CACHE_SAVE_INTERVAL = 60.0; // Seconds, so a crash doesn't lose everything compiled.
 
 	private:
 		inline static RenderSettings s_renderSettings;
@@ -61,24 +68,34 @@ namespace glex
 		inline static render::DescriptorLayoutCache s_descriptorLayoutCache;
 		inline static render::PipelineStateCache s_pipelineStateCache;
 		inline static Optional<render::StaticDescriptorAllocator> s_staticMaterialDescriptorAllocator;
-		// Current state.
-		inline static WeakPtr<MaterialInstance> s_currentMaterialInstance;
+		// Current state, per thread since draws can be recorded on pool workers.
+		inline static thread_local WeakPtr<MaterialInstance> t_currentMaterialInstance;
+		inline static thread_local gl::CommandBuffer t_recordingCommandBuffer; // A secondary, null for the frame's command buffer.
 		// Frame resources.
 		inline static Vector<render::FrameResource> s_frameResources;
 		inline static uint32_t s_currentFrame;		
-		// Staging buffer.
-		inline static void* s_stagingBufferData;
-		inline static SharedPtr<Buffer> s_stagingBuffer;
-		inline static gl::Fence s_transferFence;
+		// Uploads.
+		inline static Optional<render::UploadQueue> s_uploadQueue;
+		inline static Optional<render::GpuProfiler> s_gpuProfiler;
+		inline static Optional<render::CommandRecorder> s_commandRecorder;
 		inline static Pipeline* s_renderPipeline;
+		inline static double s_lastPipelineCacheSave;
 
 	public:
 		static void Startup(RendererStartupInfo const& info);
 		static void Shutdown();
+		// Waits for the frame slot about to be reused and recycles what it held, frame memory included.
+		// Called first thing in a tick, so everything that tick allocates goes into the new frame.
+		static void BeginFrame();
 		static void Tick();
 		static void Resize();
 		static uint32_t CurrentFrame() { return s_currentFrame; }
-		static gl::CommandBuffer CurrentCommandBuffer() { return s_frameResources[s_currentFrame].commandBuffer; }
+		static gl::CommandBuffer CurrentCommandBuffer()
+		{
+			if (t_recordingCommandBuffer.GetHandle() != VK_NULL_HANDLE)
+				return t_recordingCommandBuffer;
+			return s_frameResources[s_currentFrame].commandBuffer;
+		}
 		static RenderSettings const& GetRenderSettings() { return s_renderSettings; }
 		static render::ShaderModuleCache& GetShaderModuleCache() { return s_shaderModuleCache; }
 		static render::DescriptorLayoutCache& GetDescriptorLayoutCache() { return s_descriptorLayoutCache; }
@@ -86,6 +103,9 @@ namespace glex
 		static gl::DescriptorSet AllocateStaticMaterialDescriptorSet(gl::DescriptorSetLayout layout);
 		static void FreeStaticMaterialDescriptorSet(gl::DescriptorSet set);
 		static Pipeline* GetRenderPipeline() { return s_renderPipeline; }
+		static render::UploadQueue& GetUploadQueue() { return *s_uploadQueue; }
+		static render::GpuProfiler& GetGpuProfiler() { return *s_gpuProfiler; }
+		static render::CommandRecorder& GetCommandRecorder() { return *s_commandRecorder; }
 
 		template <typename Fn>
 		static void PendingDelete(Fn&& fn)
@@ -94,9 +114,9 @@ namespace glex
 		}
 
 		static void AutomaticLayoutTransition(gl::CommandBuffer commandBuffer, WeakPtr<Image> image, gl::ImageAspect aspect, uint32_t layer, uint32_t numLayers, gl::ImageLayout layoutBefore, gl::ImageLayout layoutAfter);
-		static void UploadBuffer(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data);
-		static bool UploadImage(WeakPtr<Image> image, uint32_t layer, glm::uvec2 size, uint32_t sizePerPixel, void const* data);
+		static UploadTicket UploadBuffer(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data) { return s_uploadQueue->UploadBuffer(buffer, offset, size, data); }
+		static Nullable<UploadTicket> UploadImage(WeakPtr<Image> image, uint32_t layer, glm::uvec2 size, uint32_t sizePerPixel, void const* data) { return s_uploadQueue->UploadImage(image, layer, size, sizePerPixel, data); }
 		static bool UploadBufferDynamic(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data, gl::PipelineStage waitStage, gl::Access waitAccess, gl::PipelineStage stageAfter, gl::Access accessAfter);
-		static WeakPtr<MaterialInstance>& GetCurrentMaterialInstance() { return s_currentMaterialInstance; }
+		static WeakPtr<MaterialInstance>& GetCurrentMaterialInstance() { return t_currentMaterialInstance; }
 	};
 }
\ No newline at end of file
@@ -95,12 +95,12 @@ bool Shader::FillDescriptorLayout(char const* shaderFile, gl::ShaderStage stage,
 							return false;
 						}
 						// Now deduce its type. There may be other overlapping issues, but we can't really check everything.
-						char const* name = member.name;
+						Name name = member.name;
 						if (member.numeric.vector.component_count == 0)
 							member.numeric.vector.component_count = 1; // Fix.
 						gl::DataType dataType = member.type_description->type_flags & SPV_REFLECT_TYPE_FLAG_FLOAT ? gl::VulkanEnum::GetFormatForFloat(member.numeric.vector.component_count) : gl::VulkanEnum::GetFormatForInt(member.numeric.scalar.signedness, member.numeric.vector.component_count);
 						uint32_t offset = member.offset;
-						auto iter = m_properties.find_as(name);
+						auto iter = m_properties.find(name);
 						if (iter == m_properties.end())
 						{
 							ShaderProperty& property = m_properties[name];
@@ -121,10 +121,11 @@ bool Shader::FillDescriptorLayout(char const* shaderFile, gl::ShaderStage stage,
 				}
 				else if (descType == gl::DescriptorType::CombinedImageSampler)
 				{
-					auto iter = m_properties.find_as(descriptor->name);
+					Name name = descriptor->name;
+					auto iter = m_properties.find(name);
 					if (iter == m_properties.end())
 					{
-						ShaderProperty& property = m_properties[descriptor->name];
+						ShaderProperty& property = m_properties[name];
 						property.type = ShaderPropertyType::Texture;
 						property.texture.type = static_cast<gl::ImageType>(descriptor->image.dim);
 						property.texture.index = descriptor->binding;
@@ -419,10 +420,12 @@ void Shader::Log(char const* vertexShaderFile, char const* geometryShaderFile, c
 
 	for (auto& [name, prop] : m_properties)
 	{
-		if (ptr + name.length() >= Limits::LOG_BUFFER_SIZE)
+		char const* nameString = name.ToString();
+		length = strlen(nameString);
+		if (ptr + length >= Limits::LOG_BUFFER_SIZE)
 			goto END;
-		memcpy(buffer + ptr, name.c_str(), name.length());
-		ptr += name.length();
+		memcpy(buffer + ptr, nameString, length);
+		ptr += length;
 
 		if (ptr + 2 >= Limits::LOG_BUFFER_SIZE)
 			goto END;
@@ -461,12 +464,12 @@ void Shader::Log(char const* vertexShaderFile, char const* geometryShaderFile, c
 
 END:
 	buffer[ptr] = 0;
-	Logger::Info(buffer);
+	Logger::Info("%s", buffer);
 }
 
-ShaderProperty Shader::GetProperty(char const* name) const
+ShaderProperty Shader::GetProperty(Name name) const
 {
-	auto iter = m_properties.find_as(name);
+	auto iter = m_properties.find(name);
 	if (iter != m_properties.end())
 		return iter->second;
 	ShaderProperty result;
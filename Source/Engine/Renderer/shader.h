@@ -2,6 +2,7 @@
 #include "Core/GL/shader.h"
 #include "Core/GL/pipeline_state.h"
 #include "Core/Utils/temp_buffer.h"
+#include "Core/Utils/name.h"
 #include "Engine/resbase.h"
 #include <array>
 
@@ -66,7 +67,7 @@ namespace glex
 		gl::ShaderStage m_pushConstantsStages;
 		uint8_t m_numVertexAttributes = 0;
 		gl::DataType m_vertexLayout[Limits::NUM_VERTEX_ATTRIBUTES];
-		HashMap<String, ShaderProperty> m_properties;
+		HashMap<Name, ShaderProperty> m_properties;
 
 		Shader(ShaderInitializer const& init);
 		bool IsValid() const { return m_descriptorLayout.GetHandle() != VK_NULL_HANDLE; }
@@ -86,7 +87,7 @@ namespace glex
 		uint32_t UniformBufferSize() const { return m_uniformBufferSize; }
 		uint32_t NumTextureArrays() const { return m_numTextureArrays; }
 		uint32_t NumTextures() const { return m_numTextures; }
-		ShaderProperty GetProperty(char const* name) const;
-		HashMap<String, ShaderProperty> const& GetAllProperties() const { return m_properties; }
+		ShaderProperty GetProperty(Name name) const;
+		HashMap<Name, ShaderProperty> const& GetAllProperties() const { return m_properties; }
 	};
 }
\ No newline at end of file
@@ -36,11 +36,13 @@ Texture::Texture(char const* imageFile, gl::Sampler sampler)
 		Logger::Error("Cannot create image object.");
 		return;
 	}
-	if (!Renderer::UploadImage(image, 0, { x, y }, channels, data))
+	Nullable<UploadTicket> ticket = Renderer::UploadImage(image, 0, { x, y }, channels, data);
+	if (ticket == nullptr)
 	{
 		Logger::Error("Cannot upload image.");
 		return;
 	}
+	m_uploadTicket = *ticket;
 	m_imageView.Emplace(image, 0, 1, gl::ImageType::Sampler2D, gl::ImageAspect::Color);
 	if (!m_imageView->IsValid())
 	{
@@ -82,11 +84,13 @@ Texture::Texture(char const* imageFile, gl::ImageFormat formatOverride, gl::Samp
 		Logger::Error("Cannot create image object.");
 		return;
 	}
-	if (!Renderer::UploadImage(image, 0, { x, y }, desiredChannels, data))
+	Nullable<UploadTicket> ticket = Renderer::UploadImage(image, 0, { x, y }, desiredChannels, data);
+	if (ticket == nullptr)
 	{
 		Logger::Error("Cannot upload image.");
 		return;
 	}
+	m_uploadTicket = *ticket;
 	m_imageView.Emplace(image, 0, 1, gl::ImageType::Sampler2D, gl::ImageAspect::Color);
 	if (!m_imageView->IsValid())
 	{
@@ -124,11 +128,13 @@ Texture::Texture(char const* left, char const* right, char const* up, char const
 		Logger::Error("Cannot create image object.");
 		return;
 	}
-	if (!Renderer::UploadImage(image, 0, { x, y }, channels, data))
+	Nullable<UploadTicket> ticket = Renderer::UploadImage(image, 0, { x, y }, channels, data);
+	if (ticket == nullptr)
 	{
 		Logger::Error("Cannot upload image.");
 		return;
 	}
+	m_uploadTicket = *ticket;
 
 	auto LoadSubsequent = [&](uint32_t layer, char const* file) -> bool
 	{
@@ -145,11 +151,13 @@ Texture::Texture(char const* left, char const* right, char const* up, char const
 			Logger::Error("Size of image %s doesn't match.", file);
 			return false;
 		}
-		if (!Renderer::UploadImage(image, layer, { x, y }, channels, data))
+		Nullable<UploadTicket> ticket = Renderer::UploadImage(image, layer, { x, y }, channels, data);
+		if (ticket == nullptr)
 		{
 			Logger::Error("Cannot upload image.");
 			return false;
 		}
+		m_uploadTicket |= *ticket;
 		return true;
 	};
 	if (!LoadSubsequent(1, left) || !LoadSubsequent(2, up) || !LoadSubsequent(3, bottom) || !LoadSubsequent(4, front) || !LoadSubsequent(5, back))
@@ -3,6 +3,7 @@
  */
 #pragma once
 #include "Engine/Renderer/image.h"
+#include "Engine/Renderer/upload.h"
 #include "Core/Container/optional.h"
 
 namespace glex
@@ -12,6 +13,7 @@ namespace glex
 	private:
 		Optional<ImageView> m_imageView;
 		gl::Sampler m_samplerObject; // External object.
+		UploadTicket m_uploadTicket;
 
 	public:
 		Texture(char const* imageFile, gl::Sampler sampler);
@@ -22,6 +24,7 @@ namespace glex
 		void SetSampler(gl::Sampler sampler);
 		ImageView const& GetImageView() const { return *m_imageView; }
 		gl::Sampler GetSampler() const { return m_samplerObject; }
+		UploadTicket GetUploadTicket() const { return m_uploadTicket; }
 		glm::uvec2 Size() const { return m_imageView->GetImage()->Size(); }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "Engine/Renderer/upload.h"
+#include "Engine/Renderer/renderer.h"
+#include "Core/GL/context.h"
+#include "Core/assert.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Utils/telemetry.h"
+
+using namespace glex;
+using namespace glex::gl;
+using namespace glex::render;
+
+bool UploadTicket::IsComplete() const
+{
+	return Renderer::GetUploadQueue().IsComplete(*this);
+}
+
+void UploadTicket::Wait() const
+{
+	Renderer::GetUploadQueue().Wait(*this);
+}
+
+UploadQueue::UploadQueue(uint32_t stagingSize) : m_stagingData(nullptr), m_stagingSize(stagingSize), m_stagingHead(0), m_stagingTail(0),
+m_recordingValue(1), m_completedValue(0), m_acquiredValue(0), m_recordedSize(0),
+m_transferQueueFamily(Context::DeviceInfo().transferQueueIndex), m_graphicsQueueFamily(Context::DeviceInfo().graphicsQueueIndex)
+{
+	GLEX_DEBUG_ASSERT(Mem::IsAligned(stagingSize, k_stagingAlignment)) {}
+	m_stagingMemory = m_stagingBuffer.Create(gl::BufferUsage::TransferSource, stagingSize, true);
+	if (m_stagingMemory.GetHandle() == VK_NULL_HANDLE)
+		return;
+	m_stagingData = static_cast<uint8_t*>(m_stagingMemory.Map(0, stagingSize));
+	m_semaphore.Create(0);
+}
+
+UploadQueue::~UploadQueue()
+{
+	// The device is idle by now.
+	if (m_recording.GetHandle() != VK_NULL_HANDLE)
+		m_freeCommandBuffers.push_back(m_recording);
+	for (Batch const& batch : m_inFlight)
+		m_freeCommandBuffers.push_back(batch.commandBuffer);
+	for (gl::CommandBuffer commandBuffer : m_freeCommandBuffers)
+		Context::GetTransferCommandPool().FreeCommandBuffer(commandBuffer);
+	if (m_semaphore.GetHandle() != VK_NULL_HANDLE)
+		m_semaphore.Destroy();
+	if (m_stagingMemory.GetHandle() != VK_NULL_HANDLE)
+	{
+		m_stagingMemory.Unmap();
+		m_stagingBuffer.Destroy(m_stagingMemory);
+	}
+}
+
+uint32_t UploadQueue::AllocateStaging(uint32_t size)
+{
+	GLEX_ASSERT_MSG(size <= m_stagingSize, "Upload is larger than the staging ring.") {}
+	for (;;)
+	{
+		// Nothing in flight, start over so a large upload doesn't have to skip the end.
+		if (m_stagingHead == m_stagingTail)
+			m_stagingHead = m_stagingTail = 0;
+		uint64_t begin = Mem::Align(m_stagingHead, k_stagingAlignment);
+		uint32_t offset = begin % m_stagingSize;
+		if (offset + size > m_stagingSize)
+		{
+			// Doesn't fit before the end, the rest of it is left unused this round.
+			begin += m_stagingSize - offset;
+			offset = 0;
+		}
+		if (begin + size - m_stagingTail <= m_stagingSize)
+		{
+			m_stagingHead = begin + size;
+			return offset;
+		}
+		// Full. Send what has been recorded and wait for the oldest batch to give its part back.
+		Submit();
+		{
+			GLEX_PROFILE_SCOPE("Wait for staging memory");
+			m_semaphore.Wait(m_inFlight.front().value);
+		}
+		Retire();
+	}
+}
+
+gl::CommandBuffer UploadQueue::GetRecording()
+{
+	if (m_recording.GetHandle() == VK_NULL_HANDLE)
+	{
+		if (m_freeCommandBuffers.empty())
+			m_recording = Context::GetTransferCommandPool().AllocateCommandBuffer();
+		else
+		{
+			m_recording = m_freeCommandBuffers.back();
+			m_freeCommandBuffers.pop_back();
+		}
+		m_recording.Reset();
+		m_recording.Begin();
+	}
+	return m_recording;
+}
+
+UploadTicket UploadQueue::EndUpload(uint32_t size)
+{
+	UploadTicket ticket(m_recordingValue);
+	m_recordedSize += size;
+	if (m_recordedSize >= k_batchSize)
+		Submit();
+	return ticket;
+}
+
+void UploadQueue::Retire()
+{
+	m_completedValue = m_semaphore.GetValue();
+	while (!m_inFlight.empty() && m_inFlight.front().value <= m_completedValue)
+	{
+		m_stagingTail = m_inFlight.front().stagingEnd;
+		m_freeCommandBuffers.push_back(m_inFlight.front().commandBuffer);
+		m_inFlight.pop_front();
+	}
+}
+
+UploadTicket UploadQueue::UploadBuffer(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data)
+{
+	TelemetryScope telemetry(TelemetryCounter::Upload);
+	UploadTicket ticket;
+	while (size != 0)
+	{
+		// Large ones go in pieces, so one of them doesn't drain the whole ring.
+		uint32_t chunkSize = Min(size, m_stagingSize / 4);
+		uint32_t stagingOffset = AllocateStaging(chunkSize);
+		memcpy(m_stagingData + stagingOffset, data, chunkSize);
+		m_stagingMemory.Flush(stagingOffset, chunkSize);
+		gl::CommandBuffer commandBuffer = GetRecording();
+		commandBuffer.CopyBuffer(m_stagingBuffer, buffer->GetBufferObject(), stagingOffset, offset, chunkSize);
+		if (m_transferQueueFamily != m_graphicsQueueFamily)
+		{
+			commandBuffer.BufferMemoryBarrier(buffer->GetBufferObject(), offset, chunkSize, gl::PipelineStage::Copy, gl::Access::TransferWrite, gl::PipelineStage::None, gl::Access::None,
+				m_transferQueueFamily, m_graphicsQueueFamily);
+			m_releases.push_back({ buffer->GetBufferObject(), gl::Image(), offset, chunkSize, m_recordingValue });
+		}
+		ticket = EndUpload(chunkSize);
+		size -= chunkSize;
+		offset += chunkSize;
+		data = Mem::Offset(data, chunkSize);
+	}
+	return ticket;
+}
+
+Nullable<UploadTicket> UploadQueue::UploadImage(WeakPtr<Image> image, uint32_t layer, glm::uvec2 size, uint32_t sizePerPixel, void const* data)
+{
+	if (size.x > Limits::TEXTURE_SIZE || size.y > Limits::TEXTURE_SIZE)
+	{
+		Logger::Error("Texture is too large.");
+		return nullptr;
+	}
+	TelemetryScope telemetry(TelemetryCounter::Upload);
+	uint32_t pixels = size.x * size.y;
+	uint32_t totalSize = sizePerPixel == 3 ? pixels * 4 : pixels * sizePerPixel;
+	uint32_t stagingOffset = AllocateStaging(totalSize);
+	uint32_t* staging = reinterpret_cast<uint32_t*>(m_stagingData + stagingOffset);
+	if (sizePerPixel == 4)
+	{
+		GLEX_DEBUG_ASSERT(VulkanEnum::GetImageFormat(image->Format()) == VK_FORMAT_B8G8R8A8_UNORM) {}
+		// Convert RGBA to BGRA.
+		for (uint32_t i = 0; i < pixels; i++)
+		{
+			union
+			{
+				uint32_t rgba;
+				struct { uint8_t r, g, b, a; };
+			} color;
+			color.rgba = reinterpret_cast<uint32_t const*>(data)[i];
+			std::swap(color.r, color.b);
+			staging[i] = color.rgba;
+		}
+	}
+	else if (sizePerPixel == 3)
+	{
+		GLEX_DEBUG_ASSERT(VulkanEnum::GetImageFormat(image->Format()) == VK_FORMAT_B8G8R8A8_UNORM) {}
+		// Convert RGB to BGRA.
+		for (uint32_t i = 0; i < pixels; i++)
+		{
+			union
+			{
+				uint32_t rgba;
+				struct { uint8_t r, g, b, a; };
+			} color;
+			color.b = reinterpret_cast<uint8_t const*>(data)[i * 3];
+			color.g = reinterpret_cast<uint8_t const*>(data)[i * 3 + 1];
+			color.r = reinterpret_cast<uint8_t const*>(data)[i * 3 + 2];
+			color.a = 255;
+			staging[i] = color.rgba;
+		}
+	}
+	else
+		memcpy(staging, data, totalSize);
+	m_stagingMemory.Flush(stagingOffset, totalSize);
+
+	gl::CommandBuffer commandBuffer = GetRecording();
+	commandBuffer.ImageMemoryBarrier(image->GetImageObject(), layer, 1, gl::ImageAspect::Color, gl::PipelineStage::None, gl::Access::None, gl::ImageLayout::Undefined, gl::PipelineStage::Copy, gl::Access::TransferWrite, gl::ImageLayout::TransferDest);
+	commandBuffer.CopyImage(m_stagingBuffer, stagingOffset, image->GetImageObject(), layer, gl::ImageAspect::Color, size);
+	if (m_transferQueueFamily != m_graphicsQueueFamily)
+	{
+		// The layout changes with the release, the acquisition repeats it.
+		commandBuffer.ImageMemoryBarrier(image->GetImageObject(), layer, 1, gl::ImageAspect::Color, gl::PipelineStage::Copy, gl::Access::TransferWrite, gl::ImageLayout::TransferDest, gl::PipelineStage::None, gl::Access::None, gl::ImageLayout::ShaderRead,
+			m_transferQueueFamily, m_graphicsQueueFamily);
+		m_releases.push_back({ gl::Buffer(), image->GetImageObject(), layer, 0, m_recordingValue });
+	}
+	else
+		commandBuffer.ImageMemoryBarrier(image->GetImageObject(), layer, 1, gl::ImageAspect::Color, gl::PipelineStage::Copy, gl::Access::TransferWrite, gl::ImageLayout::TransferDest, gl::PipelineStage::FragmentShader, gl::Access::ShaderSampledRead, gl::ImageLayout::ShaderRead);
+	return EndUpload(totalSize);
+}
+
+void UploadQueue::Submit()
+{
+	if (m_recording.GetHandle() == VK_NULL_HANDLE)
+		return;
+	m_recording.End();
+	gl::SemaphoreSubmit signal = { m_semaphore.GetHandle(), m_recordingValue, gl::PipelineStage::All };
+	Context::SubmitCommand(Context::GetTransferQueue(), m_recording, nullptr, &signal, gl::Fence());
+	m_inFlight.push_back({ m_recording, m_recordingValue, m_stagingHead });
+	m_recording = gl::CommandBuffer();
+	m_recordingValue++;
+	m_recordedSize = 0;
+}
+
+void UploadQueue::Wait(UploadTicket ticket)
+{
+	if (ticket.m_value <= m_completedValue)
+		return;
+	if (ticket.m_value == m_recordingValue)
+		Submit();
+	{
+		GLEX_PROFILE_SCOPE("Wait for upload");
+		m_semaphore.Wait(ticket.m_value);
+	}
+	Retire();
+}
+
+uint64_t UploadQueue::AcquireFinished(gl::CommandBuffer commandBuffer)
+{
+	// Whatever was recorded since the last frame goes out as one batch.
+	Submit();
+	Retire();
+	while (!m_releases.empty() && m_releases.front().value <= m_completedValue)
+	{
+		Release const& release = m_releases.front();
+		if (release.image.GetHandle() != VK_NULL_HANDLE)
+		{
+			commandBuffer.ImageMemoryBarrier(release.image, release.offset, 1, gl::ImageAspect::Color, gl::PipelineStage::None, gl::Access::None, gl::ImageLayout::TransferDest, gl::PipelineStage::FragmentShader, gl::Access::ShaderSampledRead, gl::ImageLayout::ShaderRead,
+				m_transferQueueFamily, m_graphicsQueueFamily);
+		}
+		else
+		{
+			commandBuffer.BufferMemoryBarrier(release.buffer, release.offset, release.size, gl::PipelineStage::None, gl::Access::None, gl::PipelineStage::All, gl::Access::Read,
+				m_transferQueueFamily, m_graphicsQueueFamily);
+		}
+		m_releases.pop_front();
+	}
+	m_acquiredValue = m_completedValue;
+	return m_acquiredValue;
+}
\ No newline at end of file
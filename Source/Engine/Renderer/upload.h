@@ -0,0 +1,108 @@
+/**
+ * Uploads to device local buffers and images on the transfer queue, without blocking the caller.
+ *
+ * Data is copied into a ring of staging memory and the copies are recorded into a batch.
+ * A batch is submitted once it is large enough, when the ring runs out, or at the start of a frame,
+ * and signals the timeline semaphore with its own value when it finishes. Staging memory is reused
+ * as batches finish. If the transfer queue is from another family, the batch releases what it wrote
+ * and the frame after it finishes acquires it on the graphics queue.
+ *
+ * External sync is needed.
+ */
+#pragma once
+#include "Core/Container/basic.h"
+#include "Core/Container/nullable.h"
+#include "Core/Memory/smart_ptr.h"
+#include "Core/GL/sync.h"
+#include "Engine/Renderer/buffer.h"
+#include "Engine/Renderer/image.h"
+
+namespace glex
+{
+	namespace render
+	{
+		class UploadQueue;
+	}
+
+	// The batch an upload went out with. Complete once the graphics queue can use what was uploaded.
+	class UploadTicket
+	{
+		friend class render::UploadQueue;
+
+	private:
+		uint64_t m_value;
+
+		UploadTicket(uint64_t value) : m_value(value) {}
+
+	public:
+		UploadTicket() : m_value(0) {} // Nothing to wait for.
+		bool IsComplete() const;
+		// Blocks until the copies are done. The graphics queue takes them over at the next frame.
+		void Wait() const;
+		// Batches finish in order, so the later ticket covers both.
+		UploadTicket& operator|=(UploadTicket rhs) { m_value = Max(m_value, rhs.m_value); return *this; }
+	};
+
+	namespace render
+	{
+		class UploadQueue : private Unmoveable
+		{
+		private:
+			struct Batch
+			{
+				gl::CommandBuffer commandBuffer;
+				uint64_t value;
+				uint64_t stagingEnd; // The ring tail moves here once the batch finishes.
+			};
+
+			// Ownership of what a batch wrote, to be acquired on the graphics queue once it finishes.
+			struct Release
+			{
+				gl::Buffer buffer;
+				gl::Image image;
+				uint32_t offset, size; // Layer and zero for images.
+				uint64_t value;
+			};
+
+			constexpr static uint32_t k_batchSize = 32_mib;
+			constexpr static uint32_t k_stagingAlignment = 16;
+
+			gl::Buffer m_stagingBuffer;
+			gl::Memory m_stagingMemory;
+			uint8_t* m_stagingData;
+			uint32_t m_stagingSize;
+			// Positions in the ring only grow, the offset is the position modulo the size.
+			uint64_t m_stagingHead, m_stagingTail;
+			gl::TimelineSemaphore m_semaphore;
+			uint64_t m_recordingValue;
+			uint64_t m_completedValue;
+			uint64_t m_acquiredValue;
+			gl::CommandBuffer m_recording;
+			uint32_t m_recordedSize;
+			Deque<Batch> m_inFlight;
+			Vector<gl::CommandBuffer> m_freeCommandBuffers;
+			Deque<Release> m_releases;
+			uint32_t m_transferQueueFamily, m_graphicsQueueFamily;
+
+			uint32_t AllocateStaging(uint32_t size);
+			gl::CommandBuffer GetRecording();
+			UploadTicket EndUpload(uint32_t size);
+			void Retire();
+
+		public:
+			UploadQueue(uint32_t stagingSize);
+			~UploadQueue();
+			bool IsValid() const { return m_semaphore.GetHandle() != VK_NULL_HANDLE; }
+			UploadTicket UploadBuffer(WeakPtr<Buffer> buffer, uint32_t offset, uint32_t size, void const* data);
+			Nullable<UploadTicket> UploadImage(WeakPtr<Image> image, uint32_t layer, glm::uvec2 size, uint32_t sizePerPixel, void const* data);
+			// Submits the batch being recorded, if any.
+			void Submit();
+			bool IsComplete(UploadTicket ticket) const { return ticket.m_value <= m_acquiredValue; }
+			void Wait(UploadTicket ticket);
+			// Submits what was recorded, then records the acquisition of every finished batch.
+			// Returns the value the graphics submission has to wait for.
+			uint64_t AcquireFinished(gl::CommandBuffer commandBuffer);
+			gl::TimelineSemaphore GetSemaphore() const { return m_semaphore; }
+		};
+	}
+}
\ No newline at end of file
@@ -1,8 +1,17 @@
 #include "Engine/Scripting/api.h"
+#include "Engine/Renderer/renderer.h"
 
 using namespace glex;
 using namespace glex::py;
 
+glex::PyRetVal<GpuPassTuple> py::GpuPassStats(char const* name)
+{
+	GpuScopeResult const* result = Renderer::GetGpuProfiler().FindResult(name);
+	if (result == nullptr)
+		return { glex::PyStatus::RaiseException, GpuPassTuple() };
+	return { glex::PyStatus::Success, GpuPassTuple(result->milliseconds, result->primitives, result->vertexInvocations, result->fragmentInvocations) };
+}
+
 glex::PyRetVal<void> py::Image::Create(gl::ImageFormat format, gl::ImageUsage usages, glm::uvec3 size, uint32_t samples, bool usedAsCube)
 {
 	m_image = glex::MakeShared<glex::Image>(format, usages, size, samples, usedAsCube);
@@ -85,14 +94,28 @@ PyRetVal<void> py::RenderPass::BeginRenderPass(PyObject* clearValueList)
 
 void py::RenderPass::RenderMeshList(Type<RenderList>* list, uint32_t materialDomain)
 {
-	for (auto [mr, tr] : (*list)->m_meshList)
+	Vector<std::pair<MeshRenderer&, Transform&>>& meshList = (*list)->m_meshList;
+	auto drawRange = [this, &meshList, materialDomain](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			auto [mr, tr] = meshList[i];
+			SharedPtr<MaterialInstance> const& mat = mr.GetMaterial(materialDomain);
+			glm::mat4 const& modelMat = tr.GetModelMat();
+			m_renderPass->BindMaterial(mat);
+			m_renderPass->BindObjectData(&modelMat, sizeof(glm::mat4));
+			m_renderPass->DrawMesh(mr.GetMesh());
+		}
+	};
+	if (!m_renderPass->m_parallelSubpasses[m_renderPass->m_currentSubpass])
 	{
-		SharedPtr<MaterialInstance> const& mat = mr.GetMaterial(materialDomain);
-		glm::mat4 const& modelMat = tr.GetModelMat();
-		m_renderPass->BindMaterial(mat);
-		m_renderPass->BindObjectData(&modelMat, sizeof(glm::mat4));
-		m_renderPass->DrawMesh(mr.GetMesh());
+		drawRange(0, meshList.size());
+		return;
 	}
+	// Model matrices are updated lazily, update them here so the workers only read them.
+	for (auto [mr, tr] : meshList)
+		tr.GetModelMat();
+	m_renderPass->DrawParallel(meshList.size(), drawRange);
 }
 
 void py::MaterialDomainDefinition::Create(PyKeywordParameters kwds, Type<RenderPass>* renderPass, uint32_t subpass)
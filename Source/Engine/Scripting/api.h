@@ -3,6 +3,7 @@
 #include "Core/Platform/window.h"
 #include "Core/Platform/input.h"
 #include "Core/Platform/time.h"
+#include "Core/Utils/telemetry.h"
 #include "Engine/Renderer/image.h"
 #include "Core/Memory/smart_ptr.h"
 #include "Engine/Scripting/type.h"
@@ -77,6 +78,51 @@ namespace glex::py
 		return Input::HasReleased(key);
 	}
 
+	// Count, mean, p50, p95, p99 and max, in milliseconds.
+	using TelemetryTuple = std::tuple<uint64_t, double, double, double, double, double>;
+
+	inline PyRetVal<TelemetryTuple> GetTelemetryStats(char const* name, TelemetryRange range)
+	{
+		TelemetryCounter counter;
+		if (!Telemetry::FindCounter(name, counter))
+			return { PyStatus::RaiseException, TelemetryTuple() };
+		glex::TelemetryStats stats = Telemetry::GetStats(counter, range);
+		return { PyStatus::Success, TelemetryTuple(stats.count, stats.mean, stats.p50, stats.p95, stats.p99, stats.max) };
+	}
+
+	inline PyRetVal<TelemetryTuple> TelemetryStats(char const* name)
+	{
+		return GetTelemetryStats(name, TelemetryRange::Recent);
+	}
+
+	inline PyRetVal<TelemetryTuple> TelemetrySessionStats(char const* name)
+	{
+		return GetTelemetryStats(name, TelemetryRange::Session);
+	}
+
+	inline PyRetVal<double> TelemetryPercentile(char const* name, double percentile)
+	{
+		TelemetryCounter counter;
+		if (!Telemetry::FindCounter(name, counter))
+			return { PyStatus::RaiseException, 0.0 };
+		return { PyStatus::Success, Telemetry::Percentile(counter, percentile) };
+	}
+
+	inline void SetHitchThreshold(double milliseconds)
+	{
+		Telemetry::SetHitchThreshold(milliseconds);
+	}
+
+	inline uint32_t HitchCount()
+	{
+		return Telemetry::HitchCount();
+	}
+
+	// Milliseconds, input primitives, vertex and fragment shader invocations of a render pass a few frames ago.
+	using GpuPassTuple = std::tuple<double, uint64_t, uint64_t, uint64_t>;
+
+	PyRetVal<GpuPassTuple> GpuPassStats(char const* name);
+
 	struct Image
 	{
 		SharedPtr<glex::Image> m_image;
@@ -100,6 +146,7 @@ namespace glex::py
 		glex::RenderPass::Builder m_builder;
 
 		void PushSubpass() { m_builder.PushSubpass(); }
+		void PushParallelSubpass() { m_builder.PushSubpass(true); }
 		void Read(Type<ImageView>* attachment) { m_builder.Read((*attachment)->m_imageView); }
 		void Write(Type<ImageView>* attachment) { m_builder.Write((*attachment)->m_imageView); }
 		void Clear(Type<ImageView>* attachment) { m_builder.Clear((*attachment)->m_imageView); }
@@ -124,6 +171,7 @@ namespace glex::py
 		void EndRenderPass() { m_renderPass->EndRenderPass(); }
 		void RenderMeshList(Type<RenderList>* list, uint32_t materialDomain);
 		PyRetVal<void> Recreate() { return m_renderPass->Recreate() ? PyRetVal<void>(PyStatus::Success) : PyRetVal<void>(PyStatus::RaiseException); }
+		void SetName(char const* name) { m_renderPass->SetName(name); }
 	};
 
 	struct MaterialDomainDefinition
@@ -7,6 +7,7 @@ using namespace glex::py;
 
 void Scripting::Startup(ScriptStartupInfo const& info)
 {
+	ScopedMemoryTag tag(MemoryTag::Scripting);
 	if (info.libraries.size() != 0)
 	{
 		s_modules.reserve(info.libraries.size());
@@ -82,6 +83,12 @@ LibraryInfo Scripting::MakeStandardLibrary()
 	lib.Register<py::Pressing>("pressing");
 	lib.Register<py::Time>("time");
 	lib.Register<py::DeltaTime>("delta_time");
+	lib.Register<py::TelemetryStats>("telemetry_stats");
+	lib.Register<py::TelemetrySessionStats>("telemetry_session_stats");
+	lib.Register<py::TelemetryPercentile>("telemetry_percentile");
+	lib.Register<py::SetHitchThreshold>("set_hitch_threshold");
+	lib.Register<py::HitchCount>("hitch_count");
+	lib.Register<py::GpuPassStats>("gpu_pass_stats");
 
 	Type<py::Image>::RegisterInit<&py::Image::Create>();
 	Type<py::Image>::RegisterMethod<&py::Image::Destroy>("destroy");
@@ -94,6 +101,7 @@ LibraryInfo Scripting::MakeStandardLibrary()
 	lib.Register<py::ImageView>("ImageView");
 
 	Type<py::RenderPassBuilder>::RegisterMethod<&py::RenderPassBuilder::PushSubpass>("push_subpass");
+	Type<py::RenderPassBuilder>::RegisterMethod<&py::RenderPassBuilder::PushParallelSubpass>("push_parallel_subpass");
 	Type<py::RenderPassBuilder>::RegisterMethod<&py::RenderPassBuilder::Read>("read");
 	Type<py::RenderPassBuilder>::RegisterMethod<&py::RenderPassBuilder::Write>("write");
 	Type<py::RenderPassBuilder>::RegisterMethod<&py::RenderPassBuilder::Clear>("clear");
@@ -111,6 +119,7 @@ LibraryInfo Scripting::MakeStandardLibrary()
 	Type<py::RenderPass>::RegisterMethod<&py::RenderPass::EndRenderPass>("end_renderpass");
 	Type<py::RenderPass>::RegisterMethod<&py::RenderPass::RenderMeshList>("render_meshlist");
 	Type<py::RenderPass>::RegisterMethod<&py::RenderPass::Recreate>("recreate");
+	Type<py::RenderPass>::RegisterMethod<&py::RenderPass::SetName>("set_name");
 	Type<py::RenderPass>::EnableInheritance();
 	lib.Register<py::RenderPass>("RenderPass");
 
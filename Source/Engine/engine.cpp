@@ -2,7 +2,9 @@
 #include "Engine/Renderer/renderer.h"
 #include "Engine/Physics/physics.h"
 #include "Engine/resource.h"
-#include "Core/Thread/task.h"
+#include "Core/Thread/coroutine.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Utils/telemetry.h"
 #include "game.h"
 #include <Windows.h>
 
@@ -11,32 +13,46 @@ using namespace glex;
 void Engine::Startup(EngineStartupInfo const& appInfo)
 {
 	// Make sure this is bind before anyone else and we're good to go.
-	Logger::Info("Current directory: %s", Platform::GetWorkingDirectory().Get());
+	Logger::Startup();
+	GLEX_PROFILE_THREAD("Main");
+	Logger::Info("Current directory: %s", Platform::GetWorkingDirectory()->c_str());
 	Window::GetSizeDelegate().Bind(Engine::OnResize);
 	Window::Startup(appInfo.window);
 	Scripting::Startup(appInfo.script);
-	Renderer::Startup(appInfo.render);
+	// Pipeline states are compiled on the pool.
 	Async::Startup(appInfo.numWorkingThreads);
+	Renderer::Startup(appInfo.render);
 	Physics::Startup();
+	Telemetry::SetHitchThreshold(appInfo.hitchThreshold);
 }
 
 void Engine::Shutdown()
 {
 	Physics::Shutdown();
+	Coroutine::Shutdown();
+	// A pipeline cache write still queued would be aborted with the pool. This waits for it and writes what's left.
+	gl::Context::SavePipelineCache();
 	Async::Shutdown();
 	Renderer::Shutdown();
 	Scripting::Shutdown();
 	Window::Shutdown();
-	Event::Clear();
 #if GLEX_REPORT_MEMORY_LEAKS
 	ResourceManager::FreeMemory();
 #endif
+	Logger::Shutdown();
 }
 
 void Engine::Tick()
 {
-	if (!Window::IsMinimized())
+	GLEX_PROFILE_SCOPE("Engine::Tick");
+	// Nothing is submitted while minimized, so the frame slots and the frame memory stay where they are.
+	bool isRendering = !Window::IsMinimized();
+	if (isRendering)
+		Renderer::BeginFrame();
+	Coroutine::Tick();
+	if (isRendering)
 		Renderer::Tick();
+	MemoryTracker::CheckBudgets();
 }
 
 void Engine::OnResize(uint32_t width, uint32_t height)
@@ -12,6 +12,7 @@ namespace glex
 		ScriptStartupInfo script;
 		RendererStartupInfo render;
 		uint32_t numWorkingThreads = 0;
+		double hitchThreshold = 0.0;		// Milliseconds, longer frames get their profile written out. Zero turns it off.
 	};
 
 	class Engine : private StaticClass
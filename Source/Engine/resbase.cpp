@@ -5,5 +5,5 @@ using namespace glex;
 ResourceBase::~ResourceBase()
 {
 	if (!m_key.empty())
-		ResourceManager::FreeResource(m_key);
+		ResourceManager::FreeResource(m_key, m_handle);
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "Core/Container/basic.h"
+#include "Core/Container/handle_pool.h"
 
 namespace glex
 {
@@ -21,10 +22,20 @@ namespace glex
 		Mesh
 	};
 
+	template <typename T> constexpr ResourceType k_resourceType = ResourceType::Null;
+	template <> constexpr ResourceType k_resourceType<Shader> = ResourceType::Shader;
+	template <> constexpr ResourceType k_resourceType<Material> = ResourceType::Material;
+	template <> constexpr ResourceType k_resourceType<MaterialInstance> = ResourceType::MaterialInstance;
+	template <> constexpr ResourceType k_resourceType<Mesh> = ResourceType::Mesh;
+
 	/*————————————————————————————————————————————————————————————————————————————————————————————————————
 			RESOURCE BASE CLASS
 	————————————————————————————————————————————————————————————————————————————————————————————————————*/
 	class ResourceManager;
+	class ResourceBase;
+
+	// Refers to a loaded resource without owning it. Resolving it after the resource is gone gives null.
+	using ResourceHandle = Handle<ResourceBase>;
 
 	class ResourceBase : private Unmoveable
 	{
@@ -32,11 +43,13 @@ namespace glex
 
 	private:
 		String m_key;
+		ResourceHandle m_handle;
 
-		void SetKey(String key) { m_key = std::move(key); }
+		void SetKey(String key, ResourceHandle handle) { m_key = std::move(key); m_handle = handle; }
 
 	public:
 		~ResourceBase();
 		String const& GetKey() const { return m_key; }
+		ResourceHandle GetHandle() const { return m_handle; }
 	};
 }
\ No newline at end of file
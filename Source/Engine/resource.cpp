@@ -12,17 +12,47 @@ void ResourceManager::FreeMemory()
 {
 	decltype(s_resourceMap) a;
 	s_resourceMap.swap(a);
+	s_resources = decltype(s_resources)();
 }
 #endif
 
-void ResourceManager::FreeResource(String const& key)
+// Under the lock. A load that found the resource dying may have put a new entry under the key already.
+void ResourceManager::FreeEntry(String const& key, ResourceHandle handle)
 {
-	s_resourceMap.erase(key);
+	auto iter = s_resourceMap.find(key);
+	if (iter != s_resourceMap.end() && iter->second == handle)
+		s_resourceMap.erase(iter);
+	s_resources.Remove(handle);
+}
+
+void ResourceManager::FreeResource(String const& key, ResourceHandle handle)
+{
+	ScopedLock lock(s_lock);
+	FreeEntry(key, handle);
+}
+
+// Under the lock. Follows the loader to the entry it waits for and that entry's loader on, until it gets back to
+// the thread or to a loader that isn't waiting.
+bool ResourceManager::WaitsFor(uint32_t loader, uint32_t thread)
+{
+	for (uint32_t i = 0; i <= s_waits.size(); i++)
+	{
+		if (loader == thread)
+			return true;
+		auto iter = s_waits.find(loader);
+		if (iter == s_waits.end())
+			return false;
+		ResourceEntry const* entry = s_resources.Get(iter->second);
+		if (entry == nullptr || !entry->IsPending())
+			return false;
+		loader = entry->GetLoader();
+	}
+	return false;
 }
 
 SharedPtr<Shader> ResourceManager::LoadShader(String key, Function<ShaderInitializer()> initializer)
 {
-	return LoadResource<Shader, ResourceType::Shader>(key, [&]() -> SharedPtr<Shader>
+	return LoadResource<Shader>(key, [&]() -> SharedPtr<Shader>
 	{
 		ShaderInitializer init = initializer();
 		if (init.vertexShaderFile == nullptr || init.fragmentShaderFile == nullptr)
@@ -36,7 +66,7 @@ SharedPtr<Shader> ResourceManager::LoadShader(String key, Function<ShaderInitial
 
 SharedPtr<Mesh> ResourceManager::LoadMesh(String key, Function<MeshInitializer()> initializer)
 {
-	return LoadResource<Mesh, ResourceType::Mesh>(key, [&]() -> SharedPtr<Mesh>
+	return LoadResource<Mesh>(key, [&]() -> SharedPtr<Mesh>
 	{
 		MeshInitializer init = initializer();
 		if (init.meshFile == nullptr)
@@ -50,29 +80,14 @@ SharedPtr<Mesh> ResourceManager::LoadMesh(String key, Function<MeshInitializer()
 
 SharedPtr<Material> ResourceManager::LoadMaterial(String key, Function<MaterialInitializer()> initializer)
 {
-	if (key.empty())
-		return nullptr;
-	ResourceEntry& entry = s_resourceMap[key];
-	if (entry.GetType() == ResourceType::Null)
+	return LoadResource<Material>(key, [&]() -> SharedPtr<Material>
 	{
 		MaterialInitializer param = initializer();
 		if (!param.IsValid())
-		{
-			s_resourceMap.erase(key);
 			return nullptr;
-		}
 		SharedPtr<Material> material = MakeShared<Material>(param);
 		if (!material->IsValid())
-		{
-			s_resourceMap.erase(key);
 			return nullptr;
-		}
-		entry.SetType(ResourceType::Material);
-		entry.SetPointer<Material>(material);
-		material->SetKey(std::move(key));
 		return material;
-	}
-	if (entry.GetType() == ResourceType::Material)
-		return entry.GetPointer<Material>().Pin();
-	return nullptr;
+	});
 }
\ No newline at end of file
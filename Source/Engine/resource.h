@@ -2,6 +2,9 @@
 #include "Core/Container/basic.h"
 #include "Core/Container/function.h"
 #include "Core/Memory/smart_ptr.h"
+#include "Core/Thread/lock.h"
+#include "Core/Thread/thread.h"
+#include "Core/log.h"
 #include "Engine/Renderer/shader.h"
 #include "Engine/Renderer/mesh.h"
 
@@ -21,52 +24,115 @@ namespace glex
 	class ResourceManager : private StaticClass
 	{
 	private:
+		// An entry without a pointer is pending, its loader runs on the thread it names.
 		struct ResourceEntry
 		{
 		private:
 			uint64_t m_type : 16;
 			uint64_t m_pointer : 48;
+			uint32_t m_loader;
 
 		public:
-			ResourceEntry() : m_type(0), m_pointer(0) {}
-			ResourceEntry(ResourceType type, void* ptr) : m_type(*type), m_pointer(reinterpret_cast<uint64_t>(ptr)) {}
-			void SetType(ResourceType type) { m_type = *type; }
-			template <typename T> void SetPointer(WeakPtr<T> pointer) { m_pointer = reinterpret_cast<uint64_t>(pointer.Get()); }
+			ResourceEntry(ResourceType type, void* ptr, uint32_t loader = 0) : m_type(*type), m_pointer(reinterpret_cast<uint64_t>(ptr)), m_loader(loader) {}
 			ResourceType GetType() const { return static_cast<ResourceType>(m_type); }
 			template <typename T> WeakPtr<T> GetPointer() const { return reinterpret_cast<T*>(m_pointer); }
+			void SetPointer(void* ptr) { m_pointer = reinterpret_cast<uint64_t>(ptr); }
+			bool IsPending() const { return m_pointer == 0; }
+			uint32_t GetLoader() const { return m_loader; }
 		};
 
-		inline static HashMap<StringView, ResourceEntry> s_resourceMap;
+		inline static RWLock s_lock;
+		inline static HashMap<String, ResourceHandle, StringHasher> s_resourceMap;
+		inline static HandlePool<ResourceEntry, ResourceBase> s_resources;
+		// Bumped when a pending entry is done, threads waiting for one sleep on it.
+		inline static uint32_t s_loadsDone = 0;
+		// The pending entry each sleeping thread waits for, by thread ID.
+		inline static HashMap<uint32_t, ResourceHandle> s_waits;
 
-		template <std::derived_from<ResourceBase> Res, ResourceType TYPE, typename Fn>
+		static void FreeEntry(String const& key, ResourceHandle handle);
+		static bool WaitsFor(uint32_t loader, uint32_t thread);
+
+		// The first request for a key claims it with a pending entry and runs the loader outside the lock.
+		// Requests from other threads wait for it. A request that would close a cycle, from inside the loader or from
+		// a loader the pending one is waiting for, gets null instead.
+		// A resource whose last reference is gone but whose destructor hasn't taken it out yet counts as missing.
+		template <std::derived_from<ResourceBase> Res, typename Fn>
 		static SharedPtr<Res> LoadResource(String& key, Fn&& loader)
 		{
 			if (key.empty())
 				return nullptr;
-			ResourceEntry& entry = s_resourceMap[key];
-			if (entry.GetType() == ResourceType::Null)
+			uint32_t thread = Thread::GetThreadID();
+			s_lock.Lock();
+			for (auto iter = s_resourceMap.find(key); iter != s_resourceMap.end(); iter = s_resourceMap.find(key))
 			{
-				SharedPtr<Res> resource = loader();
-				if (resource == nullptr)
+				ResourceEntry const* entry = s_resources.Get(iter->second);
+				if (!entry->IsPending())
+				{
+					if (entry->GetType() != k_resourceType<Res>)
+					{
+						s_lock.Unlock();
+						return nullptr;
+					}
+					SharedPtr<Res> resource = entry->GetPointer<Res>().TryPin();
+					if (resource == nullptr)
+						break;
+					s_lock.Unlock();
+					return resource;
+				}
+				if (WaitsFor(entry->GetLoader(), thread))
 				{
-					s_resourceMap.erase(key);
+					s_lock.Unlock();
+					Logger::Error("Loading resource %s would close a cycle of loads waiting for each other.", key.c_str());
 					return nullptr;
 				}
-				entry.SetType(TYPE);
-				entry.SetPointer<Shader>(resource);
-				resource->SetKey(std::move(key));
-				return resource;
+				s_waits[thread] = iter->second;
+				uint32_t loadsDone = Atomic::Load(&s_loadsDone);
+				s_lock.Unlock();
+				Futex::Wait(&s_loadsDone, loadsDone);
+				s_lock.Lock();
+				s_waits.erase(thread);
 			}
-			if (entry.GetType() == TYPE)
-				return entry.GetPointer<Res>().Pin();
-			return nullptr;
+			ResourceHandle handle = s_resources.Insert(k_resourceType<Res>, nullptr, thread);
+			s_resourceMap[key] = handle;
+			s_lock.Unlock();
+
+			SharedPtr<Res> resource;
+			{
+				ScopedMemoryTag tag(MemoryTag::Resources);
+				resource = loader();
+			}
+			s_lock.Lock();
+			// On failure waiting threads find the key free and try themselves.
+			if (resource == nullptr)
+				FreeEntry(key, handle);
+			else
+			{
+				s_resources.Get(handle)->SetPointer(resource.Get());
+				resource->SetKey(std::move(key), handle);
+			}
+			s_lock.Unlock();
+			Atomic::Increment(&s_loadsDone);
+			Futex::WakeAll(&s_loadsDone);
+			return resource;
 		}
 
 	public:
 #if GLEX_REPORT_MEMORY_LEAKS
 		static void FreeMemory();
 #endif
-		static void FreeResource(String const& key);
+		static void FreeResource(String const& key, ResourceHandle handle);
+
+		// Null if the resource is gone or isn't a Res.
+		template <std::derived_from<ResourceBase> Res>
+		static WeakPtr<Res> Resolve(ResourceHandle handle)
+		{
+			ScopedSharedLock lock(s_lock);
+			ResourceEntry const* entry = s_resources.Get(handle);
+			if (entry == nullptr || entry->GetType() != k_resourceType<Res>)
+				return nullptr;
+			return entry->GetPointer<Res>();
+		}
+
 		static SharedPtr<Shader> LoadShader(String key, Function<ShaderInitializer()> initializer);
 		static SharedPtr<Mesh> LoadMesh(String key, Function<MeshInitializer()> initializer);
 		static SharedPtr<Material> LoadMaterial(String key, Function<MaterialInitializer()> initializer);
@@ -21,6 +21,7 @@
 #define GLEX_REPORT_PHYSICS_ERRORS 0
 #define GLEX_REPORT_PERFORMANCE_ISSUE 0
 #define GLEX_DEBUG_RENDERING 0
+#define GLEX_MIN_LOG_LEVEL 2			// Trace and Debug lines are compiled out.
 #else
 #define GLEX_COMMON_LOGGING 1
 #define GLEX_REPORT_GL_ERRORS 1
@@ -30,8 +31,13 @@
 #define GLEX_REPORT_PHYSICS_ERRORS 1
 #define GLEX_REPORT_PERFORMANCE_ISSUE 1
 #define GLEX_DEBUG_RENDERING 1
+#define GLEX_MIN_LOG_LEVEL 0
 #endif
 
+#define GLEX_USE_SLAB_ALLOCATOR 1		// Small objects opting in come from slabs instead of mimalloc.
+#define GLEX_USE_FLAT_HASH_MAP 1		// HashMap is the open-addressing FlatHashMap instead of the EASTL node map.
+#define GLEX_ENABLE_PROFILER 1			// GLEX_PROFILE_SCOPE records spans, Profiler::SetEnabled switches it at runtime.
+
 namespace glex
 {
 	class Limits
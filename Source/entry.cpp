@@ -1,5 +1,7 @@
 #include "game.h"
 #include "Engine/engine.h"
+#include "Core/Utils/profiler.h"
+#include "Core/Utils/telemetry.h"
 #include <Windows.h>
 
 using namespace glex;
@@ -17,8 +19,14 @@ inline static void EntryPoint()
 	gameInstance.BeginPlay();
 	while (!Window::IsClosing())
 	{
+		Telemetry::EndFrame();
+		GLEX_PROFILE_FRAME();
 		Window::HandleEvents();
-		gameInstance.Tick();
+		{
+			GLEX_PROFILE_SCOPE("GameInstance::Tick");
+			TelemetryScope telemetry(TelemetryCounter::ScriptUpdate);
+			gameInstance.Tick();
+		}
 		Engine::Tick();
 	}
 	gameInstance.EndPlay();